@@ -0,0 +1,125 @@
+// Copyright 2023 VulcanDB
+#include "backend/db.h"
+
+#include <filesystem>
+#include <stdexcept>
+
+#include "backend/index/spatial_index.h"
+#include "common/defs.h"
+#include "common/mutex.h"
+#include "ifcparse/IfcFile.h"
+#include "common/vulcan_logger.h"
+
+namespace vulcan {
+
+Db::Db() { MUTEX_INIT(&mutex_, NULL); }
+
+Db::~Db() { MUTEX_DESTROY(&mutex_); }
+
+void Db::init(const char *name, const char *dbpath) {
+  if (!std::filesystem::is_regular_file(dbpath)) {
+    throw std::runtime_error(std::string(dbpath) + " is not a file");
+  }
+
+  std::unique_ptr<IfcParse::IfcFile> model(new IfcParse::IfcFile(dbpath));
+  if (!model->good()) {
+    throw std::runtime_error("Failed to load ifc model " +
+                             std::string(dbpath) + ", status=" +
+                             std::to_string(model->good().value()));
+  }
+
+  name_ = name;
+  path_ = dbpath;
+  model_ = std::move(model);
+  LOG(info, "Database {} is loaded from {}, schema={}, max id={}", name_,
+      path_, model_->schema()->name(), model_->getMaxId());
+
+  load_spatial_index();
+}
+
+std::string Db::spatial_index_path() const { return path_ + ".rtree"; }
+
+void Db::load_spatial_index() {
+  // 模型文件比索引新时索引已过期，等第一次查询时重建
+  std::string index_path = spatial_index_path();
+  std::error_code ec;
+  auto index_time = std::filesystem::last_write_time(index_path, ec);
+  if (ec || index_time < std::filesystem::last_write_time(path_)) {
+    return;
+  }
+
+  std::unique_ptr<SpatialIndex> index(new SpatialIndex());
+  if (index->load(index_path) != 0) {
+    LOG(warn, "Ignore broken spatial index {}", index_path);
+    return;
+  }
+  LOG(info, "Spatial index of {} is loaded from {}, {} products", name_,
+      index_path, index->size());
+  spatial_index_ = std::move(index);
+}
+
+const SpatialIndex &Db::spatial_index() {
+  if (spatial_index_ == nullptr) {
+    std::unique_ptr<SpatialIndex> index(new SpatialIndex());
+    index->build(model_.get());
+    // 保存失败只影响下次启动，查询仍然使用内存中的索引
+    if (index->save(spatial_index_path()) != 0) {
+      LOG(warn, "Failed to save spatial index of {}", name_);
+    }
+    spatial_index_ = std::move(index);
+  }
+  return *spatial_index_;
+}
+
+void Db::lock() const { MUTEX_LOCK(&mutex_); }
+
+void Db::unlock() const { MUTEX_UNLOCK(&mutex_); }
+
+// 不随静态对象析构：模型实例的类型来自 schema 插件，插件在首次打开模型时
+// 才加载，其静态对象先于这里析构，退出时再释放模型会访问已销毁的 schema
+DbManager *DbManager::get_instance() {
+  static DbManager *instance = new DbManager();
+  return instance;
+}
+
+DbManager::DbManager() { MUTEX_INIT(&mutex_, NULL); }
+
+Db *DbManager::open(const std::string &name, const std::string &path) {
+  Db *db = find(name);
+  if (db != nullptr) {
+    return db;
+  }
+
+  // 加载模型可能很慢，不持有锁
+  std::unique_ptr<Db> loaded(new Db());
+  loaded->init(name.c_str(), path.c_str());
+
+  MUTEX_LOCK(&mutex_);
+  std::unique_ptr<Db> &slot = dbs_[name];
+  if (slot == nullptr) {
+    slot = std::move(loaded);
+  }
+  db = slot.get();
+  MUTEX_UNLOCK(&mutex_);
+  return db;
+}
+
+Db *DbManager::find(const std::string &name) {
+  MUTEX_LOCK(&mutex_);
+  auto it = dbs_.find(name);
+  Db *db = it == dbs_.end() ? nullptr : it->second.get();
+  MUTEX_UNLOCK(&mutex_);
+  return db;
+}
+
+std::vector<std::string> DbManager::names() {
+  std::vector<std::string> names;
+  MUTEX_LOCK(&mutex_);
+  for (auto &entry : dbs_) {
+    names.push_back(entry.first);
+  }
+  MUTEX_UNLOCK(&mutex_);
+  return names;
+}
+
+}  // namespace vulcan
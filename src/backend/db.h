@@ -1,14 +1,32 @@
 // Copyright 2023 VulcanDB
 #pragma once
 
+#include <pthread.h>
+
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
+
+namespace IfcParse {
+class IfcFile;
+}  // namespace IfcParse
 
 namespace vulcan {
 
+class SpatialIndex;
+
+/**
+ * @brief 一个数据库对应一个已加载的 IFC 模型。
+ *
+ * IfcFile 会在读取属性时按需解析文件内容，不是线程安全的，访问模型前
+ * 需要持有 lock()。模型加载后不再修改，已解析的属性可以不持有锁并发读取
+ * (见 ColumnScan)。
+ */
 class Db {
  public:
-  Db() = default;
-  ~Db() = default;
+  Db();
+  ~Db();
 
   // 初始化数据库
   // @param name 数据库名称
@@ -19,9 +37,53 @@ class Db {
   const char *name() const { return name_.c_str(); }
   const char *path() const { return path_.c_str(); }
 
+  IfcParse::IfcFile *model() const { return model_.get(); }
+
+  /**
+   * @brief 模型中产品的空间索引，调用者需持有 lock()。init 时从模型旁的
+   * .rtree 文件加载，文件不存在或已过期时在第一次调用时建立并写回文件
+   */
+  const SpatialIndex &spatial_index();
+
+  void lock() const;
+  void unlock() const;
+
  private:
+  std::string spatial_index_path() const;
+  void load_spatial_index();
+
   std::string name_;
   std::string path_;
+
+  std::unique_ptr<IfcParse::IfcFile> model_;
+  std::unique_ptr<SpatialIndex> spatial_index_;
+  mutable pthread_mutex_t mutex_;  // serializes access to model_
 };  // namespace vulcan
 
+/**
+ * @brief 进程内已打开的数据库，按名称查找。数据库在进程退出前不会关闭，
+ * Session 可以直接持有 Db 指针。
+ */
+class DbManager {
+ public:
+  static DbManager *get_instance();
+
+  /**
+   * @brief 打开数据库，同名数据库已存在时直接返回
+   * @throw std::runtime_error 加载失败
+   */
+  Db *open(const std::string &name, const std::string &path);
+
+  // 未打开时返回 nullptr
+  Db *find(const std::string &name);
+
+  std::vector<std::string> names();
+
+ private:
+  DbManager();
+
+  pthread_mutex_t mutex_;  // protects dbs_
+  std::map<std::string, std::unique_ptr<Db>> dbs_;
+};
+
 }  // namespace vulcan
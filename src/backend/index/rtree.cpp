@@ -0,0 +1,324 @@
+// Copyright 2023 VulcanDB
+#include "backend/index/rtree.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace vulcan {
+
+namespace {
+
+const char RTREE_MAGIC[4] = {'V', 'R', 'T', '1'};
+
+// 32 位 id 最多装成 8 层；每层在遍历栈中最多留下 NODE_CAPACITY 个节点
+constexpr int MAX_HEIGHT = 16;
+constexpr size_t MAX_STACK = MAX_HEIGHT * RTree::NODE_CAPACITY;
+
+template <typename T>
+void sort_by_center(T *items, size_t count, int axis) {
+  std::sort(items, items + count, [axis](const T &a, const T &b) {
+    return a.box.center(axis) < b.box.center(axis);
+  });
+}
+
+/**
+ * 按 STR 对一层的项排序：先按 x 分成 S 片，片内按 y 分成 S 列，列内按 z
+ * 排序，其中 S = ceil(节点数 ^ (1/3))。排序后每 NODE_CAPACITY 个连续的项
+ * 组成一个节点。
+ */
+template <typename T>
+void str_sort(T *items, size_t count) {
+  const size_t capacity = RTree::NODE_CAPACITY;
+  size_t pages = (count + capacity - 1) / capacity;
+  size_t slices = static_cast<size_t>(std::ceil(std::cbrt(pages)));
+  size_t slab_size = slices * slices * capacity;
+  size_t run_size = slices * capacity;
+
+  sort_by_center(items, count, 0);
+  for (size_t slab = 0; slab < count; slab += slab_size) {
+    size_t slab_count = std::min(slab_size, count - slab);
+    sort_by_center(items + slab, slab_count, 1);
+    for (size_t run = 0; run < slab_count; run += run_size) {
+      sort_by_center(items + slab + run,
+                     std::min(run_size, slab_count - run), 2);
+    }
+  }
+}
+
+// 序列化时逐个字段写入，不写结构体中的填充字节
+constexpr size_t BOX_BYTES = 6 * sizeof(double);
+constexpr size_t ENTRY_BYTES = BOX_BYTES + sizeof(uint32_t);
+constexpr size_t NODE_BYTES = BOX_BYTES + 3 * sizeof(uint32_t);
+
+template <typename T>
+void append_pod(std::string *data, const T &value) {
+  data->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void append_box(std::string *data, const BoundingBox &box) {
+  data->append(reinterpret_cast<const char *>(box.min), sizeof(box.min));
+  data->append(reinterpret_cast<const char *>(box.max), sizeof(box.max));
+}
+
+template <typename T>
+const char *read_pod(const char *p, T *value) {
+  memcpy(value, p, sizeof(T));
+  return p + sizeof(T);
+}
+
+const char *read_box(const char *p, BoundingBox *box) {
+  memcpy(box->min, p, sizeof(box->min));
+  memcpy(box->max, p + sizeof(box->min), sizeof(box->max));
+  return p + BOX_BYTES;
+}
+
+}  // namespace
+
+BoundingBox::BoundingBox() {
+  for (int i = 0; i < 3; i++) {
+    min[i] = std::numeric_limits<double>::max();
+    max[i] = std::numeric_limits<double>::lowest();
+  }
+}
+
+BoundingBox::BoundingBox(double x1, double y1, double z1, double x2,
+                         double y2, double z2)
+    : min{x1, y1, z1}, max{x2, y2, z2} {}
+
+void BoundingBox::expand(const double point[3]) {
+  for (int i = 0; i < 3; i++) {
+    min[i] = std::min(min[i], point[i]);
+    max[i] = std::max(max[i], point[i]);
+  }
+}
+
+void BoundingBox::expand(const BoundingBox &other) {
+  for (int i = 0; i < 3; i++) {
+    min[i] = std::min(min[i], other.min[i]);
+    max[i] = std::max(max[i], other.max[i]);
+  }
+}
+
+bool BoundingBox::intersects(const BoundingBox &other) const {
+  return min[0] <= other.max[0] && other.min[0] <= max[0] &&
+         min[1] <= other.max[1] && other.min[1] <= max[1] &&
+         min[2] <= other.max[2] && other.min[2] <= max[2];
+}
+
+bool BoundingBox::contains(const double point[3]) const {
+  return min[0] <= point[0] && point[0] <= max[0] && min[1] <= point[1] &&
+         point[1] <= max[1] && min[2] <= point[2] && point[2] <= max[2];
+}
+
+double BoundingBox::distance2(const double point[3]) const {
+  double d2 = 0;
+  for (int i = 0; i < 3; i++) {
+    double d = std::max(std::max(min[i] - point[i], point[i] - max[i]), 0.0);
+    d2 += d * d;
+  }
+  return d2;
+}
+
+void RTree::build(std::vector<Entry> entries) {
+  entries_ = std::move(entries);
+  nodes_.clear();
+  height_ = 0;
+  if (entries_.empty()) {
+    return;
+  }
+
+  str_sort(entries_.data(), entries_.size());
+  for (size_t i = 0; i < entries_.size(); i += NODE_CAPACITY) {
+    Node node;
+    node.first = static_cast<uint32_t>(i);
+    node.count = static_cast<uint32_t>(
+        std::min<size_t>(NODE_CAPACITY, entries_.size() - i));
+    node.leaf = 1;
+    for (uint32_t j = 0; j < node.count; j++) {
+      node.box.expand(entries_[i + j].box);
+    }
+    nodes_.push_back(node);
+  }
+  height_ = 1;
+
+  size_t level_begin = 0;
+  while (nodes_.size() - level_begin > 1) {
+    size_t level_count = nodes_.size() - level_begin;
+    // 同一层的节点还没有父节点，可以直接重排
+    str_sort(&nodes_[level_begin], level_count);
+    std::vector<Node> parents;
+    for (size_t i = 0; i < level_count; i += NODE_CAPACITY) {
+      Node node;
+      node.first = static_cast<uint32_t>(level_begin + i);
+      node.count = static_cast<uint32_t>(
+          std::min<size_t>(NODE_CAPACITY, level_count - i));
+      node.leaf = 0;
+      for (uint32_t j = 0; j < node.count; j++) {
+        node.box.expand(nodes_[node.first + j].box);
+      }
+      parents.push_back(node);
+    }
+    level_begin = nodes_.size();
+    nodes_.insert(nodes_.end(), parents.begin(), parents.end());
+    height_++;
+  }
+}
+
+BoundingBox RTree::bounds() const {
+  return nodes_.empty() ? BoundingBox() : root().box;
+}
+
+void RTree::search(const BoundingBox &box, std::vector<uint32_t> *ids) const {
+  if (nodes_.empty() || !root().box.intersects(box)) {
+    return;
+  }
+  uint32_t stack[MAX_STACK];
+  size_t depth = 0;
+  stack[depth++] = static_cast<uint32_t>(nodes_.size() - 1);
+  while (depth > 0) {
+    const Node &node = nodes_[stack[--depth]];
+    if (node.leaf) {
+      for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        if (entries_[i].box.intersects(box)) {
+          ids->push_back(entries_[i].id);
+        }
+      }
+      continue;
+    }
+    for (uint32_t i = node.first; i < node.first + node.count; i++) {
+      if (nodes_[i].box.intersects(box)) {
+        stack[depth++] = i;
+      }
+    }
+  }
+}
+
+void RTree::search(const double point[3], std::vector<uint32_t> *ids) const {
+  search(BoundingBox(point[0], point[1], point[2], point[0], point[1],
+                     point[2]),
+         ids);
+}
+
+void RTree::nearest(const double point[3], size_t k,
+                    std::vector<std::pair<double, uint32_t>> *result) const {
+  result->clear();
+  if (nodes_.empty() || k == 0) {
+    return;
+  }
+
+  // 按距离从小到大展开节点，弹出的叶子项一定比队列中剩余的都近
+  struct Candidate {
+    double d2;
+    uint32_t index;
+    bool entry;
+    bool operator>(const Candidate &other) const { return d2 > other.d2; }
+  };
+  std::priority_queue<Candidate, std::vector<Candidate>,
+                      std::greater<Candidate>>
+      queue;
+  queue.push({root().box.distance2(point),
+              static_cast<uint32_t>(nodes_.size() - 1), false});
+  while (!queue.empty() && result->size() < k) {
+    Candidate top = queue.top();
+    queue.pop();
+    if (top.entry) {
+      result->emplace_back(std::sqrt(top.d2), entries_[top.index].id);
+      continue;
+    }
+    const Node &node = nodes_[top.index];
+    for (uint32_t i = node.first; i < node.first + node.count; i++) {
+      const BoundingBox &box = node.leaf ? entries_[i].box : nodes_[i].box;
+      queue.push({box.distance2(point), i, node.leaf != 0});
+    }
+  }
+}
+
+std::string RTree::serialize() const {
+  // 按本机字节序保存，只用于同一台机器上的持久化
+  std::string data(RTREE_MAGIC, sizeof(RTREE_MAGIC));
+  data.reserve(sizeof(RTREE_MAGIC) + 3 * sizeof(uint32_t) +
+               entries_.size() * ENTRY_BYTES + nodes_.size() * NODE_BYTES);
+  append_pod(&data, static_cast<uint32_t>(entries_.size()));
+  append_pod(&data, static_cast<uint32_t>(nodes_.size()));
+  append_pod(&data, static_cast<uint32_t>(height_));
+  for (const Entry &entry : entries_) {
+    append_box(&data, entry.box);
+    append_pod(&data, entry.id);
+  }
+  for (const Node &node : nodes_) {
+    append_box(&data, node.box);
+    append_pod(&data, node.first);
+    append_pod(&data, node.count);
+    append_pod(&data, node.leaf);
+  }
+  return data;
+}
+
+int RTree::deserialize(const std::string &data) {
+  entries_.clear();
+  nodes_.clear();
+  height_ = 0;
+
+  uint32_t entry_count, node_count, height;
+  size_t header_bytes = sizeof(RTREE_MAGIC) + 3 * sizeof(uint32_t);
+  if (data.size() < header_bytes ||
+      memcmp(data.data(), RTREE_MAGIC, sizeof(RTREE_MAGIC)) != 0) {
+    return -1;
+  }
+  const char *p = data.data() + sizeof(RTREE_MAGIC);
+  p = read_pod(p, &entry_count);
+  p = read_pod(p, &node_count);
+  p = read_pod(p, &height);
+  if (data.size() != header_bytes + entry_count * ENTRY_BYTES +
+                         static_cast<size_t>(node_count) * NODE_BYTES) {
+    return -1;
+  }
+
+  std::vector<Entry> entries(entry_count);
+  std::vector<Node> nodes(node_count);
+  for (Entry &entry : entries) {
+    p = read_box(p, &entry.box);
+    p = read_pod(p, &entry.id);
+  }
+  for (Node &node : nodes) {
+    p = read_box(p, &node.box);
+    p = read_pod(p, &node.first);
+    p = read_pod(p, &node.count);
+    p = read_pod(p, &node.leaf);
+  }
+
+  // 子节点必须位于父节点之前并且同一节点的子节点在同一层，否则遍历可能
+  // 越界、死循环或者超出遍历栈
+  std::vector<int> levels(nodes.size());
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const Node &node = nodes[i];
+    size_t limit = node.leaf ? entries.size() : i;
+    if (node.count == 0 || node.count > NODE_CAPACITY ||
+        node.first + static_cast<size_t>(node.count) > limit) {
+      return -1;
+    }
+    levels[i] = node.leaf ? 1 : levels[node.first] + 1;
+    for (uint32_t j = node.first; !node.leaf && j < node.first + node.count;
+         j++) {
+      if (levels[j] + 1 != levels[i]) {
+        return -1;
+      }
+    }
+  }
+  if (entries.empty() != nodes.empty() ||
+      (!nodes.empty() && (levels.back() != static_cast<int>(height) ||
+                          levels.back() > MAX_HEIGHT))) {
+    return -1;
+  }
+
+  entries_.swap(entries);
+  nodes_.swap(nodes);
+  height_ = static_cast<int>(height);
+  return 0;
+}
+
+}  // namespace vulcan
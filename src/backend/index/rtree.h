@@ -0,0 +1,99 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vulcan {
+
+/**
+ * @brief 轴对齐包围盒，空盒的 min 大于 max
+ */
+struct BoundingBox {
+  double min[3];
+  double max[3];
+
+  BoundingBox();
+  BoundingBox(double x1, double y1, double z1, double x2, double y2,
+              double z2);
+
+  bool empty() const { return min[0] > max[0]; }
+  void expand(const double point[3]);
+  void expand(const BoundingBox &other);
+  bool intersects(const BoundingBox &other) const;
+  bool contains(const double point[3]) const;
+  double center(int axis) const { return (min[axis] + max[axis]) / 2; }
+  // 点到盒的最短距离的平方，点在盒内时为 0
+  double distance2(const double point[3]) const;
+};
+
+/**
+ * @brief 按 STR(Sort-Tile-Recursive)方式批量装载的静态 R-tree。
+ *
+ * 叶子项按 x、y、z 中心坐标依次分片排序后每 NODE_CAPACITY 个装成一个节点，
+ * 上层节点以同样的方式由下层节点装成，节点几乎全满并且相互重叠少。建成
+ * 后不支持插入和删除，模型变化后需要重新装载。节点和叶子项都保存在连续的
+ * 数组中，可以直接序列化。
+ */
+class RTree {
+ public:
+  static constexpr uint32_t NODE_CAPACITY = 16;
+
+  struct Entry {
+    BoundingBox box;
+    uint32_t id;
+  };
+
+  RTree() = default;
+
+  // 以 entries 批量装载，替换已有内容
+  void build(std::vector<Entry> entries);
+
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+  // 所有项的包围盒
+  BoundingBox bounds() const;
+  // 树的层数，空树为 0
+  int height() const { return height_; }
+
+  /**
+   * @brief 查找包围盒与 box 相交的项，结果追加到 ids，不保证顺序
+   */
+  void search(const BoundingBox &box, std::vector<uint32_t> *ids) const;
+
+  /**
+   * @brief 查找包围盒包含 point 的项
+   */
+  void search(const double point[3], std::vector<uint32_t> *ids) const;
+
+  /**
+   * @brief 按包围盒到 point 的距离查找最近的 k 项
+   * @param result 按距离升序的 (距离, id)
+   */
+  void nearest(const double point[3], size_t k,
+               std::vector<std::pair<double, uint32_t>> *result) const;
+
+  std::string serialize() const;
+  /**
+   * @return 0 成功，-1 数据格式错误，此时树被清空
+   */
+  int deserialize(const std::string &data);
+
+ private:
+  struct Node {
+    BoundingBox box;
+    uint32_t first;  // 叶节点指向 entries_，否则指向 nodes_
+    uint32_t count;
+    uint32_t leaf;
+  };
+
+  const Node &root() const { return nodes_.back(); }
+
+  std::vector<Entry> entries_;  // 按叶节点顺序排列
+  std::vector<Node> nodes_;     // 自底向上逐层排列，根节点在最后
+  int height_ = 0;
+};
+
+}  // namespace vulcan
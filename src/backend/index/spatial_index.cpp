@@ -0,0 +1,636 @@
+// Copyright 2023 VulcanDB
+#include "backend/index/spatial_index.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <unordered_map>
+
+#include "common/string.h"
+#include "common/vulcan_logger.h"
+#include "ifcparse/IfcFile.h"
+#include "storage/datastore/datastore_interface.h"
+
+namespace vulcan {
+
+namespace {
+
+// 映射项和布尔运算嵌套的最大深度，防止循环引用
+constexpr int MAX_ITEM_DEPTH = 16;
+
+// 仿射变换，第 4 列为平移
+struct Transform {
+  double m[3][4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}};
+
+  void apply(const double p[3], double out[3]) const {
+    for (int i = 0; i < 3; i++) {
+      out[i] = m[i][0] * p[0] + m[i][1] * p[1] + m[i][2] * p[2] + m[i][3];
+    }
+  }
+
+  Transform operator*(const Transform &other) const {
+    Transform result;
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 4; j++) {
+        result.m[i][j] = m[i][0] * other.m[0][j] + m[i][1] * other.m[1][j] +
+                         m[i][2] * other.m[2][j] + (j == 3 ? m[i][3] : 0);
+      }
+    }
+    return result;
+  }
+};
+
+double length(const double v[3]) {
+  return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+bool normalize(double v[3]) {
+  double len = length(v);
+  if (len < 1e-12) {
+    return false;
+  }
+  for (int i = 0; i < 3; i++) {
+    v[i] /= len;
+  }
+  return true;
+}
+
+/**
+ * 由 z 轴和 x 轴的参考方向构造右手正交坐标系，x 轴取参考方向在垂直于 z 的
+ * 平面上的投影，与 IfcAxis2Placement3D 的定义一致。
+ */
+Transform make_axes(double x[3], double z[3], const double origin[3]) {
+  if (!normalize(z)) {
+    z[0] = 0, z[1] = 0, z[2] = 1;
+  }
+  double dot = x[0] * z[0] + x[1] * z[1] + x[2] * z[2];
+  for (int i = 0; i < 3; i++) {
+    x[i] -= dot * z[i];
+  }
+  if (!normalize(x)) {
+    // 参考方向与 z 轴平行，任取一个垂直方向
+    double any[3] = {std::fabs(z[0]) < 0.9 ? 1.0 : 0.0,
+                     std::fabs(z[0]) < 0.9 ? 0.0 : 1.0, 0};
+    dot = any[0] * z[0] + any[1] * z[1];
+    for (int i = 0; i < 3; i++) {
+      x[i] = any[i] - dot * z[i];
+    }
+    normalize(x);
+  }
+  double y[3] = {z[1] * x[2] - z[2] * x[1], z[2] * x[0] - z[0] * x[2],
+                 z[0] * x[1] - z[1] * x[0]};
+
+  Transform t;
+  for (int i = 0; i < 3; i++) {
+    t.m[i][0] = x[i];
+    t.m[i][1] = y[i];
+    t.m[i][2] = z[i];
+    t.m[i][3] = origin[i];
+  }
+  return t;
+}
+
+// 把局部坐标系中的盒 [lo, hi] 的 8 个角变换后并入 box
+void expand_box(const Transform &t, const double lo[3], const double hi[3],
+                BoundingBox *box) {
+  for (int corner = 0; corner < 8; corner++) {
+    double p[3] = {corner & 1 ? hi[0] : lo[0], corner & 2 ? hi[1] : lo[1],
+                   corner & 4 ? hi[2] : lo[2]};
+    double q[3];
+    t.apply(p, q);
+    box->expand(q);
+  }
+}
+
+/**
+ * 按属性名读取几何实体。只依赖属性名，不依赖具体的 schema 版本。
+ */
+class GeometryReader {
+ public:
+  explicit GeometryReader(IfcParse::IfcFile *file);
+
+  // 计算产品的包围盒，没有几何表示时返回 false
+  bool product_box(IfcUtil::IfcBaseClass *product, BoundingBox *box);
+
+ private:
+  const IfcParse::declaration *type(const char *name) const;
+  static bool is(IfcUtil::IfcBaseClass *instance,
+                 const IfcParse::declaration *decl) {
+    return decl != nullptr && instance->declaration().is(*decl);
+  }
+
+  // 属性不存在或为空时返回 nullptr
+  const Argument *attribute(IfcUtil::IfcBaseClass *instance,
+                            const char *name);
+  IfcUtil::IfcBaseClass *entity(IfcUtil::IfcBaseClass *instance,
+                                const char *name);
+  aggregate_of_instance::ptr entities(IfcUtil::IfcBaseClass *instance,
+                                      const char *name);
+  double number(IfcUtil::IfcBaseClass *instance, const char *name,
+                double default_value);
+  // 读取 IfcCartesianPoint 或 IfcDirection 的坐标，二维时 z 保持不变
+  static bool coordinates(IfcUtil::IfcBaseClass *instance, double v[3]);
+
+  Transform object_placement(IfcUtil::IfcBaseClass *placement);
+  Transform axis2_placement(IfcUtil::IfcBaseClass *placement);
+  Transform transformation_operator(IfcUtil::IfcBaseClass *op);
+
+  void item_box(IfcUtil::IfcBaseClass *item, const Transform &t,
+                BoundingBox *box, int depth);
+  // 剖面在自身坐标系中的二维包围盒
+  bool profile_box(IfcUtil::IfcBaseClass *profile, double lo[2],
+                   double hi[2]);
+  void points_box(IfcUtil::IfcBaseClass *root, const Transform &t,
+                  BoundingBox *box);
+
+  IfcParse::IfcFile *file_;
+  std::map<std::pair<const IfcParse::declaration *, const char *>, int>
+      attribute_index_;
+  std::unordered_map<unsigned int, Transform> placements_;
+
+  const IfcParse::declaration *local_placement_;
+  const IfcParse::declaration *axis2_3d_;
+  const IfcParse::declaration *point_;
+  const IfcParse::declaration *mapped_item_;
+  const IfcParse::declaration *bounding_box_;
+  const IfcParse::declaration *extruded_;
+  const IfcParse::declaration *revolved_;
+  const IfcParse::declaration *boolean_;
+  const IfcParse::declaration *half_space_;
+  const IfcParse::declaration *block_;
+  const IfcParse::declaration *rectangle_profile_;
+  const IfcParse::declaration *circle_profile_;
+  const IfcParse::declaration *ellipse_profile_;
+  const IfcParse::declaration *parameterized_profile_;
+};
+
+GeometryReader::GeometryReader(IfcParse::IfcFile *file) : file_(file) {
+  local_placement_ = type("IfcLocalPlacement");
+  axis2_3d_ = type("IfcAxis2Placement3D");
+  point_ = type("IfcCartesianPoint");
+  mapped_item_ = type("IfcMappedItem");
+  bounding_box_ = type("IfcBoundingBox");
+  extruded_ = type("IfcExtrudedAreaSolid");
+  revolved_ = type("IfcRevolvedAreaSolid");
+  boolean_ = type("IfcBooleanResult");
+  half_space_ = type("IfcHalfSpaceSolid");
+  block_ = type("IfcBlock");
+  rectangle_profile_ = type("IfcRectangleProfileDef");
+  circle_profile_ = type("IfcCircleProfileDef");
+  ellipse_profile_ = type("IfcEllipseProfileDef");
+  parameterized_profile_ = type("IfcParameterizedProfileDef");
+}
+
+const IfcParse::declaration *GeometryReader::type(const char *name) const {
+  try {
+    return file_->schema()->declaration_by_name(name);
+  } catch (const IfcParse::IfcException &) {
+    return nullptr;
+  }
+}
+
+const Argument *GeometryReader::attribute(IfcUtil::IfcBaseClass *instance,
+                                          const char *name) {
+  if (instance == nullptr) {
+    return nullptr;
+  }
+  auto key = std::make_pair(&instance->declaration(), name);
+  auto it = attribute_index_.find(key);
+  if (it == attribute_index_.end()) {
+    const IfcParse::entity *decl = instance->declaration().as_entity();
+    int index = decl == nullptr ? -1 : decl->attribute_index(name);
+    it = attribute_index_.emplace(key, index).first;
+  }
+  if (it->second < 0 ||
+      it->second >= static_cast<int>(instance->data().getArgumentCount())) {
+    return nullptr;
+  }
+  const Argument *arg = instance->data().getArgument(it->second);
+  return arg == nullptr || arg->isNull() ? nullptr : arg;
+}
+
+IfcUtil::IfcBaseClass *GeometryReader::entity(IfcUtil::IfcBaseClass *instance,
+                                              const char *name) {
+  const Argument *arg = attribute(instance, name);
+  if (arg == nullptr || arg->type() != IfcUtil::Argument_ENTITY_INSTANCE) {
+    return nullptr;
+  }
+  return *arg;
+}
+
+aggregate_of_instance::ptr GeometryReader::entities(
+    IfcUtil::IfcBaseClass *instance, const char *name) {
+  const Argument *arg = attribute(instance, name);
+  if (arg == nullptr ||
+      arg->type() != IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE) {
+    return aggregate_of_instance::ptr(new aggregate_of_instance());
+  }
+  return *arg;
+}
+
+double GeometryReader::number(IfcUtil::IfcBaseClass *instance,
+                              const char *name, double default_value) {
+  const Argument *arg = attribute(instance, name);
+  if (arg == nullptr) {
+    return default_value;
+  }
+  switch (arg->type()) {
+    case IfcUtil::Argument_DOUBLE:
+      return *arg;
+    case IfcUtil::Argument_INT:
+      return static_cast<int>(*arg);
+    default:
+      return default_value;
+  }
+}
+
+bool GeometryReader::coordinates(IfcUtil::IfcBaseClass *instance,
+                                 double v[3]) {
+  if (instance == nullptr || instance->data().getArgumentCount() == 0) {
+    return false;
+  }
+  const Argument *arg = instance->data().getArgument(0);
+  std::vector<double> values;
+  if (arg->type() == IfcUtil::Argument_AGGREGATE_OF_DOUBLE) {
+    values = static_cast<std::vector<double>>(*arg);
+  } else if (arg->type() == IfcUtil::Argument_AGGREGATE_OF_INT) {
+    std::vector<int> ints = *arg;
+    values.assign(ints.begin(), ints.end());
+  } else {
+    return false;
+  }
+  for (size_t i = 0; i < values.size() && i < 3; i++) {
+    v[i] = values[i];
+  }
+  return !values.empty();
+}
+
+Transform GeometryReader::object_placement(
+    IfcUtil::IfcBaseClass *placement) {
+  if (placement == nullptr) {
+    return Transform();
+  }
+  unsigned int id = placement->data().id();
+  auto it = placements_.find(id);
+  if (it != placements_.end()) {
+    return it->second;
+  }
+  // 先放入单位变换，PlacementRelTo 有环时不会无限递归
+  placements_[id] = Transform();
+
+  // IfcGridPlacement 等其它放置方式按单位变换处理
+  Transform t;
+  if (is(placement, local_placement_)) {
+    t = object_placement(entity(placement, "PlacementRelTo")) *
+        axis2_placement(entity(placement, "RelativePlacement"));
+  }
+  placements_[id] = t;
+  return t;
+}
+
+Transform GeometryReader::axis2_placement(IfcUtil::IfcBaseClass *placement) {
+  if (placement == nullptr) {
+    return Transform();
+  }
+  double origin[3] = {0, 0, 0};
+  double x[3] = {1, 0, 0};
+  double z[3] = {0, 0, 1};
+  coordinates(entity(placement, "Location"), origin);
+  if (is(placement, axis2_3d_)) {
+    coordinates(entity(placement, "Axis"), z);
+  }
+  coordinates(entity(placement, "RefDirection"), x);
+  x[2] = is(placement, axis2_3d_) ? x[2] : 0;
+  return make_axes(x, z, origin);
+}
+
+Transform GeometryReader::transformation_operator(IfcUtil::IfcBaseClass *op) {
+  if (op == nullptr) {
+    return Transform();
+  }
+  double origin[3] = {0, 0, 0};
+  double x[3] = {1, 0, 0};
+  double z[3] = {0, 0, 1};
+  coordinates(entity(op, "LocalOrigin"), origin);
+  coordinates(entity(op, "Axis1"), x);
+  coordinates(entity(op, "Axis3"), z);
+  Transform t = make_axes(x, z, origin);
+
+  // 非均匀缩放的 Scale2、Scale3 缺省等于 Scale
+  double scale[3];
+  scale[0] = number(op, "Scale", 1);
+  scale[1] = number(op, "Scale2", scale[0]);
+  scale[2] = number(op, "Scale3", scale[0]);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      t.m[i][j] *= scale[j];
+    }
+  }
+  return t;
+}
+
+bool GeometryReader::product_box(IfcUtil::IfcBaseClass *product,
+                                 BoundingBox *box) {
+  IfcUtil::IfcBaseClass *shape = entity(product, "Representation");
+  if (shape == nullptr) {
+    return false;
+  }
+  Transform t = object_placement(entity(product, "ObjectPlacement"));
+  BoundingBox result;
+  aggregate_of_instance::ptr representations =
+      entities(shape, "Representations");
+  for (IfcUtil::IfcBaseClass *representation : *representations) {
+    aggregate_of_instance::ptr items = entities(representation, "Items");
+    for (IfcUtil::IfcBaseClass *item : *items) {
+      item_box(item, t, &result, 0);
+    }
+  }
+  if (result.empty()) {
+    return false;
+  }
+  *box = result;
+  return true;
+}
+
+void GeometryReader::item_box(IfcUtil::IfcBaseClass *item, const Transform &t,
+                              BoundingBox *box, int depth) {
+  if (item == nullptr || depth > MAX_ITEM_DEPTH) {
+    return;
+  }
+
+  if (is(item, mapped_item_)) {
+    IfcUtil::IfcBaseClass *source = entity(item, "MappingSource");
+    Transform mapped =
+        t * transformation_operator(entity(item, "MappingTarget")) *
+        axis2_placement(entity(source, "MappingOrigin"));
+    aggregate_of_instance::ptr items =
+        entities(entity(source, "MappedRepresentation"), "Items");
+    for (IfcUtil::IfcBaseClass *sub : *items) {
+      item_box(sub, mapped, box, depth + 1);
+    }
+    return;
+  }
+
+  if (is(item, bounding_box_)) {
+    double lo[3] = {0, 0, 0};
+    coordinates(entity(item, "Corner"), lo);
+    double hi[3] = {lo[0] + number(item, "XDim", 0),
+                    lo[1] + number(item, "YDim", 0),
+                    lo[2] + number(item, "ZDim", 0)};
+    expand_box(t, lo, hi, box);
+    return;
+  }
+
+  if (is(item, block_)) {
+    double lo[3] = {0, 0, 0};
+    double hi[3] = {number(item, "XLength", 0), number(item, "YLength", 0),
+                    number(item, "ZLength", 0)};
+    expand_box(t * axis2_placement(entity(item, "Position")), lo, hi, box);
+    return;
+  }
+
+  if (is(item, extruded_)) {
+    double lo[2], hi[2];
+    if (!profile_box(entity(item, "SweptArea"), lo, hi)) {
+      points_box(item, t, box);
+      return;
+    }
+    Transform solid = t * axis2_placement(entity(item, "Position"));
+    double direction[3] = {0, 0, 1};
+    coordinates(entity(item, "ExtrudedDirection"), direction);
+    normalize(direction);
+    double extrusion = number(item, "Depth", 0);
+    // 剖面盒的四个角及其沿拉伸方向平移后的位置
+    for (int corner = 0; corner < 8; corner++) {
+      double k = corner & 4 ? extrusion : 0;
+      double p[3] = {(corner & 1 ? hi[0] : lo[0]) + direction[0] * k,
+                     (corner & 2 ? hi[1] : lo[1]) + direction[1] * k,
+                     direction[2] * k};
+      double q[3];
+      solid.apply(p, q);
+      box->expand(q);
+    }
+    return;
+  }
+
+  if (is(item, revolved_)) {
+    double lo[2], hi[2];
+    if (!profile_box(entity(item, "SweptArea"), lo, hi)) {
+      points_box(item, t, box);
+      return;
+    }
+    // 以旋转轴上的点为球心、剖面最远的角为半径求界
+    double center[3] = {0, 0, 0};
+    coordinates(entity(entity(item, "Axis"), "Location"), center);
+    double radius = 0;
+    for (int corner = 0; corner < 4; corner++) {
+      double d[3] = {(corner & 1 ? hi[0] : lo[0]) - center[0],
+                     (corner & 2 ? hi[1] : lo[1]) - center[1], -center[2]};
+      radius = std::max(radius, length(d));
+    }
+    double sphere_lo[3], sphere_hi[3];
+    for (int i = 0; i < 3; i++) {
+      sphere_lo[i] = center[i] - radius;
+      sphere_hi[i] = center[i] + radius;
+    }
+    expand_box(t * axis2_placement(entity(item, "Position")), sphere_lo,
+               sphere_hi, box);
+    return;
+  }
+
+  if (is(item, boolean_)) {
+    // 差和交不超出第一个操作数，并需要两个操作数
+    item_box(entity(item, "FirstOperand"), t, box, depth + 1);
+    const Argument *op = attribute(item, "Operator");
+    if (op != nullptr && op->type() == IfcUtil::Argument_ENUMERATION &&
+        static_cast<std::string>(*op) == "UNION") {
+      item_box(entity(item, "SecondOperand"), t, box, depth + 1);
+    }
+    return;
+  }
+
+  if (is(item, half_space_)) {
+    // 半空间无界，只用于裁剪
+    return;
+  }
+
+  points_box(item, t, box);
+}
+
+bool GeometryReader::profile_box(IfcUtil::IfcBaseClass *profile, double lo[2],
+                                 double hi[2]) {
+  if (profile == nullptr) {
+    return false;
+  }
+
+  double half[2] = {-1, -1};
+  if (is(profile, rectangle_profile_)) {
+    half[0] = number(profile, "XDim", 0) / 2;
+    half[1] = number(profile, "YDim", 0) / 2;
+  } else if (is(profile, circle_profile_)) {
+    half[0] = half[1] = number(profile, "Radius", 0);
+  } else if (is(profile, ellipse_profile_)) {
+    half[0] = number(profile, "SemiAxis1", 0);
+    half[1] = number(profile, "SemiAxis2", 0);
+  } else if (is(profile, parameterized_profile_)) {
+    // 其它参数化剖面(I、L、T、U 形等)以原点为中心，范围不超过各尺寸之和
+    double sum = 0;
+    for (size_t i = 0; i < profile->data().getArgumentCount(); i++) {
+      const Argument *arg = profile->data().getArgument(i);
+      if (!arg->isNull() && arg->type() == IfcUtil::Argument_DOUBLE) {
+        sum += std::fabs(static_cast<double>(*arg));
+      }
+    }
+    half[0] = half[1] = sum;
+  }
+
+  if (half[0] >= 0) {
+    Transform position = axis2_placement(entity(profile, "Position"));
+    BoundingBox box;
+    double local_lo[3] = {-half[0], -half[1], 0};
+    double local_hi[3] = {half[0], half[1], 0};
+    expand_box(position, local_lo, local_hi, &box);
+    lo[0] = box.min[0], lo[1] = box.min[1];
+    hi[0] = box.max[0], hi[1] = box.max[1];
+    return true;
+  }
+
+  // 任意剖面取其曲线上的点
+  BoundingBox box;
+  points_box(profile, Transform(), &box);
+  if (box.empty()) {
+    return false;
+  }
+  lo[0] = box.min[0], lo[1] = box.min[1];
+  hi[0] = box.max[0], hi[1] = box.max[1];
+  return true;
+}
+
+void GeometryReader::points_box(IfcUtil::IfcBaseClass *root,
+                                const Transform &t, BoundingBox *box) {
+  aggregate_of_instance::ptr reachable = file_->traverse(root);
+  for (IfcUtil::IfcBaseClass *instance : *reachable) {
+    double p[3] = {0, 0, 0};
+    if (is(instance, point_) && coordinates(instance, p)) {
+      double q[3];
+      t.apply(p, q);
+      box->expand(q);
+    }
+  }
+}
+
+}  // namespace
+
+size_t SpatialIndex::build(IfcParse::IfcFile *file) {
+  GeometryReader reader(file);
+  std::vector<RTree::Entry> entries;
+  aggregate_of_instance::ptr products = file->instances_by_type("IfcProduct");
+  size_t total = products ? products->size() : 0;
+  for (size_t i = 0; i < total; i++) {
+    IfcUtil::IfcBaseClass *product = (*products)[i];
+    RTree::Entry entry;
+    try {
+      if (!reader.product_box(product, &entry.box)) {
+        continue;
+      }
+    } catch (const IfcParse::IfcException &e) {
+      LOG(warn, "Skip #{} in spatial index: {}", product->data().id(),
+          e.what());
+      continue;
+    }
+    entry.id = product->data().id();
+    entries.push_back(entry);
+  }
+
+  tree_.build(std::move(entries));
+  LOG(info, "Spatial index is built over {} of {} products, height={}",
+      tree_.size(), total, tree_.height());
+  return tree_.size();
+}
+
+std::vector<uint32_t> SpatialIndex::search(const BoundingBox &box) const {
+  std::vector<uint32_t> ids;
+  tree_.search(box, &ids);
+  return ids;
+}
+
+std::vector<uint32_t> SpatialIndex::search(const double point[3]) const {
+  std::vector<uint32_t> ids;
+  tree_.search(point, &ids);
+  return ids;
+}
+
+std::vector<std::pair<double, uint32_t>> SpatialIndex::nearest(
+    const double point[3], size_t k) const {
+  std::vector<std::pair<double, uint32_t>> result;
+  tree_.nearest(point, k, &result);
+  return result;
+}
+
+void SpatialIndex::save(DataStoreSession *session,
+                        const std::string &key) const {
+  // 存储引擎的值是以 '\0' 结尾的字符串，二进制数据按十六进制保存
+  std::string data = tree_.serialize();
+  std::string hex(data.size() * 2 + 1, '\0');
+  bin_to_hex(data.data(), static_cast<int>(data.size()), &hex[0]);
+  hex.resize(data.size() * 2);
+  session->upsert_kv(key.c_str(), hex.c_str());
+}
+
+int SpatialIndex::load(DataStoreSession *session, const std::string &key) {
+  const char *hex = session->get(key.c_str());
+  if (hex == nullptr) {
+    return -1;
+  }
+  size_t len = strlen(hex);
+  if (len % 2 != 0) {
+    return -1;
+  }
+  std::string data(len / 2 + 1, '\0');
+  int data_len = 0;
+  hex_to_bin(hex, &data[0], &data_len);
+  data.resize(data_len);
+  return tree_.deserialize(data);
+}
+
+int SpatialIndex::save(const std::string &path) const {
+  std::string tmp_path = path + ".tmp";
+  std::string data = tree_.serialize();
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+    out.close();
+    if (!out) {
+      LOG(error, "Failed to write spatial index to {}", tmp_path);
+      std::remove(tmp_path.c_str());
+      return -1;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(error, "Failed to rename spatial index to {}, {}", path,
+        strerror(errno));
+    std::remove(tmp_path.c_str());
+    return -1;
+  }
+  return 0;
+}
+
+int SpatialIndex::load(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return -1;
+  }
+  std::string data((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  if (in.bad()) {
+    return -1;
+  }
+  return tree_.deserialize(data);
+}
+
+}  // namespace vulcan
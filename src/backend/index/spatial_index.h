@@ -0,0 +1,76 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "backend/index/rtree.h"
+
+namespace IfcParse {
+class IfcFile;
+}  // namespace IfcParse
+
+namespace vulcan {
+
+class DataStoreSession;
+
+/**
+ * @brief IfcProduct 几何包围盒上的空间索引。
+ *
+ * 包围盒由产品的 ObjectPlacement 链和 Representation 中的几何项计算：
+ * 映射项、拉伸体、旋转体、布尔运算和 IfcBoundingBox 按其参数求界，
+ * 其它几何项取 IfcFile::traverse 能到达的全部 IfcCartesianPoint。
+ * 对于常见的几何项结果是保守的(不小于真实包围盒)，曲线只按控制点求界。
+ * 坐标使用模型的长度单位。
+ */
+class SpatialIndex {
+ public:
+  SpatialIndex() = default;
+
+  /**
+   * @brief 计算 file 中所有 IfcProduct 的包围盒并装载 R-tree，替换已有内容。
+   * 需要读取模型，调用者需持有模型的锁。
+   * @return 建立索引的产品数，没有几何表示的产品不在索引中
+   */
+  size_t build(IfcParse::IfcFile *file);
+
+  const RTree &tree() const { return tree_; }
+  size_t size() const { return tree_.size(); }
+
+  // 与 box 相交的产品 id
+  std::vector<uint32_t> search(const BoundingBox &box) const;
+  // 包围盒包含 point 的产品 id
+  std::vector<uint32_t> search(const double point[3]) const;
+  // 包围盒离 point 最近的 k 个产品，按距离升序
+  std::vector<std::pair<double, uint32_t>> nearest(const double point[3],
+                                                   size_t k) const;
+
+  /**
+   * @brief 以 key 保存到存储引擎，值为序列化后的十六进制文本
+   */
+  void save(DataStoreSession *session, const std::string &key) const;
+
+  /**
+   * @brief 从存储引擎读取 save 保存的索引
+   * @return 0 成功，-1 不存在或格式错误
+   */
+  int load(DataStoreSession *session, const std::string &key);
+
+  /**
+   * @brief 把序列化后的索引写入文件，先写临时文件再改名，不会留下半个文件
+   * @return 0 成功，-1 写入失败
+   */
+  int save(const std::string &path) const;
+
+  /**
+   * @brief 从 save 写出的文件读取索引
+   * @return 0 成功，-1 不存在或格式错误
+   */
+  int load(const std::string &path);
+
+ private:
+  RTree tree_;
+};
+
+}  // namespace vulcan
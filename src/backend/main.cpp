@@ -6,12 +6,16 @@
 #include <iostream>
 
 #include "backend/pidfile.h"
+#include "backend/seda/execute_stage.h"
+#include "backend/seda/parse_stage.h"
+#include "backend/seda/resolve_stage.h"
 #include "backend/seda/seda_config.h"
 #include "backend/seda/session_stage.h"
 #include "backend/seda/stage_factory.h"
 #include "backend/server.h"
 #include "backend/vulcan_param.h"
 #include "common/defs.h"
+#include "common/lock_profiler.h"
 #include "common/os.h"
 #include "common/string.h"
 #include "common/vulcan_logger.h"
@@ -121,7 +125,7 @@ void init_parameter(int argc, char **argv) {
  */
 void *quit_thread_func(void *_signum) {
   intptr_t signum = (intptr_t)_signum;
-  LOG(info, "Receive signal: {}}", signum);
+  LOG(info, "Receive signal: {}", signum);
   if (g_server) {
     g_server->shutdown();
   }
@@ -162,6 +166,19 @@ void init_process(vulcan::VulcanParam *config) {
                         config->get_process_name() + std::to_string(getpid()),
                         config->get_log_level(),
                         config->get_console_log_level());
+    if (config->get(VULCAN_LOG_ASYNC) == "1") {
+      size_t queue_size = std::stoull(LOG_QUEUE_SIZE_DEFAULT);
+      vulcan::str_to_val(config->get(VULCAN_LOG_QUEUE_SIZE), queue_size);
+      vulcan::LogOverflowPolicy policy =
+          config->get(VULCAN_LOG_OVERFLOW) == "drop"
+              ? vulcan::LogOverflowPolicy::DROP
+              : vulcan::LogOverflowPolicy::BLOCK;
+      vulcan_logger->enable_async(queue_size, policy);
+    }
+
+    uint32_t lock_sample = vulcan::LockProfiler::DEFAULT_SAMPLE_PERIOD;
+    vulcan::str_to_val(config->get(VULCAN_LOCK_PROFILE_SAMPLE), lock_sample);
+    vulcan::LockProfiler::set_sample_period(lock_sample);
 
     // Initialize SEDA
     init_seda();
@@ -178,7 +195,7 @@ void init_server(vulcan::VulcanParam *config) {
   int64_t listen_addr = INADDR_ANY;
   int port = config->get_server_port();
 
-  int64_t max_connection_num;
+  int64_t max_connection_num = std::stoll(MAX_CONNECTION_NUM_DEFAULT);
   std::string conf_value = config->get(MAX_CONNECTION_NUM);
   if (!conf_value.empty()) {
     vulcan::str_to_val(conf_value, max_connection_num);
@@ -190,6 +207,13 @@ void init_server(vulcan::VulcanParam *config) {
   server_param.port = port;
   server_param.use_unix_socket = true;
   server_param.unix_socket_path = config->get(VULCAN_UNIX_SOCKET_PATH);
+  server_param.use_zerocopy = config->get(VULCAN_ZEROCOPY) == "1";
+  vulcan::str_to_val(config->get(VULCAN_IDLE_TIMEOUT),
+                     server_param.idle_timeout_sec);
+  vulcan::str_to_val(config->get(VULCAN_SHED_QUEUE_LEN),
+                     server_param.shed_queue_len);
+  vulcan::str_to_val(config->get(VULCAN_REQUEST_TIMEOUT),
+                     server_param.request_timeout_ms);
 
   vulcan::Server *server = new vulcan::Server(server_param);
   server->init();
@@ -202,14 +226,20 @@ void cleanup_process(vulcan::VulcanParam *config) {
   vulcan::removePidFile();
   // remove unix socket file
   std::filesystem::remove(config->get(VULCAN_UNIX_SOCKET_PATH));
+  // 写完异步队列中剩余的日志
+  vulcan::VulcanLogger::get_instance()->disable_async();
 }
 
 // 注册stage的工厂函数
 void init_seda() {
   static StageFactory session_stage_factory("SessionStage",
                                             &SessionStage::make_stage);
-  //   static StageFactory resolve_stage_factory("ResolveStage",
-  // &ResolveStage::make_stage);
+  static StageFactory parse_stage_factory("ParseStage",
+                                          &ParseStage::make_stage);
+  static StageFactory resolve_stage_factory("ResolveStage",
+                                            &ResolveStage::make_stage);
+  static StageFactory execute_stage_factory("ExecuteStage",
+                                            &ExecuteStage::make_stage);
 
   SedaConfig *seda = SedaConfig::get_instance();
   SedaConfig::status_t status = seda->init();
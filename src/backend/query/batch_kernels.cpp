@@ -0,0 +1,266 @@
+// Copyright 2023 VulcanDB
+#include "backend/query/batch_kernels.h"
+
+#include <stdio.h>
+#include <strings.h>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "backend/query/predicate.h"
+
+namespace vulcan {
+
+namespace {
+
+template <typename T, typename C, typename Cmp>
+void filter_loop(const T *values, const uint8_t *valid, C constant,
+                 uint8_t *mask, size_t rows, Cmp cmp) {
+  for (size_t i = 0; i < rows; i++) {
+    mask[i] &= valid[i] &
+               static_cast<uint8_t>(cmp(static_cast<C>(values[i]), constant));
+  }
+}
+
+template <typename T, typename C>
+void filter_values(const T *values, const uint8_t *valid, CompOp op,
+                   C constant, uint8_t *mask, size_t rows) {
+  switch (op) {
+    case CompOp::EQ:
+      filter_loop(values, valid, constant, mask, rows, std::equal_to<C>());
+      break;
+    case CompOp::NE:
+      filter_loop(values, valid, constant, mask, rows, std::not_equal_to<C>());
+      break;
+    case CompOp::LT:
+      filter_loop(values, valid, constant, mask, rows, std::less<C>());
+      break;
+    case CompOp::LE:
+      filter_loop(values, valid, constant, mask, rows, std::less_equal<C>());
+      break;
+    case CompOp::GT:
+      filter_loop(values, valid, constant, mask, rows, std::greater<C>());
+      break;
+    case CompOp::GE:
+      filter_loop(values, valid, constant, mask, rows,
+                  std::greater_equal<C>());
+      break;
+  }
+}
+
+void filter_strings(const Column &column, CompOp op, const QueryLiteral &value,
+                    uint8_t *mask) {
+  bool comparable = column.enumeration ? (value.kind == QueryLiteral::ENUM ||
+                                          value.kind == QueryLiteral::STRING)
+                                       : value.kind == QueryLiteral::STRING;
+  for (size_t i = 0; i < column.size(); i++) {
+    if (!mask[i]) {
+      continue;
+    }
+    if (!comparable || !column.valid[i]) {
+      mask[i] = 0;
+    } else if (column.enumeration) {
+      int cmp = strcasecmp(column.strings[i].c_str(), value.str_value.c_str());
+      mask[i] = compare(cmp, op, 0);
+    } else {
+      mask[i] = compare(column.strings[i], op, value.str_value);
+    }
+  }
+}
+
+/**
+ * 按 LANES 路独立累加，各路之间没有依赖，不需要 -ffast-math 也能被展开和
+ * 向量化；浮点求和的顺序在同一批数据上是确定的。
+ */
+template <typename T>
+void aggregate_loop(const T *values, const uint8_t *valid, const uint8_t *mask,
+                    size_t rows, int64_t *count, T *sum, T *min, T *max) {
+  constexpr size_t LANES = 4;
+  int64_t n[LANES] = {0};
+  T s[LANES] = {0};
+  T lo[LANES], hi[LANES];
+  std::fill(lo, lo + LANES, std::numeric_limits<T>::max());
+  std::fill(hi, hi + LANES, std::numeric_limits<T>::lowest());
+
+  size_t i = 0;
+  for (; i + LANES <= rows; i += LANES) {
+    for (size_t l = 0; l < LANES; l++) {
+      uint8_t selected = mask[i + l] & valid[i + l];
+      T v = values[i + l];
+      n[l] += selected;
+      s[l] += selected ? v : 0;
+      lo[l] = selected && v < lo[l] ? v : lo[l];
+      hi[l] = selected && v > hi[l] ? v : hi[l];
+    }
+  }
+  for (; i < rows; i++) {
+    uint8_t selected = mask[i] & valid[i];
+    T v = values[i];
+    n[0] += selected;
+    s[0] += selected ? v : 0;
+    lo[0] = selected && v < lo[0] ? v : lo[0];
+    hi[0] = selected && v > hi[0] ? v : hi[0];
+  }
+
+  *count = n[0] + n[1] + n[2] + n[3];
+  *sum = (s[0] + s[1]) + (s[2] + s[3]);
+  *min = std::min(std::min(lo[0], lo[1]), std::min(lo[2], lo[3]));
+  *max = std::max(std::max(hi[0], hi[1]), std::max(hi[2], hi[3]));
+}
+
+std::string format_double(double value) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.15g", value);
+  return buf;
+}
+
+}  // namespace
+
+void filter_column(const Column &column, CompOp op, const QueryLiteral &value,
+                   uint8_t *mask) {
+  size_t rows = column.size();
+  const uint8_t *valid = column.valid.data();
+  if (value.kind == QueryLiteral::NUL) {
+    // 空值只满足 = NULL，非空值只满足 != NULL
+    for (size_t i = 0; i < rows; i++) {
+      uint8_t is_null = valid[i] ^ 1;
+      mask[i] &= op == CompOp::EQ ? is_null : op == CompOp::NE ? valid[i] : 0;
+    }
+    return;
+  }
+
+  bool number = value.kind == QueryLiteral::INT ||
+                value.kind == QueryLiteral::REAL;
+  double real = value.kind == QueryLiteral::INT
+                    ? static_cast<double>(value.int_value)
+                    : value.real_value;
+  switch (column.type) {
+    case ColumnType::INT:
+      if (value.kind == QueryLiteral::INT) {
+        filter_values(column.ints.data(), valid, op, value.int_value, mask,
+                      rows);
+        return;
+      } else if (number) {
+        filter_values(column.ints.data(), valid, op, real, mask, rows);
+        return;
+      }
+      break;
+    case ColumnType::DOUBLE:
+      if (number) {
+        filter_values(column.doubles.data(), valid, op, real, mask, rows);
+        return;
+      }
+      break;
+    case ColumnType::BOOL:
+      if (value.kind == QueryLiteral::BOOL) {
+        filter_values(column.ints.data(), valid, op,
+                      static_cast<int64_t>(value.bool_value), mask, rows);
+        return;
+      }
+      break;
+    case ColumnType::REF:
+      if (value.kind == QueryLiteral::REF) {
+        filter_values(column.ints.data(), valid, op, value.int_value, mask,
+                      rows);
+        return;
+      }
+      break;
+    case ColumnType::STRING:
+      filter_strings(column, op, value, mask);
+      return;
+    case ColumnType::NUL:
+      break;
+  }
+  // 类型不匹配或整列为空，不满足
+  std::fill(mask, mask + rows, 0);
+}
+
+size_t count_selected(const uint8_t *mask, size_t rows) {
+  size_t count = 0;
+  for (size_t i = 0; i < rows; i++) {
+    count += mask[i];
+  }
+  return count;
+}
+
+int AggregateState::update(const Column *column, const uint8_t *mask,
+                           size_t rows) {
+  if (column == nullptr) {
+    count_ += count_selected(mask, rows);
+    return 0;
+  }
+  if (func_ == AggFunc::COUNT) {
+    for (size_t i = 0; i < rows; i++) {
+      count_ += mask[i] & column->valid[i];
+    }
+    return 0;
+  }
+  if (column->type == ColumnType::NUL) {
+    return 0;
+  }
+  if (!column->numeric()) {
+    return -1;
+  }
+
+  AggregateState batch(func_);
+  if (column->type == ColumnType::INT) {
+    int64_t sum, min, max;
+    aggregate_loop(column->ints.data(), column->valid.data(), mask, rows,
+                   &batch.count_, &sum, &min, &max);
+    batch.int_sum_ = sum;
+    batch.min_ = static_cast<double>(min);
+    batch.max_ = static_cast<double>(max);
+  } else {
+    aggregate_loop(column->doubles.data(), column->valid.data(), mask, rows,
+                   &batch.count_, &batch.double_sum_, &batch.min_,
+                   &batch.max_);
+    batch.has_double_ = true;
+  }
+  merge(batch);
+  return 0;
+}
+
+void AggregateState::merge(const AggregateState &other) {
+  if (other.count_ == 0) {
+    return;
+  }
+  if (count_ == 0 || func_ == AggFunc::COUNT) {
+    min_ = other.min_;
+    max_ = other.max_;
+  } else {
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+  count_ += other.count_;
+  int_sum_ += other.int_sum_;
+  double_sum_ += other.double_sum_;
+  has_double_ = has_double_ || other.has_double_;
+}
+
+std::string AggregateState::result() const {
+  if (func_ == AggFunc::COUNT) {
+    return std::to_string(count_);
+  }
+  if (count_ == 0) {
+    return "$";
+  }
+  switch (func_) {
+    case AggFunc::SUM:
+      if (!has_double_) {
+        return std::to_string(int_sum_);
+      }
+      return format_double(static_cast<double>(int_sum_) + double_sum_);
+    case AggFunc::AVG:
+      return format_double((static_cast<double>(int_sum_) + double_sum_) /
+                           static_cast<double>(count_));
+    case AggFunc::MIN:
+      return format_double(min_);
+    case AggFunc::MAX:
+      return format_double(max_);
+    default:
+      return "$";
+  }
+}
+
+}  // namespace vulcan
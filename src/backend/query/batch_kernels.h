@@ -0,0 +1,54 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "backend/query/column_batch.h"
+#include "backend/query/query_parser.h"
+
+namespace vulcan {
+
+/**
+ * 批处理的算子。选择结果用与批等长的字节掩码表示(1 为选中)，每个算子
+ * 对整批做一次无分支的循环，便于编译器向量化。
+ */
+
+/**
+ * @brief 用谓词过滤一列，结果与 mask 按位与。语义与逐行的 eval_predicate 一致。
+ */
+void filter_column(const Column &column, CompOp op, const QueryLiteral &value,
+                   uint8_t *mask);
+
+// 掩码中选中的行数
+size_t count_selected(const uint8_t *mask, size_t rows);
+
+/**
+ * @brief 一个聚合函数的中间状态，不同批(或不同 morsel)的状态可以合并
+ */
+class AggregateState {
+ public:
+  explicit AggregateState(AggFunc func = AggFunc::COUNT) : func_(func) {}
+
+  /**
+   * @brief 累加一批数据，column 为空表示 COUNT(*)
+   * @return 0 成功，-1 列不是数值类型而聚合函数要求数值
+   */
+  int update(const Column *column, const uint8_t *mask, size_t rows);
+
+  void merge(const AggregateState &other);
+
+  // 聚合结果，没有非空输入时 SUM/AVG/MIN/MAX 为 $
+  std::string result() const;
+
+ private:
+  AggFunc func_;
+  int64_t count_ = 0;      // 参与聚合的非空值个数
+  int64_t int_sum_ = 0;    // 整数列的和，保持精确
+  double double_sum_ = 0;  // 实数列的和
+  double min_ = 0;
+  double max_ = 0;
+  bool has_double_ = false;  // 出现过实数，结果按实数输出
+};
+
+}  // namespace vulcan
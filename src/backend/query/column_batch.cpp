@@ -0,0 +1,197 @@
+// Copyright 2023 VulcanDB
+#include "backend/query/column_batch.h"
+
+#include <stdio.h>
+
+#include "ifcparse/IfcFile.h"
+
+namespace vulcan {
+
+namespace {
+
+// SELECT 中包装的类型值(如 IfcLabel('x'))展开为其包装的值
+const Argument *unwrap(const Argument *arg) {
+  while (arg != nullptr && !arg->isNull() &&
+         arg->type() == IfcUtil::Argument_ENTITY_INSTANCE) {
+    IfcUtil::IfcBaseClass *instance = *arg;
+    if (instance->declaration().as_entity() != nullptr ||
+        instance->data().getArgumentCount() == 0) {
+      break;
+    }
+    arg = instance->data().getArgument(0);
+  }
+  return arg;
+}
+
+ColumnType column_type_of(const Argument *arg, bool *enumeration) {
+  if (arg == nullptr || arg->isNull()) {
+    return ColumnType::NUL;
+  }
+  switch (arg->type()) {
+    case IfcUtil::Argument_INT:
+      return ColumnType::INT;
+    case IfcUtil::Argument_DOUBLE:
+      return ColumnType::DOUBLE;
+    case IfcUtil::Argument_BOOL:
+      return ColumnType::BOOL;
+    case IfcUtil::Argument_LOGICAL: {
+      // UNKNOWN 按空值处理
+      boost::logic::tribool logical = *arg;
+      return boost::logic::indeterminate(logical) ? ColumnType::NUL
+                                                  : ColumnType::BOOL;
+    }
+    case IfcUtil::Argument_ENUMERATION:
+      *enumeration = true;
+      return ColumnType::STRING;
+    case IfcUtil::Argument_STRING:
+      *enumeration = false;
+      return ColumnType::STRING;
+    case IfcUtil::Argument_ENTITY_INSTANCE:
+      return ColumnType::REF;
+    default:
+      // 聚合、二进制等不能作为列
+      return ColumnType::NUL;
+  }
+}
+
+void load_column(IfcUtil::IfcBaseClass *const *instances, size_t count,
+                 int attribute, bool values, Column *column) {
+  std::vector<const Argument *> args(count);
+  std::vector<ColumnType> types(count);
+  column->type = ColumnType::NUL;
+  for (size_t i = 0; i < count; i++) {
+    bool enumeration = false;
+    args[i] = unwrap(instances[i]->data().getArgument(attribute));
+    types[i] = column_type_of(args[i], &enumeration);
+    if (types[i] == ColumnType::NUL) {
+      continue;
+    }
+    if (column->type == ColumnType::NUL) {
+      column->type = types[i];
+      column->enumeration = enumeration;
+    } else if (column->type != types[i] &&
+               (column->type == ColumnType::INT ||
+                column->type == ColumnType::DOUBLE) &&
+               (types[i] == ColumnType::INT ||
+                types[i] == ColumnType::DOUBLE)) {
+      column->type = ColumnType::DOUBLE;
+    }
+  }
+
+  column->valid.assign(count, 0);
+  if (!values) {
+    for (size_t i = 0; i < count; i++) {
+      column->valid[i] = types[i] != ColumnType::NUL;
+    }
+    return;
+  }
+  switch (column->type) {
+    case ColumnType::INT:
+    case ColumnType::BOOL:
+    case ColumnType::REF:
+      column->ints.assign(count, 0);
+      break;
+    case ColumnType::DOUBLE:
+      column->doubles.assign(count, 0);
+      break;
+    case ColumnType::STRING:
+      column->strings.resize(count);
+      break;
+    case ColumnType::NUL:
+      return;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    ColumnType type = types[i];
+    if (type == ColumnType::NUL) {
+      continue;
+    }
+    if (column->type == ColumnType::DOUBLE && type == ColumnType::INT) {
+      column->doubles[i] = static_cast<int>(*args[i]);
+      column->valid[i] = 1;
+      continue;
+    }
+    if (type != column->type) {
+      continue;
+    }
+    column->valid[i] = 1;
+    switch (type) {
+      case ColumnType::INT:
+        column->ints[i] = static_cast<int>(*args[i]);
+        break;
+      case ColumnType::DOUBLE:
+        column->doubles[i] = static_cast<double>(*args[i]);
+        break;
+      case ColumnType::BOOL:
+        if (args[i]->type() == IfcUtil::Argument_LOGICAL) {
+          boost::logic::tribool logical = *args[i];
+          column->ints[i] = static_cast<bool>(logical);
+        } else {
+          column->ints[i] = static_cast<bool>(*args[i]);
+        }
+        break;
+      case ColumnType::STRING:
+        column->strings[i] = static_cast<std::string>(*args[i]);
+        break;
+      case ColumnType::REF: {
+        IfcUtil::IfcBaseClass *instance = *args[i];
+        column->ints[i] = instance->data().id();
+        break;
+      }
+      case ColumnType::NUL:
+        break;
+    }
+  }
+}
+
+}  // namespace
+
+std::string Column::to_string(size_t row) const {
+  if (!valid[row]) {
+    return "$";
+  }
+  switch (type) {
+    case ColumnType::INT:
+      return std::to_string(ints[row]);
+    case ColumnType::DOUBLE: {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "%.15g", doubles[row]);
+      return buf;
+    }
+    case ColumnType::BOOL:
+      return ints[row] ? ".T." : ".F.";
+    case ColumnType::STRING: {
+      if (enumeration) {
+        return "." + strings[row] + ".";
+      }
+      std::string quoted = "'";
+      for (char c : strings[row]) {
+        quoted.push_back(c);
+        if (c == '\'') {
+          quoted.push_back(c);
+        }
+      }
+      return quoted + "'";
+    }
+    case ColumnType::REF:
+      return "#" + std::to_string(ints[row]);
+    case ColumnType::NUL:
+      break;
+  }
+  return "$";
+}
+
+void ColumnBatch::load(IfcUtil::IfcBaseClass *const *instances, size_t count,
+                       const std::vector<int> &attributes,
+                       const std::vector<uint8_t> &values) {
+  ids_.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    ids_[i] = instances[i]->data().id();
+  }
+  columns_.assign(attributes.size(), Column());
+  for (size_t c = 0; c < attributes.size(); c++) {
+    load_column(instances, count, attributes[c], values[c], &columns_[c]);
+  }
+}
+
+}  // namespace vulcan
@@ -0,0 +1,79 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace IfcUtil {
+class IfcBaseClass;
+}  // namespace IfcUtil
+
+namespace vulcan {
+
+/**
+ * @brief 列的物理类型，由属性值的 IfcUtil::ArgumentType 决定：
+ * INT -> INT，DOUBLE -> DOUBLE，BOOL/LOGICAL -> BOOL，STRING/ENUMERATION ->
+ * STRING，实体引用 -> REF(实例 id)。SELECT 中包装的类型值按其包装的值处理。
+ * 全部为空的列为 NUL。
+ */
+enum class ColumnType { NUL, INT, DOUBLE, BOOL, STRING, REF };
+
+/**
+ * @brief 一批实例的一个属性，按类型存放在连续的数组中，valid 为 0 表示空值。
+ *
+ * 同一列中出现整数和实数时统一为 DOUBLE，其他与列类型不一致的值
+ * (只会出现在 SELECT 类型的属性上)按空值处理。
+ */
+struct Column {
+  ColumnType type = ColumnType::NUL;
+  bool enumeration = false;          // STRING 列的值来自枚举
+  std::vector<int64_t> ints;         // INT、BOOL、REF
+  std::vector<double> doubles;       // DOUBLE
+  std::vector<std::string> strings;  // STRING
+  std::vector<uint8_t> valid;
+
+  size_t size() const { return valid.size(); }
+  bool numeric() const {
+    return type == ColumnType::INT || type == ColumnType::DOUBLE;
+  }
+  // 以 STEP 的格式输出一个值，空值为 $
+  std::string to_string(size_t row) const;
+};
+
+/**
+ * @brief 最多 BATCH_SIZE 个实例的若干属性，列的顺序与 load 的 attributes 一致
+ */
+class ColumnBatch {
+ public:
+  static constexpr size_t BATCH_SIZE = 1024;
+
+  size_t size() const { return ids_.size(); }
+  const std::vector<int64_t> &ids() const { return ids_; }
+  const Column &column(size_t i) const { return columns_[i]; }
+  size_t column_count() const { return columns_.size(); }
+
+  /**
+   * @brief 物化 instances 的指定属性，属性下标对应 getArgument。
+   * 读取属性会触发 IfcFile 的延迟解析，调用者需持有模型的锁。
+   * @param count 不超过 BATCH_SIZE
+   * @param values 与 attributes 等长，为 0 的列只计算类型和 valid，不转换值，
+   * 用于只参与 COUNT 或 NULL 判断的属性，避免解码字符串
+   */
+  void load(IfcUtil::IfcBaseClass *const *instances, size_t count,
+            const std::vector<int> &attributes,
+            const std::vector<uint8_t> &values);
+
+  // 测试和基准程序直接构造批数据
+  void set(std::vector<int64_t> &&ids, std::vector<Column> &&columns) {
+    ids_ = std::move(ids);
+    columns_ = std::move(columns);
+  }
+
+ private:
+  std::vector<int64_t> ids_;
+  std::vector<Column> columns_;
+};
+
+}  // namespace vulcan
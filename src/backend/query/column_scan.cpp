@@ -0,0 +1,188 @@
+// Copyright 2023 VulcanDB
+#include "backend/query/column_scan.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "backend/db.h"
+#include "ifcparse/IfcFile.h"
+
+namespace vulcan {
+
+ColumnScan::ColumnScan(const QueryPlan &plan, Db *db, int64_t max_rows)
+    : plan_(plan), db_(db) {
+  row_limit_ = plan.limit < 0 ? max_rows : std::min(plan.limit, max_rows);
+  for (const ResolvedPredicate &predicate : plan.predicates) {
+    predicate_columns_.push_back(
+        column_of(predicate.attribute_index,
+                  predicate.value.kind != QueryLiteral::NUL));
+  }
+  for (const PlanColumn &column : plan.columns) {
+    output_columns_.push_back(
+        column.attribute_index < 0
+            ? -1
+            : static_cast<int>(column_of(column.attribute_index,
+                                         column.func != AggFunc::COUNT)));
+  }
+}
+
+size_t ColumnScan::column_of(int attribute_index, bool values) {
+  auto it = std::find(attributes_.begin(), attributes_.end(), attribute_index);
+  if (it != attributes_.end()) {
+    size_t column = it - attributes_.begin();
+    values_[column] = values_[column] || values;
+    return column;
+  }
+  attributes_.push_back(attribute_index);
+  values_.push_back(values);
+  return attributes_.size() - 1;
+}
+
+int ColumnScan::init() {
+  int ret = 0;
+  db_->lock();
+  try {
+    IfcParse::IfcFile *file = db_->model();
+    aggregate_of_instance::ptr instances =
+        plan_.only ? file->instances_by_type_excl_subtypes(plan_.type)
+                   : file->instances_by_type(plan_.type);
+    if (instances) {
+      instances_.assign(instances->begin(), instances->end());
+    }
+    // 属性在第一次读取时才解析，这里在锁内一次解析完，之后 morsel 只读取
+    // 已解析的属性，可以不持有锁并发物化
+    for (IfcUtil::IfcBaseClass *instance : instances_) {
+      if (instance->data().getArgumentCount() > 0) {
+        instance->data().getArgument(0);
+      }
+    }
+  } catch (const std::exception &e) {
+    error_ = e.what();
+    ret = -1;
+  }
+  db_->unlock();
+
+  MorselResult empty;
+  for (const PlanColumn &column : plan_.columns) {
+    empty.aggregates.emplace_back(column.func);
+  }
+  results_.assign(morsel_count(), empty);
+  return ret;
+}
+
+void ColumnScan::run_morsel(size_t index) {
+  size_t begin = index * MORSEL_SIZE;
+  size_t end = std::min(begin + MORSEL_SIZE, instances_.size());
+  for (size_t offset = begin; offset < end; offset += ColumnBatch::BATCH_SIZE) {
+    ColumnBatch batch;
+    size_t count = std::min(ColumnBatch::BATCH_SIZE, end - offset);
+    try {
+      batch.load(&instances_[offset], count, attributes_, values_);
+    } catch (const std::exception &e) {
+      results_[index].error = e.what();
+      return;
+    }
+
+    if (process(batch, index) != 0) {
+      return;
+    }
+    // 多取一行用于判断结果是否被截断
+    if (!plan_.aggregate &&
+        static_cast<int64_t>(results_[index].rows.size()) > row_limit_) {
+      return;
+    }
+  }
+}
+
+int ColumnScan::process(const ColumnBatch &batch, size_t morsel) {
+  MorselResult &result = results_[morsel];
+  std::vector<uint8_t> mask(batch.size(), 1);
+  for (size_t i = 0; i < plan_.predicates.size(); i++) {
+    const ResolvedPredicate &predicate = plan_.predicates[i];
+    filter_column(batch.column(predicate_columns_[i]), predicate.op,
+                  predicate.value, mask.data());
+  }
+
+  if (plan_.aggregate) {
+    for (size_t i = 0; i < output_columns_.size(); i++) {
+      const Column *column = output_columns_[i] < 0
+                                 ? nullptr
+                                 : &batch.column(output_columns_[i]);
+      if (result.aggregates[i].update(column, mask.data(), batch.size()) !=
+          0) {
+        result.error = plan_.columns[i].name + " requires a numeric attribute";
+        return -1;
+      }
+    }
+    return 0;
+  }
+
+  for (size_t row = 0; row < batch.size(); row++) {
+    if (!mask[row]) {
+      continue;
+    }
+    if (static_cast<int64_t>(result.rows.size()) > row_limit_) {
+      break;
+    }
+    std::string line = "#" + std::to_string(batch.ids()[row]);
+    for (int column : output_columns_) {
+      line += ", " + batch.column(column).to_string(row);
+    }
+    result.rows.push_back(std::move(line));
+  }
+  return 0;
+}
+
+int ColumnScan::finish(std::string *result) {
+  for (const MorselResult &morsel : results_) {
+    if (!morsel.error.empty()) {
+      error_ = morsel.error;
+      return -1;
+    }
+  }
+
+  std::stringstream ss;
+  if (plan_.aggregate) {
+    for (size_t i = 0; i < plan_.columns.size(); i++) {
+      ss << (i == 0 ? "" : ", ") << plan_.columns[i].name;
+    }
+    ss << "\n";
+    for (size_t i = 0; i < plan_.columns.size(); i++) {
+      AggregateState state(plan_.columns[i].func);
+      for (const MorselResult &morsel : results_) {
+        state.merge(morsel.aggregates[i]);
+      }
+      ss << (i == 0 ? "" : ", ") << state.result();
+    }
+    ss << "\n(1 rows)\n";
+    *result = ss.str();
+    return 0;
+  }
+
+  ss << "#id";
+  for (const PlanColumn &column : plan_.columns) {
+    ss << ", " << column.name;
+  }
+  ss << "\n";
+  int64_t count = 0;
+  bool truncated = false;
+  for (const MorselResult &morsel : results_) {
+    for (const std::string &row : morsel.rows) {
+      if (count == row_limit_) {
+        truncated = true;
+        break;
+      }
+      ss << row << "\n";
+      count++;
+    }
+  }
+  ss << "(" << count << " rows";
+  if (truncated && plan_.limit != row_limit_) {
+    ss << ", truncated";
+  }
+  ss << ")\n";
+  *result = ss.str();
+  return 0;
+}
+
+}  // namespace vulcan
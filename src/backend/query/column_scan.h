@@ -0,0 +1,82 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "backend/query/batch_kernels.h"
+#include "backend/query/query_plan.h"
+
+namespace IfcUtil {
+class IfcBaseClass;
+}  // namespace IfcUtil
+
+namespace vulcan {
+
+class Db;
+
+/**
+ * @brief 列查询的向量化执行。
+ *
+ * 实例按 morsel(MORSEL_BATCHES 个批)划分，每个 morsel 独立地物化、过滤并
+ * 计算投影或部分聚合，不同 morsel 可以在不同线程上并发执行，全部完成后由
+ * finish 按 morsel 顺序合并。init 在 Db 的锁内收集实例并解析它们的属性，
+ * 之后模型在查询期间只读，morsel 的物化、过滤和聚合都不持有锁。
+ */
+class ColumnScan {
+ public:
+  static constexpr size_t MORSEL_BATCHES = 8;
+  static constexpr size_t MORSEL_SIZE =
+      MORSEL_BATCHES * ColumnBatch::BATCH_SIZE;
+
+  ColumnScan(const QueryPlan &plan, Db *db, int64_t max_rows);
+
+  /**
+   * @brief 收集 plan.type 的实例并解析它们的属性
+   * @return 0 成功，-1 失败，错误信息由 error() 返回
+   */
+  int init();
+
+  size_t morsel_count() const {
+    return (instances_.size() + MORSEL_SIZE - 1) / MORSEL_SIZE;
+  }
+  size_t instance_count() const { return instances_.size(); }
+
+  // 执行第 index 个 morsel，不同 morsel 可以并发执行
+  void run_morsel(size_t index);
+
+  /**
+   * @brief 所有 morsel 完成后合并结果
+   * @return 0 成功，-1 执行失败，错误信息由 error() 返回
+   */
+  int finish(std::string *result);
+
+  const std::string &error() const { return error_; }
+
+  // 处理一个已物化的批，列的顺序与 load_attributes() 一致
+  int process(const ColumnBatch &batch, size_t morsel);
+  const std::vector<int> &load_attributes() const { return attributes_; }
+
+ private:
+  struct MorselResult {
+    std::vector<AggregateState> aggregates;
+    std::vector<std::string> rows;
+    std::string error;
+  };
+
+  // 属性下标在 attributes_ 中的位置，不存在时追加；values 表示需要属性的值
+  size_t column_of(int attribute_index, bool values);
+
+  const QueryPlan &plan_;
+  Db *db_;
+  int64_t row_limit_;  // 投影输出的最多行数
+  std::vector<IfcUtil::IfcBaseClass *> instances_;
+  std::vector<int> attributes_;          // 需要物化的属性
+  std::vector<uint8_t> values_;          // 属性是否需要物化值
+  std::vector<size_t> predicate_columns_;  // 每个谓词对应的列
+  std::vector<int> output_columns_;        // 每个输出列对应的列，-1 为 *
+  std::vector<MorselResult> results_;
+  std::string error_;
+};
+
+}  // namespace vulcan
@@ -0,0 +1,90 @@
+// Copyright 2023 VulcanDB
+#include "backend/query/predicate.h"
+
+#include <strings.h>
+
+#include <string>
+
+#include "ifcparse/IfcFile.h"
+
+namespace vulcan {
+
+namespace {
+
+bool compare_number(double left, CompOp op, const QueryLiteral &value) {
+  if (value.kind == QueryLiteral::INT) {
+    return compare(left, op, static_cast<double>(value.int_value));
+  }
+  if (value.kind == QueryLiteral::REAL) {
+    return compare(left, op, value.real_value);
+  }
+  return false;
+}
+
+}  // namespace
+
+bool eval_predicate(const Argument *arg, CompOp op, const QueryLiteral &value) {
+  if (arg == nullptr || arg->isNull()) {
+    return value.kind == QueryLiteral::NUL && op == CompOp::EQ;
+  }
+  if (value.kind == QueryLiteral::NUL) {
+    return op == CompOp::NE;
+  }
+
+  switch (arg->type()) {
+    case IfcUtil::Argument_INT:
+      if (value.kind == QueryLiteral::INT) {
+        return compare(static_cast<int64_t>(static_cast<int>(*arg)), op,
+                       value.int_value);
+      }
+      return compare_number(static_cast<int>(*arg), op, value);
+    case IfcUtil::Argument_DOUBLE:
+      return compare_number(static_cast<double>(*arg), op, value);
+    case IfcUtil::Argument_STRING:
+      if (value.kind != QueryLiteral::STRING) {
+        return false;
+      }
+      return compare(static_cast<std::string>(*arg), op, value.str_value);
+    case IfcUtil::Argument_ENUMERATION: {
+      if (value.kind != QueryLiteral::ENUM &&
+          value.kind != QueryLiteral::STRING) {
+        return false;
+      }
+      std::string item = *arg;
+      int cmp = strcasecmp(item.c_str(), value.str_value.c_str());
+      return compare(cmp, op, 0);
+    }
+    case IfcUtil::Argument_BOOL:
+      if (value.kind != QueryLiteral::BOOL) {
+        return false;
+      }
+      return compare(static_cast<bool>(*arg), op, value.bool_value);
+    case IfcUtil::Argument_LOGICAL: {
+      boost::logic::tribool logical = *arg;
+      if (value.kind != QueryLiteral::BOOL ||
+          boost::logic::indeterminate(logical)) {
+        return false;
+      }
+      return compare(static_cast<bool>(logical), op, value.bool_value);
+    }
+    case IfcUtil::Argument_ENTITY_INSTANCE: {
+      IfcUtil::IfcBaseClass *instance = *arg;
+      if (instance->declaration().as_entity() == nullptr) {
+        // SELECT 中的类型值，如 IfcLabel('x')，与其包装的值比较
+        if (instance->data().getArgumentCount() == 0) {
+          return false;
+        }
+        return eval_predicate(instance->data().getArgument(0), op, value);
+      }
+      if (value.kind != QueryLiteral::REF) {
+        return false;
+      }
+      return compare(static_cast<int64_t>(instance->data().id()), op,
+                     value.int_value);
+    }
+    default:
+      return false;
+  }
+}
+
+}  // namespace vulcan
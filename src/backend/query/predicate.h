@@ -0,0 +1,38 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include "backend/query/query_parser.h"
+
+class Argument;
+
+namespace vulcan {
+
+template <typename T>
+inline bool compare(const T &left, CompOp op, const T &right) {
+  switch (op) {
+    case CompOp::EQ:
+      return left == right;
+    case CompOp::NE:
+      return left != right;
+    case CompOp::LT:
+      return left < right;
+    case CompOp::LE:
+      return left <= right;
+    case CompOp::GT:
+      return left > right;
+    case CompOp::GE:
+      return left >= right;
+  }
+  return false;
+}
+
+/**
+ * @brief 逐行判断实例的一个属性是否满足谓词。
+ *
+ * 属性为空($)时只满足 = NULL，非空属性只满足 != NULL。整数与实数可以互相
+ * 比较，枚举不区分大小写，实体引用按 id 与 #id 比较，SELECT 中包装的类型值
+ * (如 IfcLabel('x'))按其包装的值比较。其余类型不匹配时不满足。
+ */
+bool eval_predicate(const Argument *arg, CompOp op, const QueryLiteral &value);
+
+}  // namespace vulcan
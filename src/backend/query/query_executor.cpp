@@ -0,0 +1,262 @@
+// Copyright 2023 VulcanDB
+#include "backend/query/query_executor.h"
+
+#include <filesystem>
+#include <sstream>
+#include <unordered_set>
+
+#include "backend/db.h"
+#include "backend/index/spatial_index.h"
+#include "backend/query/predicate.h"
+#include "backend/session.h"
+#include "common/vulcan_logger.h"
+#include "ifcparse/IfcFile.h"
+
+namespace vulcan {
+
+int QueryExecutor::execute(const QueryPlan &plan, Session *session,
+                           std::string *result) {
+  error_.clear();
+  switch (plan.kind) {
+    case Query::OPEN:
+      return execute_open(plan, session, result);
+    case Query::USE:
+      return execute_use(plan, session, result);
+    case Query::SELECT:
+      break;
+  }
+
+  if (!plan.columns.empty()) {
+    std::unique_ptr<ColumnScan> scan;
+    if (prepare_scan(plan, session, &scan) != 0) {
+      return -1;
+    }
+    for (size_t i = 0; i < scan->morsel_count(); i++) {
+      scan->run_morsel(i);
+    }
+    if (scan->finish(result) != 0) {
+      error_ = scan->error();
+      return -1;
+    }
+    return 0;
+  }
+
+  Db *db = session->get_current_db();
+  if (db == nullptr || db->model() == nullptr) {
+    error_ = "no model is in use, OPEN or USE a model first";
+    return -1;
+  }
+
+  int ret = 0;
+  db->lock();
+  try {
+    ret = execute_select(plan, db, result);
+  } catch (const std::exception &e) {
+    error_ = e.what();
+    ret = -1;
+  }
+  db->unlock();
+  return ret;
+}
+
+int QueryExecutor::prepare_scan(const QueryPlan &plan, Session *session,
+                                std::unique_ptr<ColumnScan> *scan) {
+  error_.clear();
+  Db *db = session->get_current_db();
+  if (db == nullptr || db->model() == nullptr) {
+    error_ = "no model is in use, OPEN or USE a model first";
+    return -1;
+  }
+  scan->reset(new ColumnScan(plan, db, MAX_ROWS));
+  if ((*scan)->init() != 0) {
+    error_ = (*scan)->error();
+    return -1;
+  }
+  return 0;
+}
+
+int QueryExecutor::execute_open(const QueryPlan &plan, Session *session,
+                                std::string *result) {
+  std::string name = plan.model_name;
+  if (name.empty()) {
+    name = std::filesystem::path(plan.path_name).stem().string();
+  }
+
+  Db *db = nullptr;
+  try {
+    db = DbManager::get_instance()->open(name, plan.path_name);
+  } catch (const std::exception &e) {
+    LOG(warn, "Failed to open {}: {}", plan.path_name, e.what());
+    error_ = e.what();
+    return -1;
+  }
+  session->set_current_db(name);
+
+  std::stringstream ss;
+  ss << "OK, model " << name << " is opened from " << db->path() << "\n";
+  *result = ss.str();
+  return 0;
+}
+
+int QueryExecutor::execute_use(const QueryPlan &plan, Session *session,
+                               std::string *result) {
+  if (!session->set_current_db(plan.model_name)) {
+    error_ = "model " + plan.model_name + " is not opened";
+    return -1;
+  }
+  *result = "OK, use model " + plan.model_name + "\n";
+  return 0;
+}
+
+bool QueryExecutor::match_all(IfcUtil::IfcBaseClass *instance,
+                              const QueryPlan &plan) {
+  for (const ResolvedPredicate &predicate : plan.predicates) {
+    const Argument *arg =
+        instance->data().getArgument(predicate.attribute_index);
+    if (!eval_predicate(arg, predicate.op, predicate.value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void QueryExecutor::follow(IfcParse::IfcFile *file, const NavigationStep &step,
+                           IfcUtil::IfcBaseClass *instance,
+                           InstanceList *to) {
+  if (step.kind == NavigationStep::DYNAMIC) {
+    const IfcParse::entity *entity = instance->declaration().as_entity();
+    if (entity == nullptr) {
+      return;
+    }
+    auto it = dynamic_steps_.find(entity);
+    if (it == dynamic_steps_.end()) {
+      NavigationStep resolved;
+      const IfcParse::entity *next = nullptr;
+      if (!QueryResolver::resolve_step(entity, step.name, &resolved, &next)) {
+        resolved.kind = NavigationStep::DYNAMIC;  // 该类型上没有这个属性
+      }
+      it = dynamic_steps_.emplace(entity, resolved).first;
+    }
+    if (it->second.kind != NavigationStep::DYNAMIC) {
+      follow(file, it->second, instance, to);
+    }
+    return;
+  }
+
+  if (step.kind == NavigationStep::INVERSE) {
+    const IfcParse::entity *from = step.inverse->entity_reference();
+    int index = static_cast<int>(
+        from->attribute_index(step.inverse->attribute_reference()));
+    aggregate_of_instance::ptr refs =
+        file->getInverse(instance->data().id(), from, index);
+    if (refs) {
+      to->insert(to->end(), refs->begin(), refs->end());
+    }
+    return;
+  }
+
+  const Argument *arg = instance->data().getArgument(step.attribute_index);
+  if (arg == nullptr || arg->isNull()) {
+    return;
+  }
+  switch (arg->type()) {
+    case IfcUtil::Argument_ENTITY_INSTANCE: {
+      IfcUtil::IfcBaseClass *target = *arg;
+      to->push_back(target);
+      break;
+    }
+    case IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE: {
+      aggregate_of_instance::ptr targets = *arg;
+      to->insert(to->end(), targets->begin(), targets->end());
+      break;
+    }
+    case IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_ENTITY_INSTANCE: {
+      aggregate_of_aggregate_of_instance::ptr targets = *arg;
+      for (auto outer = targets->begin(); outer != targets->end(); ++outer) {
+        to->insert(to->end(), outer->begin(), outer->end());
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void QueryExecutor::navigate(IfcParse::IfcFile *file,
+                             const NavigationStep &step,
+                             const InstanceList &from, InstanceList *to) {
+  InstanceList targets;
+  for (IfcUtil::IfcBaseClass *instance : from) {
+    follow(file, step, instance, &targets);
+  }
+
+  // 多个实例可能指向同一个目标，按首次出现的顺序去重
+  std::unordered_set<IfcUtil::IfcBaseClass *> seen;
+  for (IfcUtil::IfcBaseClass *target : targets) {
+    // SELECT 中的类型值(如 IfcLabel)不是实体实例，不作为导航结果
+    if (target->declaration().as_entity() != nullptr &&
+        seen.insert(target).second) {
+      to->push_back(target);
+    }
+  }
+}
+
+int QueryExecutor::execute_select(const QueryPlan &plan, Db *db,
+                                  std::string *result) {
+  IfcParse::IfcFile *file = db->model();
+  // WITHIN 先由空间索引得到候选产品，再按类型和谓词过滤
+  std::unordered_set<uint32_t> within;
+  if (plan.within) {
+    const double *b = plan.within_box;
+    BoundingBox box(b[0], b[1], b[2], b[3], b[4], b[5]);
+    std::vector<uint32_t> ids = db->spatial_index().search(box);
+    within.insert(ids.begin(), ids.end());
+  }
+
+  int64_t limit = plan.limit < 0 ? MAX_ROWS : std::min(plan.limit, MAX_ROWS);
+  // 没有导航时可以在过滤阶段提前结束
+  size_t source_limit = plan.path.empty() ? limit : SIZE_MAX;
+
+  InstanceList rows;
+  if (plan.type != nullptr) {
+    aggregate_of_instance::ptr instances =
+        plan.only ? file->instances_by_type_excl_subtypes(plan.type)
+                  : file->instances_by_type(plan.type);
+    if (instances) {
+      for (IfcUtil::IfcBaseClass *instance : *instances) {
+        if (rows.size() >= source_limit) {
+          break;
+        }
+        if (plan.within && within.count(instance->data().id()) == 0) {
+          continue;
+        }
+        if (match_all(instance, plan)) {
+          rows.push_back(instance);
+        }
+      }
+    }
+  } else {
+    rows.push_back(file->instance_by_id(plan.instance_id));
+  }
+
+  for (const NavigationStep &step : plan.path) {
+    InstanceList next;
+    navigate(file, step, rows, &next);
+    rows.swap(next);
+  }
+
+  std::stringstream ss;
+  size_t count = std::min(rows.size(), static_cast<size_t>(limit));
+  for (size_t i = 0; i < count; i++) {
+    ss << rows[i]->data().toString() << "\n";
+  }
+  ss << "(" << count << " rows";
+  if (count < rows.size() && (plan.limit < 0 || plan.limit > MAX_ROWS)) {
+    ss << ", truncated from " << rows.size();
+  }
+  ss << ")\n";
+  *result = ss.str();
+  return 0;
+}
+
+}  // namespace vulcan
@@ -0,0 +1,69 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "backend/query/column_scan.h"
+#include "backend/query/query_plan.h"
+
+namespace IfcParse {
+class IfcFile;
+}  // namespace IfcParse
+
+namespace IfcUtil {
+class IfcBaseClass;
+}  // namespace IfcUtil
+
+namespace vulcan {
+
+class Db;
+class Session;
+
+/**
+ * @brief 在会话当前的数据库上执行已解析的查询，结果为文本形式。
+ *
+ * 每行输出一个实例的 STEP 表示，最后一行为结果行数。执行期间持有 Db 的锁。
+ */
+class QueryExecutor {
+ public:
+  // 单条查询最多返回的行数，LIMIT 更大时同样截断
+  static constexpr int64_t MAX_ROWS = 10000;
+
+  /**
+   * @return 0 成功，-1 执行失败，错误信息由 error() 返回
+   */
+  int execute(const QueryPlan &plan, Session *session, std::string *result);
+
+  /**
+   * @brief 为列查询创建 ColumnScan，调用者可以把 morsel 分发到多个线程
+   * @return 0 成功，-1 失败，错误信息由 error() 返回
+   */
+  int prepare_scan(const QueryPlan &plan, Session *session,
+                   std::unique_ptr<ColumnScan> *scan);
+
+  const std::string &error() const { return error_; }
+
+ private:
+  typedef std::vector<IfcUtil::IfcBaseClass *> InstanceList;
+
+  int execute_open(const QueryPlan &plan, Session *session,
+                   std::string *result);
+  int execute_use(const QueryPlan &plan, Session *session,
+                  std::string *result);
+  int execute_select(const QueryPlan &plan, Db *db, std::string *result);
+
+  bool match_all(IfcUtil::IfcBaseClass *instance, const QueryPlan &plan);
+  void navigate(IfcParse::IfcFile *file, const NavigationStep &step,
+                const InstanceList &from, InstanceList *to);
+  void follow(IfcParse::IfcFile *file, const NavigationStep &step,
+              IfcUtil::IfcBaseClass *instance, InstanceList *to);
+
+  std::string error_;
+  // DYNAMIC 导航按实例的实际类型解析，同一类型只解析一次
+  std::unordered_map<const IfcParse::entity *, NavigationStep> dynamic_steps_;
+};
+
+}  // namespace vulcan
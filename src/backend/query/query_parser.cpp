@@ -0,0 +1,435 @@
+// Copyright 2023 VulcanDB
+#include "backend/query/query_parser.h"
+
+#include <ctype.h>
+#include <strings.h>
+
+#include <cstdlib>
+#include <sstream>
+#include <utility>
+
+namespace vulcan {
+
+std::string QueryLiteral::to_string() const {
+  std::stringstream ss;
+  switch (kind) {
+    case NUL:
+      ss << "NULL";
+      break;
+    case INT:
+      ss << int_value;
+      break;
+    case REAL:
+      ss << real_value;
+      break;
+    case STRING:
+      ss << "'" << str_value << "'";
+      break;
+    case ENUM:
+      ss << "." << str_value << ".";
+      break;
+    case BOOL:
+      ss << (bool_value ? "TRUE" : "FALSE");
+      break;
+    case REF:
+      ss << "#" << int_value;
+      break;
+  }
+  return ss.str();
+}
+
+int QueryParser::fail(const std::string &message) {
+  std::stringstream ss;
+  ss << message;
+  if (pos_ < tokens_.size()) {
+    ss << " at position " << tokens_[pos_].pos;
+  }
+  error_ = ss.str();
+  return -1;
+}
+
+int QueryParser::tokenize(const std::string &text) {
+  tokens_.clear();
+  size_t i = 0;
+  while (i < text.size()) {
+    char c = text[i];
+    if (isspace(static_cast<unsigned char>(c))) {
+      i++;
+      continue;
+    }
+
+    Token token;
+    token.pos = i;
+    if (isalpha(static_cast<unsigned char>(c)) || c == '_') {
+      size_t start = i;
+      while (i < text.size() &&
+             (isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_')) {
+        i++;
+      }
+      token.type = Token::IDENT;
+      token.text = text.substr(start, i - start);
+    } else if (isdigit(static_cast<unsigned char>(c)) ||
+               ((c == '-' || c == '.') && i + 1 < text.size() &&
+                isdigit(static_cast<unsigned char>(text[i + 1])))) {
+      size_t start = i;
+      i++;
+      bool real = c == '.';
+      while (i < text.size() &&
+             (isdigit(static_cast<unsigned char>(text[i])) || text[i] == '.' ||
+              text[i] == 'e' || text[i] == 'E' ||
+              ((text[i] == '-' || text[i] == '+') &&
+               (text[i - 1] == 'e' || text[i - 1] == 'E')))) {
+        real = real || !isdigit(static_cast<unsigned char>(text[i]));
+        i++;
+      }
+      token.type = real ? Token::REAL : Token::INT;
+      token.text = text.substr(start, i - start);
+    } else if (c == '\'') {
+      // '' 表示字符串中的单引号
+      i++;
+      bool closed = false;
+      while (i < text.size()) {
+        if (text[i] == '\'') {
+          if (i + 1 < text.size() && text[i + 1] == '\'') {
+            token.text.push_back('\'');
+            i += 2;
+            continue;
+          }
+          closed = true;
+          i++;
+          break;
+        }
+        token.text.push_back(text[i++]);
+      }
+      if (!closed) {
+        error_ = "unterminated string at position " + std::to_string(token.pos);
+        return -1;
+      }
+      token.type = Token::STRING;
+    } else if (c == '.') {
+      size_t end = text.find('.', i + 1);
+      if (end == std::string::npos || end == i + 1) {
+        error_ = "invalid enumeration at position " + std::to_string(i);
+        return -1;
+      }
+      token.type = Token::ENUM;
+      token.text = text.substr(i + 1, end - i - 1);
+      i = end + 1;
+    } else if (c == '#') {
+      size_t start = ++i;
+      while (i < text.size() && isdigit(static_cast<unsigned char>(text[i]))) {
+        i++;
+      }
+      if (start == i) {
+        error_ = "expect instance id after '#' at position " +
+                 std::to_string(token.pos);
+        return -1;
+      }
+      token.type = Token::REF;
+      token.text = text.substr(start, i - start);
+    } else if (c == '-' && i + 1 < text.size() && text[i + 1] == '>') {
+      token.type = Token::ARROW;
+      token.text = "->";
+      i += 2;
+    } else if (c == '=' || c == '<' || c == '>' || c == '!') {
+      token.type = Token::OP;
+      token.text.push_back(c);
+      i++;
+      if (i < text.size() && (text[i] == '=' || (c == '<' && text[i] == '>'))) {
+        token.text.push_back(text[i++]);
+      }
+      if (token.text == "!") {
+        error_ = "unexpected '!' at position " + std::to_string(token.pos);
+        return -1;
+      }
+    } else if (c == ';' || c == '(' || c == ')' || c == ',' || c == '*') {
+      token.type = c == ';'   ? Token::SEMICOLON
+                   : c == '(' ? Token::LPAREN
+                   : c == ')' ? Token::RPAREN
+                   : c == ',' ? Token::COMMA
+                              : Token::STAR;
+      token.text.push_back(c);
+      i++;
+    } else {
+      error_ = std::string("unexpected character '") + c + "' at position " +
+               std::to_string(i);
+      return -1;
+    }
+    tokens_.push_back(token);
+  }
+
+  Token end;
+  end.type = Token::END;
+  end.pos = text.size();
+  tokens_.push_back(end);
+  return 0;
+}
+
+bool QueryParser::accept_keyword(const char *keyword) {
+  if (peek().type == Token::IDENT &&
+      strcasecmp(peek().text.c_str(), keyword) == 0) {
+    pos_++;
+    return true;
+  }
+  return false;
+}
+
+bool QueryParser::expect_end() {
+  if (peek().type == Token::SEMICOLON) {
+    pos_++;
+  }
+  return peek().type == Token::END;
+}
+
+int QueryParser::parse(const std::string &text, Query *query) {
+  error_.clear();
+  pos_ = 0;
+  if (tokenize(text) != 0) {
+    return -1;
+  }
+
+  if (accept_keyword("SELECT")) {
+    query->kind = Query::SELECT;
+    if (parse_select(&query->select) != 0) {
+      return -1;
+    }
+  } else if (accept_keyword("OPEN")) {
+    query->kind = Query::OPEN;
+    if (peek().type != Token::STRING) {
+      return fail("expect quoted file path after OPEN");
+    }
+    query->path = next().text;
+    if (accept_keyword("AS")) {
+      if (peek().type != Token::IDENT) {
+        return fail("expect model name after AS");
+      }
+      query->name = next().text;
+    }
+  } else if (accept_keyword("USE")) {
+    query->kind = Query::USE;
+    if (peek().type != Token::IDENT) {
+      return fail("expect model name after USE");
+    }
+    query->name = next().text;
+  } else {
+    return fail("expect SELECT, OPEN or USE");
+  }
+
+  if (!expect_end()) {
+    return fail("unexpected '" + peek().text + "'");
+  }
+  return 0;
+}
+
+int QueryParser::parse_select_items(SelectQuery *select) {
+  static const std::pair<const char *, AggFunc> funcs[] = {
+      {"COUNT", AggFunc::COUNT}, {"SUM", AggFunc::SUM}, {"AVG", AggFunc::AVG},
+      {"MIN", AggFunc::MIN},     {"MAX", AggFunc::MAX}};
+
+  do {
+    if (peek().type != Token::IDENT) {
+      return fail("expect attribute or aggregate in select list");
+    }
+    SelectItem item;
+    if (peek(1).type == Token::LPAREN) {
+      const std::string &name = next().text;
+      for (const auto &func : funcs) {
+        if (strcasecmp(name.c_str(), func.first) == 0) {
+          item.func = func.second;
+        }
+      }
+      if (item.func == AggFunc::NONE) {
+        pos_--;
+        return fail("unknown aggregate function '" + name + "'");
+      }
+      pos_++;  // (
+      if (peek().type == Token::STAR && item.func == AggFunc::COUNT) {
+        pos_++;
+      } else if (peek().type == Token::IDENT) {
+        item.attribute = next().text;
+      } else {
+        return fail("expect attribute name in aggregate");
+      }
+      if (peek().type != Token::RPAREN) {
+        return fail("expect ')'");
+      }
+      pos_++;
+    } else {
+      item.attribute = next().text;
+    }
+    select->items.push_back(item);
+    if (peek().type != Token::COMMA) {
+      break;
+    }
+    pos_++;
+  } while (true);
+
+  if (!accept_keyword("FROM")) {
+    return fail("expect FROM after select list");
+  }
+  select->only = accept_keyword("ONLY");
+  if (peek().type != Token::IDENT) {
+    return fail("expect entity type after FROM");
+  }
+  select->type_name = next().text;
+  return 0;
+}
+
+int QueryParser::parse_select(SelectQuery *select) {
+  // SELECT 后紧跟 '('、',' 或 FROM 说明是列查询
+  bool columns = peek().type == Token::IDENT &&
+                 (peek(1).type == Token::LPAREN ||
+                  peek(1).type == Token::COMMA ||
+                  (peek(1).type == Token::IDENT &&
+                   strcasecmp(peek(1).text.c_str(), "FROM") == 0));
+  if (columns) {
+    if (parse_select_items(select) != 0) {
+      return -1;
+    }
+  } else {
+    select->only = accept_keyword("ONLY");
+    if (peek().type == Token::IDENT) {
+      select->type_name = next().text;
+    } else if (peek().type == Token::REF) {
+      select->instance_id = atoi(next().text.c_str());
+    } else {
+      return fail("expect entity type or #id after SELECT");
+    }
+  }
+
+  if (accept_keyword("WHERE")) {
+    do {
+      QueryPredicate predicate;
+      if (parse_predicate(&predicate) != 0) {
+        return -1;
+      }
+      select->predicates.push_back(predicate);
+    } while (accept_keyword("AND"));
+  }
+
+  if (accept_keyword("WITHIN")) {
+    if (!select->items.empty()) {
+      return fail("WITHIN is not supported in a column query");
+    }
+    if (parse_within(select) != 0) {
+      return -1;
+    }
+  }
+
+  while (peek().type == Token::ARROW) {
+    if (!select->items.empty()) {
+      return fail("'->' is not supported in a column query");
+    }
+    pos_++;
+    if (peek().type != Token::IDENT) {
+      return fail("expect attribute name after '->'");
+    }
+    select->path.push_back(next().text);
+  }
+
+  if (accept_keyword("LIMIT")) {
+    if (peek().type != Token::INT || peek().text[0] == '-') {
+      return fail("expect non-negative integer after LIMIT");
+    }
+    select->limit = strtoll(next().text.c_str(), nullptr, 10);
+  }
+  return 0;
+}
+
+int QueryParser::parse_within(SelectQuery *select) {
+  if (peek().type != Token::LPAREN) {
+    return fail("expect '(' after WITHIN");
+  }
+  pos_++;
+  for (int i = 0; i < 6; i++) {
+    if (i > 0) {
+      if (peek().type != Token::COMMA) {
+        return fail("expect ',' between WITHIN coordinates");
+      }
+      pos_++;
+    }
+    if (peek().type != Token::INT && peek().type != Token::REAL) {
+      return fail("expect number in WITHIN");
+    }
+    select->within_box[i] = strtod(next().text.c_str(), nullptr);
+  }
+  if (peek().type != Token::RPAREN) {
+    return fail("expect ')'");
+  }
+  pos_++;
+  select->within = true;
+  return 0;
+}
+
+int QueryParser::parse_predicate(QueryPredicate *predicate) {
+  if (peek().type != Token::IDENT) {
+    return fail("expect attribute name in WHERE clause");
+  }
+  predicate->attribute = next().text;
+
+  if (peek().type != Token::OP) {
+    return fail("expect comparison operator");
+  }
+  const std::string &op = next().text;
+  if (op == "=") {
+    predicate->op = CompOp::EQ;
+  } else if (op == "!=" || op == "<>") {
+    predicate->op = CompOp::NE;
+  } else if (op == "<") {
+    predicate->op = CompOp::LT;
+  } else if (op == "<=") {
+    predicate->op = CompOp::LE;
+  } else if (op == ">") {
+    predicate->op = CompOp::GT;
+  } else if (op == ">=") {
+    predicate->op = CompOp::GE;
+  } else {
+    pos_--;
+    return fail("unknown operator '" + op + "'");
+  }
+  return parse_literal(&predicate->value);
+}
+
+int QueryParser::parse_literal(QueryLiteral *literal) {
+  const Token &token = peek();
+  switch (token.type) {
+    case Token::INT:
+      literal->kind = QueryLiteral::INT;
+      literal->int_value = strtoll(token.text.c_str(), nullptr, 10);
+      break;
+    case Token::REAL:
+      literal->kind = QueryLiteral::REAL;
+      literal->real_value = strtod(token.text.c_str(), nullptr);
+      break;
+    case Token::STRING:
+      literal->kind = QueryLiteral::STRING;
+      literal->str_value = token.text;
+      break;
+    case Token::ENUM:
+      literal->kind = QueryLiteral::ENUM;
+      literal->str_value = token.text;
+      break;
+    case Token::REF:
+      literal->kind = QueryLiteral::REF;
+      literal->int_value = strtoll(token.text.c_str(), nullptr, 10);
+      break;
+    case Token::IDENT:
+      if (strcasecmp(token.text.c_str(), "TRUE") == 0 ||
+          strcasecmp(token.text.c_str(), "FALSE") == 0) {
+        literal->kind = QueryLiteral::BOOL;
+        literal->bool_value = strcasecmp(token.text.c_str(), "TRUE") == 0;
+        break;
+      }
+      if (strcasecmp(token.text.c_str(), "NULL") == 0) {
+        literal->kind = QueryLiteral::NUL;
+        break;
+      }
+      return fail("unexpected '" + token.text + "', expect a literal");
+    default:
+      return fail("expect a literal");
+  }
+  pos_++;
+  return 0;
+}
+
+}  // namespace vulcan
@@ -0,0 +1,144 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vulcan {
+
+/**
+ * @brief IFC 查询语言的语法树。
+ *
+ * 支持的语句(关键字不区分大小写)：
+ *
+ *   OPEN '<ifc文件路径>' [AS <名称>]     路径限定在 VULCAN_DATA_DIR 下
+ *   USE <名称>
+ *   SELECT [ONLY] <实体类型 | #id>
+ *          [WHERE <属性> <op> <字面量> [AND ...]]
+ *          [WITHIN (x1, y1, z1, x2, y2, z2)]
+ *          [-> <属性或反向属性> ...]
+ *          [LIMIT <n>]
+ *   SELECT <列> [, <列> ...] FROM [ONLY] <实体类型>
+ *          [WHERE ...] [LIMIT <n>]
+ *
+ * 例如：SELECT IfcWall WHERE Name = 'W-01' -> ContainedInStructure
+ *       -> RelatingStructure LIMIT 10
+ *       SELECT COUNT(*), SUM(VolumeValue) FROM IfcQuantityVolume
+ *       WHERE Name = 'NetVolume'
+ *
+ * 列为属性名或聚合函数 COUNT(*)、COUNT/SUM/AVG/MIN/MAX(<属性>)，
+ * 聚合与普通属性不能混用。列查询由向量化引擎按批执行。
+ * WITHIN 只保留包围盒与给定长方体相交的产品，由模型的空间索引求解。
+ *
+ * ONLY 表示不包含子类型；op 为 = != <> < <= > >=；字面量为整数、实数、
+ * '字符串'、.枚举.、TRUE/FALSE、NULL 或 #id。
+ */
+enum class CompOp { EQ, NE, LT, LE, GT, GE };
+
+struct QueryLiteral {
+  enum Kind { NUL, INT, REAL, STRING, ENUM, BOOL, REF };
+
+  Kind kind = NUL;
+  int64_t int_value = 0;
+  double real_value = 0;
+  bool bool_value = false;
+  std::string str_value;  // STRING 和 ENUM(不含两侧的点)
+
+  std::string to_string() const;
+};
+
+struct QueryPredicate {
+  std::string attribute;
+  CompOp op = CompOp::EQ;
+  QueryLiteral value;
+};
+
+enum class AggFunc { NONE, COUNT, SUM, AVG, MIN, MAX };
+
+struct SelectItem {
+  AggFunc func = AggFunc::NONE;
+  std::string attribute;  // COUNT(*) 时为空
+};
+
+struct SelectQuery {
+  std::vector<SelectItem> items;  // 非空时为列查询
+  std::string type_name;  // 为空时按 instance_id 查询
+  int instance_id = 0;
+  bool only = false;  // 不包含子类型
+  std::vector<QueryPredicate> predicates;
+  bool within = false;
+  double within_box[6] = {};      // WITHIN 的 x1 y1 z1 x2 y2 z2
+  std::vector<std::string> path;  // 依次导航的属性名
+  int64_t limit = -1;             // -1 表示不限制
+};
+
+struct Query {
+  enum Kind { SELECT, OPEN, USE };
+
+  Kind kind = SELECT;
+  SelectQuery select;
+  std::string path;  // OPEN 的文件路径
+  std::string name;  // OPEN AS / USE 的模型名称
+};
+
+/**
+ * @brief 手写的递归下降解析器，不依赖 schema，名称在 ResolveStage 中解析
+ */
+class QueryParser {
+ public:
+  /**
+   * @brief 解析一条查询语句
+   * @return 0 成功，-1 语法错误，错误信息由 error() 返回
+   */
+  int parse(const std::string &text, Query *query);
+
+  const std::string &error() const { return error_; }
+
+ private:
+  struct Token {
+    enum Type {
+      IDENT,
+      INT,
+      REAL,
+      STRING,
+      ENUM,
+      REF,
+      ARROW,
+      OP,
+      LPAREN,
+      RPAREN,
+      COMMA,
+      STAR,
+      SEMICOLON,
+      END
+    };
+
+    Type type;
+    std::string text;
+    size_t pos;
+  };
+
+  int tokenize(const std::string &text);
+  int parse_select(SelectQuery *select);
+  int parse_select_items(SelectQuery *select);
+  int parse_predicate(QueryPredicate *predicate);
+  int parse_within(SelectQuery *select);
+  int parse_literal(QueryLiteral *literal);
+
+  const Token &peek() const { return tokens_[pos_]; }
+  const Token &peek(size_t offset) const {
+    return tokens_[std::min(pos_ + offset, tokens_.size() - 1)];
+  }
+  const Token &next() { return tokens_[pos_++]; }
+  bool accept_keyword(const char *keyword);
+  bool expect_end();
+  int fail(const std::string &message);
+
+  std::vector<Token> tokens_;
+  size_t pos_ = 0;
+  std::string error_;
+};
+
+}  // namespace vulcan
@@ -0,0 +1,270 @@
+// Copyright 2023 VulcanDB
+#include "backend/query/query_plan.h"
+
+#include <strings.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include "ifcparse/IfcException.h"
+
+namespace vulcan {
+
+namespace {
+
+// 属性名不区分大小写，返回在全部属性(含父类型)中的下标
+int find_attribute(const IfcParse::entity *entity, const std::string &name) {
+  const std::vector<const IfcParse::attribute *> attrs =
+      entity->all_attributes();
+  for (size_t i = 0; i < attrs.size(); i++) {
+    if (strcasecmp(attrs[i]->name().c_str(), name.c_str()) == 0) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+const IfcParse::inverse_attribute *find_inverse(const IfcParse::entity *entity,
+                                                const std::string &name) {
+  for (const IfcParse::inverse_attribute *inverse :
+       entity->all_inverse_attributes()) {
+    if (strcasecmp(inverse->name().c_str(), name.c_str()) == 0) {
+      return inverse;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * 属性是否引用实体实例(可以是聚合)。引用 SELECT 类型时实际类型要到
+ * 执行时才能确定，target 置空。
+ */
+bool references_entity(const IfcParse::parameter_type *type,
+                       const IfcParse::entity **target) {
+  while (type != nullptr) {
+    if (const IfcParse::aggregation_type *aggr = type->as_aggregation_type()) {
+      type = aggr->type_of_element();
+      continue;
+    }
+    const IfcParse::named_type *named = type->as_named_type();
+    if (named == nullptr) {
+      return false;
+    }
+    const IfcParse::declaration *decl = named->declared_type();
+    if (decl->as_entity() != nullptr) {
+      *target = decl->as_entity();
+      return true;
+    }
+    if (decl->as_select_type() != nullptr) {
+      *target = nullptr;
+      return true;
+    }
+    return false;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool QueryResolver::resolve_step(const IfcParse::entity *entity,
+                                 const std::string &name, NavigationStep *step,
+                                 const IfcParse::entity **next) {
+  step->name = name;
+  int index = find_attribute(entity, name);
+  if (index >= 0) {
+    const IfcParse::attribute *attr = entity->attribute_by_index(index);
+    if (!references_entity(attr->type_of_attribute(), next)) {
+      return false;
+    }
+    step->kind = NavigationStep::FORWARD;
+    step->attribute_index = index;
+    return true;
+  }
+
+  const IfcParse::inverse_attribute *inverse = find_inverse(entity, name);
+  if (inverse != nullptr) {
+    step->kind = NavigationStep::INVERSE;
+    step->inverse = inverse;
+    *next = inverse->entity_reference();
+    return true;
+  }
+  return false;
+}
+
+int QueryResolver::resolve(const Query &query,
+                           const IfcParse::schema_definition *schema,
+                           QueryPlan *plan) {
+  error_.clear();
+  plan->kind = query.kind;
+  switch (query.kind) {
+    case Query::OPEN:
+      return resolve_open(query, plan);
+    case Query::USE:
+      plan->model_name = query.name;
+      return 0;
+    case Query::SELECT:
+      if (schema == nullptr) {
+        error_ = "no model is in use, OPEN or USE a model first";
+        return -1;
+      }
+      return resolve_select(query.select, schema, plan);
+  }
+  return 0;
+}
+
+int QueryResolver::resolve_open(const Query &query, QueryPlan *plan) {
+  if (data_dir_.empty()) {
+    error_ = "OPEN is disabled, no data directory is configured";
+    return -1;
+  }
+  std::filesystem::path path(query.path);
+  for (const std::filesystem::path &part : path) {
+    if (part == "..") {
+      error_ = "path of OPEN must not contain '..'";
+      return -1;
+    }
+  }
+
+  // 相对路径基于数据目录；绝对路径和符号链接解析后都必须仍在数据目录下
+  std::error_code ec;
+  std::filesystem::path root =
+      std::filesystem::weakly_canonical(data_dir_, ec);
+  std::filesystem::path full;
+  if (!ec) {
+    full = std::filesystem::weakly_canonical(root / path, ec);
+  }
+  if (ec) {
+    error_ = "invalid path '" + query.path + "': " + ec.message();
+    return -1;
+  }
+  if (root.filename().empty()) {
+    root = root.parent_path();
+  }
+  auto diverge = std::mismatch(root.begin(), root.end(), full.begin(),
+                               full.end());
+  if (diverge.first != root.end() || diverge.second == full.end()) {
+    error_ = "'" + query.path + "' is outside the data directory";
+    return -1;
+  }
+
+  plan->path_name = full.string();
+  plan->model_name = query.name;
+  return 0;
+}
+
+int QueryResolver::resolve_columns(const SelectQuery &select,
+                                   QueryPlan *plan) {
+  static const char *func_names[] = {"", "COUNT", "SUM", "AVG", "MIN", "MAX"};
+
+  size_t aggregates = 0;
+  for (const SelectItem &item : select.items) {
+    PlanColumn column;
+    column.func = item.func;
+    if (!item.attribute.empty()) {
+      column.attribute_index = find_attribute(plan->type, item.attribute);
+      if (column.attribute_index < 0) {
+        error_ = "'" + plan->type->name() + "' has no attribute '" +
+                 item.attribute + "'";
+        return -1;
+      }
+      column.name =
+          plan->type->attribute_by_index(column.attribute_index)->name();
+    } else {
+      column.name = "*";
+    }
+    if (item.func != AggFunc::NONE) {
+      column.name = std::string(func_names[static_cast<int>(item.func)]) +
+                    "(" + column.name + ")";
+      aggregates++;
+    }
+    plan->columns.push_back(column);
+  }
+
+  if (aggregates > 0 && aggregates != plan->columns.size()) {
+    error_ = "aggregates can not be mixed with attributes without GROUP BY";
+    return -1;
+  }
+  plan->aggregate = aggregates > 0;
+  return 0;
+}
+
+int QueryResolver::resolve_select(const SelectQuery &select,
+                                  const IfcParse::schema_definition *schema,
+                                  QueryPlan *plan) {
+  plan->instance_id = select.instance_id;
+  plan->only = select.only;
+  plan->limit = select.limit;
+
+  const IfcParse::entity *current = nullptr;
+  if (!select.type_name.empty()) {
+    const IfcParse::declaration *decl = nullptr;
+    try {
+      decl = schema->declaration_by_name(select.type_name);
+    } catch (const IfcParse::IfcException &) {
+      error_ = "unknown type '" + select.type_name + "' in schema " +
+               schema->name();
+      return -1;
+    }
+    if (decl->as_entity() == nullptr) {
+      error_ = "'" + decl->name() + "' is not an entity type";
+      return -1;
+    }
+    plan->type = decl->as_entity();
+    current = plan->type;
+  }
+
+  if (resolve_columns(select, plan) != 0) {
+    return -1;
+  }
+
+  if (!select.predicates.empty() && plan->type == nullptr) {
+    error_ = "WHERE requires an entity type instead of an instance id";
+    return -1;
+  }
+  for (const QueryPredicate &predicate : select.predicates) {
+    ResolvedPredicate resolved;
+    resolved.attribute_index = find_attribute(plan->type, predicate.attribute);
+    if (resolved.attribute_index < 0) {
+      error_ = "'" + plan->type->name() + "' has no attribute '" +
+               predicate.attribute + "'";
+      return -1;
+    }
+    resolved.attribute_name =
+        plan->type->attribute_by_index(resolved.attribute_index)->name();
+    resolved.op = predicate.op;
+    resolved.value = predicate.value;
+    plan->predicates.push_back(resolved);
+  }
+
+  if (select.within) {
+    if (plan->type == nullptr) {
+      error_ = "WITHIN requires an entity type instead of an instance id";
+      return -1;
+    }
+    plan->within = true;
+    for (int i = 0; i < 3; i++) {
+      plan->within_box[i] =
+          std::min(select.within_box[i], select.within_box[i + 3]);
+      plan->within_box[i + 3] =
+          std::max(select.within_box[i], select.within_box[i + 3]);
+    }
+  }
+
+  for (const std::string &name : select.path) {
+    NavigationStep step;
+    step.name = name;
+    if (current == nullptr) {
+      // 上一步的类型未知，执行时按实例的实际类型解析
+      step.kind = NavigationStep::DYNAMIC;
+    } else if (!resolve_step(current, name, &step, &current)) {
+      error_ = "'" + current->name() +
+               "' has no entity attribute or inverse '" + name + "'";
+      return -1;
+    }
+    plan->path.push_back(step);
+  }
+  return 0;
+}
+
+}  // namespace vulcan
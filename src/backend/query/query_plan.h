@@ -0,0 +1,103 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "backend/query/query_parser.h"
+#include "ifcparse/IfcSchema.h"
+
+namespace vulcan {
+
+/**
+ * @brief 已解析名称的谓词，属性下标对应 IfcEntityInstanceData::getArgument
+ */
+struct ResolvedPredicate {
+  int attribute_index = -1;
+  std::string attribute_name;
+  CompOp op = CompOp::EQ;
+  QueryLiteral value;
+};
+
+/**
+ * @brief 一步导航。当前实体类型在解析时已知则静态解析为正向属性或反向属性，
+ * 否则(例如经过 SELECT 类型的属性)在执行时按实例的实际类型查找。
+ */
+struct NavigationStep {
+  enum Kind { FORWARD, INVERSE, DYNAMIC };
+
+  Kind kind = DYNAMIC;
+  std::string name;
+  int attribute_index = -1;                               // FORWARD
+  const IfcParse::inverse_attribute *inverse = nullptr;  // INVERSE
+};
+
+/**
+ * @brief 列查询的一列，attribute_index 为 -1 表示 COUNT(*)
+ */
+struct PlanColumn {
+  AggFunc func = AggFunc::NONE;
+  int attribute_index = -1;
+  std::string name;  // 输出的列名，如 SUM(VolumeValue)
+};
+
+struct QueryPlan {
+  Query::Kind kind = Query::SELECT;
+
+  // SELECT
+  const IfcParse::entity *type = nullptr;  // 为空时按 instance_id 查询
+  int instance_id = 0;
+  bool only = false;
+  std::vector<ResolvedPredicate> predicates;
+  bool within = false;
+  double within_box[6] = {};  // 已规整为 min xyz、max xyz
+  std::vector<NavigationStep> path;
+  int64_t limit = -1;
+  std::vector<PlanColumn> columns;  // 非空时为列查询，由向量化引擎执行
+  bool aggregate = false;           // 列均为聚合函数
+
+  // OPEN / USE
+  std::string path_name;
+  std::string model_name;
+};
+
+/**
+ * @brief 将语法树中的类型名和属性名解析为 schema 中的声明
+ */
+class QueryResolver {
+ public:
+  /**
+   * @param schema 当前模型的 schema，OPEN/USE 语句可以为空
+   * @return 0 成功，-1 名称无法解析，错误信息由 error() 返回
+   */
+  int resolve(const Query &query, const IfcParse::schema_definition *schema,
+              QueryPlan *plan);
+
+  const std::string &error() const { return error_; }
+
+  /**
+   * @brief OPEN 只能打开该目录下的模型，为空时拒绝所有 OPEN 语句
+   */
+  void set_data_dir(const std::string &data_dir) { data_dir_ = data_dir; }
+
+  /**
+   * @brief 在实体(含父类型)上按名称查找一步导航，找不到时返回 false
+   * @param[out] next 导航后的实体类型，无法静态确定时为空
+   */
+  static bool resolve_step(const IfcParse::entity *entity,
+                           const std::string &name, NavigationStep *step,
+                           const IfcParse::entity **next);
+
+ private:
+  int resolve_select(const SelectQuery &select,
+                     const IfcParse::schema_definition *schema,
+                     QueryPlan *plan);
+  int resolve_columns(const SelectQuery &select, QueryPlan *plan);
+  // 把 OPEN 的路径解析为数据目录下的绝对路径
+  int resolve_open(const Query &query, QueryPlan *plan);
+
+  std::string error_;
+  std::string data_dir_;
+};
+
+}  // namespace vulcan
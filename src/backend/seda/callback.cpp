@@ -4,7 +4,9 @@
 
 #include "backend/seda/stage.h"
 #include "backend/seda/stage_event.h"
+#include "backend/seda/stage_stats.h"
 #include "common/vulcan_logger.h"
+#include "common/vulcan_utility.h"
 
 namespace vulcan {
 
@@ -54,16 +56,30 @@ void CompletionCallback::event_done(StageEvent *ev) {
   if (ev_hist_flag_) {
     ev->save_stage(target_stage_, StageEvent::CALLBACK_EV);
   }
+  // callback_event may free the event
+  bool traced = ev->is_traced();
+  uint64_t start_us = monotonic_us();
   target_stage_->callback_event(ev, context_);
+  uint64_t callback_us = monotonic_us() - start_us;
+  target_stage_->metrics().callback.record(callback_us);
+  if (traced) {
+    SedaTracer::get_instance()->record(target_stage_->get_name(), "callback",
+                                       start_us, callback_us);
+  }
 }
 
 // Reschedule callback on target stage thread
 void CompletionCallback::event_reschedule(StageEvent *ev) {
-  target_stage_->add_event(ev);
+  if (!target_stage_->add_event(ev)) {
+    // 回调不能丢弃，目标 stage 队列已满时直接在当前线程执行。
+    // callback_event 可能释放事件及其回调链，因此与 done_immediate 一样先
+    // 把本回调从事件上摘下，执行完成后再释放
+    ev->done_immediate();
+  }
 }
 
 void CompletionCallback::event_timeout(StageEvent *ev) {
-  LOG(debug, "to call event_timeout for stage {}}", target_stage_->get_name());
+  LOG(debug, "to call event_timeout for stage {}", target_stage_->get_name());
   if (ev_hist_flag_) {
     ev->save_stage(target_stage_, StageEvent::TIMEOUT_EV);
   }
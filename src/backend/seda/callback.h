@@ -2,7 +2,7 @@
 #pragma once
 
 #include "backend/seda/stage.h"
-
+#include "common/object_pool.h"
 
 namespace vulcan {
 
@@ -39,9 +39,11 @@ class CallbackContext;
  * to execute the callback stack in place, it can call the done_immediate()
  * interface.  Note that this will execute the *entire* callback stack on
  * the current thread.
+ * <p>
+ * Callbacks are allocated from the per-thread ObjectPool.
  */
 
-class CompletionCallback {
+class CompletionCallback : public PooledObject {
   // public interface operations
 
  public:
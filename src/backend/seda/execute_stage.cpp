@@ -0,0 +1,127 @@
+// Copyright 2023 VulcanDB
+#include "backend/seda/execute_stage.h"
+
+#include <string>
+#include <utility>
+
+#include "backend/query/query_executor.h"
+#include "backend/seda/morsel_event.h"
+#include "backend/seda/query_stage_event.h"
+#include "backend/seda/session_event.h"
+#include "common/vulcan_logger.h"
+
+namespace vulcan {
+
+ExecuteStage::ExecuteStage(const char *tag) : Stage(tag) {}
+
+ExecuteStage::~ExecuteStage() {}
+
+Stage *ExecuteStage::make_stage(const std::string &tag) {
+  ExecuteStage *stage = new (std::nothrow) ExecuteStage(tag.c_str());
+  if (stage == nullptr) {
+    LOG(error, "new ExecuteStage failed");
+    return nullptr;
+  }
+  stage->set_properties();
+  return stage;
+}
+
+bool ExecuteStage::set_properties() { return true; }
+
+bool ExecuteStage::initialize() {
+  LOG(trace, "ExecuteStage initialized successfully");
+  return true;
+}
+
+void ExecuteStage::cleanup() {
+  LOG(trace, "ExecuteStage cleanup successfully");
+}
+
+void ExecuteStage::handle_event(StageEvent *event) {
+  MorselEvent *mev = dynamic_cast<MorselEvent *>(event);
+  if (mev != nullptr) {
+    handle_morsel(mev);
+    return;
+  }
+
+  QueryStageEvent *qev = dynamic_cast<QueryStageEvent *>(event);
+  if (nullptr == qev) {
+    LOG(error, "Cannot cat event to QueryStageEvent");
+    event->done();
+    return;
+  }
+
+  if (!qev->plan().columns.empty()) {
+    execute_scan(qev);
+    return;
+  }
+
+  QueryExecutor executor;
+  std::string result;
+  if (executor.execute(qev->plan(), qev->session_event()->session(),
+                       &result) != 0) {
+    LOG(info, "Failed to execute query {}: {}", qev->query_text(),
+        executor.error());
+    qev->set_error(executor.error());
+  } else {
+    qev->set_response(std::move(result));
+  }
+  qev->done();
+}
+
+void ExecuteStage::execute_scan(QueryStageEvent *qev) {
+  QueryExecutor executor;
+  std::unique_ptr<ColumnScan> scan;
+  if (executor.prepare_scan(qev->plan(), qev->session_event()->session(),
+                            &scan) != 0) {
+    qev->set_error(executor.error());
+    qev->done();
+    return;
+  }
+
+  size_t morsels = scan->morsel_count();
+  LOG(debug, "Scan {} instances in {} morsels for query {}",
+      scan->instance_count(), morsels, qev->query_text());
+  // 多计一次，保证分发完所有 morsel 之前 job 不会被其他线程释放
+  ScanJob *job = new ScanJob(std::move(scan), qev, morsels + 1);
+  for (size_t i = 1; i < morsels; i++) {
+    MorselEvent *mev = new MorselEvent(job, i);
+    if (!add_event(mev)) {
+      handle_morsel(mev);
+    }
+  }
+  // 第一个 morsel 在当前线程执行
+  if (morsels > 0) {
+    job->scan->run_morsel(0);
+    complete_morsel(job);
+  }
+  complete_morsel(job);
+}
+
+void ExecuteStage::handle_morsel(MorselEvent *mev) {
+  ScanJob *job = mev->job();
+  job->scan->run_morsel(mev->morsel());
+  mev->done();
+  complete_morsel(job);
+}
+
+void ExecuteStage::complete_morsel(ScanJob *job) {
+  if (job->pending.fetch_sub(1) != 1) {
+    return;
+  }
+
+  QueryStageEvent *qev = job->query_event;
+  std::string result;
+  if (job->scan->finish(&result) != 0) {
+    qev->set_error(job->scan->error());
+  } else {
+    qev->set_response(std::move(result));
+  }
+  delete job;
+  qev->done();
+}
+
+void ExecuteStage::callback_event(StageEvent * /*event*/,
+                                  CallbackContext * /*context*/) {}
+
+}  // namespace vulcan
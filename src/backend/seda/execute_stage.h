@@ -0,0 +1,38 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <string>
+
+#include "backend/seda/stage.h"
+
+namespace vulcan {
+
+class MorselEvent;
+class QueryStageEvent;
+struct ScanJob;
+
+/**
+ * @brief 在会话当前的模型上执行查询计划，结果作为响应返回 SessionStage
+ */
+class ExecuteStage : public Stage {
+ public:
+  ~ExecuteStage();
+  static Stage *make_stage(const std::string &tag);
+
+ protected:
+  explicit ExecuteStage(const char *tag);
+  bool set_properties() override;
+
+  bool initialize() override;
+  void cleanup() override;
+  void handle_event(StageEvent *event) override;
+  void callback_event(StageEvent *event, CallbackContext *context) override;
+
+ private:
+  // 列查询按 morsel 拆分为 MorselEvent，由本 stage 的多个线程并发执行
+  void execute_scan(QueryStageEvent *qev);
+  void handle_morsel(MorselEvent *mev);
+  void complete_morsel(ScanJob *job);
+};
+
+}  // namespace vulcan
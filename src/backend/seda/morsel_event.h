@@ -0,0 +1,45 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "backend/query/column_scan.h"
+#include "backend/seda/stage_event.h"
+
+namespace vulcan {
+
+class QueryStageEvent;
+
+/**
+ * @brief 一个列查询的所有 morsel 共享的状态，最后完成的 morsel 负责合并结果、
+ * 完成查询事件并释放它
+ */
+struct ScanJob {
+  ScanJob(std::unique_ptr<ColumnScan> &&scan, QueryStageEvent *event,
+          size_t pending)
+      : scan(std::move(scan)), query_event(event), pending(pending) {}
+
+  std::unique_ptr<ColumnScan> scan;
+  QueryStageEvent *query_event;
+  std::atomic<size_t> pending;
+};
+
+/**
+ * @brief 在 ExecuteStage 的线程池中执行一个 morsel。不设置超时，保证每个
+ * morsel 都会执行并计数，查询的超时由 QueryStageEvent 完成时处理。
+ */
+class MorselEvent : public StageEvent {
+ public:
+  MorselEvent(ScanJob *job, size_t morsel) : job_(job), morsel_(morsel) {}
+  virtual ~MorselEvent() {}
+
+  ScanJob *job() const { return job_; }
+  size_t morsel() const { return morsel_; }
+
+ private:
+  ScanJob *job_;
+  size_t morsel_;
+};
+
+}  // namespace vulcan
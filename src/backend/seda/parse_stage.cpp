@@ -0,0 +1,69 @@
+// Copyright 2023 VulcanDB
+#include "backend/seda/parse_stage.h"
+
+#include <string>
+
+#include "backend/query/query_parser.h"
+#include "backend/seda/query_stage_event.h"
+#include "common/vulcan_logger.h"
+
+namespace vulcan {
+
+ParseStage::ParseStage(const char *tag) : Stage(tag) {}
+
+ParseStage::~ParseStage() {}
+
+Stage *ParseStage::make_stage(const std::string &tag) {
+  ParseStage *stage = new (std::nothrow) ParseStage(tag.c_str());
+  if (stage == nullptr) {
+    LOG(error, "new ParseStage failed");
+    return nullptr;
+  }
+  stage->set_properties();
+  return stage;
+}
+
+bool ParseStage::set_properties() { return true; }
+
+bool ParseStage::initialize() {
+  LOG(trace, "ParseStage initializing");
+
+  if (next_stage_list_.empty()) {
+    LOG(error, "ParseStage requires NextStages");
+    return false;
+  }
+  resolve_stage_ = next_stage_list_.front();
+
+  LOG(trace, "ParseStage initialized successfully");
+  return true;
+}
+
+void ParseStage::cleanup() { LOG(trace, "ParseStage cleanup successfully"); }
+
+void ParseStage::handle_event(StageEvent *event) {
+  QueryStageEvent *qev = dynamic_cast<QueryStageEvent *>(event);
+  if (nullptr == qev) {
+    LOG(error, "Cannot cat event to QueryStageEvent");
+    event->done();
+    return;
+  }
+
+  QueryParser parser;
+  if (parser.parse(qev->query_text(), &qev->query()) != 0) {
+    LOG(debug, "Failed to parse query {}: {}", qev->query_text(),
+        parser.error());
+    qev->set_error(parser.error());
+    qev->done();
+    return;
+  }
+
+  if (!resolve_stage_->add_event(qev)) {
+    qev->set_error("server is busy, please retry later");
+    qev->done();
+  }
+}
+
+void ParseStage::callback_event(StageEvent * /*event*/,
+                                CallbackContext * /*context*/) {}
+
+}  // namespace vulcan
@@ -0,0 +1,31 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <string>
+
+#include "backend/seda/stage.h"
+
+namespace vulcan {
+
+/**
+ * @brief 将请求文本解析为查询语法树，交给 ResolveStage
+ */
+class ParseStage : public Stage {
+ public:
+  ~ParseStage();
+  static Stage *make_stage(const std::string &tag);
+
+ protected:
+  explicit ParseStage(const char *tag);
+  bool set_properties() override;
+
+  bool initialize() override;
+  void cleanup() override;
+  void handle_event(StageEvent *event) override;
+  void callback_event(StageEvent *event, CallbackContext *context) override;
+
+ private:
+  Stage *resolve_stage_ = nullptr;
+};
+
+}  // namespace vulcan
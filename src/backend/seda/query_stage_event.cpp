@@ -0,0 +1,15 @@
+// Copyright 2023 VulcanDB
+#include "backend/seda/query_stage_event.h"
+
+#include "backend/seda/session_event.h"
+
+namespace vulcan {
+
+QueryStageEvent::QueryStageEvent(SessionEvent *event, const std::string &query)
+    : session_event_(event), query_text_(query) {
+  set_timeout_info(*event);
+}
+
+QueryStageEvent::~QueryStageEvent() {}
+
+}  // namespace vulcan
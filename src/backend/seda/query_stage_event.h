@@ -0,0 +1,47 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <string>
+#include <utility>
+
+#include "backend/query/query_parser.h"
+#include "backend/query/query_plan.h"
+#include "backend/seda/stage_event.h"
+
+namespace vulcan {
+
+class SessionEvent;
+
+/**
+ * @brief 查询在 ParseStage -> ResolveStage -> ExecuteStage 间传递的事件。
+ *
+ * 不拥有 SessionEvent，二者由 SessionStage 在回调中一起释放。与 SessionEvent
+ * 共享超时信息，在任一 stage 队列中超时都会回到 SessionStage::timeout_event。
+ */
+class QueryStageEvent : public StageEvent {
+ public:
+  QueryStageEvent(SessionEvent *event, const std::string &query);
+  virtual ~QueryStageEvent();
+
+  SessionEvent *session_event() const { return session_event_; }
+  const std::string &query_text() const { return query_text_; }
+
+  Query &query() { return query_; }
+  QueryPlan &plan() { return plan_; }
+
+  // 处理失败时以 ERROR 开头，与服务器其他错误响应一致
+  void set_error(const std::string &message) {
+    response_ = "ERROR: " + message + "\n";
+  }
+  void set_response(std::string &&response) { response_ = std::move(response); }
+  std::string take_response() { return std::move(response_); }
+
+ private:
+  SessionEvent *session_event_ = nullptr;
+  std::string query_text_;
+  Query query_;
+  QueryPlan plan_;
+  std::string response_;
+};
+
+}  // namespace vulcan
@@ -0,0 +1,87 @@
+// Copyright 2023 VulcanDB
+#include "backend/seda/resolve_stage.h"
+
+#include <string>
+
+#include "backend/db.h"
+#include "backend/query/query_plan.h"
+#include "backend/seda/query_stage_event.h"
+#include "backend/seda/session_event.h"
+#include "backend/vulcan_param.h"
+#include "common/defs.h"
+#include "common/vulcan_logger.h"
+#include "ifcparse/IfcFile.h"
+
+namespace vulcan {
+
+ResolveStage::ResolveStage(const char *tag) : Stage(tag) {}
+
+ResolveStage::~ResolveStage() {}
+
+Stage *ResolveStage::make_stage(const std::string &tag) {
+  ResolveStage *stage = new (std::nothrow) ResolveStage(tag.c_str());
+  if (stage == nullptr) {
+    LOG(error, "new ResolveStage failed");
+    return nullptr;
+  }
+  stage->set_properties();
+  return stage;
+}
+
+bool ResolveStage::set_properties() { return true; }
+
+bool ResolveStage::initialize() {
+  LOG(trace, "ResolveStage initializing");
+
+  if (next_stage_list_.empty()) {
+    LOG(error, "ResolveStage requires NextStages");
+    return false;
+  }
+  execute_stage_ = next_stage_list_.front();
+  data_dir_ = VulcanParam::get_instance()->get(VULCAN_DATA_DIR);
+
+  LOG(trace, "ResolveStage initialized successfully");
+  return true;
+}
+
+void ResolveStage::cleanup() {
+  LOG(trace, "ResolveStage cleanup successfully");
+}
+
+void ResolveStage::handle_event(StageEvent *event) {
+  QueryStageEvent *qev = dynamic_cast<QueryStageEvent *>(event);
+  if (nullptr == qev) {
+    LOG(error, "Cannot cat event to QueryStageEvent");
+    event->done();
+    return;
+  }
+
+  // schema 随模型加载后不再变化，只需在读取模型时持有锁
+  const IfcParse::schema_definition *schema = nullptr;
+  Db *db = qev->session_event()->session()->get_current_db();
+  if (db != nullptr && db->model() != nullptr) {
+    db->lock();
+    schema = db->model()->schema();
+    db->unlock();
+  }
+
+  QueryResolver resolver;
+  resolver.set_data_dir(data_dir_);
+  if (resolver.resolve(qev->query(), schema, &qev->plan()) != 0) {
+    LOG(debug, "Failed to resolve query {}: {}", qev->query_text(),
+        resolver.error());
+    qev->set_error(resolver.error());
+    qev->done();
+    return;
+  }
+
+  if (!execute_stage_->add_event(qev)) {
+    qev->set_error("server is busy, please retry later");
+    qev->done();
+  }
+}
+
+void ResolveStage::callback_event(StageEvent * /*event*/,
+                                  CallbackContext * /*context*/) {}
+
+}  // namespace vulcan
@@ -0,0 +1,32 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <string>
+
+#include "backend/seda/stage.h"
+
+namespace vulcan {
+
+/**
+ * @brief 按当前模型的 schema 解析查询中的类型名和属性名，交给 ExecuteStage
+ */
+class ResolveStage : public Stage {
+ public:
+  ~ResolveStage();
+  static Stage *make_stage(const std::string &tag);
+
+ protected:
+  explicit ResolveStage(const char *tag);
+  bool set_properties() override;
+
+  bool initialize() override;
+  void cleanup() override;
+  void handle_event(StageEvent *event) override;
+  void callback_event(StageEvent *event, CallbackContext *context) override;
+
+ private:
+  Stage *execute_stage_ = nullptr;
+  std::string data_dir_;  // OPEN 可以访问的目录
+};
+
+}  // namespace vulcan
@@ -5,13 +5,18 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <sstream>
+#include <string>
 #include <typeinfo>
 #include <vector>
 
 #include "backend/seda/seda_defs.h"
 #include "backend/seda/stage.h"
 #include "backend/seda/stage_factory.h"
+#include "backend/seda/stage_stats.h"
 #include "backend/seda/thread_pool.h"
+#include "backend/seda/timer_wheel.h"
 #include "common/vulcan_logger.h"
 #include "common/vulcan_utility.h"
 
@@ -66,6 +71,17 @@ SedaConfig::status_t SedaConfig::start() {
     iter++;
   }
 
+  if (stat == SUCCESS && tuner_ != nullptr && tuner_->start() != 0) {
+    LOG(warn, "Failed to start threadpool tuner, thread pools keep their size");
+  }
+
+  if (stat == SUCCESS) {
+    // 定时器到期时撤回仍在队列中的事件，交给所在 stage 的超时处理
+    if (TimerWheel::get_instance()->start() != 0) {
+      LOG(warn, "Failed to start timer wheel, event timeouts are disabled");
+    }
+  }
+
   return stat;
 }
 
@@ -77,6 +93,11 @@ SedaConfig::status_t SedaConfig::init() {
   ASSERT(stages_.empty(), "Attempt to initialize sedaconfig twice");
   ASSERT(thread_pools_.empty(), "Attempt to initialize sedaconfig twice");
 
+  unsigned int trace_sample_rate = 0;
+  str_to_val(seda_cfg_.get(TRACE_SAMPLE_RATE, "0", SEDA_BASE_NAME),
+             trace_sample_rate);
+  SedaTracer::get_instance()->set_sample_rate(trace_sample_rate);
+
   // instantiate the parsed config
   stat = instantiate();
   if (stat) {
@@ -94,6 +115,13 @@ SedaConfig::status_t SedaConfig::init() {
 
 // Clean-up the threadpool and stages_
 void SedaConfig::cleanup() {
+  // stop resizing thread pools before they are destroyed
+  if (tuner_ != nullptr) {
+    tuner_->stop();
+  }
+
+  TimerWheel::get_instance()->stop();
+
   // first disconnect all stages_
   if (stages_.empty() == false) {
     std::map<std::string, Stage *>::iterator iter = stages_.begin();
@@ -139,6 +167,11 @@ SedaConfig::status_t SedaConfig::init_thread_pool() {
     std::string default_cpu_num_str;
     val_to_str(cpu_num, default_cpu_num_str);
 
+    unsigned int tune_interval_ms = 200;
+    str_to_val(seda_cfg_.get(TUNE_INTERVAL, "200", SEDA_BASE_NAME),
+               tune_interval_ms);
+    tuner_ = new ThreadpoolTuner(tune_interval_ms);
+
     for (size_t pos = 0; pos != name_list.size(); pos++) {
       std::string &thread_name = name_list[pos];
 
@@ -161,12 +194,32 @@ SedaConfig::status_t SedaConfig::init_thread_pool() {
         return INITFAIL;
       }
 
+      // MinCount < MaxCount 时线程数由 ThreadpoolTuner 在区间内自动调整
+      TunerPolicy policy;
+      str_to_val(seda_cfg_.get(MIN_COUNT, std::to_string(thread_count),
+                               thread_name),
+                 policy.min_threads);
+      str_to_val(seda_cfg_.get(MAX_COUNT, std::to_string(thread_count),
+                               thread_name),
+                 policy.max_threads);
+      if (policy.min_threads < 1 || policy.min_threads > policy.max_threads ||
+          policy.max_threads >= static_cast<unsigned int>(max_thread_count)) {
+        LOG(error, "Invalid thread range of {}: [{}, {}]", thread_name,
+            policy.min_threads, policy.max_threads);
+        return INITFAIL;
+      }
+      thread_count = std::min<int>(
+          std::max<int>(thread_count, policy.min_threads), policy.max_threads);
+
       Threadpool *thread_pool = new Threadpool(thread_count, thread_name);
       if (thread_pool == NULL) {
         LOG(error, "Failed to new {} threadpool\n", thread_name.c_str());
         return INITFAIL;
       }
       thread_pools_[thread_name] = thread_pool;
+      if (policy.min_threads < policy.max_threads) {
+        tuner_->add_pool(thread_pool, policy);
+      }
     }
 
     if (thread_pools_.find(DEFAULT_THREAD_POOL) == thread_pools_.end()) {
@@ -221,6 +274,47 @@ std::string SedaConfig::get_thread_pool(std::string &stage_name) {
   return thread_name;
 }
 
+SedaConfig::status_t SedaConfig::init_stage_queue(const std::string &stage_name,
+                                                  Stage *stage) {
+  size_t capacity = 0;
+  str_to_val(seda_cfg_.get(QUEUE_CAPACITY, "0", stage_name), capacity);
+  if (capacity == 0) {
+    return SUCCESS;
+  }
+
+  size_t high = capacity;
+  size_t low = capacity / 2;
+  str_to_val(seda_cfg_.get(HIGH_WATERMARK, std::to_string(high), stage_name),
+             high);
+  str_to_val(seda_cfg_.get(LOW_WATERMARK, std::to_string(low), stage_name),
+             low);
+  if (high == 0 || high > capacity || low > high) {
+    LOG(error, "Invalid watermarks of stage {}: low={} high={} capacity={}",
+        stage_name, low, high, capacity);
+    return INITFAIL;
+  }
+
+  std::string policy_str = seda_cfg_.get(OVERLOAD_POLICY, "reject", stage_name);
+  str_to_lower(policy_str);
+  Stage::OverloadPolicy policy;
+  if (policy_str == "reject") {
+    policy = Stage::OVERLOAD_REJECT;
+  } else if (policy_str == "block") {
+    policy = Stage::OVERLOAD_BLOCK;
+  } else if (policy_str == "pause") {
+    policy = Stage::OVERLOAD_PAUSE;
+  } else {
+    LOG(error, "Unknown {} of stage {}: {}", OVERLOAD_POLICY, stage_name,
+        policy_str);
+    return INITFAIL;
+  }
+
+  stage->set_queue_limits(capacity, high, low, policy);
+  LOG(info, "Stage {} queue capacity={} watermarks=[{}, {}] policy={}",
+      stage_name, capacity, low, high, policy_str);
+  return SUCCESS;
+}
+
 SedaConfig::status_t SedaConfig::init_stages() {
   try {
     // 获取所有stage的名称
@@ -257,6 +351,10 @@ SedaConfig::status_t SedaConfig::init_stages() {
       }
       stages_[stage_name] = stage;
       stage->set_pool(t);
+      if (init_stage_queue(stage_name, stage) != SUCCESS) {
+        clear_config();
+        return INITFAIL;
+      }
 
       LOG(info, "Stage {} use threadpool {}.", stage_name.c_str(),
           thread_name.c_str());
@@ -373,6 +471,9 @@ void SedaConfig::clear_config() {
   }
   thread_pools_.clear();
   LOG(info, "Seda thread pools released");
+
+  delete tuner_;
+  tuner_ = nullptr;
 }
 
 void SedaConfig::get_stage_names(std::vector<std::string> &names) const {
@@ -387,6 +488,24 @@ void SedaConfig::get_stage_queue_status(std::vector<int> &stats) const {
   }
 }
 
+std::string SedaConfig::stage_report() {
+  std::stringstream ss;
+  for (std::map<std::string, Stage *>::const_iterator i = stages_.begin();
+       i != stages_.end(); ++i) {
+    Stage *stg = i->second;
+    ss << i->first << ": queue=" << stg->qlen() << "\n"
+       << stg->metrics().report();
+  }
+  return ss.str();
+}
+
+std::string SedaConfig::thread_pool_report() {
+  if (tuner_ == nullptr) {
+    return "";
+  }
+  return tuner_->stats_report();
+}
+
 // Global seda config object
 SedaConfig *&get_seda_config() {
   static SedaConfig *seda_config = NULL;
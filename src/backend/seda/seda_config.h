@@ -10,6 +10,7 @@
 #include "backend/seda/session_stage.h"
 #include "backend/seda/stage.h"
 #include "backend/seda/thread_pool.h"
+#include "backend/seda/thread_pool_tuner.h"
 #include "common/ini_parser.h"
 #include "common/string.h"
 
@@ -46,10 +47,15 @@ class Seda {
 
   std::string get(const std::string &key, const std::string &defaultValue,
                   const std::string &section) {
-    if (seda_.find(section) == seda_.end()) {
+    auto sec = seda_.find(section);
+    if (sec == seda_.end()) {
+      return defaultValue;
+    }
+    auto it = sec->second.find(key);
+    if (it == sec->second.end()) {
       return defaultValue;
     }
-    return seda_[section][key];
+    return it->second;
   }
 
   static const char CFG_DELIMIT_TAG = ',';
@@ -60,11 +66,24 @@ class Seda {
        {{"EventHistory", "false"},
         {"MaxEventHistoryNum", "100"},
         {THREAD_POOLS_NAME, "SQLThreads,IOThreads,DefaultThreads"},
-        {"STAGES", "SessionStage"}}},
-      {"SQLThreads", {{"count", "3"}}},
+        {TUNE_INTERVAL, "200"},
+        {TRACE_SAMPLE_RATE, "0"},
+        {"STAGES", "SessionStage,ParseStage,ResolveStage,ExecuteStage"}}},
+      {"SQLThreads", {{"count", "3"}, {MIN_COUNT, "2"}, {MAX_COUNT, "16"}}},
       {"IOThreads", {{"count", "3"}}},
       {DEFAULT_THREAD_POOL, {{COUNT, "3"}}},
-      {SESSION_STAGE_NAME, {{THREAD_POOL_ID, "SQLThreads"}}}};
+      {SESSION_STAGE_NAME,
+       {{THREAD_POOL_ID, "SQLThreads"},
+        {QUEUE_CAPACITY, "4096"},
+        {HIGH_WATERMARK, "3072"},
+        {LOW_WATERMARK, "1024"},
+        {OVERLOAD_POLICY, "pause"},
+        {NEXT_STAGES, PARSE_STAGE_NAME}}},
+      {PARSE_STAGE_NAME,
+       {{THREAD_POOL_ID, "SQLThreads"}, {NEXT_STAGES, RESOLVE_STAGE_NAME}}},
+      {RESOLVE_STAGE_NAME,
+       {{THREAD_POOL_ID, "SQLThreads"}, {NEXT_STAGES, EXECUTE_STAGE_NAME}}},
+      {EXECUTE_STAGE_NAME, {{THREAD_POOL_ID, "IOThreads"}}}};
 };
 
 /**
@@ -152,6 +171,16 @@ class SedaConfig {
    */
   void get_stage_queue_status(std::vector<int> &stats) const;
 
+  /**
+   * Report the load and resize counters of the adaptive thread pools
+   */
+  std::string thread_pool_report();
+
+  /**
+   * 各个stage的队列长度和延迟统计
+   */
+  std::string stage_report();
+
   std::map<std::string, Stage *>::iterator begin();
   std::map<std::string, Stage *>::iterator end();
 
@@ -173,6 +202,9 @@ class SedaConfig {
 
   std::string get_thread_pool(std::string &stage_name);
 
+  // 根据配置设置 stage 队列的容量、高低水位和过载策略
+  status_t init_stage_queue(const std::string &stage_name, Stage *stage);
+
   status_t init_stages();
   status_t gen_next_stages();
 
@@ -197,6 +229,7 @@ class SedaConfig {
   std::map<std::string, Stage *> stages_;  // stage_name -> stage
   std::vector<std::string> stage_names_;
   Seda seda_cfg_;
+  ThreadpoolTuner *tuner_ = nullptr;  // resizes pools with MinCount<MaxCount
 };
 
 inline std::map<std::string, Stage *>::iterator SedaConfig::begin() {
@@ -9,9 +9,24 @@ namespace vulcan {
 #define THREAD_POOLS_NAME "ThreadPools"  // 配置文件中ThreadPools字段名
 #define STAGES "STAGES"                  // 配置文件中STAGES字段名
 #define SESSION_STAGE_NAME "SessionStage"
+#define PARSE_STAGE_NAME "ParseStage"
+#define RESOLVE_STAGE_NAME "ResolveStage"
+#define EXECUTE_STAGE_NAME "ExecuteStage"
 #define COUNT "count"  // 配置文件中线程池大小count字段名
+#define MIN_COUNT "MinCount"  // 线程池自适应调整时的最小线程数
+#define MAX_COUNT "MaxCount"  // 线程池自适应调整时的最大线程数
+#define TUNE_INTERVAL "TuneIntervalMs"  // 线程池负载采样间隔(毫秒)
+#define TRACE_SAMPLE_RATE "TraceSampleRate"  // 每N个事件采样一个做trace，0为关闭
 #define THREAD_POOL_ID "ThreadId"  // 配置文件中线程池id字段名
 #define NEXT_STAGES "NextStages"   // 配置文件中下一个stage字段名
 #define DEFAULT_THREAD_POOL "DefaultThreads"  // 配置文件中默认线程池大小字段名
+#define QUEUE_CAPACITY "QueueCapacity"  // stage队列容量，0表示不限制
+#define HIGH_WATERMARK "HighWatermark"  // 队列长度达到该值时进入过载状态
+#define LOW_WATERMARK "LowWatermark"    // 队列长度回落到该值时解除过载
+#define OVERLOAD_POLICY "OverloadPolicy"  // 过载策略: reject/block/pause
+
+#define STATS_COMMAND "stats"  // 查询服务器运行统计信息的命令
+#define TRACE_COMMAND "trace"  // 导出采样的stage事件时间线的命令
+#define LOCK_REPORT_TOP_N 10   // stats中列出等待时间最长的加锁位置数
 
 }  // namespace vulcan
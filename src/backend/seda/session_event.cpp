@@ -4,7 +4,8 @@
 
 namespace vulcan {
 
-SessionEvent::SessionEvent(ConnectionContext *client) : client_(client) {}
+SessionEvent::SessionEvent(ConnectionContext *client, std::string request)
+    : client_(client), request_(std::move(request)) {}
 
 SessionEvent::~SessionEvent() {}
 
@@ -28,8 +29,8 @@ void SessionEvent::set_response(std::string &&response) {
 
 int SessionEvent::get_response_len() const { return response_.size(); }
 
-char *SessionEvent::get_request_buf() { return client_->buf; }
+const char *SessionEvent::get_request_buf() const { return request_.c_str(); }
 
-int SessionEvent::get_request_buf_len() { return SOCKET_BUFFER_SIZE; }
+int SessionEvent::get_request_buf_len() const { return request_.size(); }
 
 }  // namespace vulcan
@@ -14,7 +14,8 @@ class Session;
 
 class SessionEvent : public StageEvent {
  public:
-  explicit SessionEvent(ConnectionContext *client);
+  // 请求内容拷贝到事件中，连接的接收缓冲区可以继续读取下一个请求
+  SessionEvent(ConnectionContext *client, std::string request);
   virtual ~SessionEvent();
 
   ConnectionContext *get_client() const;
@@ -25,12 +26,16 @@ class SessionEvent : public StageEvent {
   void set_response(const char *response, int len);
   void set_response(std::string &&response);
   int get_response_len() const;
-  char *get_request_buf();
-  int get_request_buf_len();
+  // 取走响应内容，避免发送时再拷贝一次
+  std::string take_response() { return std::move(response_); }
+  const char *get_request_buf() const;
+  int get_request_buf_len() const;
 
  private:
   ConnectionContext *client_;
 
+  std::string request_;
+
   std::string response_;
 };
 
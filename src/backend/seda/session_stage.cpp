@@ -3,21 +3,25 @@
 
 #include <list>
 #include <string>
+#include <utility>
 
 #include "backend/seda/callback.h"
+#include "backend/seda/query_stage_event.h"
+#include "backend/seda/seda_config.h"
+#include "backend/seda/seda_defs.h"
 #include "backend/seda/session_event.h"
+#include "backend/seda/stage_stats.h"
 #include "backend/server.h"
+#include "backend/vulcan_param.h"
+#include "common/lock_profiler.h"
 #include "common/string.h"
 #include "common/vulcan_logger.h"
-// TODO(Ziming zhang): 引入对应的头文件
-// #include "backend/seda/parse_stage.h"
-// #include "backend/seda/sql_stage_event.h"
 
 namespace vulcan {
 
 // Constructor
 SessionStage::SessionStage(const char *tag)
-    : Stage(tag), plan_cache_stage_(nullptr) {}
+    : Stage(tag), parse_stage_(nullptr) {}
 
 // Destructor
 SessionStage::~SessionStage() {}
@@ -50,8 +54,10 @@ bool SessionStage::set_properties() {
 bool SessionStage::initialize() {
   LOG(trace, "SessionStage initializing");
 
-  std::list<Stage *>::iterator stgp = next_stage_list_.begin();
-  plan_cache_stage_ = *(stgp++);
+  // 未配置 NextStages 时只能响应 stats/trace 等内置命令
+  if (!next_stage_list_.empty()) {
+    parse_stage_ = next_stage_list_.front();
+  }
 
   LOG(trace, "SessionStage initialized successfully");
   return true;
@@ -77,61 +83,126 @@ void SessionStage::handle_event(StageEvent *event) {
 void SessionStage::callback_event(StageEvent *event, CallbackContext *context) {
   LOG(trace, "Enter\n");
 
-  SessionEvent *sev = dynamic_cast<SessionEvent *>(event);
-  if (nullptr == sev) {
-    LOG(error, "Cannot cat event to sessionEvent");
-    return;
+  SessionEvent *sev = nullptr;
+  std::string response;
+  QueryStageEvent *qev = dynamic_cast<QueryStageEvent *>(event);
+  if (qev != nullptr) {
+    sev = qev->session_event();
+    response = qev->take_response();
+    delete qev;
+  } else {
+    sev = dynamic_cast<SessionEvent *>(event);
+    if (nullptr == sev) {
+      LOG(error, "Cannot cat event to sessionEvent");
+      return;
+    }
+    response = sev->take_response();
   }
 
-  const char *response = sev->get_response();
-  int len = sev->get_response_len();
-  if (len <= 0 || response == nullptr) {
+  if (response.empty()) {
     response = "No data\n";
-    len = strlen(response) + 1;
-  }
-  Server::send(sev->get_client(), response, len);
-  if ('\0' != response[len - 1]) {
-    // 这里强制性的给发送一个消息终结符，如果需要发送多条消息，需要调整
-    char end = 0;
-    Server::send(sev->get_client(), &end, 1);
   }
+  // 响应与消息终结符进入连接的发送队列，由 reactor 异步发送，不阻塞工作线程
+  Server::send_response(sev->get_client(), std::move(response));
+  delete sev;
 
-  // sev->done();
   LOG(trace, "Exit\n");
   return;
 }
 
-void SessionStage::handle_request(StageEvent *event) {
+void SessionStage::timeout_event(StageEvent *event, CallbackContext *context) {
+  QueryStageEvent *qev = dynamic_cast<QueryStageEvent *>(event);
+  if (nullptr == qev) {
+    callback_event(event, context);
+    return;
+  }
+
+  SessionEvent *sev = qev->session_event();
+  LOG(warn, "Query from {} timed out: {}", sev->get_client()->addr,
+      qev->query_text());
+  delete qev;
+  Server::send_timeout(sev->get_client());
+  delete sev;
+}
+
+void SessionStage::expire_event(StageEvent *event) {
   SessionEvent *sev = dynamic_cast<SessionEvent *>(event);
   if (nullptr == sev) {
     LOG(error, "Cannot cat event to sessionEvent");
+    event->done_timeout();
     return;
   }
 
-  // TODO(Ziming Zhang): 将sql发送给parse_stage_，并且注册回调函数
+  LOG(warn, "Request from {} timed out in queue", sev->get_client()->addr);
+  Server::send_timeout(sev->get_client());
+  sev->done_timeout();
+}
+
+std::string SessionStage::stats_report() {
+  std::string report = "[server]\n";
+  report += Server::stats_report();
+  report += "[thread_pools]\n";
+  report += SedaConfig::get_instance()->thread_pool_report();
+  report += "[stages]\n";
+  report += SedaConfig::get_instance()->stage_report();
+  report += "[locks]\n";
+  report += LockProfiler::report(LOCK_REPORT_TOP_N);
+  return report;
+}
+
+std::string SessionStage::trace_report() {
+  std::string path =
+      VulcanParam::get_instance()->get(VULCAN_LOG_DIR) + "/seda_trace.json";
+  int count = SedaTracer::get_instance()->dump(path);
+  if (count < 0) {
+    return "ERROR: failed to write " + path + "\n";
+  }
+  return "dump " + std::to_string(count) + " trace events to " + path + "\n";
+}
 
-  //   std::string sql = sev->get_request_buf();
-  //   if (is_blank(sql.c_str())) {
-  //     sev->done_immediate();
-  //     return;
-  //   }
+void SessionStage::handle_request(StageEvent *event) {
+  SessionEvent *sev = dynamic_cast<SessionEvent *>(event);
+  if (nullptr == sev) {
+    LOG(error, "Cannot cat event to sessionEvent");
+    return;
+  }
 
   LOG(info, "SessionStage is handling event {}", sev->get_request_buf());
-  sev->set_response("Hello, world!\n", strlen("Hello, world!\n") + 1);
+  std::string request = sev->get_request_buf();
+  strip(request);
+  std::string command = request;
+  str_to_lower(command);
 
   CompletionCallback *cb = new (std::nothrow) CompletionCallback(this, nullptr);
   if (cb == nullptr) {
     LOG(error, "Failed to new callback for SessionEvent");
+    Server::send_response(sev->get_client(),
+                          "ERROR: server is out of memory\n");
+    delete sev;
+    return;
+  }
 
+  if (command == STATS_COMMAND || command == TRACE_COMMAND ||
+      parse_stage_ == nullptr) {
+    if (command == STATS_COMMAND) {
+      sev->set_response(stats_report());
+    } else if (command == TRACE_COMMAND) {
+      sev->set_response(trace_report());
+    } else {
+      sev->set_response("ERROR: query pipeline is not configured\n");
+    }
+    sev->push_callback(cb);
     sev->done_immediate();
     return;
   }
 
-  sev->push_callback(cb);
-
-  //   SQLStageEvent *sql_event = new SQLStageEvent(sev, sql);
-  //   parse_stage_->handle_event(sql_event);
-  sev->done_immediate();
+  // 查询事件完成后回到本 stage 的线程发送响应
+  QueryStageEvent *qev = new QueryStageEvent(sev, request);
+  qev->push_callback(cb);
+  if (!parse_stage_->add_event(qev)) {
+    qev->set_error("server is busy, please retry later");
+    qev->done_immediate();
+  }
 }
 
 }  // namespace vulcan
@@ -29,14 +29,23 @@ class SessionStage : public Stage {
   void handle_event(StageEvent *event) override;
   void callback_event(StageEvent *event,
                       CallbackContext *context) override;
+  // 请求在队列中超过期限，直接返回超时错误
+  void expire_event(StageEvent *event) override;
+  // 查询在下游 stage 中超时，回到这里返回超时错误并释放事件
+  void timeout_event(StageEvent *event, CallbackContext *context) override;
 
  protected:
   void handle_input(StageEvent *event);
 
   void handle_request(StageEvent *event);
 
+  // 汇总各模块的运行统计信息，作为 stats 命令的响应
+  std::string stats_report();
+  // 导出采样的stage时间线，返回给客户端的提示信息
+  std::string trace_report();
+
  private:
-  Stage *plan_cache_stage_ = nullptr;
+  Stage *parse_stage_ = nullptr;
 };
 
 }  // namespace vulcan
@@ -5,11 +5,15 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <utility>
+
 #include "backend/seda/seda_defs.h"
 #include "backend/seda/stage_event.h"
 #include "backend/seda/thread_pool.h"
 #include "common/mutex.h"
 #include "common/vulcan_logger.h"
+#include "common/vulcan_utility.h"
 
 namespace vulcan {
 
@@ -28,6 +32,7 @@ Stage::Stage(const char *tag)
 
   MUTEX_INIT(&list_mutex_, NULL);
   COND_INIT(&disconnect_cond_, NULL);
+  COND_INIT(&not_full_cond_, NULL);
   stage_name_ = new char[strlen(tag) + 1];
   snprintf(stage_name_, strlen(tag) + 1, "%s", tag);
   LOG(trace, "{}", "exit");
@@ -41,16 +46,23 @@ Stage::Stage(const char *tag)
 Stage::~Stage() {
   LOG(trace, "{}", "enter");
   assert(!connected_);
+  // deleting an event detaches its timeout info, which may be expiring and
+  // waiting for the queue lock, so the events are deleted outside of it
   MUTEX_LOCK(&list_mutex_);
-  while (event_list_.size() > 0) {
-    delete *(event_list_.begin());
-    event_list_.pop_front();
+  std::deque<StageEvent *, PoolAllocator<StageEvent *>> pending;
+  pending.swap(event_list_);
+  for (StageEvent *event : pending) {
+    event->set_queued_stage(nullptr);
   }
   MUTEX_UNLOCK(&list_mutex_);
+  for (StageEvent *event : pending) {
+    delete event;
+  }
   next_stage_list_.clear();
 
   MUTEX_DESTROY(&list_mutex_);
   COND_DESTROY(&disconnect_cond_);
+  COND_DESTROY(&not_full_cond_);
   delete[] stage_name_;
   LOG(trace, "{}", "exit");
 }
@@ -119,6 +131,7 @@ void Stage::disconnect() {
   MUTEX_LOCK(&list_mutex_);
   disconnect_prepare();
   connected_ = false;
+  COND_BRAODCAST(&not_full_cond_);
   while (event_ref_ > 0) {
     COND_WAIT(&disconnect_cond_, &list_mutex_);
   }
@@ -136,15 +149,45 @@ void Stage::disconnect() {
  * @pre  event non-null
  * @post event added to the end of event queue
  * @post event must not be de-referenced by caller after return
+ * @return false if the event is rejected because the queue is full
  */
-void Stage::add_event(StageEvent *event) {
+bool Stage::add_event(StageEvent *event) {
   assert(event != NULL);
 
+  uint64_t start_us = monotonic_us();
   MUTEX_LOCK(&list_mutex_);
 
+  if (queue_capacity_ > 0 && event_list_.size() >= queue_capacity_) {
+    // 工作线程阻塞等待时，负责消费队列的线程可能正是它自己或同一线程池
+    // 中同样在等待的线程，因此 stage 线程中的 block 策略退化为拒绝
+    bool on_stage_thread = Threadpool::get_thread_pool_ptr() != NULL;
+    if (overload_policy_ == OVERLOAD_REJECT ||
+        (overload_policy_ == OVERLOAD_BLOCK && on_stage_thread)) {
+      MUTEX_UNLOCK(&list_mutex_);
+      LOG(warn, "Stage {} is full(capacity={}), reject event", stage_name_,
+          queue_capacity_);
+      return false;
+    }
+    if (overload_policy_ == OVERLOAD_BLOCK) {
+      while (connected_ && event_list_.size() >= queue_capacity_) {
+        COND_WAIT(&not_full_cond_, &list_mutex_);
+      }
+    }
+    // OVERLOAD_PAUSE: 依靠上游停止读取来限流，这里仍然接受事件
+  }
+
   // add event to back of queue
+  event->set_enqueue_time(monotonic_us());
+  event->set_queued_stage(this);
   event_list_.push_back(event);
 
+  bool became_overloaded = false;
+  if (high_watermark_ > 0 && !overloaded_ &&
+      event_list_.size() >= high_watermark_) {
+    overloaded_ = true;
+    became_overloaded = true;
+  }
+
   if (connected_) {
     assert(th_pool_ != NULL);
 
@@ -154,8 +197,39 @@ void Stage::add_event(StageEvent *event) {
   } else {
     MUTEX_UNLOCK(&list_mutex_);
   }
+
+  if (became_overloaded) {
+    LOG(warn, "Stage {} reaches high watermark {}", stage_name_,
+        high_watermark_);
+    if (watermark_listener_) {
+      watermark_listener_(this, true);
+    }
+  }
+
+  // the event may already be handled and freed by a worker thread here
+  metrics_.enqueue.record(monotonic_us() - start_us);
+  return true;
+}
+
+void Stage::set_queue_limits(size_t capacity, size_t high, size_t low,
+                             OverloadPolicy policy) {
+  ASSERT(!connected_, "attempt to set queue limits while connected: {}",
+         stage_name_);
+  ASSERT(capacity == 0 || (low <= high && high <= capacity),
+         "invalid watermarks of stage {}: low={} high={} capacity={}",
+         stage_name_, low, high, capacity);
+  queue_capacity_ = capacity;
+  high_watermark_ = high;
+  low_watermark_ = low;
+  overload_policy_ = policy;
+}
+
+void Stage::set_watermark_listener(WatermarkListener listener) {
+  watermark_listener_ = std::move(listener);
 }
 
+void Stage::expire_event(StageEvent *event) { event->done_timeout(); }
+
 /**
  * Query length of queue
  * @return length of event queue.
@@ -185,22 +259,74 @@ bool Stage::qempty() const {
 /**
  * Remove an event from the queue.  Called only by service thread.
  *
- * @pre queue not empty.
- * @return first event on queue.
+ * @return first event on queue, or NULL if the event scheduled for this
+ *         run has been withdrawn by its timeout.
  * @post  first event on queue is removed from queue.
  */
 StageEvent *Stage::remove_event() {
   MUTEX_LOCK(&list_mutex_);
 
-  assert(!event_list_.empty());
+  if (event_list_.empty()) {
+    MUTEX_UNLOCK(&list_mutex_);
+    return NULL;
+  }
 
   StageEvent *se = *(event_list_.begin());
   event_list_.pop_front();
+  se->set_queued_stage(nullptr);
+
+  bool recovered = dequeued();
   MUTEX_UNLOCK(&list_mutex_);
 
+  if (recovered) {
+    notify_recovered();
+  }
+
   return se;
 }
 
+bool Stage::withdraw_event(StageEvent *event) {
+  MUTEX_LOCK(&list_mutex_);
+
+  auto it = std::find(event_list_.begin(), event_list_.end(), event);
+  if (it == event_list_.end()) {
+    MUTEX_UNLOCK(&list_mutex_);
+    return false;
+  }
+  event_list_.erase(it);
+  event->set_queued_stage(nullptr);
+
+  // the run scheduled for this event finds the queue short and only
+  // releases its reference
+  bool recovered = dequeued();
+  MUTEX_UNLOCK(&list_mutex_);
+
+  if (recovered) {
+    notify_recovered();
+  }
+  return true;
+}
+
+bool Stage::dequeued() {
+  if (queue_capacity_ > 0 && event_list_.size() < queue_capacity_) {
+    COND_SIGNAL(&not_full_cond_);
+  }
+
+  if (overloaded_ && event_list_.size() <= low_watermark_) {
+    overloaded_ = false;
+    return true;
+  }
+  return false;
+}
+
+void Stage::notify_recovered() {
+  LOG(info, "Stage {} drains to low watermark {}", stage_name_,
+      low_watermark_);
+  if (watermark_listener_) {
+    watermark_listener_(this, false);
+  }
+}
+
 /**
  * Release event reference on stage.  Called only by service thread.
  *
@@ -1,10 +1,14 @@
 // Copyright 2023 VulcanDB
 #pragma once
 
+#include <atomic>
 #include <deque>
+#include <functional>
 #include <list>
 #include <string>
 
+#include "backend/seda/stage_stats.h"
+#include "common/object_pool.h"
 #include "common/vulcan_logger.h"
 
 
@@ -74,6 +78,21 @@ class Stage {
   // public interface operations
 
  public:
+  /**
+   * 队列达到容量上限时对新事件的处理策略
+   */
+  enum OverloadPolicy {
+    OVERLOAD_REJECT,  ///< add_event 返回 false，由调用者处理被拒绝的事件
+    OVERLOAD_BLOCK,   ///< 阻塞生产者直到队列低于容量上限，stage 线程按拒绝处理
+    OVERLOAD_PAUSE,   ///< 接受事件，但通知上游(如 Server)暂停读取
+  };
+
+  /**
+   * 队列越过高水位或回落到低水位时的回调，参数为当前是否过载。
+   * 回调在入队/出队线程中执行，不持有队列锁。
+   */
+  typedef std::function<void(Stage *, bool)> WatermarkListener;
+
   /**
    * Destructor
    * @pre  stage is not connected
@@ -161,8 +180,43 @@ class Stage {
    * @post event added to the end of event queue
    * @post event must not be de-referenced by caller after return
    * @post event ref count on stage is incremented
+   * @return false if the queue is full and the policy is OVERLOAD_REJECT,
+   *         or OVERLOAD_BLOCK on a stage thread, the event is not queued
+   *         and still owned by the caller
    */
-  void add_event(StageEvent *event);
+  bool add_event(StageEvent *event);
+
+  /**
+   * Set the capacity and watermarks of the event queue
+   * @param[in] capacity  max number of queued events, 0 means unbounded
+   * @param[in] high      queue length at which the stage becomes overloaded
+   * @param[in] low       queue length at which the stage recovers
+   * @param[in] policy    how to handle events beyond the capacity
+   *
+   * @pre  low <= high <= capacity when capacity > 0
+   */
+  void set_queue_limits(size_t capacity, size_t high, size_t low,
+                        OverloadPolicy policy);
+
+  /**
+   * Register the listener notified on watermark transitions
+   */
+  void set_watermark_listener(WatermarkListener listener);
+
+  /**
+   * Query whether the queue has passed the high watermark and not yet
+   * drained to the low watermark
+   */
+  bool overloaded() const { return overloaded_; }
+
+  OverloadPolicy overload_policy() const { return overload_policy_; }
+  size_t queue_capacity() const { return queue_capacity_; }
+  size_t high_watermark() const { return high_watermark_; }
+
+  /**
+   * Latency histograms of this stage
+   */
+  StageMetrics &metrics() { return metrics_; }
 
   /**
    * Query length of queue
@@ -213,6 +267,25 @@ class Stage {
     this->callback_event(event, context);
   }
 
+  /**
+   * Perform Stage-specific processing for an event which has timed out
+   * while waiting in the queue of this stage, instead of \c handle_event.
+   * By default the callbacks are unwound with \c timeout_event.
+   *
+   * @post  event must not be de-referenced by caller after return
+   */
+  virtual void expire_event(StageEvent *event);
+
+  /**
+   * Take an event out of the queue before a service thread removes it,
+   * used to time out events that are still waiting when their deadline
+   * is reached.
+   *
+   * @return true if the event was queued in this stage, the caller owns
+   *         it afterwards
+   */
+  bool withdraw_event(StageEvent *event);
+
  protected:
   /**
    * Constructor
@@ -227,8 +300,8 @@ class Stage {
   /**
    * Remove an event from the queue. Called only by service thread.
    *
-   * @pre queue not empty
-   * @return first event on queue.
+   * @return first event on queue, or NULL if the event scheduled for this
+   *         run has been withdrawn by its timeout.
    * @post  first event on queue is removed from queue.
    */
   StageEvent *remove_event();
@@ -284,12 +357,31 @@ class Stage {
   friend class Threadpool;
 
  private:
-  std::deque<StageEvent *> event_list_;  // event queue
+  // Signal blocked producers and check the low watermark after an event
+  // leaves the queue, returns true if the stage recovered. Needs list_mutex_
+  bool dequeued();
+
+  // Report the recovery to the watermark listener, without list_mutex_
+  void notify_recovered();
+
+  // event queue, its blocks are recycled through the ObjectPool
+  std::deque<StageEvent *, PoolAllocator<StageEvent *>> event_list_;
   mutable pthread_mutex_t list_mutex_;   // protects the event queue
   pthread_cond_t disconnect_cond_;       // wait here for disconnect
+  pthread_cond_t not_full_cond_;         // blocked producers wait here
   bool connected_;                       // is stage connected to pool?
   int64_t event_ref_;                    // # of outstanding events
   Threadpool *th_pool_ = nullptr;        // Threadpool for this stage
+
+  // queue capacity and watermarks, 0 capacity means unbounded
+  size_t queue_capacity_ = 0;
+  size_t high_watermark_ = 0;
+  size_t low_watermark_ = 0;
+  OverloadPolicy overload_policy_ = OVERLOAD_REJECT;
+  std::atomic<bool> overloaded_{false};
+  WatermarkListener watermark_listener_;
+
+  StageMetrics metrics_;  // enqueue/queue wait/handle/callback latencies
 };
 
 inline void Stage::set_pool(Threadpool *th) {
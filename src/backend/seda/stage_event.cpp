@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "backend/seda/callback.h"
+#include "backend/seda/stage_stats.h"
 #include "backend/seda/timeout_info.h"
 #include "common/defs.h"
 #include "common/vulcan_logger.h"
@@ -18,9 +19,11 @@ StageEvent::StageEvent()
     : comp_cb_(NULL),
       ud_(NULL),
       cb_flag_(false),
-      history_(NULL),
       stage_hops_(0),
-      tm_info_(NULL) {}
+      tm_info_(NULL),
+      enqueue_us_(0),
+      queued_stage_(nullptr),
+      traced_(SedaTracer::get_instance()->should_sample()) {}
 
 // Destructor
 StageEvent::~StageEvent() {
@@ -31,14 +34,8 @@ StageEvent::~StageEvent() {
     delete top;
   }
 
-  // delete the history_ if present
-  if (history_) {
-    history_->clear();
-    delete history_;
-  }
-
   if (tm_info_) {
-    tm_info_->detach();
+    tm_info_->detach(this);
     tm_info_ = NULL;
   }
 }
@@ -100,19 +97,15 @@ UserData *StageEvent::get_user_data() { return ud_; }
 
 // Add stage to list of stages which have handled this event
 void StageEvent::save_stage(Stage *stg, HistType type) {
-  if (!history_) {
-    history_ = new std::list<HistEntry>;
-  }
-  if (history_) {
-    history_->push_back(std::make_pair(stg, type));
-    stage_hops_++;
-    ASSERT(stage_hops_ <= get_max_event_hops(), "Event exceeded max hops");
-  }
+  history_.push_back(std::make_pair(stg, type));
+  stage_hops_++;
+  ASSERT(stage_hops_ <= get_max_event_hops(), "Event exceeded max hops");
 }
 
-void StageEvent::set_timeout_info(time_t deadline) {
-  TimeoutInfo *tmi = new TimeoutInfo(deadline);
+void StageEvent::set_deadline(uint64_t deadline_ms) {
+  TimeoutInfo *tmi = new TimeoutInfo(deadline_ms);
   set_timeout_info(tmi);
+  tmi->arm();
 }
 
 void StageEvent::set_timeout_info(const StageEvent &ev) {
@@ -122,12 +115,12 @@ void StageEvent::set_timeout_info(const StageEvent &ev) {
 void StageEvent::set_timeout_info(TimeoutInfo *tmi) {
   // release the previous timeout info
   if (tm_info_) {
-    tm_info_->detach();
+    tm_info_->detach(this);
   }
 
   tm_info_ = tmi;
   if (tm_info_) {
-    tm_info_->attach();
+    tm_info_->attach(this);
   }
 }
 
@@ -4,6 +4,7 @@
 // Include Files
 #include <time.h>
 
+#include <atomic>
 #include <list>
 #include <map>
 #include <string>
@@ -11,6 +12,7 @@
 
 #include "backend/seda/timeout_info.h"
 #include "common/defs.h"
+#include "common/object_pool.h"
 
 namespace vulcan {
 
@@ -45,8 +47,10 @@ class TimeoutInfo;
  * Calling done_immediate() has the same effect as done(), except that the
  * callbacks are executed on the current stack.
  * </ul>
+ * Events and their history are allocated from the per-thread ObjectPool,
+ * so deleting an event in done() returns it to the pool.
  */
-class StageEvent {
+class StageEvent : public PooledObject {
  public:
   // Interface for collecting debugging information
   typedef enum { HANDLE_EV = 0, CALLBACK_EV, TIMEOUT_EV } HistType;
@@ -54,7 +58,8 @@ class StageEvent {
   /**
    *  Constructor
    *  Should not create StageEvents on the stack.  done() assumes that
-   *  event is dynamically allocated.
+   *  event is dynamically allocated.  Hold events that are not yet handed
+   *  to a stage in a std::unique_ptr.
    */
   StageEvent();
 
@@ -104,9 +109,9 @@ class StageEvent {
 
   /**
    * Set a timeout info into the event
-   * @param[in] deadline  deadline of the timeout
+   * @param[in] deadline_ms  deadline of the timeout, in monotonic_ms()
    */
-  void set_timeout_info(time_t deadline);
+  void set_deadline(uint64_t deadline_ms);
 
   // Share a timeout info with another \c StageEvent
   void set_timeout_info(const StageEvent &ev);
@@ -114,8 +119,24 @@ class StageEvent {
   // If the event has timed out (and should be dropped)
   bool has_timed_out();
 
+  // Time(monotonic_us) the event was last put on a stage queue
+  uint64_t enqueue_time() const { return enqueue_us_; }
+  void set_enqueue_time(uint64_t us) { enqueue_us_ = us; }
+
+  // Stage whose queue holds the event, null while it is being handled
+  Stage *queued_stage() const {
+    return queued_stage_.load(std::memory_order_acquire);
+  }
+  void set_queued_stage(Stage *stage) {
+    queued_stage_.store(stage, std::memory_order_release);
+  }
+
+  // True if the event is sampled by the SedaTracer
+  bool is_traced() const { return traced_; }
+
  private:
   typedef std::pair<Stage *, HistType> HistEntry;
+  typedef std::list<HistEntry, PoolAllocator<HistEntry>> History;
 
   // Interface to allow callbacks to be run on target stage's threads
   void mark_callback() { cb_flag_ = true; }
@@ -127,9 +148,12 @@ class StageEvent {
   CompletionCallback *comp_cb_;    // completion callback stack for this event
   UserData *ud_;                   // user data associated with event by caller
   bool cb_flag_;                   // true if this event is a callback
-  std::list<HistEntry> *history_;  // List of stages which have handled ev
+  History history_;                // List of stages which have handled ev
   uint32_t stage_hops_;            // Number of stages which have handled ev
   TimeoutInfo *tm_info_;           // the timeout info for this event
+  uint64_t enqueue_us_;            // when the event was last enqueued
+  std::atomic<Stage *> queued_stage_;  // set by the stage queue holding it
+  bool traced_;                    // sampled into the chrome trace
 };
 
 /**
@@ -0,0 +1,77 @@
+// Copyright 2023 VulcanDB
+#include "backend/seda/stage_stats.h"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "common/defs.h"
+#include "common/mutex.h"
+#include "common/vulcan_logger.h"
+
+namespace vulcan {
+
+std::string StageMetrics::report() const {
+  std::stringstream ss;
+  ss << "  enqueue_us: " << enqueue.summary() << "\n"
+     << "  queue_wait_us: " << queue_wait.summary() << "\n"
+     << "  handle_us: " << handle.summary() << "\n"
+     << "  callback_us: " << callback.summary() << "\n";
+  return ss.str();
+}
+
+SedaTracer *SedaTracer::get_instance() {
+  static SedaTracer instance;
+  return &instance;
+}
+
+SedaTracer::SedaTracer() { MUTEX_INIT(&mutex_, NULL); }
+
+bool SedaTracer::should_sample() {
+  uint32_t rate = sample_rate_.load(std::memory_order_relaxed);
+  if (rate == 0) {
+    return false;
+  }
+  return event_seq_.fetch_add(1, std::memory_order_relaxed) % rate == 0;
+}
+
+void SedaTracer::record(const char *stage, const char *phase,
+                        uint64_t start_us, uint64_t duration_us) {
+  int64_t tid = gettid();
+  MUTEX_LOCK(&mutex_);
+  if (events_.size() < MAX_EVENTS) {
+    events_.push_back({stage, phase, start_us, duration_us, tid});
+  }
+  MUTEX_UNLOCK(&mutex_);
+}
+
+int SedaTracer::dump(const std::string &path) {
+  std::vector<TraceEvent> events;
+  MUTEX_LOCK(&mutex_);
+  events.swap(events_);
+  MUTEX_UNLOCK(&mutex_);
+
+  std::ofstream out(path, std::ios::out | std::ios::trunc);
+  if (!out.is_open()) {
+    LOG(error, "Failed to open trace file {}", path);
+    return -1;
+  }
+
+  int pid = getpid();
+  out << "{\"traceEvents\":[";
+  for (size_t i = 0; i < events.size(); i++) {
+    const TraceEvent &ev = events[i];
+    out << (i == 0 ? "" : ",") << "\n{\"name\":\"" << ev.name
+        << "\",\"cat\":\"" << ev.phase << "\",\"ph\":\"X\",\"ts\":"
+        << ev.start_us << ",\"dur\":" << ev.duration_us << ",\"pid\":" << pid
+        << ",\"tid\":" << ev.tid << "}";
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  out.close();
+
+  LOG(info, "Dump {} trace events to {}", events.size(), path);
+  return static_cast<int>(events.size());
+}
+
+}  // namespace vulcan
@@ -0,0 +1,83 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <pthread.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/latency_histogram.h"
+
+namespace vulcan {
+
+/**
+ * @brief 一个 stage 的延迟统计，单位均为微秒。
+ *
+ * - enqueue:    add_event 本身的耗时(包括 OVERLOAD_BLOCK 策略下的阻塞)
+ * - queue_wait: 事件从入队到被工作线程取出的时间
+ * - handle:     handle_event 的执行时间
+ * - callback:   callback_event 的执行时间
+ */
+struct StageMetrics {
+  LatencyHistogram enqueue;
+  LatencyHistogram queue_wait;
+  LatencyHistogram handle;
+  LatencyHistogram callback;
+
+  std::string report() const;
+};
+
+/**
+ * @brief 按采样率记录 stage 事件的时间线，导出为 Chrome trace JSON
+ * (chrome://tracing 或 Perfetto 可直接打开)。
+ *
+ * 是否采样在事件创建时决定，同一个事件经过的所有 stage 都会被记录，
+ * 便于查看一次请求完整的排队和处理过程。缓冲区写满后丢弃新的记录。
+ */
+class SedaTracer {
+ public:
+  static SedaTracer *get_instance();
+
+  /**
+   * @brief 每 every_n 个事件采样一个，0 表示关闭
+   */
+  void set_sample_rate(uint32_t every_n) { sample_rate_ = every_n; }
+  bool should_sample();
+
+  /**
+   * @brief 记录一个完整区间("ph":"X")
+   * @param stage 区间名，使用 stage 名称
+   * @param phase 区间类别，如 queue/handle/callback
+   */
+  void record(const char *stage, const char *phase, uint64_t start_us,
+              uint64_t duration_us);
+
+  /**
+   * @brief 将已记录的区间写入文件并清空缓冲区
+   * @return 写入的区间个数，失败返回 -1
+   */
+  int dump(const std::string &path);
+
+ private:
+  SedaTracer();
+
+  struct TraceEvent {
+    std::string name;
+    const char *phase;
+    uint64_t start_us;
+    uint64_t duration_us;
+    int64_t tid;
+  };
+
+  static constexpr size_t MAX_EVENTS = 100000;
+
+  std::atomic<uint32_t> sample_rate_{0};
+  std::atomic<uint64_t> event_seq_{0};
+
+  pthread_mutex_t mutex_;  // protects events_
+  std::vector<TraceEvent> events_;
+};
+
+}  // namespace vulcan
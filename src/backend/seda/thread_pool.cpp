@@ -3,11 +3,15 @@
 
 #include <assert.h>
 
+#include <algorithm>
+
 #include "backend/seda/kill_thread_stage.h"
 #include "backend/seda/stage.h"
 #include "backend/seda/stage_event.h"
+#include "backend/seda/stage_stats.h"
 #include "common/mutex.h"
 #include "common/vulcan_logger.h"
+#include "common/vulcan_utility.h"
 
 namespace vulcan {
 
@@ -204,7 +208,7 @@ void Threadpool::schedule(Stage *stage) {
 
   MUTEX_LOCK(&run_mutex_);
   bool was_empty = run_queue_.empty();
-  run_queue_.push_back(stage);
+  run_queue_.emplace_back(stage, monotonic_us());
   // let current thread continue to run the target stage if there is
   // only one event and the target stage is in the same thread pool
   if (was_empty == false || this != get_thread_pool_ptr()) {
@@ -219,6 +223,28 @@ void Threadpool::schedule(Stage *stage) {
 // Get name of thread pool
 const std::string &Threadpool::get_name() { return name_; }
 
+Threadpool::LoadSample Threadpool::sample_load() {
+  LoadSample sample;
+  sample.nthreads = num_threads();
+
+  MUTEX_LOCK(&run_mutex_);
+  sample.n_idles = n_idles_;
+  sample.run_queue_len = run_queue_.size();
+  sample.dispatched = dispatched_;
+  sample.queue_wait_us = queue_wait_us_;
+  sample.max_queue_wait_us = max_queue_wait_us_;
+  // 仍在排队的事件也计入等待时间，避免线程全部阻塞时看不到积压
+  if (!run_queue_.empty()) {
+    uint64_t oldest_wait = monotonic_us() - run_queue_.front().second;
+    sample.max_queue_wait_us = std::max(sample.max_queue_wait_us, oldest_wait);
+  }
+  dispatched_ = 0;
+  queue_wait_us_ = 0;
+  max_queue_wait_us_ = 0;
+  MUTEX_UNLOCK(&run_mutex_);
+  return sample;
+}
+
 /**
  * Internal thread control function
  * Function which contains the control loop for each service thread.
@@ -250,39 +276,63 @@ void *Threadpool::run_thread(void *pool_ptr) {
     }
 
     assert(!pool->run_queue_.empty());
-    Stage *run_stage = *(pool->run_queue_.begin());
+    Stage *run_stage = pool->run_queue_.front().first;
+    uint64_t wait_us = monotonic_us() - pool->run_queue_.front().second;
     pool->run_queue_.pop_front();
+    pool->dispatched_++;
+    pool->queue_wait_us_ += wait_us;
+    pool->max_queue_wait_us_ = std::max(pool->max_queue_wait_us_, wait_us);
     MUTEX_UNLOCK(&(pool->run_mutex_));
 
     StageEvent *event = run_stage->remove_event();
+    if (event == NULL) {
+      // the event was withdrawn and timed out by the TimerWheel
+      run_stage->release_event();
+      continue;
+    }
+
+    // the event may be freed while it is handled, read what we need first
+    uint64_t start_us = monotonic_us();
+    uint64_t enqueue_us = event->enqueue_time();
+    bool traced = event->is_traced();
+    bool is_callback = event->is_callback();
+    run_stage->metrics().queue_wait.record(start_us - enqueue_us);
+    if (traced) {
+      SedaTracer::get_instance()->record(run_stage->get_name(), "queue",
+                                         enqueue_us, start_us - enqueue_us);
+    }
 
     // need to check if this is a rescheduled callback
+    // the TimerWheel sets the timeout flag and withdraws the waiting events,
+    // an event expiring between the two is caught here
     if (event->is_callback()) {
-#ifdef ENABLE_STAGE_LEVEL_TIMEOUT
       // check if the event has timed out.
       if (event->has_timed_out()) {
         event->done_timeout();
       } else {
         event->done_immediate();
       }
-#else
-      event->done_immediate();
-#endif
     } else {
       if (pool->eventhist_) {
         event->save_stage(run_stage, StageEvent::HANDLE_EV);
       }
 
-#ifdef ENABLE_STAGE_LEVEL_TIMEOUT
       // check if the event has timed out
       if (event->has_timed_out()) {
-        event->done();
+        run_stage->expire_event(event);
       } else {
         run_stage->handle_event(event);
       }
-#else
-      run_stage->handle_event(event);
-#endif
+    }
+
+    if (!is_callback) {
+      // 回调的耗时由 CompletionCallback::event_done 记录
+      uint64_t handle_us = monotonic_us() - start_us;
+      run_stage->metrics().handle.record(handle_us);
+      if (traced) {
+        SedaTracer::get_instance()->record(run_stage->get_name(), "handle",
+                                           start_us, handle_us);
+      }
     }
     run_stage->release_event();
   }
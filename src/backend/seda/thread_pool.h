@@ -3,9 +3,11 @@
 
 #include <deque>
 #include <string>
+#include <utility>
 
 #include "backend/seda/kill_thread_stage.h"
 #include "common/defs.h"
+#include "common/object_pool.h"
 
 namespace vulcan {
 
@@ -30,12 +32,28 @@ class Stage;
  */
 class Threadpool {
  public:
+  /**
+   * 线程池在一个采样窗口内的负载情况，供 ThreadpoolTuner 调整线程数
+   */
+  struct LoadSample {
+    unsigned int nthreads = 0;     // 当前线程数
+    unsigned int n_idles = 0;      // 采样时空闲的线程数
+    size_t run_queue_len = 0;      // 采样时等待调度的事件数
+    uint64_t dispatched = 0;       // 窗口内被取出执行的事件数
+    uint64_t queue_wait_us = 0;    // 窗口内事件在运行队列中等待的总时间
+    uint64_t max_queue_wait_us = 0;  // 窗口内的最大等待时间
+  };
+
   // Initialize the static data structures of ThreadPool
   static void create_pool_key();
 
   // Finalize the static data structures of ThreadPool
   static void del_pool_key();
 
+  // Get the thread pool pointer for this thread, NULL if it is not a
+  // service thread
+  static const Threadpool *get_thread_pool_ptr();
+
   /**
    * Constructor
    * @param[in] threads The number of threads to create.
@@ -97,6 +115,11 @@ class Threadpool {
   // Get name of thread pool
   const std::string &get_name();
 
+  /**
+   * Take a load sample and reset the counters of the current window
+   */
+  LoadSample sample_load();
+
  protected:
   /**
    * Internal thread kill.
@@ -128,15 +151,19 @@ class Threadpool {
   // Save the thread pool pointer for this thread
   static void set_thread_pool_ptr(const Threadpool *thd_pool);
 
-  // Get the thread pool pointer for this thread
-  static const Threadpool *get_thread_pool_ptr();
-
   // run queue state
   pthread_mutex_t run_mutex_;      //< protects the run queue
   pthread_cond_t run_cond_;        //< wait here for stage to be scheduled
-  std::deque<Stage *> run_queue_;  //< list of stages with work to do
+  //< list of stages with work to do, with the time they were scheduled
+  typedef std::pair<Stage *, uint64_t> RunEntry;
+  std::deque<RunEntry, PoolAllocator<RunEntry>> run_queue_;
   bool eventhist_;                 //< is event history enabled?
 
+  // load statistics of the current sampling window, protected by run_mutex_
+  uint64_t dispatched_ = 0;
+  uint64_t queue_wait_us_ = 0;
+  uint64_t max_queue_wait_us_ = 0;
+
   // thread state
   pthread_mutex_t thread_mutex_;  //< protects thread state
   pthread_cond_t thread_cond_;    //< wait here when killing threads
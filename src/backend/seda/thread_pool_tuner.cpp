@@ -0,0 +1,168 @@
+// Copyright 2023 VulcanDB
+#include "backend/seda/thread_pool_tuner.h"
+
+#include <errno.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "common/defs.h"
+#include "common/mutex.h"
+#include "common/vulcan_logger.h"
+
+namespace vulcan {
+
+ThreadpoolTuner::ThreadpoolTuner(unsigned int interval_ms)
+    : interval_ms_(interval_ms) {
+  MUTEX_INIT(&mutex_, NULL);
+  COND_INIT(&cond_, NULL);
+}
+
+ThreadpoolTuner::~ThreadpoolTuner() {
+  stop();
+  MUTEX_DESTROY(&mutex_);
+  COND_DESTROY(&cond_);
+}
+
+void ThreadpoolTuner::add_pool(Threadpool *pool, const TunerPolicy &policy) {
+  ASSERT(!running_, "attempt to add threadpool {} while tuner is running",
+         pool->get_name());
+  PoolState state;
+  state.pool = pool;
+  state.policy = policy;
+  pools_.push_back(state);
+  LOG(info, "Threadpool {} is tuned in [{}, {}] threads", pool->get_name(),
+      policy.min_threads, policy.max_threads);
+}
+
+int ThreadpoolTuner::start() {
+  if (pools_.empty()) {
+    return 0;
+  }
+
+  MUTEX_LOCK(&mutex_);
+  running_ = true;
+  MUTEX_UNLOCK(&mutex_);
+
+  int ret = pthread_create(&thread_, NULL, ThreadpoolTuner::run, this);
+  if (ret != 0) {
+    LOG(error, "Failed to create threadpool tuner thread, {}", strerror(ret));
+    running_ = false;
+    return -1;
+  }
+  return 0;
+}
+
+void ThreadpoolTuner::stop() {
+  MUTEX_LOCK(&mutex_);
+  if (!running_) {
+    MUTEX_UNLOCK(&mutex_);
+    return;
+  }
+  running_ = false;
+  COND_SIGNAL(&cond_);
+  MUTEX_UNLOCK(&mutex_);
+
+  pthread_join(thread_, NULL);
+}
+
+void *ThreadpoolTuner::run(void *arg) {
+  ThreadpoolTuner *tuner = reinterpret_cast<ThreadpoolTuner *>(arg);
+  pthread_setname_np(pthread_self(), "PoolTuner");
+
+  while (true) {
+    MUTEX_LOCK(&tuner->mutex_);
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    uint64_t deadline_us = now.tv_sec * 1000000ULL + now.tv_usec +
+                           tuner->interval_ms_ * 1000ULL;
+    struct timespec abstime;
+    abstime.tv_sec = deadline_us / 1000000;
+    abstime.tv_nsec = (deadline_us % 1000000) * 1000;
+
+    int ret = 0;
+    while (tuner->running_ && ret != ETIMEDOUT) {
+      COND_WAIT_TIMEOUT(&tuner->cond_, &tuner->mutex_, &abstime, ret);
+    }
+    bool running = tuner->running_;
+    MUTEX_UNLOCK(&tuner->mutex_);
+
+    if (!running) {
+      break;
+    }
+
+    for (PoolState &state : tuner->pools_) {
+      tuner->tune(&state);
+    }
+  }
+  return NULL;
+}
+
+void ThreadpoolTuner::tune(PoolState *state) {
+  Threadpool::LoadSample sample = state->pool->sample_load();
+  const TunerPolicy &policy = state->policy;
+
+  uint64_t avg_wait_us =
+      sample.dispatched == 0 ? 0 : sample.queue_wait_us / sample.dispatched;
+  bool busy = sample.run_queue_len > sample.nthreads ||
+              avg_wait_us > policy.grow_wait_us ||
+              sample.max_queue_wait_us > policy.grow_wait_us * 4;
+  // 留一个空闲线程应对突发请求，多出来的空闲线程才考虑回收
+  bool idle = sample.run_queue_len == 0 &&
+              (sample.n_idles >= 2 ||
+               (sample.n_idles >= 1 && sample.dispatched == 0));
+
+  state->busy_samples = busy ? state->busy_samples + 1 : 0;
+  state->idle_samples = idle ? state->idle_samples + 1 : 0;
+
+  if (state->busy_samples >= policy.grow_samples &&
+      sample.nthreads < policy.max_threads) {
+    // 扩容要快：每次增加当前线程数的一半
+    unsigned int to_add =
+        std::min(std::max(sample.nthreads / 2, 1u),
+                 policy.max_threads - sample.nthreads);
+    unsigned int added = state->pool->add_threads(to_add);
+    LOG(info,
+        "Threadpool {} is busy(queue={}, avg wait={}us), add {} threads to {}",
+        state->pool->get_name(), sample.run_queue_len, avg_wait_us, added,
+        sample.nthreads + added);
+    MUTEX_LOCK(&mutex_);
+    state->grows++;
+    MUTEX_UNLOCK(&mutex_);
+    state->busy_samples = 0;
+    state->idle_samples = 0;
+  } else if (state->idle_samples >= policy.shrink_samples &&
+             sample.nthreads > policy.min_threads) {
+    // 缩容要慢：每次只退出一个线程，kill_threads 会等待线程退出
+    unsigned int killed = state->pool->kill_threads(1);
+    LOG(info, "Threadpool {} is idle, kill {} thread to {}",
+        state->pool->get_name(), killed, sample.nthreads - killed);
+    MUTEX_LOCK(&mutex_);
+    state->shrinks++;
+    MUTEX_UNLOCK(&mutex_);
+    state->idle_samples = 0;
+    state->busy_samples = 0;
+  }
+
+  MUTEX_LOCK(&mutex_);
+  state->last = sample;
+  MUTEX_UNLOCK(&mutex_);
+}
+
+std::string ThreadpoolTuner::stats_report() {
+  std::stringstream ss;
+  MUTEX_LOCK(&mutex_);
+  for (const PoolState &state : pools_) {
+    const Threadpool::LoadSample &last = state.last;
+    ss << state.pool->get_name() << ": threads=" << last.nthreads
+       << " idle=" << last.n_idles << " queue=" << last.run_queue_len
+       << " range=[" << state.policy.min_threads << ", "
+       << state.policy.max_threads << "]"
+       << " grows=" << state.grows << " shrinks=" << state.shrinks << "\n";
+  }
+  MUTEX_UNLOCK(&mutex_);
+  return ss.str();
+}
+
+}  // namespace vulcan
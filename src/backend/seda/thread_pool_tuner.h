@@ -0,0 +1,78 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <pthread.h>
+
+#include <string>
+#include <vector>
+
+#include "backend/seda/thread_pool.h"
+
+namespace vulcan {
+
+/**
+ * @brief 线程池自适应调整参数
+ */
+struct TunerPolicy {
+  unsigned int min_threads = 1;  // 线程数下限
+  unsigned int max_threads = 1;  // 线程数上限，等于下限时不调整
+  // 采样窗口内平均排队时间超过该值(微秒)，或排队事件多于线程数时视为过载
+  uint64_t grow_wait_us = 5000;
+  // 连续过载多少个采样窗口后扩容
+  unsigned int grow_samples = 2;
+  // 连续空闲多少个采样窗口后缩容，缩容比扩容更保守以避免抖动
+  unsigned int shrink_samples = 20;
+};
+
+/**
+ * @brief 根据负载自动调整线程池大小。
+ *
+ * 一个后台线程周期性地对每个注册的线程池调用 Threadpool::sample_load()，
+ * 根据排队长度和排队时间判断是否需要扩容或缩容。扩容使用 add_threads()，
+ * 缩容复用 kill_threads() 的 KillThreadStage 机制，每次只退出一个线程。
+ * 扩容和缩容都需要连续多个窗口满足条件才会触发(滞后)，并且在每次调整后
+ * 清零计数，保证线程数在 [min_threads, max_threads] 内平滑变化。
+ */
+class ThreadpoolTuner {
+ public:
+  explicit ThreadpoolTuner(unsigned int interval_ms);
+  ~ThreadpoolTuner();
+
+  /**
+   * @brief 注册一个需要自适应调整的线程池，必须在 start() 之前调用
+   */
+  void add_pool(Threadpool *pool, const TunerPolicy &policy);
+
+  int start();
+  void stop();
+
+  /**
+   * @brief 以文本形式输出各线程池的当前状态和调整次数
+   */
+  std::string stats_report();
+
+ private:
+  struct PoolState {
+    Threadpool *pool;
+    TunerPolicy policy;
+    unsigned int busy_samples = 0;  // 连续过载的窗口数
+    unsigned int idle_samples = 0;  // 连续空闲的窗口数
+    uint64_t grows = 0;
+    uint64_t shrinks = 0;
+    Threadpool::LoadSample last;
+  };
+
+  static void *run(void *arg);
+  void tune(PoolState *state);
+
+ private:
+  unsigned int interval_ms_;
+  std::vector<PoolState> pools_;
+
+  pthread_t thread_;
+  bool running_ = false;
+  pthread_mutex_t mutex_;  // protects running_ and pool states
+  pthread_cond_t cond_;    // wakes the tuner thread on stop
+};
+
+}  // namespace vulcan
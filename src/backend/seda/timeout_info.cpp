@@ -1,51 +1,89 @@
 // Copyright 2023 VulcanDB
 #include "backend/seda/timeout_info.h"
 
-#include <sys/time.h>
+#include <algorithm>
+#include <utility>
 
-#include "common/mutex.h"
+#include "backend/seda/stage.h"
+#include "backend/seda/stage_event.h"
+#include "common/vulcan_utility.h"
 
 namespace vulcan {
 
-TimeoutInfo::TimeoutInfo(time_t deadLine)
-    : deadline_(deadLine), is_timed_out_(false), ref_cnt_(0) {
-  MUTEX_INIT(&mutex_, NULL);
-}
+TimeoutInfo::TimeoutInfo(uint64_t deadline_ms)
+    : deadline_ms_(deadline_ms),
+      is_timed_out_(false),
+      ref_cnt_(0),
+      timer_id_(TimerWheel::INVALID_TIMER) {}
 
-TimeoutInfo::~TimeoutInfo() {
-  // unlock mutex_ as we locked it before 'delete this'
-  MUTEX_UNLOCK(&mutex_);
+TimeoutInfo::~TimeoutInfo() {}
 
-  MUTEX_DESTROY(&mutex_);
+void TimeoutInfo::arm() {
+  if (deadline_ms_ <= monotonic_ms()) {
+    is_timed_out_ = true;
+    return;
+  }
+  // take the timer's reference before it may fire, the wheel writes
+  // timer_id_ before the expiry can run
+  ref_cnt_.fetch_add(1, std::memory_order_relaxed);
+  TimerWheel::get_instance()->schedule(
+      deadline_ms_, [this]() { expire(); }, &timer_id_);
 }
 
-void TimeoutInfo::attach() {
-  MUTEX_LOCK(&mutex_);
-  ref_cnt_++;
-  MUTEX_UNLOCK(&mutex_);
+void TimeoutInfo::attach(StageEvent *event) {
+  TimerWheel *wheel = TimerWheel::get_instance();
+  wheel->lock();
+  events_.push_back(event);
+  wheel->unlock();
+  ref_cnt_.fetch_add(1, std::memory_order_relaxed);
 }
 
-void TimeoutInfo::detach() {
-  MUTEX_LOCK(&mutex_);
-  if (0 == --ref_cnt_) {
-    delete this;
-    return;
+void TimeoutInfo::detach(StageEvent *event) {
+  TimerWheel *wheel = TimerWheel::get_instance();
+  wheel->lock();
+  events_.erase(std::find(events_.begin(), events_.end(), event));
+  bool last = events_.empty();
+  wheel->unlock();
+
+  if (last && timer_id_ != TimerWheel::INVALID_TIMER &&
+      wheel->cancel(timer_id_)) {
+    // no event is waiting for the deadline any more, drop the timer's ref
+    release();
   }
-  MUTEX_UNLOCK(&mutex_);
+  release();
 }
 
-bool TimeoutInfo::has_timed_out() {
-  MUTEX_LOCK(&mutex_);
-  bool ret = is_timed_out_;
-  if (!is_timed_out_) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
+void TimeoutInfo::expire() {
+  is_timed_out_.store(true, std::memory_order_release);
 
-    ret = is_timed_out_ = (tv.tv_sec >= deadline_);
+  // an attached event can not be freed while the wheel's lock is held, its
+  // destructor detaches first. Once withdrawn from its queue the event is
+  // owned here, so the timeout path runs after the lock is released.
+  std::vector<std::pair<Stage *, StageEvent *>> withdrawn;
+  TimerWheel *wheel = TimerWheel::get_instance();
+  wheel->lock();
+  for (StageEvent *event : events_) {
+    Stage *stage = event->queued_stage();
+    if (stage != nullptr && stage->withdraw_event(event)) {
+      withdrawn.emplace_back(stage, event);
+    }
   }
-  MUTEX_UNLOCK(&mutex_);
+  wheel->unlock();
 
-  return ret;
+  for (auto &entry : withdrawn) {
+    if (entry.second->is_callback()) {
+      entry.second->done_timeout();
+    } else {
+      entry.first->expire_event(entry.second);
+    }
+  }
+  release();
+}
+
+void TimeoutInfo::release() {
+  if (ref_cnt_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
 }
 
 }  // namespace vulcan
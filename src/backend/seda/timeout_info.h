@@ -1,35 +1,58 @@
 // Copyright 2023 VulcanDB
 #pragma once
 
-#include <time.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
 
-#include "common/mutex.h"
+#include "backend/seda/timer_wheel.h"
 
 namespace vulcan {
 
+class StageEvent;
+
 /**
  * Timeout info class used to judge if a certain deadline_ has reached or not.
  * It's good to use handle-body to automate the reference count
  * increase/decrease. However, explicit attach/detach interfaces
  * are used here to simplify the implementation.
+ *
+ * The deadline is registered in the \c TimerWheel by \c arm(). When it
+ * expires, the info is marked as timed out and every attached event still
+ * waiting in a stage queue is withdrawn from it and handed to the stage's
+ * timeout path on the timer thread, so a request stuck behind busy workers
+ * is answered at its deadline. The wheel holds a reference of its own until
+ * the timer fires or is cancelled by the last \c detach() of the events.
+ * The list of attached events is guarded by \c TimerWheel::lock(), so
+ * detaching an event excludes a concurrent expiry without a lock per info.
  */
 
 class TimeoutInfo {
  public:
   /**
    * Constructor
-   * @param[in] deadline_  deadline_ of this timeout
+   * @param[in] deadline_ms  deadline of this timeout, in monotonic_ms()
    */
-  TimeoutInfo(time_t deadline_);
+  explicit TimeoutInfo(uint64_t deadline_ms);
+
+  // Increase ref count, the event is timed out with this info
+  void attach(StageEvent *event);
 
-  // Increase ref count
-  void attach();
+  /**
+   * Register the deadline in the timer wheel
+   * @pre the owning event has attached, so an early expiry can not free it
+   */
+  void arm();
 
   // Decrease ref count
-  void detach();
+  void detach(StageEvent *event);
 
   // Check if it has timed out
-  bool has_timed_out();
+  bool has_timed_out() const {
+    return is_timed_out_.load(std::memory_order_acquire);
+  }
+
+  uint64_t deadline() const { return deadline_ms_; }
 
  private:
   // Forbid copy ctor and =() to support ref count
@@ -40,6 +63,12 @@ class TimeoutInfo {
   // Assignment operator.
   TimeoutInfo &operator=(const TimeoutInfo &ti);
 
+  // Called by the timer wheel when the deadline is reached
+  void expire();
+
+  // Drop one reference held either by the events or by the timer
+  void release();
+
  protected:
   // Avoid heap-based \c TimeoutInfo
   // so it can easily associated with \c StageEvent
@@ -48,15 +77,14 @@ class TimeoutInfo {
   ~TimeoutInfo();
 
  private:
-  time_t deadline_;  // when should this be timed out
-
-  // used to predict timeout if now + reservedTime > deadline_
-  // time_t reservedTime;
+  uint64_t deadline_ms_;  // when should this be timed out
 
-  bool is_timed_out_;  // timeout flag
+  std::atomic<bool> is_timed_out_;  // timeout flag
 
-  int ref_cnt_;            // reference count of this object
-  pthread_mutex_t mutex_;  // mutex_ to protect ref_cnt_ and flag
+  std::vector<StageEvent *> events_;  // events sharing this info, guarded
+                                      // by TimerWheel::lock()
+  std::atomic<int> ref_cnt_;  // events_.size() + 1 while the timer is armed
+  TimerWheel::TimerId timer_id_;
 };
 
 }  // namespace vulcan
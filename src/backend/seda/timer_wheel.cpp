@@ -0,0 +1,285 @@
+// Copyright 2023 VulcanDB
+#include "backend/seda/timer_wheel.h"
+
+#include <errno.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "common/defs.h"
+#include "common/mutex.h"
+#include "common/vulcan_logger.h"
+#include "common/vulcan_utility.h"
+
+namespace vulcan {
+
+TimerWheel *TimerWheel::get_instance() {
+  static TimerWheel instance;
+  return &instance;
+}
+
+TimerWheel::TimerWheel() : current_ms_(monotonic_ms()) {
+  MUTEX_INIT(&mutex_, NULL);
+  COND_INIT(&cond_, NULL);
+}
+
+TimerWheel::~TimerWheel() {
+  stop();
+  for (auto &entry : timers_) {
+    delete entry.second;
+  }
+  timers_.clear();
+  MUTEX_DESTROY(&mutex_);
+  COND_DESTROY(&cond_);
+}
+
+int TimerWheel::start() {
+  MUTEX_LOCK(&mutex_);
+  if (running_) {
+    MUTEX_UNLOCK(&mutex_);
+    return 0;
+  }
+  running_ = true;
+  MUTEX_UNLOCK(&mutex_);
+
+  int ret = pthread_create(&thread_, NULL, TimerWheel::run, this);
+  if (ret != 0) {
+    LOG(error, "Failed to create timer wheel thread, {}", strerror(ret));
+    running_ = false;
+    return -1;
+  }
+  return 0;
+}
+
+void TimerWheel::stop() {
+  MUTEX_LOCK(&mutex_);
+  if (!running_) {
+    MUTEX_UNLOCK(&mutex_);
+    return;
+  }
+  running_ = false;
+  COND_SIGNAL(&cond_);
+  MUTEX_UNLOCK(&mutex_);
+
+  pthread_join(thread_, NULL);
+}
+
+TimerWheel::TimerId TimerWheel::schedule(uint64_t deadline_ms, Callback cb,
+                                         TimerId *id) {
+  TimerNode *node = new TimerNode();
+  node->deadline_ms = deadline_ms;
+  node->cb = std::move(cb);
+
+  MUTEX_LOCK(&mutex_);
+  if (timers_.empty()) {
+    // 空闲期间没有推进时间轮，先对齐到当前时间，避免之后逐毫秒追赶
+    current_ms_ = std::max(current_ms_, monotonic_ms());
+  }
+  // 当前时刻的槽已经处理过，已过期的定时器在下一次推进时触发
+  node->deadline_ms = std::max(node->deadline_ms, current_ms_ + 1);
+  node->id = next_id_++;
+  if (id != nullptr) {
+    // 到期回调要先获取锁才能被取出，调用者在回调中总能看到 id
+    *id = node->id;
+  }
+  timers_[node->id] = node;
+  link(node);
+  if (node->deadline_ms < wakeup_ms_) {
+    // 比定时器线程等待的时刻更早，唤醒它重新计算
+    COND_SIGNAL(&cond_);
+  }
+  TimerId node_id = node->id;
+  MUTEX_UNLOCK(&mutex_);
+  return node_id;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+  MUTEX_LOCK(&mutex_);
+  auto it = timers_.find(id);
+  if (it == timers_.end()) {
+    MUTEX_UNLOCK(&mutex_);
+    return false;
+  }
+  TimerNode *node = it->second;
+  timers_.erase(it);
+  unlink(node);
+  MUTEX_UNLOCK(&mutex_);
+
+  delete node;
+  return true;
+}
+
+size_t TimerWheel::size() {
+  MUTEX_LOCK(&mutex_);
+  size_t size = timers_.size();
+  MUTEX_UNLOCK(&mutex_);
+  return size;
+}
+
+void TimerWheel::lock() { MUTEX_LOCK(&mutex_); }
+
+void TimerWheel::unlock() { MUTEX_UNLOCK(&mutex_); }
+
+void TimerWheel::link(TimerNode *node) {
+  // 降级时 current_ms_ 是正在处理的时刻，剩余的定时器都不早于它
+  uint64_t expire = node->deadline_ms;
+  uint64_t delta = expire - current_ms_;
+
+  int level = 0;
+  while (level < LEVELS - 1 && delta >= (1ULL << (SLOT_BITS * (level + 1)))) {
+    level++;
+  }
+  if (delta >= (1ULL << (SLOT_BITS * LEVELS))) {
+    // 超出时间轮范围，先放在最高层最远的槽，降级时重新计算
+    expire = current_ms_ + (1ULL << (SLOT_BITS * LEVELS)) - 1;
+  }
+
+  Slot &slot = wheel_[level][(expire >> (SLOT_BITS * level)) & (SLOTS - 1)];
+  node->slot = &slot;
+  node->prev = nullptr;
+  node->next = slot.head;
+  if (slot.head != nullptr) {
+    slot.head->prev = node;
+  }
+  slot.head = node;
+}
+
+void TimerWheel::unlink(TimerNode *node) {
+  if (node->prev == nullptr) {
+    node->slot->head = node->next;
+  } else {
+    node->prev->next = node->next;
+  }
+  if (node->next != nullptr) {
+    node->next->prev = node->prev;
+  }
+  node->slot = nullptr;
+  node->prev = nullptr;
+  node->next = nullptr;
+}
+
+void TimerWheel::cascade(int level) {
+  int index = (current_ms_ >> (SLOT_BITS * level)) & (SLOTS - 1);
+  Slot &slot = wheel_[level][index];
+  TimerNode *node = slot.head;
+  slot.head = nullptr;
+  while (node != nullptr) {
+    TimerNode *next = node->next;
+    link(node);
+    node = next;
+  }
+}
+
+uint64_t TimerWheel::next_expiry() const {
+  uint64_t next = UINT64_MAX;
+  // 第 0 层的槽对应确切的到期时刻
+  for (uint64_t ms = current_ms_ + 1; ms < current_ms_ + SLOTS; ms++) {
+    if (wheel_[0][ms & (SLOTS - 1)].head != nullptr) {
+      next = ms;
+      break;
+    }
+  }
+  // 高层的槽在降级时才展开到低层，在降级的时刻醒来
+  for (int level = 1; level < LEVELS; level++) {
+    int shift = SLOT_BITS * level;
+    uint64_t base = current_ms_ >> shift;
+    for (uint64_t i = 1; i <= SLOTS; i++) {
+      if (wheel_[level][(base + i) & (SLOTS - 1)].head != nullptr) {
+        next = std::min(next, (base + i) << shift);
+        break;
+      }
+    }
+  }
+  return next;
+}
+
+size_t TimerWheel::advance(uint64_t now_ms) {
+  std::vector<TimerNode *> expired;
+
+  MUTEX_LOCK(&mutex_);
+  if (timers_.empty()) {
+    current_ms_ = std::max(current_ms_, now_ms);
+    MUTEX_UNLOCK(&mutex_);
+    return 0;
+  }
+
+  while (current_ms_ < now_ms) {
+    current_ms_++;
+
+    // 高层的槽先降级，降级后可能恰好落入本次要触发的第 0 层槽
+    for (int level = LEVELS - 1; level > 0; level--) {
+      uint64_t mask = (1ULL << (SLOT_BITS * level)) - 1;
+      if ((current_ms_ & mask) == 0) {
+        cascade(level);
+      }
+    }
+
+    Slot &slot = wheel_[0][current_ms_ & (SLOTS - 1)];
+    TimerNode *node = slot.head;
+    slot.head = nullptr;
+    while (node != nullptr) {
+      timers_.erase(node->id);
+      expired.push_back(node);
+      node = node->next;
+    }
+
+    if (timers_.empty()) {
+      current_ms_ = now_ms;
+    }
+  }
+  MUTEX_UNLOCK(&mutex_);
+
+  for (TimerNode *node : expired) {
+    node->cb();
+    delete node;
+  }
+  return expired.size();
+}
+
+void *TimerWheel::run(void *arg) {
+  TimerWheel *wheel = reinterpret_cast<TimerWheel *>(arg);
+  pthread_setname_np(pthread_self(), "TimerWheel");
+
+  while (true) {
+    MUTEX_LOCK(&wheel->mutex_);
+    while (wheel->running_) {
+      uint64_t next =
+          wheel->timers_.empty() ? UINT64_MAX : wheel->next_expiry();
+      uint64_t now_ms = monotonic_ms();
+      if (next <= now_ms) {
+        break;
+      }
+      wheel->wakeup_ms_ = next;
+      if (next == UINT64_MAX) {
+        COND_WAIT(&wheel->cond_, &wheel->mutex_);
+        continue;
+      }
+      // 条件变量使用 CLOCK_REALTIME，按剩余时间换算等待的截止时刻
+      struct timeval now;
+      gettimeofday(&now, NULL);
+      uint64_t deadline_us =
+          now.tv_sec * 1000000ULL + now.tv_usec + (next - now_ms) * 1000;
+      struct timespec abstime;
+      abstime.tv_sec = deadline_us / 1000000;
+      abstime.tv_nsec = (deadline_us % 1000000) * 1000;
+      int ret = 0;
+      COND_WAIT_TIMEOUT(&wheel->cond_, &wheel->mutex_, &abstime, ret);
+      if (ret != 0 && ret != ETIMEDOUT) {
+        LOG(warn, "Timer wheel failed to wait, {}", strerror(ret));
+      }
+    }
+    wheel->wakeup_ms_ = 0;
+    bool running = wheel->running_;
+    MUTEX_UNLOCK(&wheel->mutex_);
+
+    if (!running) {
+      break;
+    }
+    wheel->advance(monotonic_ms());
+  }
+  return NULL;
+}
+
+}  // namespace vulcan
@@ -0,0 +1,107 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <pthread.h>
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+namespace vulcan {
+
+/**
+ * @brief 分层时间轮，毫秒精度。
+ *
+ * 4 层、每层 256 个槽，第 0 层每槽 1ms，覆盖约 49 天的超时时间；更远的
+ * 定时器先放在最高层，逐层降级。调度与取消都是 O(1)。由一个独立的定时器
+ * 线程推进，它睡眠到最近的非空槽到期(或高层的槽降级)的时刻，插入更早的
+ * 定时器时被唤醒；没有定时器时线程阻塞等待。
+ *
+ * 到期回调在定时器线程中执行(不持有时间轮的锁)，必须足够短且不能阻塞；
+ * 需要较重处理的逻辑应当把事件重新投递到 stage 中。
+ *
+ * 时间基准为 monotonic_ms()。
+ */
+class TimerWheel {
+ public:
+  typedef uint64_t TimerId;
+  typedef std::function<void()> Callback;
+
+  static constexpr int LEVELS = 4;
+  static constexpr int SLOT_BITS = 8;
+  static constexpr int SLOTS = 1 << SLOT_BITS;
+  static constexpr TimerId INVALID_TIMER = 0;
+
+  static TimerWheel *get_instance();
+
+  TimerWheel();
+  ~TimerWheel();
+
+  int start();
+  void stop();
+
+  /**
+   * @brief 注册一个定时器
+   * @param deadline_ms 到期时间(monotonic_ms)，已过期的定时器在下一次推进时触发
+   * @param id 非空时在定时器可能触发之前写入定时器 id
+   * @return 定时器 id，用于 cancel
+   */
+  TimerId schedule(uint64_t deadline_ms, Callback cb, TimerId *id = nullptr);
+
+  /**
+   * @brief 取消定时器
+   * @return true 表示已取消，回调不会再执行；false 表示定时器已触发或不存在
+   */
+  bool cancel(TimerId id);
+
+  size_t size();
+
+  /**
+   * @brief 时间轮的锁，也用来保护定时器所属对象的状态(如 TimeoutInfo 的
+   * 事件列表)，使其与到期回调互斥。持有期间不能调用 schedule 和 cancel。
+   */
+  void lock();
+  void unlock();
+
+  /**
+   * @brief 将时间轮推进到 now_ms 并执行到期的回调，返回触发的个数。
+   * 定时器线程调用它，测试时也可以不启动线程直接驱动。
+   */
+  size_t advance(uint64_t now_ms);
+
+ private:
+  struct TimerNode;
+
+  struct Slot {
+    TimerNode *head = nullptr;
+  };
+
+  struct TimerNode {
+    TimerId id;
+    uint64_t deadline_ms;
+    Callback cb;
+    Slot *slot;  // 所在的槽，prev 为空时是槽头
+    TimerNode *prev;
+    TimerNode *next;
+  };
+
+  void link(TimerNode *node);
+  void unlink(TimerNode *node);
+  void cascade(int level);
+  uint64_t next_expiry() const;
+
+  static void *run(void *arg);
+
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  pthread_t thread_;
+  bool running_ = false;
+  uint64_t wakeup_ms_ = 0;  // 定时器线程睡眠到的时刻，未睡眠时为 0
+
+  uint64_t current_ms_;  // 已经处理到的时刻
+  TimerId next_id_ = 1;
+  Slot wheel_[LEVELS][SLOTS];
+  std::unordered_map<TimerId, TimerNode *> timers_;
+};
+
+}  // namespace vulcan
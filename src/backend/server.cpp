@@ -17,6 +17,11 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+
 #include "backend/seda/seda_config.h"
 #include "backend/seda/seda_defs.h"
 #include "backend/seda/session_event.h"
@@ -24,20 +29,27 @@
 #include "backend/session.h"
 #include "common/defs.h"
 #include "common/io/io.h"
+#include "common/mutex.h"
 #include "common/vulcan_logger.h"
+#include "common/vulcan_utility.h"
 
 namespace vulcan {
 
 Stage *Server::session_stage_ = nullptr;
+ServerParam *Server::param_ = nullptr;
+ServerStats Server::stats_;
+pthread_mutex_t Server::paused_mutex_ = PTHREAD_MUTEX_INITIALIZER;
+std::list<ConnectionContext *> Server::paused_clients_;
 
 ServerParam::ServerParam() {
-  listen_addr;
-  max_connection_num;
-  port;
+  listen_addr = INADDR_ANY;
+  max_connection_num = std::stoi(MAX_CONNECTION_NUM_DEFAULT);
+  port = std::stoi(PORT_DEFAULT);
 }
 
 Server::Server(ServerParam input_server_param)
     : server_param_(input_server_param) {
+  param_ = &server_param_;
   started_ = false;
   server_socket_ = 0;
   event_base_ = nullptr;
@@ -52,6 +64,61 @@ Server::~Server() {
 
 void Server::init() {
   session_stage_ = SedaConfig::get_instance()->get_stage(SESSION_STAGE_NAME);
+  if (session_stage_->overload_policy() == Stage::OVERLOAD_PAUSE) {
+    session_stage_->set_watermark_listener(on_session_watermark);
+  }
+
+  // 拒绝请求的阈值低于 stage 高水位时，队列在触发暂停读取之前就开始拒绝
+  // 请求，水位线的背压策略永远不会生效
+  int64_t high_watermark = session_stage_->high_watermark();
+  if (param_->shed_queue_len == 0) {
+    param_->shed_queue_len = session_stage_->queue_capacity();
+  } else if (param_->shed_queue_len < high_watermark) {
+    LOG(warn, "Shed queue length {} is below the high watermark {} of {}, "
+        "use the high watermark", param_->shed_queue_len, high_watermark,
+        session_stage_->get_name());
+    param_->shed_queue_len = high_watermark;
+  }
+}
+
+void Server::pause_reading(ConnectionContext *client) {
+  MUTEX_LOCK(&paused_mutex_);
+  if (!client->paused) {
+    // 数据留在内核缓冲区中，TCP 窗口会把压力反馈给客户端
+    event_del(&client->read_event);
+    client->paused = true;
+    paused_clients_.push_back(client);
+    stats_.read_pauses++;
+  }
+  MUTEX_UNLOCK(&paused_mutex_);
+
+  // stage 可能在暂停前已经回落到低水位，此时不会再有通知，需要立即恢复
+  if (!session_stage_->overloaded()) {
+    on_session_watermark(session_stage_, false);
+  }
+}
+
+void Server::on_session_watermark(Stage *stage, bool overloaded) {
+  if (overloaded) {
+    // 新到达的请求在 recv 中发现过载后各自暂停，这里无需处理
+    return;
+  }
+
+  MUTEX_LOCK(&paused_mutex_);
+  LOG(info, "Stage {} recovers, resume reading {} connections",
+      stage->get_name(), paused_clients_.size());
+  struct timeval idle_timeout = {param_->idle_timeout_sec, 0};
+  for (ConnectionContext *client : paused_clients_) {
+    client->paused = false;
+    if (event_add(&client->read_event,
+                  param_->idle_timeout_sec > 0 ? &idle_timeout : nullptr) <
+        0) {
+      LOG(error, "Failed to resume read event of {}, {}", client->addr,
+          strerror(errno));
+    }
+  }
+  paused_clients_.clear();
+  MUTEX_UNLOCK(&paused_mutex_);
 }
 
 int Server::set_non_block(int fd) {
@@ -69,29 +136,140 @@ int Server::set_non_block(int fd) {
   return 0;
 }
 
+// 连接只在 reactor 线程中释放。仍有请求在 stage 中处理时先停止监听事件，
+// 等 send_response 发出最后的响应后由 request_close 唤醒 reactor 再释放
 void Server::close_connection(ConnectionContext *client_context) {
-  LOG(info, "Close connection of {}.", client_context->addr);
+  MUTEX_LOCK(&client_context->mutex);
+  bool busy = client_context->inflight > 0;
+  client_context->closing = true;
+  MUTEX_UNLOCK(&client_context->mutex);
+
+  MUTEX_LOCK(&paused_mutex_);
+  if (client_context->paused) {
+    client_context->paused = false;
+    paused_clients_.remove(client_context);
+  }
+  MUTEX_UNLOCK(&paused_mutex_);
   event_del(&client_context->read_event);
+  event_del(&client_context->write_event);
+  if (busy) {
+    LOG(info, "Defer closing connection of {} until its request finishes",
+        client_context->addr);
+    return;
+  }
+
+  LOG(info, "Close connection of {}.", client_context->addr);
   ::close(client_context->fd);
   delete client_context->session;
   client_context->session = nullptr;
+  delete client_context->output;
+  client_context->output = nullptr;
+  stats_.buffer_bytes -= client_context->buf_size;
+  free(client_context->buf);
   delete client_context;
+  stats_.active_connections--;
+}
+
+void Server::request_close(ConnectionContext *client) {
+  client->closing = true;
+  // 读事件可能已被移除，event_active 对未注册的事件同样有效。调用者持有
+  // client->mutex，reactor 在释放连接前需要获取该锁，连接此时不会被释放
+  event_active(&client->read_event, EV_READ, 1);
+}
+
+int Server::grow_buffer(ConnectionContext *client) {
+  int new_size = client->buf_size == 0 ? MAX_MEM_BUFFER_SIZE
+                                       : client->buf_size * 2;
+  if (client->buf_size >= param_->max_request_size) {
+    return -1;
+  }
+  new_size = std::min(new_size, param_->max_request_size);
+
+  char *new_buf = reinterpret_cast<char *>(realloc(client->buf, new_size));
+  if (new_buf == nullptr) {
+    LOG(error, "Failed to allocate {} bytes request buffer for {}", new_size,
+        client->addr);
+    return -1;
+  }
+  memset(new_buf + client->buf_size, 0, new_size - client->buf_size);
+  stats_.buffer_bytes += new_size - client->buf_size;
+  client->buf = new_buf;
+  client->buf_size = new_size;
+  return 0;
+}
+
+void Server::shrink_buffer(ConnectionContext *client) {
+  if (client->buf_size <= MAX_MEM_BUFFER_SIZE) {
+    return;
+  }
+  char *new_buf =
+      reinterpret_cast<char *>(realloc(client->buf, MAX_MEM_BUFFER_SIZE));
+  if (new_buf == nullptr) {
+    // 缩小失败时保留原缓冲区
+    return;
+  }
+  stats_.buffer_bytes -= client->buf_size - MAX_MEM_BUFFER_SIZE;
+  client->buf = new_buf;
+  client->buf_size = MAX_MEM_BUFFER_SIZE;
 }
 
 void Server::recv(int fd, int16_t ev, void *arg) {
   ConnectionContext *client = reinterpret_cast<ConnectionContext *>(arg);
 
+  if (client->closing) {
+    close_connection(client);
+    return;
+  }
+
+  if (ev & EV_TIMEOUT) {
+    if (client->inflight > 0) {
+      // 请求仍在处理中，不算空闲
+      return;
+    }
+    LOG(info, "Connection of {} is idle for {}s, closing", client->addr,
+        param_->idle_timeout_sec);
+    stats_.idle_timeouts++;
+    close_connection(client);
+    return;
+  }
+
+  if (session_stage_->overloaded() &&
+      session_stage_->overload_policy() == Stage::OVERLOAD_PAUSE) {
+    // 下游已饱和，暂停读取该连接直到 stage 回落到低水位
+    pause_reading(client);
+    return;
+  }
+
   int data_len = 0;
   int read_len = 0;
-  int buf_size = sizeof(client->buf);
-  memset(client->buf, 0, buf_size);
+  bool oversized = false;
+
+  std::string request;
 
   MUTEX_LOCK(&client->mutex);
+  // 缓冲区在第一次收到数据时才分配，空闲连接不占用请求缓冲区。缓冲区只在
+  // reactor 线程中使用，请求内容拷贝到 SessionEvent 后再交给 stage
   // 持续接收消息，直到遇到'\0'。将'\0'遇到的后续数据直接丢弃没有处理，因为目前仅支持一收一发的模式
   while (true) {
-    read_len = ::read(client->fd, client->buf + data_len, buf_size - data_len);
+    // 预留一个字节，保证缓冲区中的请求总是以'\0'结尾
+    if (data_len + 1 >= client->buf_size && grow_buffer(client) < 0) {
+      oversized = true;
+      break;
+    }
+
+    read_len = ::read(client->fd, client->buf + data_len,
+                      client->buf_size - data_len - 1);
     if (read_len < 0) {
       if (errno == EAGAIN) {
+        if (data_len == 0) {
+          // 可写事件或 zerocopy 完成通知引起的唤醒，没有待读数据。完成
+          // 通知留在错误队列中会使 fd 持续就绪，必须在这里读空
+          if (client->output->zerocopy_pending()) {
+            client->output->reap_zerocopy(client->fd);
+          }
+          MUTEX_UNLOCK(&client->mutex);
+          return;
+        }
         continue;
       }
       break;
@@ -100,11 +278,6 @@ void Server::recv(int fd, int16_t ev, void *arg) {
       break;
     }
 
-    if (read_len + data_len > buf_size) {
-      data_len += read_len;
-      break;
-    }
-
     bool msg_end = false;
     for (int i = 0; i < read_len; i++) {
       if (client->buf[data_len + i] == 0) {
@@ -115,16 +288,23 @@ void Server::recv(int fd, int16_t ev, void *arg) {
     }
 
     if (msg_end) {
+      request.assign(client->buf, data_len - 1);
       break;
     }
 
     data_len += read_len;
   }
+  if (!oversized && read_len > 0) {
+    // 请求已拷贝出去，大请求撑大的缓冲区不必在连接空闲期间一直占用
+    shrink_buffer(client);
+  }
 
   MUTEX_UNLOCK(&client->mutex);
 
-  if (data_len > buf_size) {
-    LOG(warn, "The length of sql exceeds the limitation {}\n", buf_size);
+  if (oversized) {
+    LOG(warn, "The length of request exceeds the limitation {}\n",
+        param_->max_request_size);
+    stats_.oversized_requests++;
     close_connection(client);
     return;
   }
@@ -139,9 +319,31 @@ void Server::recv(int fd, int16_t ev, void *arg) {
     return;
   }
 
-  LOG(info, "receive command(size={}): {}", data_len, client->buf);
-  SessionEvent *sev = new SessionEvent(client);
-  session_stage_->add_event(sev);
+  LOG(info, "receive command(size={}): {}", data_len, request);
+  // 每个请求都以一次 send_response 结束，由它减少在途计数
+  client->inflight++;
+  if (param_->shed_queue_len > 0 &&
+      session_stage_->qlen() >= param_->shed_queue_len) {
+    // 下游队列过载时直接拒绝，避免排队请求无限增长导致延迟失控
+    LOG(warn, "Session stage is overloaded(qlen={}), reject request from {}",
+        session_stage_->qlen(), client->addr);
+    stats_.shed_requests++;
+    send_response(client, "ERROR: server is busy, please retry later\n");
+    return;
+  }
+
+  // 事件来自对象池，交给 stage 之前由 unique_ptr 持有
+  std::unique_ptr<SessionEvent> sev(
+      new SessionEvent(client, std::move(request)));
+  if (param_->request_timeout_ms > 0) {
+    sev->set_deadline(monotonic_ms() + param_->request_timeout_ms);
+  }
+  if (!session_stage_->add_event(sev.get())) {
+    stats_.rejected_by_stage++;
+    send_response(client, "ERROR: server is busy, please retry later\n");
+    return;
+  }
+  sev.release();
   //   const char *ack = "ack";
   //   send(client, ack, strlen(ack) + 1);
   LOG(info, "Server::recv 执行成功");
@@ -154,20 +356,98 @@ int Server::send(ConnectionContext *client, const char *buf, int data_len) {
   }
 
   MUTEX_LOCK(&client->mutex);
-  int ret = writen(client->fd, buf, data_len);
+  client->output->append(std::string(buf, data_len));
+  int ret = flush_output(client);
   if (ret < 0) {
-    LOG(error, "Failed to send data back to client. ret={}, error={}", ret,
-        strerror(errno));
-    MUTEX_UNLOCK(&client->mutex);
+    request_close(client);
+  }
+  MUTEX_UNLOCK(&client->mutex);
+  return ret;
+}
 
-    close_connection(client);
+int Server::send_response(ConnectionContext *client, std::string &&response) {
+  // 消息终结符，作为独立片段与响应一起聚合发送
+  static const char terminator = '\0';
+
+  bool need_terminator = response.empty() || response.back() != '\0';
+
+  int ret = 0;
+  MUTEX_LOCK(&client->mutex);
+  client->inflight--;
+  if (client->closing) {
+    // 对端已断开，丢弃响应并让 reactor 完成推迟的关闭
+    request_close(client);
+  } else {
+    client->output->append(std::move(response));
+    if (need_terminator) {
+      client->output->append_ref(&terminator, 1);
+    }
+    ret = flush_output(client);
+    if (ret < 0) {
+      request_close(client);
+    }
+  }
+  MUTEX_UNLOCK(&client->mutex);
+  return ret;
+}
+
+void Server::send_timeout(ConnectionContext *client) {
+  stats_.request_timeouts++;
+  send_response(client, "ERROR: request timed out\n");
+}
+
+std::string Server::stats_report() {
+  std::stringstream ss;
+  ss << "active_connections: " << stats_.active_connections << "\n"
+     << "max_connections: " << param_->max_connection_num << "\n"
+     << "accepted_connections: " << stats_.accepted << "\n"
+     << "rejected_by_limit: " << stats_.rejected_by_limit << "\n"
+     << "idle_timeouts: " << stats_.idle_timeouts << "\n"
+     << "shed_requests: " << stats_.shed_requests << "\n"
+     << "oversized_requests: " << stats_.oversized_requests << "\n"
+     << "rejected_by_stage: " << stats_.rejected_by_stage << "\n"
+     << "read_pauses: " << stats_.read_pauses << "\n"
+     << "request_timeouts: " << stats_.request_timeouts << "\n"
+     << "request_buffer_bytes: " << stats_.buffer_bytes << "\n"
+     << "session_queue_len: "
+     << (session_stage_ == nullptr ? 0 : session_stage_->qlen()) << "\n"
+     << "session_overloaded: "
+     << (session_stage_ != nullptr && session_stage_->overloaded()) << "\n";
+  return ss.str();
+}
+
+int Server::flush_output(ConnectionContext *client) {
+  OutputQueue::FlushStatus status = client->output->flush(client->fd);
+  if (status == OutputQueue::FLUSH_ERROR) {
+    LOG(error, "Failed to send data back to client {}, error={}",
+        client->addr, strerror(errno));
     return -1;
   }
 
-  MUTEX_UNLOCK(&client->mutex);
+  if (status == OutputQueue::FLUSH_PENDING &&
+      !event_pending(&client->write_event, EV_WRITE, nullptr)) {
+    // 套接字已写满，剩余数据等待可写事件后由 reactor 发送
+    if (event_add(&client->write_event, nullptr) < 0) {
+      LOG(error, "Failed to add write event of {} into libevent, {}",
+          client->addr, strerror(errno));
+      return -1;
+    }
+  }
   return 0;
 }
 
+void Server::on_writable(int /*fd*/, int16_t /*ev*/, void *arg) {
+  ConnectionContext *client = reinterpret_cast<ConnectionContext *>(arg);
+
+  MUTEX_LOCK(&client->mutex);
+  int ret = flush_output(client);
+  MUTEX_UNLOCK(&client->mutex);
+
+  if (ret < 0) {
+    close_connection(client);
+  }
+}
+
 void Server::accept(int fd, int16_t ev, void *arg) {
   Server *instance = reinterpret_cast<Server *>(arg);
   struct sockaddr_in addr;
@@ -181,6 +461,18 @@ void Server::accept(int fd, int16_t ev, void *arg) {
     return;
   }
 
+  if (instance->server_param_.max_connection_num > 0 &&
+      stats_.active_connections >= instance->server_param_.max_connection_num) {
+    // 超过最大连接数时尽力告知客户端后立即关闭，不为其分配任何资源
+    static const char busy_msg[] = "ERROR: too many connections\n";
+    ::send(client_fd, busy_msg, sizeof(busy_msg), MSG_DONTWAIT | MSG_NOSIGNAL);
+    ::close(client_fd);
+    stats_.rejected_by_limit++;
+    LOG(warn, "Reject connection, the number of connections reaches {}",
+        instance->server_param_.max_connection_num);
+    return;
+  }
+
   char ip_addr[24];
   if (inet_ntop(AF_INET, &addr.sin_addr, ip_addr, sizeof(ip_addr)) == nullptr) {
     LOG(error, "Failed to get ip address of client, {}", strerror(errno));
@@ -211,36 +503,57 @@ void Server::accept(int fd, int16_t ev, void *arg) {
     }
   }
 
+  // 值初始化将所有成员置零
   ConnectionContext *client_context = new ConnectionContext();
-  memset(client_context, 0, sizeof(ConnectionContext));
   client_context->fd = client_fd;
   snprintf(client_context->addr, sizeof(client_context->addr), "%s",
            addr_str.c_str());
   pthread_mutex_init(&client_context->mutex, nullptr);
 
+  client_context->output = new OutputQueue();
+  if (instance->server_param_.use_zerocopy &&
+      !instance->server_param_.use_unix_socket &&
+      client_context->output->enable_zerocopy(client_fd) < 0) {
+    LOG(warn, "Failed to enable zerocopy on socket of {}, {}",
+        client_context->addr, strerror(errno));
+  }
+
   event_set(&client_context->read_event, client_context->fd,
             EV_READ | EV_PERSIST, recv, client_context);
+  event_set(&client_context->write_event, client_context->fd, EV_WRITE,
+            on_writable, client_context);
 
   ret = event_base_set(instance->event_base_, &client_context->read_event);
+  if (ret == 0) {
+    ret = event_base_set(instance->event_base_, &client_context->write_event);
+  }
   if (ret < 0) {
     LOG(error,
-        "Failed to do event_base_set for read event of {} into libevent, {}",
+        "Failed to do event_base_set for events of {} into libevent, {}",
         client_context->addr, strerror(errno));
+    delete client_context->output;
     delete client_context;
     ::close(instance->server_socket_);
     return;
   }
 
-  ret = event_add(&client_context->read_event, nullptr);
+  // 带超时的读事件：连接空闲超过 idle_timeout_sec 后以 EV_TIMEOUT 回调 recv
+  struct timeval idle_timeout = {instance->server_param_.idle_timeout_sec, 0};
+  ret = event_add(&client_context->read_event,
+                  instance->server_param_.idle_timeout_sec > 0 ? &idle_timeout
+                                                               : nullptr);
   if (ret < 0) {
     LOG(error, "Failed to event_add for read event of {} into libevent, {}",
         client_context->addr, strerror(errno));
+    delete client_context->output;
     delete client_context;
     ::close(instance->server_socket_);
     return;
   }
 
   client_context->session = new Session(Session::default_session());
+  stats_.active_connections++;
+  stats_.accepted++;
   LOG(info, "Accepted connection from {}\n", client_context->addr);
 }
 
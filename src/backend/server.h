@@ -1,6 +1,8 @@
 // Copyright 2023 VulcanDB
 #pragma once
 
+#include <atomic>
+#include <list>
 #include <string>
 
 #include "common/defs.h"
@@ -34,6 +36,38 @@ class ServerParam {
 
   // 如果使用标准输入输出作为通信条件，就不再监听端口
   bool use_unix_socket = false;
+
+  // 对较大的响应使用 MSG_ZEROCOPY 发送，仅对 TCP 连接生效
+  bool use_zerocopy = false;
+
+  // 连接空闲超过该时间(秒)后关闭，0 表示不超时
+  int idle_timeout_sec = 0;
+
+  // 单个请求从收到到响应的期限(毫秒)，超时后返回错误，0 表示不限制
+  int request_timeout_ms = 0;
+
+  // SessionStage 队列长度达到该值后拒绝新请求。0 表示使用 stage 的
+  // QueueCapacity，stage 也不限制容量时不拒绝请求
+  int64_t shed_queue_len = 0;
+
+  // 单个连接请求缓冲区的上限，缓冲区从 MAX_MEM_BUFFER_SIZE 开始按需扩容
+  int max_request_size = SOCKET_BUFFER_SIZE;
+};
+
+/**
+ * @brief 连接准入控制相关的计数器，由 stats 命令输出
+ */
+struct ServerStats {
+  std::atomic<int64_t> active_connections{0};  // 当前连接数
+  std::atomic<int64_t> accepted{0};            // 累计接受的连接数
+  std::atomic<int64_t> rejected_by_limit{0};   // 超过最大连接数被拒绝
+  std::atomic<int64_t> idle_timeouts{0};       // 空闲超时被关闭
+  std::atomic<int64_t> shed_requests{0};       // 队列过载被拒绝的请求
+  std::atomic<int64_t> oversized_requests{0};  // 超过缓冲区上限的请求
+  std::atomic<int64_t> rejected_by_stage{0};   // stage 队列已满被拒绝的请求
+  std::atomic<int64_t> read_pauses{0};         // 因下游过载暂停读取的次数
+  std::atomic<int64_t> request_timeouts{0};    // 超过请求期限未处理的请求
+  std::atomic<int64_t> buffer_bytes{0};        // 所有连接请求缓冲区的总大小
 };
 
 class Server {
@@ -45,15 +79,48 @@ class Server {
   static void init();
   static int send(ConnectionContext *client, const char *buf, int data_len);
 
+  /**
+   * @brief 将一条完整响应放入连接的发送队列，必要时追加消息终结符。
+   *
+   * 响应与终结符以一次 writev 聚合发送；套接字写满时剩余数据由 reactor
+   * 在可写事件中继续发送，调用线程不会阻塞。
+   */
+  static int send_response(ConnectionContext *client, std::string &&response);
+
+  /**
+   * @brief 请求在排队期间超过期限，向客户端返回超时错误
+   */
+  static void send_timeout(ConnectionContext *client);
+
+  /**
+   * @brief 以文本形式输出连接相关的计数器
+   */
+  static std::string stats_report();
+
  public:
   int serve();
   void shutdown();
 
  private:
   static void accept(int fd, int16_t ev, void *arg);
-  // close connection
+  // close connection, must run on the reactor thread
   static void close_connection(ConnectionContext *client_context);
+  // ask the reactor to close the connection, callable from any thread,
+  // caller must hold client->mutex
+  static void request_close(ConnectionContext *client);
   static void recv(int fd, int16_t ev, void *arg);
+  // flush pending output when the socket becomes writable
+  static void on_writable(int fd, int16_t ev, void *arg);
+  // caller must hold client->mutex
+  static int flush_output(ConnectionContext *client);
+  // grow the request buffer of client, -1 if it would exceed the budget
+  static int grow_buffer(ConnectionContext *client);
+  // return a buffer grown by a large request to the default size
+  static void shrink_buffer(ConnectionContext *client);
+
+  // 下游 stage 越过高水位时暂停读取，回落到低水位时恢复所有被暂停的连接
+  static void on_session_watermark(Stage *stage, bool overloaded);
+  static void pause_reading(ConnectionContext *client);
 
  private:
   int set_non_block(int fd);
@@ -70,6 +137,11 @@ class Server {
   ServerParam server_param_;
 
   static Stage *session_stage_;
+  static ServerParam *param_;
+  static ServerStats stats_;
+
+  static pthread_mutex_t paused_mutex_;             // protects paused_clients_
+  static std::list<ConnectionContext *> paused_clients_;
 };
 
 class Communicator {
@@ -24,8 +24,14 @@ const char *Session::get_current_db_name() const {
 
 Db *Session::get_current_db() const { return db_; }
 
-void Session::set_current_db(const std::string &dbname) {
-  // TODO(Ziming Zhang): implement this function
+bool Session::set_current_db(const std::string &dbname) {
+  Db *db = DbManager::get_instance()->find(dbname);
+  if (db == nullptr) {
+    LOG(warn, "Database {} is not opened", dbname);
+    return false;
+  }
+  db_ = db;
+  return true;
 }
 
 }  // namespace vulcan
@@ -1,11 +1,13 @@
 // Copyright 2023 VulcanDB
 #pragma once
 
+#include <atomic>
 #include <string>
 
 #include "backend/db.h"
 #include "backend/session.h"
 #include "common/defs.h"
+#include "common/io/output_queue.h"
 #include "libevent/include/event.h"
 
 namespace vulcan {
@@ -46,8 +48,9 @@ class Session {
    * @brief Set the current database.
    *
    * @param dbname The name of the database to set as the current database.
+   * @return false if no database with this name is opened.
    */
-  void set_current_db(const std::string &dbname);
+  bool set_current_db(const std::string &dbname);
 
  private:
   Db *db_ = nullptr;
@@ -57,15 +60,22 @@ class Session {
  * @brief Represents the context of a connection.
  *
  * This struct holds information related to a connection, including the
- * associated session, file descriptor, read event, mutex, address, and buffer.
+ * associated session, file descriptor, read/write events, pending output,
+ * mutex, address, and buffer.
  */
 typedef struct _ConnectionContext {
   Session *session;             /* Pointer to the associated session */
   int fd;                       /* File descriptor of the connection */
   struct event read_event;      /* Read event for the connection */
+  struct event write_event;     /* Write readiness event for pending output */
+  OutputQueue *output;          /* Response fragments waiting to be sent */
   pthread_mutex_t mutex;        /* Mutex for thread synchronization */
   char addr[24];                /* Address of the connection */
-  char buf[SOCKET_BUFFER_SIZE]; /* Buffer for storing data */
+  char *buf;                    /* Request buffer, allocated on first read */
+  int buf_size;                 /* Current capacity of buf */
+  std::atomic<int> inflight;    /* Requests not yet answered by stages */
+  std::atomic<bool> closing;    /* Close is pending, done by the reactor */
+  bool paused;                  /* Reading is paused by stage backpressure */
 } ConnectionContext;
 
 }  // namespace vulcan
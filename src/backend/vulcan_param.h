@@ -101,7 +101,15 @@ class VulcanParam {
       {VULCAN_CONSOLE_LOG_LEVEL, DEFAULT_LOG_LEVEL},
       {VULCAN_PORT, PORT_DEFAULT},
       {VULCAN_UNIX_SOCKET_PATH, UNIX_SOCKET_PATH_DEFAULT},
-      {MAX_CONNECTION_NUM, MAX_CONNECTION_NUM_DEFAULT}};
+      {MAX_CONNECTION_NUM, MAX_CONNECTION_NUM_DEFAULT},
+      {VULCAN_ZEROCOPY, ZEROCOPY_DEFAULT},
+      {VULCAN_IDLE_TIMEOUT, IDLE_TIMEOUT_DEFAULT},
+      {VULCAN_SHED_QUEUE_LEN, SHED_QUEUE_LEN_DEFAULT},
+      {VULCAN_REQUEST_TIMEOUT, REQUEST_TIMEOUT_DEFAULT},
+      {VULCAN_LOG_ASYNC, LOG_ASYNC_DEFAULT},
+      {VULCAN_LOG_QUEUE_SIZE, LOG_QUEUE_SIZE_DEFAULT},
+      {VULCAN_LOG_OVERFLOW, LOG_OVERFLOW_DEFAULT},
+      {VULCAN_LOCK_PROFILE_SAMPLE, LOCK_PROFILE_SAMPLE_DEFAULT}};
 
   // 日志级别
   const std::vector<LOG_LEVEL> log_levels_ = {
@@ -20,36 +20,35 @@ constexpr unsigned int ONE_GIGA = ONE_MILLION * ONE_KILO;
 #define VULCAN_UNIX_SOCKET_PATH "UNIX_SOCKET_PATH"
 #define VULCAN_LOG_LEVEL "LOG_LEVEL"
 #define VULCAN_CONSOLE_LOG_LEVEL "LOG_CONSOLE_LOG_LEVEL"
+#define VULCAN_ZEROCOPY "ZEROCOPY"
+#define VULCAN_IDLE_TIMEOUT "CONNECTION_IDLE_TIMEOUT"
+#define VULCAN_SHED_QUEUE_LEN "SHED_QUEUE_LEN"
+#define VULCAN_REQUEST_TIMEOUT "REQUEST_TIMEOUT_MS"
+#define VULCAN_LOG_ASYNC "LOG_ASYNC"
+#define VULCAN_LOG_QUEUE_SIZE "LOG_QUEUE_SIZE"
+#define VULCAN_LOG_OVERFLOW "LOG_OVERFLOW_POLICY"
+#define VULCAN_LOCK_PROFILE_SAMPLE "LOCK_PROFILE_SAMPLE"
 
 // Default Settings
 #define MAX_CONNECTION_NUM_DEFAULT "1024"              // 默认最大连接数
 #define PORT_DEFAULT "6688"                            // 默认端口号
 #define UNIX_SOCKET_PATH_DEFAULT "/tmp/vulcandb.sock"  // 默认unix socket路径
-#define SOCKET_BUFFER_SIZE ONE_MILLION    // 默认socket缓冲区大小
+#define SOCKET_BUFFER_SIZE ONE_MILLION    // 单个连接请求缓冲区的上限
 #define MAX_MEM_BUFFER_SIZE 8 * ONE_KILO  // 默认内存缓冲区大小
 #define DEFAULT_CONF_FILE "/etc/vulcandb.conf"
 #define DEFAULT_HOME "~/vulcandb/"
 #define DEFAULT_DATA_DIR "~/vulcandb/data"
 #define DEFAULT_LOG_DIR "~/vulcandb/log"
 #define DEFAULT_LOG_LEVEL "3"  // 0-5级别递减，0为最高级别
+#define ZEROCOPY_DEFAULT "0"   // 默认不使用MSG_ZEROCOPY发送响应
+#define IDLE_TIMEOUT_DEFAULT "600"  // 空闲连接超时时间(秒)，0表示不超时
+#define SHED_QUEUE_LEN_DEFAULT "0"  // 拒绝新请求的队列长度，0表示取stage容量
+#define REQUEST_TIMEOUT_DEFAULT "0"  // 请求处理期限(毫秒)，0表示不限制
+#define LOG_ASYNC_DEFAULT "0"  // 1为由后台线程写日志，崩溃时可能丢失未写出的日志
+#define LOG_QUEUE_SIZE_DEFAULT "8192"  // 异步日志队列槽位数
+#define LOG_OVERFLOW_DEFAULT "block"   // 队列满时 block 等待或 drop 丢弃
+#define LOCK_PROFILE_SAMPLE_DEFAULT "64"  // 每N次加锁采样一次等待时间，0关闭
 
 #define SYS_OUTPUT_ERROR ",error:" << errno << ":" << strerror(errno)
 
-#ifndef DEBUG_LOCK
-#define MUTEXT_STATIC_INIT() PTHREAD_MUTEX_INITIALIZER
-#define MUTEX_INIT(lock, attr) pthread_mutex_init(lock, attr)
-#define MUTEX_DESTROY(lock) pthread_mutex_destroy(lock)
-#define MUTEX_LOCK(lock) pthread_mutex_lock(lock)
-#define MUTEX_UNLOCK(lock) pthread_mutex_unlock(lock)
-#define MUTEX_TRYLOCK(lock) pthread_mutex_trylock(lock)
-
-#define COND_INIT(cond, attr) pthread_cond_init(cond, attr)
-#define COND_DESTROY(cond) pthread_cond_destroy(cond)
-#define COND_WAIT(cond, mutex) pthread_cond_wait(cond, mutex)
-#define COND_WAIT_TIMEOUT(cond, mutex, time, ret) \
-  ret = pthread_cond_timedwait(cond, mutex, time)
-#define COND_SIGNAL(cond) pthread_cond_signal(cond)
-#define COND_BRAODCAST(cond) pthread_cond_broadcast(cond)
-#endif  // DEBUG_LOCK
-
 }  // namespace vulcan
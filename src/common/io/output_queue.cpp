@@ -0,0 +1,225 @@
+// Copyright 2023 VulcanDB
+
+#include "common/io/output_queue.h"
+
+#include <errno.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace vulcan {
+
+OutputQueue::~OutputQueue() {
+  for (auto &frag : fragments_) {
+    if (frag.file_fd >= 0) {
+      ::close(frag.file_fd);
+    }
+  }
+}
+
+void OutputQueue::append(std::string &&data) {
+  if (data.empty()) {
+    return;
+  }
+  Fragment frag;
+  frag.owned = std::make_shared<std::string>(std::move(data));
+  frag.data = frag.owned->data();
+  frag.len = frag.owned->size();
+  pending_bytes_ += frag.len;
+  fragments_.push_back(std::move(frag));
+}
+
+void OutputQueue::append_ref(const char *data, size_t len) {
+  if (data == nullptr || len == 0) {
+    return;
+  }
+  Fragment frag;
+  frag.data = data;
+  frag.len = len;
+  pending_bytes_ += len;
+  fragments_.push_back(std::move(frag));
+}
+
+void OutputQueue::append_file(int file_fd, off_t offset, size_t len) {
+  if (len == 0) {
+    ::close(file_fd);
+    return;
+  }
+  Fragment frag;
+  frag.file_fd = file_fd;
+  frag.file_offset = offset;
+  frag.len = len;
+  pending_bytes_ += len;
+  fragments_.push_back(std::move(frag));
+}
+
+int OutputQueue::enable_zerocopy(int fd) {
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && \
+    defined(SO_EE_ORIGIN_ZEROCOPY)
+  int yes = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &yes, sizeof(yes)) == 0) {
+    zerocopy_ = true;
+    return 0;
+  }
+#endif
+  return -1;
+}
+
+OutputQueue::FlushStatus OutputQueue::flush(int fd) {
+  if (zerocopy_pending()) {
+    reap_zerocopy(fd);
+  }
+
+  struct iovec iov[MAX_IOV_PER_FLUSH];
+  while (!fragments_.empty()) {
+    if (fragments_.front().file_fd >= 0) {
+      FlushStatus status = flush_file(fd, &fragments_.front());
+      if (status != FLUSH_DONE) {
+        return status;
+      }
+      continue;
+    }
+
+    // 将队首连续的内存片段聚合到一次系统调用中
+    int iovcnt = 0;
+    size_t iov_bytes = 0;
+    for (auto it = fragments_.begin();
+         it != fragments_.end() && it->file_fd < 0 &&
+         iovcnt < MAX_IOV_PER_FLUSH;
+         ++it, ++iovcnt) {
+      iov[iovcnt].iov_base = const_cast<char *>(it->data);
+      iov[iovcnt].iov_len = it->len;
+      iov_bytes += it->len;
+    }
+
+    bool zerocopy = zerocopy_ && iov_bytes >= ZEROCOPY_THRESHOLD;
+    ssize_t ret = send_vector(fd, iov, iovcnt, zerocopy);
+    if (ret < 0 && zerocopy && errno == ENOBUFS) {
+      // 超出 optmem 限制时退回普通拷贝发送
+      zerocopy = false;
+      ret = send_vector(fd, iov, iovcnt, false);
+    }
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return FLUSH_PENDING;
+      }
+      return FLUSH_ERROR;
+    }
+
+    if (zerocopy) {
+      // 内核在完成通知到达前仍引用这些页面，需保留数据所有权
+      for (int i = 0; i < iovcnt; i++) {
+        if (fragments_[i].owned) {
+          zerocopy_holds_.push_back({zerocopy_seq_, fragments_[i].owned});
+        }
+      }
+      zerocopy_seq_++;
+    }
+    consume(static_cast<size_t>(ret));
+  }
+  return FLUSH_DONE;
+}
+
+OutputQueue::FlushStatus OutputQueue::flush_file(int fd, Fragment *frag) {
+  while (frag->len > 0) {
+    size_t chunk = std::min(frag->len, static_cast<size_t>(1) << 30);
+    ssize_t ret = ::sendfile(fd, frag->file_fd, &frag->file_offset, chunk);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return FLUSH_PENDING;
+      }
+      return FLUSH_ERROR;
+    }
+    if (ret == 0) {
+      // 文件在发送过程中被截断
+      errno = EIO;
+      return FLUSH_ERROR;
+    }
+    frag->len -= ret;
+    pending_bytes_ -= ret;
+  }
+
+  ::close(frag->file_fd);
+  fragments_.pop_front();
+  return FLUSH_DONE;
+}
+
+ssize_t OutputQueue::send_vector(int fd, struct iovec *iov, int iovcnt,
+                                 bool zerocopy) {
+  struct msghdr msg = {};
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iovcnt;
+  int flags = MSG_NOSIGNAL;
+#ifdef MSG_ZEROCOPY
+  if (zerocopy) {
+    flags |= MSG_ZEROCOPY;
+  }
+#endif
+  return ::sendmsg(fd, &msg, flags);
+}
+
+void OutputQueue::consume(size_t bytes) {
+  pending_bytes_ -= bytes;
+  while (bytes > 0 && !fragments_.empty()) {
+    Fragment &front = fragments_.front();
+    if (bytes < front.len) {
+      front.data += bytes;
+      front.len -= bytes;
+      return;
+    }
+    bytes -= front.len;
+    fragments_.pop_front();
+  }
+}
+
+void OutputQueue::reap_zerocopy(int fd) {
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+  char control[128];
+  // 即使没有需要释放的数据也要读空错误队列，否则 fd 会一直处于就绪状态
+  while (true) {
+    struct msghdr msg = {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (::recvmsg(fd, &msg, MSG_ERRQUEUE) < 0) {
+      return;
+    }
+
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != nullptr;
+         cm = CMSG_NXTHDR(&msg, cm)) {
+      if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+            (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+        continue;
+      }
+      auto *serr = reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(cm));
+      if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+        continue;
+      }
+      // [ee_info, ee_data] 区间内的发送均已完成
+      uint32_t hi = serr->ee_data;
+      if (static_cast<int32_t>(hi + 1 - zerocopy_done_) > 0) {
+        zerocopy_done_ = hi + 1;
+      }
+      while (!zerocopy_holds_.empty() &&
+             static_cast<int32_t>(zerocopy_holds_.front().seq - hi) <= 0) {
+        zerocopy_holds_.pop_front();
+      }
+    }
+  }
+#else
+  (void)fd;
+#endif
+}
+
+}  // namespace vulcan
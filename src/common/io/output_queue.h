@@ -0,0 +1,118 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+struct iovec;
+
+namespace vulcan {
+
+/**
+ * @brief 每个连接的待发送数据队列。
+ *
+ * 响应被切分成若干片段(fragment)排队，由 flush() 以 sendmsg 一次性
+ * 聚合发送，文件片段使用 sendfile 直接从页缓存发送。flush() 从不阻塞：
+ * 套接字写满时返回 PENDING，由调用者等待可写事件后再次调用。
+ *
+ * 内存片段以 MSG_NOSIGNAL 发送，对端关闭时返回 FLUSH_ERROR(EPIPE)。
+ * sendfile 无法指定该标志，使用文件片段的进程需要忽略 SIGPIPE。
+ *
+ * 该类本身不加锁，调用者需持有连接的互斥锁。
+ */
+class OutputQueue {
+ public:
+  enum FlushStatus {
+    FLUSH_DONE = 0,     ///< 队列已清空
+    FLUSH_PENDING = 1,  ///< 套接字不可写，需等待可写事件
+    FLUSH_ERROR = -1,   ///< 发送出错，errno 保存错误原因
+  };
+
+  /// 单次 writev/sendmsg 聚合的最大片段数
+  static constexpr int MAX_IOV_PER_FLUSH = 64;
+  /// 超过该大小的片段在开启 zerocopy 时使用 MSG_ZEROCOPY 发送
+  static constexpr size_t ZEROCOPY_THRESHOLD = 64 * 1024;
+
+ public:
+  OutputQueue() = default;
+  ~OutputQueue();
+
+  OutputQueue(const OutputQueue &) = delete;
+  OutputQueue &operator=(const OutputQueue &) = delete;
+
+  /**
+   * @brief 追加一段数据，队列接管其所有权，不发生拷贝。
+   */
+  void append(std::string &&data);
+
+  /**
+   * @brief 追加一段静态数据的引用，调用者需保证数据在发送完成前有效。
+   */
+  void append_ref(const char *data, size_t len);
+
+  /**
+   * @brief 追加一个文件片段，发送时使用 sendfile。队列接管 file_fd，
+   * 发送完成或队列销毁时关闭。
+   */
+  void append_file(int file_fd, off_t offset, size_t len);
+
+  /**
+   * @brief 尝试在 fd 上开启 SO_ZEROCOPY，此后较大的内存片段使用
+   * MSG_ZEROCOPY 发送。
+   *
+   * @return 0 开启成功，-1 内核或套接字类型不支持
+   */
+  int enable_zerocopy(int fd);
+
+  /**
+   * @brief 以非阻塞方式尽可能多地发送队列中的数据。
+   */
+  FlushStatus flush(int fd);
+
+  /**
+   * @brief 读取 fd 错误队列中的 zerocopy 完成通知，释放内核不再引用的
+   * 数据。通知未读取前 fd 会一直报告错误事件，reactor 在每次唤醒时都
+   * 需要调用。
+   */
+  void reap_zerocopy(int fd);
+
+  /// 是否还有以 MSG_ZEROCOPY 提交、尚未收到完成通知的发送
+  bool zerocopy_pending() const { return zerocopy_done_ != zerocopy_seq_; }
+
+  bool empty() const { return fragments_.empty(); }
+  size_t pending_bytes() const { return pending_bytes_; }
+
+ private:
+  struct Fragment {
+    std::shared_ptr<std::string> owned;  // 队列持有的数据
+    const char *data = nullptr;          // 内存片段起始地址
+    size_t len = 0;                      // 剩余待发送长度
+    int file_fd = -1;                    // 文件片段的文件描述符
+    off_t file_offset = 0;               // 文件片段的当前偏移
+  };
+
+  /// 已经以 MSG_ZEROCOPY 提交、等待内核完成通知的数据
+  struct ZeroCopyHold {
+    uint32_t seq;
+    std::shared_ptr<std::string> data;
+  };
+
+  FlushStatus flush_file(int fd, Fragment *frag);
+  ssize_t send_vector(int fd, struct iovec *iov, int iovcnt, bool zerocopy);
+  void consume(size_t bytes);
+
+ private:
+  std::deque<Fragment> fragments_;
+  size_t pending_bytes_ = 0;
+
+  bool zerocopy_ = false;
+  uint32_t zerocopy_seq_ = 0;   // 下一次 zerocopy 发送的序号
+  uint32_t zerocopy_done_ = 0;  // 第一个尚未完成的序号
+  std::deque<ZeroCopyHold> zerocopy_holds_;
+};
+
+}  // namespace vulcan
@@ -0,0 +1,83 @@
+// Copyright 2023 VulcanDB
+#include "common/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace vulcan {
+
+int LatencyHistogram::shard_index() {
+  static std::atomic<int> next_shard{0};
+  thread_local int index =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+  return index;
+}
+
+int LatencyHistogram::bucket_index(uint64_t value) {
+  if (value < 2 * SUB_BUCKETS) {
+    return static_cast<int>(value);
+  }
+  int msb = 63 - __builtin_clzll(value);
+  int exponent = msb - SUB_BUCKET_BITS;
+  if (exponent > MAX_EXPONENT) {
+    return BUCKETS - 1;
+  }
+  // mantissa 落在 [SUB_BUCKETS, 2 * SUB_BUCKETS)
+  int mantissa = static_cast<int>(value >> exponent);
+  return exponent * SUB_BUCKETS + mantissa;
+}
+
+uint64_t LatencyHistogram::bucket_lower_bound(int index) {
+  if (index < 2 * SUB_BUCKETS) {
+    return index;
+  }
+  int exponent = index / SUB_BUCKETS - 1;
+  uint64_t mantissa = index - exponent * SUB_BUCKETS;
+  return mantissa << exponent;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+  Snapshot snap;
+  for (const Shard &shard : shards_) {
+    for (int i = 0; i < BUCKETS; i++) {
+      uint64_t count = shard.counts[i].load(std::memory_order_relaxed);
+      snap.counts[i] += count;
+      snap.total += count;
+    }
+    snap.sum += shard.sum.load(std::memory_order_relaxed);
+    snap.max = std::max(snap.max, shard.max.load(std::memory_order_relaxed));
+  }
+  return snap;
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(double quantile) const {
+  if (total == 0) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * total));
+  rank = std::max<uint64_t>(rank, 1);
+
+  uint64_t seen = 0;
+  for (int i = 0; i < BUCKETS; i++) {
+    seen += counts[i];
+    if (seen >= rank) {
+      uint64_t lower = bucket_lower_bound(i);
+      uint64_t upper =
+          i + 1 < BUCKETS ? bucket_lower_bound(i + 1) : lower + 1;
+      return std::min(lower + (upper - lower) / 2, max);
+    }
+  }
+  return max;
+}
+
+std::string LatencyHistogram::summary() const {
+  Snapshot snap = snapshot();
+  std::stringstream ss;
+  ss << "count=" << snap.total << " mean=" << snap.mean()
+     << " p50=" << snap.percentile(0.5) << " p99=" << snap.percentile(0.99)
+     << " p999=" << snap.percentile(0.999) << " max=" << snap.max;
+  return ss.str();
+}
+
+}  // namespace vulcan
@@ -0,0 +1,81 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace vulcan {
+
+/**
+ * @brief 无锁的对数线性(HDR 风格)延迟直方图。
+ *
+ * 每个 2 的幂区间再均分为 16 个子桶，相对误差不超过 1/16。记录操作只做
+ * 一次 relaxed fetch_add，并按线程分片以避免多个工作线程写同一缓存行；
+ * 读取时把各分片合并成快照再计算分位数。数值单位由调用者决定，
+ * backend 中统一使用微秒。
+ */
+class LatencyHistogram {
+ public:
+  static constexpr int SUB_BUCKET_BITS = 4;
+  static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static constexpr int MAX_EXPONENT = 40;  // 超过 2^44 的值落入最后一个桶
+  static constexpr int BUCKETS = (MAX_EXPONENT + 2) * SUB_BUCKETS;
+  static constexpr int SHARDS = 8;
+
+  /**
+   * @brief 合并后的直方图快照
+   */
+  struct Snapshot {
+    uint64_t counts[BUCKETS] = {0};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    /**
+     * @brief 计算分位数
+     * @param quantile 取值 [0, 1]，如 0.99
+     * @return 分位数所在桶的中间值，没有样本时返回 0
+     */
+    uint64_t percentile(double quantile) const;
+    uint64_t mean() const { return total == 0 ? 0 : sum / total; }
+  };
+
+ public:
+  LatencyHistogram() = default;
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+  void record(uint64_t value) {
+    Shard &shard = shards_[shard_index()];
+    shard.counts[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t cur = shard.max.load(std::memory_order_relaxed);
+    while (value > cur && !shard.max.compare_exchange_weak(
+                              cur, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  Snapshot snapshot() const;
+
+  /**
+   * @brief 格式化为 "count=.. p50=.. p99=.. p999=.. max=.."
+   */
+  std::string summary() const;
+
+  static int bucket_index(uint64_t value);
+  static uint64_t bucket_lower_bound(int index);
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> counts[BUCKETS] = {};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+  };
+
+  static int shard_index();
+
+  Shard shards_[SHARDS];
+};
+
+}  // namespace vulcan
@@ -0,0 +1,108 @@
+// Copyright 2023 VulcanDB
+#include "common/lock_profiler.h"
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace vulcan {
+
+LockSite::LockSite(const char *file, int line) : file_(file), line_(line) {
+  LockSite *head = head_.load(std::memory_order_relaxed);
+  do {
+    next_ = head;
+  } while (!head_.compare_exchange_weak(head, this, std::memory_order_release,
+                                        std::memory_order_relaxed));
+}
+
+int LockSite::shard_index() {
+  static std::atomic<int> next_shard{0};
+  thread_local int index =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+  return index;
+}
+
+LockSite::Counters LockSite::collect() const {
+  Counters counters;
+  for (const Shard &shard : shards_) {
+    counters.acquisitions += shard.acquisitions.load(std::memory_order_relaxed);
+    counters.contended += shard.contended.load(std::memory_order_relaxed);
+    counters.sampled_contended +=
+        shard.sampled_contended.load(std::memory_order_relaxed);
+    counters.wait_ns += shard.wait_ns.load(std::memory_order_relaxed);
+    counters.max_wait_ns =
+        std::max(counters.max_wait_ns,
+                 shard.max_wait_ns.load(std::memory_order_relaxed));
+  }
+  return counters;
+}
+
+void LockSite::reset() {
+  for (Shard &shard : shards_) {
+    shard.acquisitions.store(0, std::memory_order_relaxed);
+    shard.contended.store(0, std::memory_order_relaxed);
+    shard.sampled_contended.store(0, std::memory_order_relaxed);
+    shard.wait_ns.store(0, std::memory_order_relaxed);
+    shard.max_wait_ns.store(0, std::memory_order_relaxed);
+  }
+}
+
+// 在 [period / 2, period * 3 / 2) 内均匀取值，均值为 period
+int LockProfiler::next_countdown(uint32_t period) {
+  thread_local uint32_t state =
+      0x9e3779b9u ^ static_cast<uint32_t>(
+                        reinterpret_cast<uintptr_t>(&sample_countdown_));
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return static_cast<int>(period / 2 + state % period);
+}
+
+std::string LockProfiler::report(size_t top_n) {
+  std::vector<std::pair<const LockSite *, LockSite::Counters>> sites;
+  for (const LockSite *site = LockSite::head(); site != nullptr;
+       site = site->next()) {
+    LockSite::Counters counters = site->collect();
+    if (counters.acquisitions > 0) {
+      sites.emplace_back(site, counters);
+    }
+  }
+  std::sort(sites.begin(), sites.end(), [](const auto &a, const auto &b) {
+    uint64_t wait_a = a.second.estimated_wait_ns();
+    uint64_t wait_b = b.second.estimated_wait_ns();
+    if (wait_a != wait_b) {
+      return wait_a > wait_b;
+    }
+    return a.second.contended > b.second.contended;
+  });
+  if (sites.size() > top_n) {
+    sites.resize(top_n);
+  }
+
+  std::stringstream ss;
+  ss << "sample_period: " << sample_period() << "\n";
+  for (const auto &entry : sites) {
+    // 只保留 src/ 之后的路径
+    std::string file = entry.first->file();
+    size_t pos = file.rfind("src/");
+    if (pos != std::string::npos) {
+      file = file.substr(pos + 4);
+    }
+    const LockSite::Counters &c = entry.second;
+    ss << file << ":" << entry.first->line()
+       << ": acquisitions=" << c.acquisitions << " contended=" << c.contended
+       << " wait_us=" << c.estimated_wait_ns() / 1000
+       << " max_wait_us=" << c.max_wait_ns / 1000 << "\n";
+  }
+  return ss.str();
+}
+
+void LockProfiler::reset() {
+  for (LockSite *site = LockSite::head(); site != nullptr;
+       site = site->next()) {
+    site->reset();
+  }
+}
+
+}  // namespace vulcan
@@ -0,0 +1,155 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <errno.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace vulcan {
+
+/**
+ * @brief 一个加锁调用点(MUTEX_LOCK 所在的文件和行)的争用统计。
+ *
+ * 由 MUTEX_LOCK 展开出的函数内静态对象表示，首次执行时挂到全局链表上，
+ * 进程退出前不会移除。计数按线程分片，避免多个线程写同一缓存行。
+ */
+class LockSite {
+ public:
+  static constexpr int SHARDS = 8;
+
+  struct Counters {
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;          // trylock 失败、需要等待的次数
+    uint64_t sampled_contended = 0;  // 其中被采样计时的次数
+    uint64_t wait_ns = 0;            // 采样到的等待时间之和
+    uint64_t max_wait_ns = 0;
+
+    // 按采样比例估算的总等待时间
+    uint64_t estimated_wait_ns() const {
+      return sampled_contended == 0
+                 ? 0
+                 : static_cast<uint64_t>(static_cast<double>(wait_ns) *
+                                         contended / sampled_contended);
+    }
+  };
+
+  LockSite(const char *file, int line);
+  LockSite(const LockSite &) = delete;
+  LockSite &operator=(const LockSite &) = delete;
+
+  const char *file() const { return file_; }
+  int line() const { return line_; }
+
+  // 已执行过的调用点链表
+  static LockSite *head() { return head_.load(std::memory_order_acquire); }
+  LockSite *next() const { return next_; }
+
+  void record(bool contended, bool sampled, uint64_t wait_ns) {
+    Shard &shard = shards_[shard_index()];
+    shard.acquisitions.fetch_add(1, std::memory_order_relaxed);
+    if (!contended) {
+      return;
+    }
+    shard.contended.fetch_add(1, std::memory_order_relaxed);
+    if (sampled) {
+      shard.sampled_contended.fetch_add(1, std::memory_order_relaxed);
+      shard.wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+      uint64_t cur = shard.max_wait_ns.load(std::memory_order_relaxed);
+      while (wait_ns > cur && !shard.max_wait_ns.compare_exchange_weak(
+                                  cur, wait_ns, std::memory_order_relaxed)) {
+      }
+    }
+  }
+
+  Counters collect() const;
+  void reset();
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> sampled_contended{0};
+    std::atomic<uint64_t> wait_ns{0};
+    std::atomic<uint64_t> max_wait_ns{0};
+  };
+
+  static int shard_index();
+
+  inline static std::atomic<LockSite *> head_{nullptr};
+
+  const char *file_;
+  int line_;
+  LockSite *next_ = nullptr;
+  Shard shards_[SHARDS];
+};
+
+/**
+ * @brief 采样式的锁争用分析器，开销足够低，可以在线上常开。
+ *
+ * 每次加锁先 trylock：成功即为无争用，只增加调用点的计数；失败时才阻塞
+ * 等待。平均每 sample_period 次加锁中有一次对等待计时，计时只发生在
+ * 有争用的路径上。采样间隔带随机抖动，避免与固定的加锁顺序同步。
+ * sample_period 为 0 时直接调用 pthread_mutex_lock。
+ */
+class LockProfiler {
+ public:
+  static constexpr uint32_t DEFAULT_SAMPLE_PERIOD = 64;
+
+  static void set_sample_period(uint32_t period) {
+    sample_period_.store(period, std::memory_order_relaxed);
+  }
+  static uint32_t sample_period() {
+    return sample_period_.load(std::memory_order_relaxed);
+  }
+
+  static int lock(pthread_mutex_t *mutex, LockSite *site) {
+    uint32_t period = sample_period();
+    if (period == 0) {
+      return pthread_mutex_lock(mutex);
+    }
+    bool sampled = --sample_countdown_ <= 0;
+    if (sampled) {
+      sample_countdown_ = next_countdown(period);
+    }
+    int rc = pthread_mutex_trylock(mutex);
+    if (rc != EBUSY) {
+      if (rc == 0) {
+        site->record(false, sampled, 0);
+      }
+      return rc;
+    }
+    if (!sampled) {
+      rc = pthread_mutex_lock(mutex);
+      site->record(true, false, 0);
+      return rc;
+    }
+    auto start = std::chrono::steady_clock::now();
+    rc = pthread_mutex_lock(mutex);
+    auto wait = std::chrono::steady_clock::now() - start;
+    site->record(
+        true, true,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count());
+    return rc;
+  }
+
+  /**
+   * @brief 按估算等待时间排序的前 top_n 个调用点
+   * @return 每个调用点一行 "file:line: acquisitions=.. contended=.. ..."
+   */
+  static std::string report(size_t top_n);
+
+  // 清零所有调用点的计数
+  static void reset();
+
+ private:
+  static int next_countdown(uint32_t period);
+
+  inline static std::atomic<uint32_t> sample_period_{DEFAULT_SAMPLE_PERIOD};
+  inline static thread_local int sample_countdown_ = 0;
+};
+
+}  // namespace vulcan
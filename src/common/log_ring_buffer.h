@@ -0,0 +1,131 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "spdlog/common.h"
+#include "spdlog/fmt/fmt.h"
+
+namespace vulcan {
+
+/**
+ * @brief 异步日志队列中的一条日志记录，槽位在队列创建时预先分配并循环复用。
+ *
+ * 参数全部为算术或枚举类型时只拷贝参数，由后台线程调用 format 格式化；
+ * 否则由调用线程格式化到 text 中，format 为空。
+ */
+struct LogRecord {
+  static constexpr size_t ARG_BYTES = 64;      // 延迟格式化参数的最大字节数
+  static constexpr size_t MAX_TEXT = 4096;     // 超过该容量的文本缓冲区用后释放
+  typedef fmt::basic_memory_buffer<char, 256> Buffer;
+  typedef void (*FormatFunc)(const LogRecord &record, Buffer *out);
+
+  std::atomic<size_t> sequence{0};
+  size_t position = 0;
+  spdlog::level::level_enum level = spdlog::level::info;
+  spdlog::log_clock::time_point time;
+  size_t thread_id = 0;
+  FormatFunc format = nullptr;
+  const char *fmt = nullptr;  // 字符串字面量，生命周期覆盖整个进程
+  alignas(std::max_align_t) unsigned char args[ARG_BYTES];
+  Buffer text;
+};
+
+/**
+ * @brief 多生产者、单消费者的有界无锁环形队列(Vyukov)。
+ *
+ * 每个槽位的序号表示其状态：等于 pos 时可由生产者占用，等于 pos + 1 时
+ * 可由消费者读取，读取后置为 pos + capacity 交给下一轮的生产者。生产者
+ * 通过 try_claim() 原地填写槽位后 publish()，入队不分配内存也不加锁；
+ * 消费者按入队顺序读取，一个已占用但尚未发布的槽位会挡住其后的记录。
+ */
+class LogRingBuffer {
+ public:
+  /**
+   * @param capacity 槽位数，向上取整为 2 的幂，至少为 2
+   */
+  explicit LogRingBuffer(size_t capacity) {
+    capacity_ = 2;
+    while (capacity_ < capacity) {
+      capacity_ <<= 1;
+    }
+    mask_ = capacity_ - 1;
+    records_.reset(new LogRecord[capacity_]);
+    for (size_t i = 0; i < capacity_; i++) {
+      records_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  LogRingBuffer(const LogRingBuffer &) = delete;
+  LogRingBuffer &operator=(const LogRingBuffer &) = delete;
+
+  size_t capacity() const { return capacity_; }
+
+  /**
+   * @brief 生产者占用一个空闲槽位
+   * @return 队列已满时返回 nullptr
+   */
+  LogRecord *try_claim() {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      LogRecord *record = &records_[pos & mask_];
+      size_t seq = record->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          record->position = pos;
+          return record;
+        }
+      } else if (diff < 0) {
+        return nullptr;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // 生产者填写完成，记录对消费者可见
+  void publish(LogRecord *record) {
+    record->sequence.store(record->position + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief 消费者查看队首记录
+   * @return 队列为空或队首尚未发布时返回 nullptr
+   */
+  LogRecord *front() {
+    LogRecord *record = &records_[dequeue_pos_ & mask_];
+    size_t seq = record->sequence.load(std::memory_order_acquire);
+    return seq == dequeue_pos_ + 1 ? record : nullptr;
+  }
+
+  // 消费者处理完队首记录，槽位交还生产者
+  void pop(LogRecord *record) {
+    record->sequence.store(dequeue_pos_ + capacity_, std::memory_order_release);
+    dequeue_pos_++;
+    consumed_.store(dequeue_pos_, std::memory_order_release);
+  }
+
+  // 已入队(含尚未发布)的记录总数
+  size_t enqueued() const {
+    return enqueue_pos_.load(std::memory_order_acquire);
+  }
+
+  // 已被消费者处理的记录总数
+  size_t consumed() const { return consumed_.load(std::memory_order_acquire); }
+
+ private:
+  size_t capacity_;
+  size_t mask_;
+  std::unique_ptr<LogRecord[]> records_;
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) size_t dequeue_pos_ = 0;
+  std::atomic<size_t> consumed_{0};
+};
+
+}  // namespace vulcan
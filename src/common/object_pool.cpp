@@ -0,0 +1,144 @@
+// Copyright 2023 VulcanDB
+#include "common/object_pool.h"
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace vulcan {
+
+namespace {
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+// 线程之间流转的空闲块，每条链表对应一次成批归还
+class Depot {
+ public:
+  void put(size_t cls, FreeBlock *head, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    chains_[cls].emplace_back(head, count);
+  }
+
+  FreeBlock *take(size_t cls, size_t *count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (chains_[cls].empty()) {
+      return nullptr;
+    }
+    std::pair<FreeBlock *, size_t> chain = chains_[cls].back();
+    chains_[cls].pop_back();
+    *count = chain.second;
+    return chain.first;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::pair<FreeBlock *, size_t>> chains_[ObjectPool::CLASSES];
+};
+
+// 不析构，其他线程退出或静态对象析构时仍可归还
+Depot &depot() {
+  static Depot *instance = new Depot();
+  return *instance;
+}
+
+// 可平凡析构，线程退出期间其他 thread_local 析构时仍可访问
+struct ThreadCache {
+  FreeBlock *heads[ObjectPool::CLASSES];
+  size_t counts[ObjectPool::CLASSES];
+  bool registered;
+  bool released;  // 已归还仓库，之后的释放直接交给仓库
+};
+
+thread_local ThreadCache cache;
+
+struct CacheReleaser {
+  ~CacheReleaser() {
+    for (size_t cls = 0; cls < ObjectPool::CLASSES; cls++) {
+      if (cache.heads[cls] != nullptr) {
+        depot().put(cls, cache.heads[cls], cache.counts[cls]);
+        cache.heads[cls] = nullptr;
+        cache.counts[cls] = 0;
+      }
+    }
+    cache.released = true;
+  }
+};
+
+ThreadCache &thread_cache() {
+  if (!cache.registered) {
+    thread_local CacheReleaser releaser;
+    (void)releaser;
+    cache.registered = true;
+  }
+  return cache;
+}
+
+size_t class_of(size_t size) {
+  return size == 0 ? 0 : (size - 1) / ObjectPool::CLASS_SIZE;
+}
+
+}  // namespace
+
+void *ObjectPool::allocate(size_t size) {
+#ifdef __SANITIZE_ADDRESS__
+  return ::operator new(size);
+#else
+  if (size > MAX_SIZE) {
+    return ::operator new(size);
+  }
+  size_t cls = class_of(size);
+  ThreadCache &local = thread_cache();
+  FreeBlock *block = local.heads[cls];
+  if (block == nullptr && !local.released) {
+    block = depot().take(cls, &local.counts[cls]);
+  }
+  if (block == nullptr) {
+    heap_blocks_.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new((cls + 1) * CLASS_SIZE);
+  }
+  local.heads[cls] = block->next;
+  local.counts[cls]--;
+  return block;
+#endif
+}
+
+void ObjectPool::deallocate(void *ptr, size_t size) {
+#ifdef __SANITIZE_ADDRESS__
+  ::operator delete(ptr);
+#else
+  if (ptr == nullptr) {
+    return;
+  }
+  if (size > MAX_SIZE) {
+    ::operator delete(ptr);
+    return;
+  }
+  size_t cls = class_of(size);
+  FreeBlock *block = static_cast<FreeBlock *>(ptr);
+  ThreadCache &local = thread_cache();
+  if (local.released) {
+    block->next = nullptr;
+    depot().put(cls, block, 1);
+    return;
+  }
+
+  block->next = local.heads[cls];
+  local.heads[cls] = block;
+  if (++local.counts[cls] <= 2 * BATCH) {
+    return;
+  }
+  // 把链表前 BATCH 块成批交给仓库
+  FreeBlock *tail = block;
+  for (size_t i = 1; i < BATCH; i++) {
+    tail = tail->next;
+  }
+  local.heads[cls] = tail->next;
+  local.counts[cls] -= BATCH;
+  tail->next = nullptr;
+  depot().put(cls, block, BATCH);
+#endif
+}
+
+}  // namespace vulcan
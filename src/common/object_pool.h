@@ -0,0 +1,94 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace vulcan {
+
+/**
+ * @brief 按 64 字节尺寸类划分的小对象池，每个线程一份空闲链表。
+ *
+ * 分配和释放只操作调用线程的空闲链表，不加锁。SEDA 中的事件常在一个
+ * 线程分配、在另一个线程释放，线程缓存超过 2 * BATCH 块时把 BATCH 块
+ * 成批交给全局仓库，缓存为空时从仓库成批取回，跨线程的流转只在每
+ * BATCH 个对象上加一次锁。超过 MAX_SIZE 的请求以及 ASan 构建直接使用
+ * 全局 operator new，后者保留对释放后使用的检查。
+ *
+ * 池中的内存不归还系统，峰值之后一直保留供复用。
+ */
+class ObjectPool {
+ public:
+  static constexpr size_t CLASS_SIZE = 64;
+  static constexpr size_t CLASSES = 16;
+  static constexpr size_t MAX_SIZE = CLASS_SIZE * CLASSES;
+  static constexpr size_t BATCH = 32;
+
+  static void *allocate(size_t size);
+  static void deallocate(void *ptr, size_t size);
+
+  // 向系统申请过的块数，用于观察稳态下是否仍在分配
+  static uint64_t heap_blocks() {
+    return heap_blocks_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  inline static std::atomic<uint64_t> heap_blocks_{0};
+};
+
+/**
+ * @brief 继承后类的 new/delete 走 ObjectPool。
+ *
+ * 虚析构的类经由基类指针 delete 时，编译器传入的是实际类型的大小，
+ * 因此子类大小不同也会归还到正确的尺寸类。持有者用 std::unique_ptr
+ * 即可在析构时归还对象池。
+ */
+class PooledObject {
+ public:
+  static void *operator new(size_t size) { return ObjectPool::allocate(size); }
+
+  static void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    try {
+      return ObjectPool::allocate(size);
+    } catch (const std::bad_alloc &) {
+      return nullptr;
+    }
+  }
+
+  static void operator delete(void *ptr, size_t size) {
+    ObjectPool::deallocate(ptr, size);
+  }
+};
+
+/**
+ * @brief 从 ObjectPool 分配的 STL 分配器，用于链表节点等定长的小块内存。
+ */
+template <typename T>
+class PoolAllocator {
+ public:
+  typedef T value_type;
+
+  PoolAllocator() noexcept = default;
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(ObjectPool::allocate(n * sizeof(T)));
+  }
+  void deallocate(T *ptr, size_t n) {
+    ObjectPool::deallocate(ptr, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U> &) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const PoolAllocator<U> &) const noexcept {
+    return false;
+  }
+};
+
+}  // namespace vulcan
@@ -0,0 +1,272 @@
+// Copyright 2023 VulcanDB
+#include "common/roaring_bitmap.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace vulcan {
+
+size_t RoaringBitmap::find(uint16_t key, bool *found) const {
+  // 按 id 顺序插入时总是命中最后一个容器
+  if (!containers_.empty() && containers_.back().key == key) {
+    *found = true;
+    return containers_.size() - 1;
+  }
+  auto it = std::lower_bound(
+      containers_.begin(), containers_.end(), key,
+      [](const Container &c, uint16_t k) { return c.key < k; });
+  *found = it != containers_.end() && it->key == key;
+  return it - containers_.begin();
+}
+
+bool RoaringBitmap::contains(const Container &c, uint16_t low) {
+  if (!c.bitset.empty()) {
+    return (c.bitset[low >> 6] >> (low & 63)) & 1;
+  }
+  return std::binary_search(c.array.begin(), c.array.end(), low);
+}
+
+void RoaringBitmap::to_bitset(Container *c) {
+  c->bitset.assign(BITSET_WORDS, 0);
+  for (uint16_t low : c->array) {
+    c->bitset[low >> 6] |= uint64_t(1) << (low & 63);
+  }
+  c->array.clear();
+  c->array.shrink_to_fit();
+}
+
+void RoaringBitmap::to_array(Container *c) {
+  std::vector<uint16_t> array;
+  array.reserve(c->cardinality);
+  for (size_t w = 0; w < BITSET_WORDS; w++) {
+    uint64_t word = c->bitset[w];
+    while (word != 0) {
+      array.push_back(static_cast<uint16_t>(w * 64 + __builtin_ctzll(word)));
+      word &= word - 1;
+    }
+  }
+  c->array.swap(array);
+  c->bitset.clear();
+  c->bitset.shrink_to_fit();
+}
+
+void RoaringBitmap::add(uint32_t value) {
+  uint16_t key = static_cast<uint16_t>(value >> 16);
+  uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+  bool found = false;
+  size_t index = find(key, &found);
+  if (!found) {
+    Container c;
+    c.key = key;
+    containers_.insert(containers_.begin() + index, c);
+  }
+
+  Container &c = containers_[index];
+  if (!c.bitset.empty()) {
+    uint64_t &word = c.bitset[low >> 6];
+    uint64_t bit = uint64_t(1) << (low & 63);
+    c.cardinality += (word & bit) == 0;
+    word |= bit;
+    return;
+  }
+  if (c.array.empty() || c.array.back() < low) {
+    c.array.push_back(low);
+  } else {
+    auto it = std::lower_bound(c.array.begin(), c.array.end(), low);
+    if (*it == low) {
+      return;
+    }
+    c.array.insert(it, low);
+  }
+  c.cardinality++;
+  if (c.cardinality > ARRAY_MAX) {
+    to_bitset(&c);
+  }
+}
+
+bool RoaringBitmap::remove(uint32_t value) {
+  bool found = false;
+  size_t index = find(static_cast<uint16_t>(value >> 16), &found);
+  if (!found) {
+    return false;
+  }
+
+  Container &c = containers_[index];
+  uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+  if (!c.bitset.empty()) {
+    uint64_t &word = c.bitset[low >> 6];
+    uint64_t bit = uint64_t(1) << (low & 63);
+    if ((word & bit) == 0) {
+      return false;
+    }
+    word &= ~bit;
+    c.cardinality--;
+    if (c.cardinality <= ARRAY_MAX) {
+      to_array(&c);
+    }
+  } else {
+    auto it = std::lower_bound(c.array.begin(), c.array.end(), low);
+    if (it == c.array.end() || *it != low) {
+      return false;
+    }
+    c.array.erase(it);
+    c.cardinality--;
+  }
+  if (c.cardinality == 0) {
+    containers_.erase(containers_.begin() + index);
+  }
+  return true;
+}
+
+bool RoaringBitmap::contains(uint32_t value) const {
+  bool found = false;
+  size_t index = find(static_cast<uint16_t>(value >> 16), &found);
+  return found &&
+         contains(containers_[index], static_cast<uint16_t>(value & 0xFFFF));
+}
+
+uint64_t RoaringBitmap::cardinality() const {
+  uint64_t total = 0;
+  for (const Container &c : containers_) {
+    total += c.cardinality;
+  }
+  return total;
+}
+
+RoaringBitmap::Container RoaringBitmap::and_of(const Container &a,
+                                               const Container &b) {
+  Container result;
+  result.key = a.key;
+  if (!a.bitset.empty() && !b.bitset.empty()) {
+    result.bitset.resize(BITSET_WORDS);
+    for (size_t w = 0; w < BITSET_WORDS; w++) {
+      result.bitset[w] = a.bitset[w] & b.bitset[w];
+      result.cardinality += __builtin_popcountll(result.bitset[w]);
+    }
+    if (result.cardinality <= ARRAY_MAX) {
+      to_array(&result);
+    }
+    return result;
+  }
+  if (a.bitset.empty() && b.bitset.empty()) {
+    std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(),
+                          b.array.end(), std::back_inserter(result.array));
+  } else {
+    const Container &array = a.bitset.empty() ? a : b;
+    const Container &bitset = a.bitset.empty() ? b : a;
+    for (uint16_t low : array.array) {
+      if (contains(bitset, low)) {
+        result.array.push_back(low);
+      }
+    }
+  }
+  result.cardinality = static_cast<uint32_t>(result.array.size());
+  return result;
+}
+
+void RoaringBitmap::or_into(Container *a, const Container &b) {
+  if (a->bitset.empty() && b.bitset.empty() &&
+      a->cardinality + b.cardinality <= ARRAY_MAX) {
+    std::vector<uint16_t> merged;
+    merged.reserve(a->cardinality + b.cardinality);
+    std::set_union(a->array.begin(), a->array.end(), b.array.begin(),
+                   b.array.end(), std::back_inserter(merged));
+    a->array.swap(merged);
+    a->cardinality = static_cast<uint32_t>(a->array.size());
+    return;
+  }
+
+  if (a->bitset.empty()) {
+    to_bitset(a);
+  }
+  if (b.bitset.empty()) {
+    for (uint16_t low : b.array) {
+      a->bitset[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+  } else {
+    for (size_t w = 0; w < BITSET_WORDS; w++) {
+      a->bitset[w] |= b.bitset[w];
+    }
+  }
+  a->cardinality = 0;
+  for (size_t w = 0; w < BITSET_WORDS; w++) {
+    a->cardinality += __builtin_popcountll(a->bitset[w]);
+  }
+  if (a->cardinality <= ARRAY_MAX) {
+    to_array(a);
+  }
+}
+
+RoaringBitmap &RoaringBitmap::operator|=(const RoaringBitmap &other) {
+  std::vector<Container> result;
+  result.reserve(containers_.size() + other.containers_.size());
+  size_t i = 0, j = 0;
+  while (i < containers_.size() || j < other.containers_.size()) {
+    if (j == other.containers_.size() ||
+        (i < containers_.size() &&
+         containers_[i].key < other.containers_[j].key)) {
+      result.push_back(std::move(containers_[i++]));
+    } else if (i == containers_.size() ||
+               other.containers_[j].key < containers_[i].key) {
+      result.push_back(other.containers_[j++]);
+    } else {
+      or_into(&containers_[i], other.containers_[j++]);
+      result.push_back(std::move(containers_[i++]));
+    }
+  }
+  containers_.swap(result);
+  return *this;
+}
+
+RoaringBitmap &RoaringBitmap::operator&=(const RoaringBitmap &other) {
+  std::vector<Container> result;
+  size_t i = 0, j = 0;
+  while (i < containers_.size() && j < other.containers_.size()) {
+    if (containers_[i].key < other.containers_[j].key) {
+      i++;
+    } else if (other.containers_[j].key < containers_[i].key) {
+      j++;
+    } else {
+      Container c = and_of(containers_[i++], other.containers_[j++]);
+      if (c.cardinality != 0) {
+        result.push_back(std::move(c));
+      }
+    }
+  }
+  containers_.swap(result);
+  return *this;
+}
+
+bool RoaringBitmap::operator==(const RoaringBitmap &other) const {
+  if (containers_.size() != other.containers_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < containers_.size(); i++) {
+    const Container &a = containers_[i];
+    const Container &b = other.containers_[i];
+    // 表示只由元素数决定，元素数相同时两者的表示一致
+    if (a.key != b.key || a.cardinality != b.cardinality ||
+        a.array != b.array || a.bitset != b.bitset) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<uint32_t> RoaringBitmap::to_vector() const {
+  std::vector<uint32_t> values;
+  values.reserve(cardinality());
+  for_each([&values](uint32_t value) { values.push_back(value); });
+  return values;
+}
+
+size_t RoaringBitmap::memory_bytes() const {
+  size_t bytes = containers_.capacity() * sizeof(Container);
+  for (const Container &c : containers_) {
+    bytes += c.array.capacity() * sizeof(uint16_t) +
+             c.bitset.capacity() * sizeof(uint64_t);
+  }
+  return bytes;
+}
+
+}  // namespace vulcan
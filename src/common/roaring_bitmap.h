@@ -0,0 +1,102 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vulcan {
+
+/**
+ * @brief 32 位无符号整数的压缩位图(Roaring bitmap)。
+ *
+ * 值按高 16 位分到不同的容器，容器内只保存低 16 位：元素不超过
+ * ARRAY_MAX 个时用有序数组，否则用 65536 位的位图，两种表示随元素数
+ * 自动转换。IFC 实例 id 大多连续分配，同一类型的实例通常集中在少数几个
+ * 容器里，占用远小于保存指针的列表，并且交、并运算可以按 64 位字批量进行。
+ */
+class RoaringBitmap {
+ public:
+  static constexpr size_t ARRAY_MAX = 4096;
+  static constexpr size_t BITSET_WORDS = 65536 / 64;
+
+  RoaringBitmap() = default;
+
+  void add(uint32_t value);
+  /**
+   * @return 值存在并被删除时返回 true
+   */
+  bool remove(uint32_t value);
+  bool contains(uint32_t value) const;
+
+  uint64_t cardinality() const;
+  bool empty() const { return containers_.empty(); }
+  void clear() { containers_.clear(); }
+
+  RoaringBitmap &operator|=(const RoaringBitmap &other);
+  RoaringBitmap &operator&=(const RoaringBitmap &other);
+  bool operator==(const RoaringBitmap &other) const;
+  bool operator!=(const RoaringBitmap &other) const {
+    return !(*this == other);
+  }
+
+  /**
+   * @brief 按升序访问所有值
+   */
+  template <typename F>
+  void for_each(F f) const {
+    for (const Container &c : containers_) {
+      uint32_t high = static_cast<uint32_t>(c.key) << 16;
+      if (c.bitset.empty()) {
+        for (uint16_t low : c.array) {
+          f(high | low);
+        }
+        continue;
+      }
+      for (size_t w = 0; w < BITSET_WORDS; w++) {
+        uint64_t word = c.bitset[w];
+        while (word != 0) {
+          uint32_t bit = static_cast<uint32_t>(__builtin_ctzll(word));
+          f(high | static_cast<uint32_t>(w * 64 + bit));
+          word &= word - 1;
+        }
+      }
+    }
+  }
+
+  std::vector<uint32_t> to_vector() const;
+
+  // 容器占用的堆内存，用于统计
+  size_t memory_bytes() const;
+
+ private:
+  struct Container {
+    uint16_t key = 0;
+    uint32_t cardinality = 0;
+    std::vector<uint16_t> array;    // 有序，位图表示时为空
+    std::vector<uint64_t> bitset;   // BITSET_WORDS 个字，数组表示时为空
+  };
+
+  // key 所在容器的下标，不存在时返回应插入的位置并置 found 为 false
+  size_t find(uint16_t key, bool *found) const;
+
+  static bool contains(const Container &c, uint16_t low);
+  static void to_bitset(Container *c);
+  static void to_array(Container *c);
+  static Container and_of(const Container &a, const Container &b);
+  static void or_into(Container *a, const Container &b);
+
+  std::vector<Container> containers_;  // 按 key 升序
+};
+
+inline RoaringBitmap operator|(RoaringBitmap left, const RoaringBitmap &right) {
+  left |= right;
+  return left;
+}
+
+inline RoaringBitmap operator&(RoaringBitmap left, const RoaringBitmap &right) {
+  left &= right;
+  return left;
+}
+
+}  // namespace vulcan
@@ -3,6 +3,8 @@
 
 #include <stdarg.h>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <utility>
 
@@ -38,7 +40,10 @@ void VulcanLogger::init(const std::filesystem::path& log_dir,
 
     spdlog::sinks_init_list sink_list = {file_sink, console_sink};
 
+    // logger 自身的级别默认为 info，需放开到两个 sink 中较低的级别
+    active_level_ = std::max(log_level_, console_level_);
     logger_ = std::make_unique<spdlog::logger>("vulcan_logger", sink_list);
+    logger_->set_level(log_level_map_[active_level_]);
     logger_->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] [%t] %v");
     logger_->flush_on(spdlog::level::trace);
     is_init_ = true;
@@ -49,4 +54,150 @@ void VulcanLogger::init(const std::filesystem::path& log_dir,
   }
 }
 
+int VulcanLogger::enable_async(size_t queue_size,
+                               LogOverflowPolicy policy) {
+  if (!is_init_ || is_async() || queue_size == 0) {
+    return -1;
+  }
+  queue_ = std::make_unique<LogRingBuffer>(queue_size);
+  overflow_policy_ = policy;
+  stopping_.store(false);
+  flusher_ = std::thread(&VulcanLogger::flush_loop, this);
+  async_.store(true, std::memory_order_release);
+  return 0;
+}
+
+void VulcanLogger::disable_async() {
+  if (!is_async()) {
+    return;
+  }
+  // 之后的日志同步写入，后台线程写完已入队的日志后退出
+  async_.store(false, std::memory_order_release);
+  stopping_.store(true);
+  wake_flusher();
+  flusher_.join();
+}
+
+void VulcanLogger::flush() {
+  if (!is_init_) {
+    return;
+  }
+  if (is_async()) {
+    size_t target = queue_->enqueued();
+    while (queue_->consumed() < target) {
+      wake_flusher();
+      std::this_thread::yield();
+    }
+  }
+  logger_->flush();
+}
+
+LogRecord* VulcanLogger::claim_overflow() {
+  if (overflow_policy_ == LogOverflowPolicy::DROP) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  LogRecord* record = nullptr;
+  while ((record = queue_->try_claim()) == nullptr) {
+    wake_flusher();
+    std::this_thread::yield();
+  }
+  return record;
+}
+
+void VulcanLogger::wake_flusher() {
+  std::lock_guard<std::mutex> lock(flusher_mutex_);
+  flusher_cv_.notify_one();
+}
+
+// 后台线程：按入队顺序写出日志，队列排空时 flush，空闲时休眠
+void VulcanLogger::flush_loop() {
+  LogRecord::Buffer buffer;
+  uint64_t reported = 0;
+  bool dirty = false;
+  for (;;) {
+    LogRecord* record = queue_->front();
+    if (record != nullptr) {
+      write_record(*record, &buffer);
+      if (record->text.capacity() > LogRecord::MAX_TEXT) {
+        record->text = LogRecord::Buffer();
+      }
+      queue_->pop(record);
+      dirty = true;
+      continue;
+    }
+
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported) {
+      spdlog::details::log_msg msg(
+          logger_->name(), spdlog::level::warn,
+          fmt::format("async log queue full, dropped {} messages",
+                      dropped - reported));
+      for (auto& sink : logger_->sinks()) {
+        if (sink->should_log(msg.level)) {
+          sink->log(msg);
+        }
+      }
+      reported = dropped;
+      dirty = true;
+    }
+    if (dirty) {
+      flush_sinks();
+      dirty = false;
+      continue;
+    }
+    if (stopping_.load()) {
+      break;
+    }
+
+    // 生产者发布后检查 flusher_sleeping_，休眠前再检查一次队列；
+    // 超时兜底可能错过的唤醒
+    std::unique_lock<std::mutex> lock(flusher_mutex_);
+    flusher_sleeping_.store(true);
+    if (queue_->front() == nullptr && !stopping_.load()) {
+      flusher_cv_.wait_for(lock, std::chrono::milliseconds(50));
+    }
+    flusher_sleeping_.store(false);
+  }
+}
+
+void VulcanLogger::write_record(const LogRecord& record,
+                                LogRecord::Buffer* buffer) {
+  spdlog::string_view_t payload(record.text.data(), record.text.size());
+  if (record.format != nullptr) {
+    buffer->clear();
+    try {
+      record.format(record, buffer);
+    } catch (const std::exception& ex) {
+      buffer->clear();
+      fmt::format_to(std::back_inserter(*buffer), "[format error: {}] {}",
+                     ex.what(), record.fmt);
+    }
+    payload = spdlog::string_view_t(buffer->data(), buffer->size());
+  }
+
+  spdlog::details::log_msg msg(record.time, spdlog::source_loc{},
+                               logger_->name(), record.level, payload);
+  msg.thread_id = record.thread_id;
+  for (auto& sink : logger_->sinks()) {
+    if (sink->should_log(msg.level)) {
+      try {
+        sink->log(msg);
+      } catch (const std::exception& ex) {
+        std::cerr << "VulcanLogger write failed: " << ex.what() << std::endl;
+      }
+    }
+  }
+}
+
+void VulcanLogger::flush_sinks() {
+  for (auto& sink : logger_->sinks()) {
+    try {
+      sink->flush();
+    } catch (const std::exception& ex) {
+      std::cerr << "VulcanLogger flush failed: " << ex.what() << std::endl;
+    }
+  }
+}
+
 }  // namespace vulcan
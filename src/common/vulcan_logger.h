@@ -6,14 +6,24 @@
 #include <pthread.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 
 #include "common/defs.h"
+#include "common/log_ring_buffer.h"
+#include "spdlog/details/os.h"
 #include "spdlog/sinks/basic_file_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/spdlog.h"
@@ -33,9 +43,38 @@ typedef enum {
   LAST
 } LOG_LEVEL;
 
+// LOG 宏中的级别名到 LOG_LEVEL 的映射
+namespace log_level {
+constexpr LOG_LEVEL panic = PANIC;
+constexpr LOG_LEVEL error = ERR;
+constexpr LOG_LEVEL warn = WARN;
+constexpr LOG_LEVEL info = INFO;
+constexpr LOG_LEVEL debug = DEBUG;
+constexpr LOG_LEVEL trace = TRACE;
+}  // namespace log_level
+
+/*
+ * 编译期启用的最低日志级别，低于该级别的 LOG 调用连同参数求值一起被编译
+ * 器消除。Release 构建默认去掉 trace，可通过 -DVULCAN_LOG_ACTIVE_LEVEL=n
+ * 覆盖。
+ */
+#ifndef VULCAN_LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define VULCAN_LOG_ACTIVE_LEVEL vulcan::DEBUG
+#else
+#define VULCAN_LOG_ACTIVE_LEVEL vulcan::TRACE
+#endif
+#endif  // VULCAN_LOG_ACTIVE_LEVEL
+
+// 异步日志队列满时的处理方式
+enum class LogOverflowPolicy {
+  DROP,   // 丢弃新日志并计数，由后台线程定期报告丢弃条数
+  BLOCK,  // 调用线程等待后台线程腾出槽位
+};
+
 class VulcanLogger {
  public:
-  ~VulcanLogger() = default;
+  ~VulcanLogger() { disable_async(); }
 
   static VulcanLogger* get_instance() {
     static VulcanLogger instance;
@@ -45,37 +84,63 @@ class VulcanLogger {
   void init(const std::filesystem::path& log_dir, const std::string& log_name,
             LOG_LEVEL log_level = INFO, LOG_LEVEL console_level = WARN);
 
+  /**
+   * @brief 切换到异步模式，须在 init() 之后、其他线程开始写日志之前调用。
+   *
+   * 调用线程只占用预分配的环形队列槽位并拷贝参数或格式化后的文本，
+   * 由后台线程格式化、写入各个 sink，并在队列排空时 flush。
+   * @param queue_size 队列槽位数，向上取整为 2 的幂
+   * @param policy 队列满时的处理方式
+   * @return 0 成功，-1 未初始化、已是异步模式或参数非法
+   */
+  int enable_async(size_t queue_size, LogOverflowPolicy policy);
+
+  // 写完队列中的日志后停止后台线程，之后的日志同步写入
+  void disable_async();
+
+  // 等待此前提交的日志全部写入并 flush
+  void flush();
+
   bool is_init() const { return is_init_; }
+  bool is_async() const { return async_.load(std::memory_order_acquire); }
   LOG_LEVEL get_log_level() const { return log_level_; }
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // 文件和控制台都不输出的级别直接跳过，不求值参数
+  bool should_log(LOG_LEVEL level) const { return level <= active_level_; }
 
   template <typename... Args>
   void trace(const char* fmt, const Args&... args) {
-    logger_->trace(fmt, args...);
+    log(spdlog::level::trace, fmt, args...);
   }
 
   template <typename... Args>
   void debug(const char* fmt, const Args&... args) {
-    logger_->debug(fmt, args...);
+    log(spdlog::level::debug, fmt, args...);
   }
 
   template <typename... Args>
   void info(const char* fmt, const Args&... args) {
-    logger_->info(fmt, args...);
+    log(spdlog::level::info, fmt, args...);
   }
 
   template <typename... Args>
   void warn(const char* fmt, const Args&... args) {
-    logger_->warn(fmt, args...);
+    log(spdlog::level::warn, fmt, args...);
   }
 
   template <typename... Args>
   void error(const char* fmt, const Args&... args) {
-    std::cerr << SYS_OUTPUT_FILE_POS;
-    logger_->error(fmt, args...);
+    if (!is_async()) {
+      std::cerr << SYS_OUTPUT_FILE_POS;
+    }
+    log(spdlog::level::err, fmt, args...);
   }
 
+  // 进程可能随即退出，先写完队列中的日志再同步写入
   template <typename... Args>
   void panic(const char* fmt, const Args&... args) {
+    flush();
     std::cerr << SYS_OUTPUT_FILE_POS;
     logger_->critical(fmt, args...);
   }
@@ -83,12 +148,89 @@ class VulcanLogger {
  private:
   VulcanLogger() = default;
 
+  // 参数全部为按值拷贝即可安全跨线程的类型时延迟格式化。指针和
+  // string_view 等虽可平凡拷贝，但指向的内存可能在格式化前失效
+  template <typename... Args>
+  static constexpr bool deferrable() {
+    return (... && (std::is_arithmetic_v<Args> || std::is_enum_v<Args>)) &&
+           sizeof(std::tuple<Args...>) <= LogRecord::ARG_BYTES;
+  }
+
+  template <typename... Args>
+  static void format_deferred(const LogRecord& record,
+                              LogRecord::Buffer* out) {
+    const std::tuple<Args...>& args = *std::launder(
+        reinterpret_cast<const std::tuple<Args...>*>(record.args));
+    std::apply(
+        [&](const Args&... values) {
+          fmt::vformat_to(std::back_inserter(*out),
+                          fmt::string_view(record.fmt),
+                          fmt::make_format_args(values...));
+        },
+        args);
+  }
+
+  template <typename... Args>
+  void log(spdlog::level::level_enum level, const char* fmt,
+           const Args&... args) {
+    if (!is_async()) {
+      logger_->log(level, fmt, args...);
+      return;
+    }
+
+    LogRecord* record = queue_->try_claim();
+    if (record == nullptr && (record = claim_overflow()) == nullptr) {
+      return;
+    }
+    record->level = level;
+    record->time = spdlog::log_clock::now();
+    record->thread_id = spdlog::details::os::thread_id();
+    record->fmt = fmt;
+    if constexpr (deferrable<Args...>()) {
+      new (record->args) std::tuple<Args...>(args...);
+      record->format = &format_deferred<Args...>;
+    } else {
+      record->format = nullptr;
+      record->text.clear();
+      try {
+        fmt::vformat_to(std::back_inserter(record->text),
+                        fmt::string_view(fmt), fmt::make_format_args(args...));
+      } catch (const std::exception& ex) {
+        record->text.clear();
+        fmt::format_to(std::back_inserter(record->text),
+                       "[format error: {}] {}", ex.what(), fmt);
+      }
+    }
+    queue_->publish(record);
+    if (flusher_sleeping_.load()) {
+      wake_flusher();
+    }
+  }
+
+  // 队列已满时按溢出策略处理，返回 nullptr 表示丢弃
+  LogRecord* claim_overflow();
+  void wake_flusher();
+  void flush_loop();
+  void write_record(const LogRecord& record, LogRecord::Buffer* buffer);
+  void flush_sinks();
+
   bool is_init_ = false;
   std::unique_ptr<spdlog::logger> logger_;
   std::filesystem::path log_dir_;
   std::filesystem::path log_file_;
   LOG_LEVEL log_level_;
   LOG_LEVEL console_level_;
+  LOG_LEVEL active_level_ = TRACE;
+
+  std::atomic<bool> async_{false};
+  std::unique_ptr<LogRingBuffer> queue_;
+  LogOverflowPolicy overflow_policy_ = LogOverflowPolicy::BLOCK;
+  std::atomic<uint64_t> dropped_{0};
+  std::thread flusher_;
+  std::atomic<bool> flusher_sleeping_{false};
+  std::atomic<bool> stopping_{false};
+  std::mutex flusher_mutex_;
+  std::condition_variable flusher_cv_;
   std::map<LOG_LEVEL, spdlog::level::level_enum> log_level_map_ = {
       {PANIC, spdlog::level::critical}, {ERR, spdlog::level::err},
       {WARN, spdlog::level::warn},      {INFO, spdlog::level::info},
@@ -98,16 +240,22 @@ class VulcanLogger {
 /*
  * LOG(level, fmt, ...)
  * @param level: log level. e.g. trace, info, warn, error, debug, panic
- * @param fmt: format string. e.g. "hello {}"
+ * @param fmt: format string literal. e.g. "hello {}". Asynchronous mode may
+ *             format it on the flush thread, so it must outlive the call.
  * @param ...: format string arguments. e.g. "world"
  */
-#define LOG(level, fmt, ...)                                           \
-  do {                                                                 \
-    if (vulcan::VulcanLogger::get_instance()->is_init()) {             \
-      vulcan::VulcanLogger::get_instance()->level(fmt, ##__VA_ARGS__); \
-    } else {                                                           \
-      spdlog::info(fmt, ##__VA_ARGS__);                                \
-    }                                                                  \
+#define LOG(level, fmt, ...)                                               \
+  do {                                                                     \
+    if constexpr (vulcan::log_level::level <= VULCAN_LOG_ACTIVE_LEVEL) {   \
+      vulcan::VulcanLogger *vulcan_logger_instance =                       \
+          vulcan::VulcanLogger::get_instance();                            \
+      if (!vulcan_logger_instance->is_init()) {                            \
+        spdlog::info("" fmt, ##__VA_ARGS__);                               \
+      } else if (vulcan_logger_instance->should_log(                       \
+                     vulcan::log_level::level)) {                          \
+        vulcan_logger_instance->level("" fmt, ##__VA_ARGS__);              \
+      }                                                                    \
+    }                                                                      \
   } while (0);
 
 #ifndef ASSERT
@@ -5,6 +5,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <stdexcept>
@@ -20,6 +21,24 @@ namespace vulcan {
  */
 inline uint32_t getCpuNum() { return std::thread::hardware_concurrency(); }
 
+/**
+ * Returns microseconds of the monotonic clock, for measuring durations.
+ */
+inline uint64_t monotonic_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * Returns milliseconds of the monotonic clock, used for deadlines.
+ */
+inline uint64_t monotonic_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 /**
  * @brief Replaces all occurrences of a substring in a string with a new
  * substring.
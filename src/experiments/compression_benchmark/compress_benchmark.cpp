@@ -7,6 +7,7 @@
 
 #include "common/vulcan_utility.h"
 #include "experiments/compression_benchmark/deflate_test_runner.h"
+#include "geometry_codec_test_runner.h"
 #include "ifccompressor_test_runner.h"
 #include "yaml-cpp/yaml.h"
 
@@ -14,6 +15,7 @@ void load_config(const std::string& config_file);
 void clear_directory(const std::filesystem::path& path);
 void run_deflate_test();
 void run_ifccompressor_test();
+void run_geometry_codec_test();
 
 // 配置文件路径
 std::string g_config_file =
@@ -39,6 +41,7 @@ int main(int argc, char** argv) {
 
   //   run_deflate_test();
   run_ifccompressor_test();
+  run_geometry_codec_test();
 
   std::cout << "All Test Runned Successfully! Weee!" << std::endl;
   return 0;
@@ -50,8 +53,12 @@ void run_deflate_test() {
     YAML::Node deflate_config = g_config["deflate_test_config"];
     YAML::Node compress_level_vector = deflate_config["compress_level"];
     YAML::Node chunk_size_vector = deflate_config["chunk_size"];
+    YAML::Node block_size_vector = deflate_config["block_size"];
+    YAML::Node thread_count_vector = deflate_config["threads"];
     std::vector<int> compress_levels;
     std::vector<int64_t> chunk_sizes;
+    std::vector<int64_t> block_sizes;
+    std::vector<unsigned> thread_counts;
 
     for (size_t i = 0; i < compress_level_vector.size(); ++i) {
       compress_levels.push_back(std::stoi(compress_level_vector[i].Scalar()));
@@ -61,10 +68,20 @@ void run_deflate_test() {
       chunk_sizes.push_back(std::stol(chunk_size_vector[i].Scalar()));
     }
 
+    for (size_t i = 0; i < block_size_vector.size(); ++i) {
+      block_sizes.push_back(std::stol(block_size_vector[i].Scalar()));
+    }
+
+    for (size_t i = 0; i < thread_count_vector.size(); ++i) {
+      thread_counts.push_back(std::stoul(thread_count_vector[i].Scalar()));
+    }
+
     compbench::DeflateTestRunner deflate_runner;
     deflate_runner.setup(g_working_dir, g_data_dir);
     deflate_runner.set_compress_levels(compress_levels);
     deflate_runner.set_chunk_sizes(chunk_sizes);
+    deflate_runner.set_block_sizes(block_sizes);
+    deflate_runner.set_thread_counts(thread_counts);
     deflate_runner.run();
     deflate_runner.teardown();
   } catch (const std::exception& e) {
@@ -95,6 +112,30 @@ void run_ifccompressor_test() {
   }
 }
 
+// 执行几何数据列式编码压缩测试
+void run_geometry_codec_test() {
+  try {
+    YAML::Node geometry_codec_config = g_config["geometry_codec_test_config"];
+    YAML::Node tolerance_node = geometry_codec_config["tolerance"];
+    std::vector<double> tolerance_vector;
+
+    for (size_t i = 0; i < tolerance_node.size(); ++i) {
+      tolerance_vector.push_back(std::stod(tolerance_node[i].Scalar()));
+    }
+
+    compbench::GeometryCodecTestRunner geometry_codec_runner;
+    if (!tolerance_vector.empty()) {
+      geometry_codec_runner.set_tolerance_vector(tolerance_vector);
+    }
+    geometry_codec_runner.setup(g_data_dir, g_working_dir);
+    geometry_codec_runner.run();
+    geometry_codec_runner.teardown();
+  } catch (const std::exception& e) {
+    std::cerr << "[GeometryCodec Test Failed] " << e.what() << std::endl;
+    exit(1);
+  }
+}
+
 void load_config(const std::string& config_file) {
   try {
     g_config = YAML::LoadFile(config_file);
@@ -108,6 +149,19 @@ void load_config(const std::string& config_file) {
     g_working_dir = global_config["result_dir"].Scalar();
     g_data_dir = global_config["source_dir"].Scalar();
 
+    // 重复次数、预热次数和并行文件数，未配置时每个文件只执行一次
+    compbench::BenchmarkOptions options;
+    if (global_config["warmup"].IsDefined()) {
+      options.warmup = global_config["warmup"].as<int>();
+    }
+    if (global_config["repetitions"].IsDefined()) {
+      options.repetitions = global_config["repetitions"].as<int>();
+    }
+    if (global_config["jobs"].IsDefined()) {
+      options.jobs = global_config["jobs"].as<unsigned>();
+    }
+    compbench::set_benchmark_options(options);
+
     if (!std::filesystem::exists(g_working_dir)) {
       std::filesystem::create_directory(g_working_dir);
     }
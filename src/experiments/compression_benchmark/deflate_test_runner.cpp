@@ -3,12 +3,17 @@
 #include "experiments/compression_benchmark/deflate_test_runner.h"
 
 #include <assert.h>
+#include <ctype.h>
+#include <string.h>
 
+#include <algorithm>
+#include <atomic>
 #include <exception>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
 
 namespace compbench {
 
@@ -18,8 +23,8 @@ void Deflate::compress(const std::string& input_filename,
   int ret, flush;
   unsigned have;
   z_stream strm;
-  unsigned char in[chunck_size];
-  unsigned char out[chunck_size];
+  std::vector<unsigned char> in(chunck_size);
+  std::vector<unsigned char> out(chunck_size);
   FILE* source = fopen(input_filename.c_str(), "r");
   FILE* dest = fopen(output_filename.c_str(), "w");
 
@@ -34,21 +39,21 @@ void Deflate::compress(const std::string& input_filename,
   }
 
   do {
-    strm.avail_in = fread(in, 1, chunck_size, source);
+    strm.avail_in = fread(in.data(), 1, chunck_size, source);
     if (ferror(source)) {
       (void)deflateEnd(&strm);
       std::cerr << "Error reading file" << std::endl;
       exit(1);
     }
     flush = feof(source) ? Z_FINISH : Z_NO_FLUSH;
-    strm.next_in = in;
+    strm.next_in = in.data();
     do {
       strm.avail_out = chunck_size;
-      strm.next_out = out;
+      strm.next_out = out.data();
       ret = deflate(&strm, flush);
       assert(ret != Z_STREAM_ERROR);
       have = chunck_size - strm.avail_out;
-      if (fwrite(out, 1, have, dest) != have || ferror(dest)) {
+      if (fwrite(out.data(), 1, have, dest) != have || ferror(dest)) {
         (void)deflateEnd(&strm);
         std::cerr << "Error writing file" << std::endl;
         exit(1);
@@ -63,6 +68,340 @@ void Deflate::compress(const std::string& input_filename,
   fclose(dest);
 }
 
+void Deflate::decompress(const std::string& input_filename,
+                         const std::string& output_filename) {
+  int ret;
+  unsigned have;
+  z_stream strm;
+  std::vector<unsigned char> in(CHUNCK_SIZE);
+  std::vector<unsigned char> out(CHUNCK_SIZE);
+  FILE* source = fopen(input_filename.c_str(), "r");
+  FILE* dest = fopen(output_filename.c_str(), "w");
+
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  strm.avail_in = 0;
+  strm.next_in = Z_NULL;
+  ret = inflateInit(&strm);
+  if (ret != Z_OK) {
+    std::cerr << "Error initializing zlib: (" << ret << ")" << std::endl;
+    exit(1);
+  }
+
+  do {
+    strm.avail_in = fread(in.data(), 1, CHUNCK_SIZE, source);
+    if (ferror(source)) {
+      (void)inflateEnd(&strm);
+      std::cerr << "Error reading file" << std::endl;
+      exit(1);
+    }
+    if (strm.avail_in == 0) {
+      break;
+    }
+    strm.next_in = in.data();
+    do {
+      strm.avail_out = CHUNCK_SIZE;
+      strm.next_out = out.data();
+      ret = inflate(&strm, Z_NO_FLUSH);
+      if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
+        (void)inflateEnd(&strm);
+        std::cerr << "Error decompressing file" << std::endl;
+        exit(1);
+      }
+      have = CHUNCK_SIZE - strm.avail_out;
+      if (fwrite(out.data(), 1, have, dest) != have || ferror(dest)) {
+        (void)inflateEnd(&strm);
+        std::cerr << "Error writing file" << std::endl;
+        exit(1);
+      }
+    } while (strm.avail_out == 0);
+  } while (ret != Z_STREAM_END);
+
+  (void)inflateEnd(&strm);
+  fclose(source);
+  fclose(dest);
+  if (ret != Z_STREAM_END) {
+    std::cerr << "Error decompressing file" << std::endl;
+    exit(1);
+  }
+}
+
+namespace {
+
+const char BLOCK_MAGIC[] = "VBD1";
+const char INDEX_MAGIC[] = "VBDX";
+const size_t MAGIC_SIZE = 4;
+const size_t INDEX_FIELDS = 6;
+const size_t FOOTER_SIZE = 2 * sizeof(uint64_t) + MAGIC_SIZE;
+
+// pos 处的语句结束后的位置：跳过字符串中的内容找到语句的分号，同一行的空白
+// 和行尾换行也归入该语句。pos 必须是语句的开头，否则字符串的边界会被颠倒。
+// 字符串中的 '' 是转义的单引号，按两次进出字符串处理结果相同。
+size_t statement_end(const std::string& s, size_t pos) {
+  bool in_string = false;
+  size_t i = pos;
+  for (; i < s.size(); i++) {
+    if (s[i] == '\'') {
+      in_string = !in_string;
+    } else if (s[i] == ';' && !in_string) {
+      break;
+    }
+  }
+  if (i == s.size()) {
+    return s.size();
+  }
+  for (i++; i < s.size(); i++) {
+    if (s[i] == '\n') {
+      return i + 1;
+    }
+    if (s[i] != ' ' && s[i] != '\t' && s[i] != '\r') {
+      break;
+    }
+  }
+  return i;
+}
+
+// 语句开头的实例名，例如 #12=
+bool instance_id(const std::string& s, size_t pos, size_t end, uint64_t& id) {
+  while (pos < end && isspace(static_cast<unsigned char>(s[pos]))) {
+    pos++;
+  }
+  if (pos >= end || s[pos] != '#') {
+    return false;
+  }
+  size_t digits = ++pos;
+  id = 0;
+  for (; pos < end && isdigit(static_cast<unsigned char>(s[pos])); pos++) {
+    id = id * 10 + (s[pos] - '0');
+  }
+  return pos > digits;
+}
+
+void put_uint64(std::string& out, uint64_t v) {
+  for (int i = 0; i < 8; i++) {
+    out.push_back(static_cast<char>(v >> (i * 8)));
+  }
+}
+
+uint64_t get_uint64(const char* p) {
+  uint64_t v = 0;
+  for (int i = 7; i >= 0; i--) {
+    v = (v << 8) | static_cast<unsigned char>(p[i]);
+  }
+  return v;
+}
+
+bool read_block(std::ifstream& file, const BlockDeflate::BlockIndex& block,
+                std::string& raw) {
+  std::string compressed(block.compressed_size, '\0');
+  file.seekg(block.compressed_offset);
+  if (!file.read(&compressed[0], compressed.size())) {
+    return false;
+  }
+  raw.assign(block.raw_size, '\0');
+  uLongf raw_size = block.raw_size;
+  return uncompress(reinterpret_cast<Bytef*>(&raw[0]), &raw_size,
+                    reinterpret_cast<const Bytef*>(compressed.data()),
+                    compressed.size()) == Z_OK &&
+         raw_size == block.raw_size;
+}
+
+}  // namespace
+
+void BlockDeflate::compress(const std::string& input_filename,
+                            const std::string& output_filename, int level,
+                            int64_t block_size, unsigned threads) {
+  std::ifstream source(input_filename, std::ios::binary);
+  if (!source || block_size <= 0) {
+    std::cerr << "Error reading file" << std::endl;
+    exit(1);
+  }
+  std::stringstream buffer;
+  buffer << source.rdbuf();
+  const std::string text = buffer.str();
+
+  std::vector<BlockIndex> index;
+  for (size_t start = 0; start < text.size();) {
+    BlockIndex block;
+    block.raw_offset = start;
+    // 从块头逐条语句向后推进，块边界总在语句之间，也不会落在字符串中
+    size_t end = start;
+    while (end < text.size() &&
+           end - start < static_cast<size_t>(block_size)) {
+      end = statement_end(text, end);
+    }
+    block.raw_size = end - start;
+    index.push_back(block);
+    start = end;
+  }
+
+  // 各线程按序领取块，块的压缩结果互相独立
+  std::vector<std::string> compressed(index.size());
+  std::atomic<size_t> next_block(0);
+  std::atomic<bool> failed(false);
+  auto worker = [&]() {
+    for (size_t i = next_block++; i < index.size(); i = next_block++) {
+      BlockIndex& block = index[i];
+      size_t end = block.raw_offset + block.raw_size;
+      for (size_t pos = block.raw_offset; pos < end;) {
+        size_t next = std::min(statement_end(text, pos), end);
+        uint64_t id;
+        if (instance_id(text, pos, next, id)) {
+          block.first_id = std::min(block.first_id, id);
+          block.last_id = std::max(block.last_id, id);
+        }
+        pos = next;
+      }
+      uLongf size = compressBound(block.raw_size);
+      compressed[i].resize(size);
+      if (compress2(reinterpret_cast<Bytef*>(&compressed[i][0]), &size,
+                    reinterpret_cast<const Bytef*>(text.data()) +
+                        block.raw_offset,
+                    block.raw_size, level) != Z_OK) {
+        failed = true;
+      }
+      compressed[i].resize(size);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (unsigned i = 1; i < std::max(threads, 1u); i++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& t : workers) {
+    t.join();
+  }
+  if (failed) {
+    std::cerr << "Error compressing file" << std::endl;
+    exit(1);
+  }
+
+  std::ofstream dest(output_filename, std::ios::binary);
+  dest.write(BLOCK_MAGIC, MAGIC_SIZE);
+  uint64_t offset = MAGIC_SIZE;
+  std::string footer;
+  for (size_t i = 0; i < index.size(); i++) {
+    dest.write(compressed[i].data(), compressed[i].size());
+    index[i].compressed_offset = offset;
+    index[i].compressed_size = compressed[i].size();
+    offset += compressed[i].size();
+    put_uint64(footer, index[i].raw_offset);
+    put_uint64(footer, index[i].raw_size);
+    put_uint64(footer, index[i].compressed_offset);
+    put_uint64(footer, index[i].compressed_size);
+    put_uint64(footer, index[i].first_id);
+    put_uint64(footer, index[i].last_id);
+  }
+  put_uint64(footer, offset);
+  put_uint64(footer, index.size());
+  footer.append(INDEX_MAGIC, MAGIC_SIZE);
+  dest.write(footer.data(), footer.size());
+  if (!dest) {
+    std::cerr << "Error writing file" << std::endl;
+    exit(1);
+  }
+}
+
+int BlockDeflate::read_index(std::ifstream& file,
+                             std::vector<BlockIndex>& index) {
+  char magic[MAGIC_SIZE];
+  char footer[FOOTER_SIZE];
+  file.seekg(0, std::ios::end);
+  uint64_t file_size = file.tellg();
+  file.seekg(0);
+  if (file_size < MAGIC_SIZE + FOOTER_SIZE || !file.read(magic, MAGIC_SIZE) ||
+      memcmp(magic, BLOCK_MAGIC, MAGIC_SIZE) != 0) {
+    return -1;
+  }
+  file.seekg(file_size - FOOTER_SIZE);
+  if (!file.read(footer, FOOTER_SIZE) ||
+      memcmp(footer + 2 * sizeof(uint64_t), INDEX_MAGIC, MAGIC_SIZE) != 0) {
+    return -1;
+  }
+  uint64_t index_offset = get_uint64(footer);
+  uint64_t count = get_uint64(footer + sizeof(uint64_t));
+  uint64_t entry_size = INDEX_FIELDS * sizeof(uint64_t);
+  if (index_offset < MAGIC_SIZE ||
+      index_offset > file_size - FOOTER_SIZE ||
+      (file_size - FOOTER_SIZE - index_offset) / entry_size != count ||
+      (file_size - FOOTER_SIZE - index_offset) % entry_size != 0) {
+    return -1;
+  }
+
+  std::string entries(count * entry_size, '\0');
+  file.seekg(index_offset);
+  if (!file.read(&entries[0], entries.size())) {
+    return -1;
+  }
+  index.resize(count);
+  for (uint64_t i = 0; i < count; i++) {
+    const char* p = entries.data() + i * entry_size;
+    BlockIndex& block = index[i];
+    block.raw_offset = get_uint64(p);
+    block.raw_size = get_uint64(p + 8);
+    block.compressed_offset = get_uint64(p + 16);
+    block.compressed_size = get_uint64(p + 24);
+    block.first_id = get_uint64(p + 32);
+    block.last_id = get_uint64(p + 40);
+    if (block.compressed_offset < MAGIC_SIZE ||
+        block.compressed_offset > index_offset ||
+        block.compressed_size > index_offset - block.compressed_offset) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void BlockDeflate::decompress(const std::string& input_filename,
+                              const std::string& output_filename) {
+  std::ifstream source(input_filename, std::ios::binary);
+  std::vector<BlockIndex> index;
+  if (!source || read_index(source, index) != 0) {
+    std::cerr << "Error reading file" << std::endl;
+    exit(1);
+  }
+  std::ofstream dest(output_filename, std::ios::binary);
+  std::string raw;
+  for (const BlockIndex& block : index) {
+    if (!read_block(source, block, raw)) {
+      std::cerr << "Error decompressing file" << std::endl;
+      exit(1);
+    }
+    dest.write(raw.data(), raw.size());
+  }
+}
+
+int BlockDeflate::read_instances(const std::string& filename,
+                                 uint64_t first_id, uint64_t last_id,
+                                 std::string& statements) {
+  std::ifstream source(filename, std::ios::binary);
+  std::vector<BlockIndex> index;
+  if (!source || read_index(source, index) != 0) {
+    return -1;
+  }
+  statements.clear();
+  std::string raw;
+  for (const BlockIndex& block : index) {
+    if (block.first_id > last_id || block.last_id < first_id) {
+      continue;
+    }
+    if (!read_block(source, block, raw)) {
+      return -1;
+    }
+    for (size_t pos = 0; pos < raw.size();) {
+      size_t next = statement_end(raw, pos);
+      uint64_t id;
+      if (instance_id(raw, pos, next, id) && id >= first_id &&
+          id <= last_id) {
+        statements.append(raw, pos, next - pos);
+      }
+      pos = next;
+    }
+  }
+  return 0;
+}
+
 void DeflateTestRunner::setup(std::string workding_dir, std::string data_dir) {
   std::filesystem::path working_dir_path(workding_dir);
   working_dir_path /= "deflate";
@@ -85,6 +424,41 @@ void DeflateTestRunner::run() {
       }
     }
   }
+
+  // 分块压缩按线程数输出总吞吐量，便于观察并行的加速比。只统计各文件压缩
+  // 阶段计时的中位数，不含预热、还原和校验
+  for (int level : compress_levels_) {
+    for (int64_t block_size : block_sizes_) {
+      double base_time = 0;
+      for (unsigned threads : thread_counts_) {
+        BlockDeflateConverter block_task(level, block_size, threads);
+        try {
+          std::filesystem::path result_dir =
+              working_dir_ / block_task.method_name();
+          std::vector<TestWatcher> results = traverseDir(
+              data_dir_, result_dir, ".ifc", ".ifcBZ", block_task);
+          double total_size = 0;
+          double compress_time = 0;
+          for (const TestWatcher& result : results) {
+            total_size += result.origin_size_;
+            compress_time += result.compress_time_;
+          }
+          if (compress_time <= 0) {
+            continue;
+          }
+          if (base_time == 0) {
+            base_time = compress_time;
+          }
+          std::cout << block_task.method_name() << ": "
+                    << total_size / compress_time / (1 << 20)
+                    << " MB/s, speedup " << base_time / compress_time
+                    << std::endl;
+        } catch (const std::exception& e) {
+          std::cerr << "[EXCEPTION] " << e.what() << std::endl;
+        }
+      }
+    }
+  }
 }
 
 void DeflateTestRunner::teardown() {}
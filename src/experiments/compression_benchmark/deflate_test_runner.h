@@ -36,6 +36,78 @@ class Deflate {
                          const std::string& output_filename);
 };
 
+/*
+ * 分块并行的Deflate压缩
+ *
+ * 输入在实例语句的边界处切分为互相独立的块，由多个线程分别压缩。文件格式为：
+ *   "VBD1" | 各块的zlib数据 | 块索引 | 索引偏移(8字节) | 块数(8字节) | "VBDX"
+ * 块索引中每块依次记录原始偏移、原始长度、压缩偏移、压缩长度以及块内实例名的
+ * 最小值和最大值，均为8字节小端整数。读取部分实例时只解压相关的块。
+ */
+class BlockDeflate {
+ public:
+  static const int64_t BLOCK_SIZE = 1 << 20;
+
+  struct BlockIndex {
+    uint64_t raw_offset = 0;
+    uint64_t raw_size = 0;
+    uint64_t compressed_offset = 0;
+    uint64_t compressed_size = 0;
+    // 块内没有实例时 first_id 大于 last_id
+    uint64_t first_id = UINT64_MAX;
+    uint64_t last_id = 0;
+  };
+
+  static void compress(const std::string& input_filename,
+                       const std::string& output_filename,
+                       int level = Z_DEFAULT_COMPRESSION,
+                       int64_t block_size = BLOCK_SIZE, unsigned threads = 1);
+
+  static void decompress(const std::string& input_filename,
+                         const std::string& output_filename);
+
+  /*
+   * 读取实例名在 [first_id, last_id] 内的实例语句，按文件中的顺序输出
+   *
+   * @return 0 成功，-1 文件损坏或无法读取
+   */
+  static int read_instances(const std::string& filename, uint64_t first_id,
+                            uint64_t last_id, std::string& statements);
+
+ private:
+  // 读取块索引
+  static int read_index(std::ifstream& file, std::vector<BlockIndex>& index);
+};
+
+class BlockDeflateConverter : public compbench::Converter {
+ public:
+  int level = Z_DEFAULT_COMPRESSION;
+  int64_t block_size = BlockDeflate::BLOCK_SIZE;
+  unsigned threads = 1;
+
+  BlockDeflateConverter(int level, int64_t block_size, unsigned threads)
+      : level(level), block_size(block_size), threads(threads) {}
+
+  void convert(const std::string& input_file,
+               const std::string& output_file) override {
+    BlockDeflate::compress(input_file, output_file, level, block_size,
+                           threads);
+  }
+
+  bool revert(const std::string& converted_file,
+              const std::string& output_file) override {
+    BlockDeflate::decompress(converted_file, output_file);
+    return true;
+  }
+
+  bool thread_safe() const override { return true; }
+
+  std::string method_name() const override {
+    return "BlockDeflate-level" + std::to_string(level) + "-blksize" +
+           std::to_string(block_size) + "-threads" + std::to_string(threads);
+  }
+};
+
 // 从输入文件流读入数据，通过zip压缩后写入输出流
 class ZipConverter : public compbench::Converter {
   friend class DeflateTestRunner;
@@ -52,6 +124,14 @@ class ZipConverter : public compbench::Converter {
     Deflate::compress(input_file, output_file, level, chunck_size);
   }
 
+  bool revert(const std::string& converted_file,
+              const std::string& output_file) override {
+    Deflate::decompress(converted_file, output_file);
+    return true;
+  }
+
+  bool thread_safe() const override { return true; }
+
   void operator()(const std::string& input_filename,
                   const std::string& output_filename) {
     convert(input_filename, output_filename);
@@ -90,11 +170,29 @@ class DeflateTestRunner : public TestRunnerInterface {
     chunk_sizes_ = chunk_sizes;
   }
 
+  // 设置分块压缩的块大小向量
+  void set_block_sizes(const std::vector<int64_t>& block_sizes) {
+    if (block_sizes.empty()) {
+      return;
+    }
+    block_sizes_ = block_sizes;
+  }
+
+  // 设置分块压缩的线程数向量
+  void set_thread_counts(const std::vector<unsigned>& thread_counts) {
+    if (thread_counts.empty()) {
+      return;
+    }
+    thread_counts_ = thread_counts;
+  }
+
  private:
   std::filesystem::path working_dir_;
   std::filesystem::path data_dir_;
   std::vector<int> compress_levels_ = {Z_DEFAULT_COMPRESSION};
   std::vector<int64_t> chunk_sizes_ = {16384};
+  std::vector<int64_t> block_sizes_ = {BlockDeflate::BLOCK_SIZE};
+  std::vector<unsigned> thread_counts_ = {1, 2, 4, 8};
 };
 
 }  // namespace compbench
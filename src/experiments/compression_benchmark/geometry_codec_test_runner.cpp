@@ -0,0 +1,42 @@
+// Copyright 2023 VulcanDB
+
+#include "geometry_codec_test_runner.h"
+
+namespace compbench {
+
+void GeometryCodecTestRunner::setup(std::string input_dir,
+                                    std::string output_dir) {
+  input_dir_ = input_dir;
+  output_dir_ = std::filesystem::path(output_dir) / "GeometryCodec";
+  if (!std::filesystem::exists(input_dir_)) {
+    std::cerr << "Input directory does not exist" << std::endl;
+    exit(1);
+  }
+
+  if (!std::filesystem::exists(output_dir_)) {
+    std::filesystem::create_directories(output_dir_);
+    std::cout << output_dir_ << " not found. Create it." << std::endl;
+  }
+}
+
+void GeometryCodecTestRunner::run() {
+  std::cout << "GeometryCodec Test is running..." << std::endl;
+
+  GeometryCodecConverter geometry_codec;
+  for (double tolerance : tolerance_vector_) {
+    geometry_codec.set_tolerance(tolerance);
+    std::filesystem::path output_dir =
+        std::filesystem::path(output_dir_) / geometry_codec.method_name();
+    if (!std::filesystem::exists(output_dir)) {
+      std::filesystem::create_directories(output_dir);
+      std::cout << output_dir << " not found. Create it." << std::endl;
+    }
+    traverseDir(input_dir_, output_dir, ".ifc", ".vgc", geometry_codec);
+  }
+}
+
+void GeometryCodecTestRunner::teardown() {
+  std::cout << "GeometryCodecTestRunner run successfully!" << std::endl;
+}
+
+}  // namespace compbench
@@ -0,0 +1,83 @@
+// Copyright 2023 VulcanDB
+
+#pragma once
+
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "experiments/test_runner_interface.h"
+#include "experiments/test_util.h"
+#include "storage/compression/geometry_codec.h"
+
+namespace compbench {
+
+class GeometryCodecConverter : public compbench::Converter {
+ private:
+  vulcan::GeometryCodec geometry_codec_;
+  vulcan::GeometryCodecArg geometry_codec_arg_;
+
+ public:
+  GeometryCodecConverter() = default;
+  ~GeometryCodecConverter() = default;
+
+  void convert(const std::string& input_file,
+               const std::string& output_file) override {
+    geometry_codec_.compress(input_file, output_file, &geometry_codec_arg_);
+  }
+
+  bool revert(const std::string& converted_file,
+              const std::string& output_file) override {
+    geometry_codec_.decompress(converted_file, output_file);
+    return true;
+  }
+
+  // 坐标经过量化，还原结果再次编码后应与编码结果相同
+  bool verify(const std::string& /*origin_file*/,
+              const std::string& converted_file,
+              const std::string& reverted_file) override {
+    std::string reencoded_file = reverted_file + ".vgc";
+    geometry_codec_.compress(reverted_file, reencoded_file,
+                             &geometry_codec_arg_);
+    bool same =
+        Converter::verify(converted_file, reencoded_file, reencoded_file);
+    std::filesystem::remove(reencoded_file);
+    return same;
+  }
+
+  bool thread_safe() const override { return true; }
+
+  std::string method_name() const override {
+    std::ostringstream name;
+    name << "GeometryCodec-" << geometry_codec_arg_.tolerance;
+    return name.str();
+  }
+
+  void set_tolerance(const double tolerance) {
+    geometry_codec_arg_.tolerance = tolerance;
+  }
+};
+
+class GeometryCodecTestRunner : public TestRunnerInterface {
+ private:
+  std::string input_dir_;
+  std::string output_dir_;
+  // 坐标量化步长向量
+  std::vector<double> tolerance_vector_ = {1e-3, 1e-4, 1e-5};
+
+ public:
+  GeometryCodecTestRunner() = default;
+  ~GeometryCodecTestRunner() = default;
+
+  void setup(std::string input_dir, std::string output_dir) override;
+  void run() override;
+  void teardown() override;
+
+  void set_tolerance_vector(const std::vector<double>& tolerance_vector) {
+    tolerance_vector_ = tolerance_vector;
+  }
+};
+
+}  // namespace compbench
@@ -0,0 +1,118 @@
+// Copyright 2023 VulcanDB
+//
+// 测量 IfcCharacterDecoder 解码字符串记号的耗时。先用词法分析器扫描整个
+// 模型，记录所有字符串记号的位置，扫描耗时中包含 skip() 跳过字符串的
+// 开销；再对记录下的位置重复调用 get() 解码。含转义序列、引号或非
+// ASCII 字符的字符串计入 escaped，它们仍由状态机解码。
+//
+// 用法：ifc-decoder-benchmark [-d 模型目录] [-n 重复次数]
+// 输出 csv：model,strings,escaped,string_bytes,lex_ms,decode_ns_per_string
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "experiments/test_util.h"
+#include "ifcparse/IfcCharacterDecoder.h"
+#include "ifcparse/IfcFile.h"
+#include "ifcparse/IfcParse.h"
+#include "ifcparse/IfcSpfStream.h"
+
+namespace {
+
+std::string g_data_dir = "resources/ifcModels";
+int g_iterations = 5;
+
+void run_model(const std::filesystem::path &path) {
+  // 由 IfcFile 打开文件并初始化词法分析依赖的数值 locale，之后只借用
+  // 它的文件流
+  IfcParse::IfcFile file(path.string());
+  if (!file.good()) {
+    std::cerr << "failed to open " << path << std::endl;
+    return;
+  }
+  IfcParse::IfcSpfStream &stream = *file.stream;
+
+  // 字符串记号开头引号之后的位置
+  std::vector<unsigned int> offsets;
+  size_t escaped = 0;
+  size_t string_bytes = 0;
+  double lex_seconds = std::numeric_limits<double>::max();
+  for (int i = 0; i < g_iterations; i++) {
+    offsets.clear();
+    stream.Seek(0);
+    IfcParse::IfcSpfLexer lexer(&stream, nullptr);
+    compbench::Timer timer;
+    while (!stream.eof) {
+      IfcParse::Token token = lexer.Next();
+      if (token.type == IfcParse::Token_STRING) {
+        offsets.push_back(token.startPos + 1);
+      }
+    }
+    lex_seconds = std::min(lex_seconds, timer.elapsed());
+  }
+
+  IfcParse::IfcCharacterDecoder decoder(&stream);
+  for (unsigned int offset : offsets) {
+    unsigned int end = offset;
+    std::string value = decoder.get(end);
+    string_bytes += end - offset;
+    // 解码结果带引号，与原文相同说明不需要转义处理
+    if (value.size() != end - offset + 1 ||
+        value.compare(1, value.size() - 2, stream.data_at(offset),
+                      value.size() - 2) != 0) {
+      escaped++;
+    }
+  }
+
+  double decode_seconds = std::numeric_limits<double>::max();
+  size_t checksum = 0;
+  for (int i = 0; i < g_iterations; i++) {
+    compbench::Timer timer;
+    for (unsigned int offset : offsets) {
+      unsigned int ptr = offset;
+      checksum += decoder.get(ptr).size();
+    }
+    decode_seconds = std::min(decode_seconds, timer.elapsed());
+  }
+  if (checksum == 0 && !offsets.empty()) {
+    std::cerr << "unexpected empty strings" << std::endl;
+  }
+
+  std::cout << path.filename().string() << "," << offsets.size() << ","
+            << escaped << "," << string_bytes << "," << lex_seconds * 1000
+            << ","
+            << (offsets.empty() ? 0 : decode_seconds * 1e9 / offsets.size())
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int para;
+  while ((para = getopt(argc, argv, "d:n:")) != -1) {
+    switch (para) {
+      case 'd':
+        g_data_dir = optarg;
+        break;
+      case 'n':
+        g_iterations = std::max(1, atoi(optarg));
+        break;
+    }
+  }
+
+  std::cout << "model,strings,escaped,string_bytes,lex_ms,"
+               "decode_ns_per_string"
+            << std::endl;
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator(g_data_dir)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".ifc") {
+      run_model(entry.path());
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,265 @@
+// Copyright 2023 VulcanDB
+//
+// 统计一次查询请求在 SEDA 流水线上触发的堆分配次数。替换全局 operator new
+// 计数，用真实的 SessionStage -> ParseStage -> ResolveStage -> ExecuteStage
+// 处理请求：主线程像 Server::recv 一样分配 SessionEvent 交给会话 stage，
+// 响应经 Server::send_response 写入 socketpair 的一端，主线程从另一端按
+// 消息终结符读取响应。先用 OPEN 打开模型，预热之后清零计数，再测量稳态下
+// 每个请求的分配次数。
+//
+// 用法：event-pool-benchmark [-d 数据目录] [-m 模型] [-q 查询]...
+//                            [-n 请求数] [-w 预热请求数] [-e]
+//       -q 可以重复，每个查询单独测量；-e 打开事件历史
+// 输出 csv：query,requests,operator_new_calls,per_request,pool_heap_blocks,
+//           us_per_request
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "backend/seda/execute_stage.h"
+#include "backend/seda/parse_stage.h"
+#include "backend/seda/resolve_stage.h"
+#include "backend/seda/session_event.h"
+#include "backend/seda/session_stage.h"
+#include "backend/seda/thread_pool.h"
+#include "backend/session.h"
+#include "backend/vulcan_param.h"
+#include "common/defs.h"
+#include "common/io/output_queue.h"
+#include "common/object_pool.h"
+#include "common/vulcan_logger.h"
+#include "experiments/test_util.h"
+
+namespace {
+
+std::atomic<uint64_t> g_new_calls{0};
+
+}  // namespace
+
+void *operator new(size_t size) {
+  g_new_calls.fetch_add(1, std::memory_order_relaxed);
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+namespace vulcan {
+
+extern bool &get_event_history_flag();
+extern uint32_t &get_max_event_hops();
+
+namespace {
+
+const int WINDOW = 64;  // 同时在途的请求数
+
+std::string g_data_dir = "resources/ifcModels";
+std::string g_model = "M5.ifc";
+std::vector<std::string> g_queries;
+uint64_t g_requests = 100000;
+uint64_t g_warmup = 10000;
+
+// 按 Server::accept 的方式初始化连接，响应写入 fd
+void init_client(ConnectionContext *client, Session *session, int fd) {
+  client->session = session;
+  client->fd = fd;
+  client->output = new OutputQueue();
+  pthread_mutex_init(&client->mutex, nullptr);
+  snprintf(client->addr, sizeof(client->addr), "bench");
+}
+
+// 与 Server::recv 相同：计入在途请求后把 SessionEvent 交给会话 stage
+void send_request(Stage *session, ConnectionContext *client,
+                  const std::string &request) {
+  client->inflight++;
+  session->add_event(new SessionEvent(client, request));
+}
+
+// 读取到一个或多个完整响应，返回其个数。last 保存最后一个完整响应
+int read_responses(int fd, std::string *pending, std::string *last) {
+  char buf[4096];
+  ssize_t len = ::read(fd, buf, sizeof(buf));
+  if (len <= 0) {
+    std::cerr << "Failed to read responses" << std::endl;
+    exit(1);
+  }
+
+  int count = 0;
+  for (ssize_t i = 0; i < len; i++) {
+    if (buf[i] == '\0') {
+      last->swap(*pending);
+      pending->clear();
+      count++;
+    } else {
+      pending->push_back(buf[i]);
+    }
+  }
+  return count;
+}
+
+// 保持 WINDOW 个请求在途，直到收到 count 个响应，返回最后一个响应
+std::string run_requests(Stage *session, ConnectionContext *client, int fd,
+                         const std::string &request, uint64_t count) {
+  std::string pending;
+  std::string last;
+  pending.reserve(4096);
+  last.reserve(4096);
+  uint64_t sent = 0;
+  uint64_t completed = 0;
+  while (completed < count) {
+    if (sent < count && sent - completed < WINDOW) {
+      send_request(session, client, request);
+      sent++;
+    } else {
+      completed += read_responses(fd, &pending, &last);
+    }
+  }
+  return last;
+}
+
+bool is_error(const std::string &response) {
+  return response.compare(0, 5, "ERROR") == 0;
+}
+
+}  // namespace
+}  // namespace vulcan
+
+int main(int argc, char *argv[]) {
+  int para;
+  while ((para = getopt(argc, argv, "d:m:q:n:w:e")) != -1) {
+    switch (para) {
+      case 'd':
+        vulcan::g_data_dir = optarg;
+        break;
+      case 'm':
+        vulcan::g_model = optarg;
+        break;
+      case 'q':
+        vulcan::g_queries.push_back(optarg);
+        break;
+      case 'n':
+        vulcan::g_requests = strtoull(optarg, nullptr, 10);
+        break;
+      case 'w':
+        vulcan::g_warmup = strtoull(optarg, nullptr, 10);
+        break;
+      case 'e':
+        vulcan::get_event_history_flag() = true;
+        // 与 seda.ini 中 MaxEventHistoryNum 的默认值一致
+        vulcan::get_max_event_hops() = 100;
+        break;
+    }
+  }
+  if (vulcan::g_queries.empty()) {
+    // 分别走按类型遍历实例和 morsel 并行列扫描两条执行路径
+    vulcan::g_queries = {"SELECT IfcWallStandardCase LIMIT 1",
+                         "SELECT COUNT(*) FROM IfcPropertySingleValue"};
+  }
+
+  // 每个请求都有 info 日志，只输出警告以上，避免日志主导分配次数
+  vulcan::VulcanLogger::get_instance()->init(
+      std::filesystem::temp_directory_path(), "event-pool-benchmark.log",
+      vulcan::WARN, vulcan::WARN);
+  vulcan::VulcanParam::get_instance()->set(VULCAN_DATA_DIR,
+                                           vulcan::g_data_dir);
+
+  // 阻塞的 socketpair，发送方写满时等待主线程读取，不会进入 reactor 路径
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    std::cerr << "Failed to create socketpair" << std::endl;
+    return 1;
+  }
+  vulcan::Session session;
+  // 值初始化将所有成员置零
+  vulcan::ConnectionContext client{};
+  vulcan::init_client(&client, &session, fds[0]);
+
+  vulcan::Stage *session_stage =
+      vulcan::SessionStage::make_stage("SessionStage");
+  vulcan::Stage *parse_stage = vulcan::ParseStage::make_stage("ParseStage");
+  vulcan::Stage *resolve_stage =
+      vulcan::ResolveStage::make_stage("ResolveStage");
+  vulcan::Stage *execute_stage =
+      vulcan::ExecuteStage::make_stage("ExecuteStage");
+  session_stage->push_stage(parse_stage);
+  parse_stage->push_stage(resolve_stage);
+  resolve_stage->push_stage(execute_stage);
+
+  vulcan::Threadpool *session_pool = new vulcan::Threadpool(1, "session");
+  vulcan::Threadpool *query_pool = new vulcan::Threadpool(2, "query");
+  session_stage->set_pool(session_pool);
+  parse_stage->set_pool(query_pool);
+  resolve_stage->set_pool(query_pool);
+  execute_stage->set_pool(query_pool);
+  // 下游先连接，initialize() 时 next_stage_list_ 中的 stage 已可接收事件
+  execute_stage->connect();
+  resolve_stage->connect();
+  parse_stage->connect();
+  session_stage->connect();
+
+  std::string response = vulcan::run_requests(
+      session_stage, &client, fds[1],
+      "OPEN '" + vulcan::g_model + "' AS bench", 1);
+  if (vulcan::is_error(response)) {
+    std::cerr << response;
+    return 1;
+  }
+
+  std::cout << "query,requests,operator_new_calls,per_request,"
+               "pool_heap_blocks,us_per_request"
+            << std::endl;
+  for (const std::string &query : vulcan::g_queries) {
+    response = vulcan::run_requests(session_stage, &client, fds[1], query,
+                                    vulcan::g_warmup);
+    if (vulcan::is_error(response)) {
+      std::cerr << query << ": " << response;
+      continue;
+    }
+
+    uint64_t heap_blocks = vulcan::ObjectPool::heap_blocks();
+    g_new_calls.store(0);
+    compbench::Timer timer;
+    vulcan::run_requests(session_stage, &client, fds[1], query,
+                         vulcan::g_requests);
+    double seconds = timer.elapsed();
+    uint64_t new_calls = g_new_calls.load();
+    heap_blocks = vulcan::ObjectPool::heap_blocks() - heap_blocks;
+
+    std::cout << "\"" << query << "\"," << vulcan::g_requests << ","
+              << new_calls << ","
+              << static_cast<double>(new_calls) / vulcan::g_requests << ","
+              << heap_blocks << "," << seconds * 1e6 / vulcan::g_requests
+              << std::endl;
+  }
+
+  session_stage->disconnect();
+  parse_stage->disconnect();
+  resolve_stage->disconnect();
+  execute_stage->disconnect();
+  delete session_stage;
+  delete parse_stage;
+  delete resolve_stage;
+  delete execute_stage;
+  delete query_pool;
+  delete session_pool;
+  delete client.output;
+  close(fds[0]);
+  close(fds[1]);
+  return 0;
+}
@@ -0,0 +1,168 @@
+// Copyright 2023 VulcanDB
+//
+// 测量编辑模型时维护反向引用索引的开销。随机选取模型中一定比例的实例
+// 引用属性重新赋值：单个引用赋为原值，引用列表赋为逆序后的列表，相当于
+// 编辑服务保存一个对象时整体写回其属性。分别测量逐条修改与 batch()/
+// unbatch() 批量修改的耗时，以及修改后对所有实例查询反向引用的耗时。
+//
+// 用法：ifc-inverse-benchmark [-d 模型目录] [-p 修改比例(%)] [-s 随机种子]
+// 输出 csv：model,instances,attributes,edits,direct_ms,batched_ms,inverse_ms
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "experiments/test_util.h"
+#include "ifcparse/IfcFile.h"
+#include "ifcparse/IfcWrite.h"
+
+namespace {
+
+std::string g_data_dir = "resources/ifcModels";
+double g_percent = 1;
+unsigned int g_seed = 42;
+
+// (实例名, 属性下标)
+typedef std::vector<std::pair<int, int>> AttributeList;
+
+// 解析全部实例并列出所有实体引用属性，之后的修改不再触发延迟解析
+AttributeList reference_attributes(IfcParse::IfcFile *file) {
+  AttributeList attributes;
+  for (const auto &pair : *file) {
+    IfcEntityInstanceData &data = pair.second->data();
+    for (size_t i = 0; i < data.getArgumentCount(); i++) {
+      IfcUtil::ArgumentType type = data.getArgument(i)->type();
+      if (type == IfcUtil::Argument_ENTITY_INSTANCE ||
+          type == IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE) {
+        attributes.emplace_back(pair.first, static_cast<int>(i));
+      }
+    }
+  }
+  std::sort(attributes.begin(), attributes.end());
+  return attributes;
+}
+
+// 构造新的属性值，不计入修改耗时
+std::vector<IfcWrite::IfcWriteArgument *> make_values(
+    IfcParse::IfcFile *file, const AttributeList &edits) {
+  std::vector<IfcWrite::IfcWriteArgument *> values;
+  for (const auto &edit : edits) {
+    Argument *arg =
+        file->instance_by_id(edit.first)->data().getArgument(edit.second);
+    IfcWrite::IfcWriteArgument *value = new IfcWrite::IfcWriteArgument();
+    if (arg->type() == IfcUtil::Argument_ENTITY_INSTANCE) {
+      IfcUtil::IfcBaseClass *instance = *arg;
+      value->set(static_cast<IfcUtil::IfcBaseInterface *>(instance));
+    } else {
+      aggregate_of_instance::ptr list = *arg;
+      aggregate_of_instance::ptr reversed(new aggregate_of_instance);
+      for (auto it = list->end(); it != list->begin();) {
+        reversed->push(*--it);
+      }
+      value->set(reversed);
+    }
+    values.push_back(value);
+  }
+  return values;
+}
+
+// 返回修改耗时(毫秒)
+double apply_edits(IfcParse::IfcFile *file, const AttributeList &edits,
+                   bool batched) {
+  std::vector<IfcWrite::IfcWriteArgument *> values = make_values(file, edits);
+  compbench::Timer timer;
+  if (batched) {
+    file->batch();
+  }
+  for (size_t i = 0; i < edits.size(); i++) {
+    file->instance_by_id(edits[i].first)
+        ->data()
+        .setArgument(edits[i].second, values[i]);
+  }
+  if (batched) {
+    file->unbatch();
+  }
+  return timer.elapsed() * 1000;
+}
+
+std::unique_ptr<IfcParse::IfcFile> open_model(
+    const std::filesystem::path &path) {
+  std::unique_ptr<IfcParse::IfcFile> file(
+      new IfcParse::IfcFile(path.string()));
+  if (!file->good()) {
+    std::cerr << "Failed to load " << path << std::endl;
+    return nullptr;
+  }
+  return file;
+}
+
+void run_model(const std::filesystem::path &path) {
+  std::unique_ptr<IfcParse::IfcFile> direct = open_model(path);
+  std::unique_ptr<IfcParse::IfcFile> batched = open_model(path);
+  if (direct == nullptr || batched == nullptr) {
+    return;
+  }
+
+  AttributeList attributes = reference_attributes(direct.get());
+  reference_attributes(batched.get());
+  AttributeList edits;
+  std::mt19937 rng(g_seed);
+  std::sample(attributes.begin(), attributes.end(), std::back_inserter(edits),
+              static_cast<size_t>(attributes.size() * g_percent / 100), rng);
+  std::shuffle(edits.begin(), edits.end(), rng);
+
+  double direct_ms = apply_edits(direct.get(), edits, false);
+  double batched_ms = apply_edits(batched.get(), edits, true);
+
+  compbench::Timer timer;
+  size_t inverses = 0;
+  for (const auto &pair : *batched) {
+    inverses += batched->getInverse(pair.first, nullptr, -1)->size();
+  }
+  double inverse_ms = timer.elapsed() * 1000;
+
+  size_t instances = std::distance(batched->begin(), batched->end());
+  std::cout << path.filename().string() << "," << instances << ","
+            << attributes.size() << "," << edits.size() << "," << direct_ms
+            << "," << batched_ms << "," << inverse_ms << std::endl;
+  if (inverses == 0) {
+    std::cerr << "No inverse references in " << path << std::endl;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int para;
+  while ((para = getopt(argc, argv, "d:p:s:")) != -1) {
+    switch (para) {
+      case 'd':
+        g_data_dir = optarg;
+        break;
+      case 'p':
+        g_percent = std::min(100.0, std::max(0.0, atof(optarg)));
+        break;
+      case 's':
+        g_seed = static_cast<unsigned int>(atoi(optarg));
+        break;
+    }
+  }
+
+  std::cout << "model,instances,attributes,edits,direct_ms,batched_ms,"
+               "inverse_ms"
+            << std::endl;
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator(g_data_dir)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".ifc") {
+      run_model(entry.path());
+    }
+  }
+  return 0;
+}
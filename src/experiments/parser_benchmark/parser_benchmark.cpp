@@ -0,0 +1,386 @@
+// Copyright 2023 VulcanDB
+//
+// ifcparse 的基准测试，作为解析器优化前后对比的基线。对模型目录下的每个
+// 模型以及按 -g 生成的合成模型，依次测量：
+//   lex            词法分析器逐个读取记号，items 为记号数
+//   token_values   对已读取的记号取值(字符串解码、数值、实体名)，items 为
+//                  记号数
+//   load_eager     关闭延迟解析加载 IfcFile，items 为实例数
+//   load_lazy      延迟解析加载 IfcFile，items 为实例数
+//   by_type_cold   对模型中出现的每个类型调用 instances_by_type，每次重复
+//                  前清空类型缓存，测量计算子类型并集和生成列表的耗时，
+//                  items 为返回的实例数
+//   by_type_warm   同上，但缓存已填满，测量命中缓存的耗时
+//   inverse        对每个实例调用 getInverse，items 为实例数
+//   traverse       从每个 IfcProduct 出发调用 traverse，items 为访问的实例数
+//   guid_lookup    按 GlobalId 查找全部 IfcRoot 实例，items 为查找次数
+//   serialize      用 operator<< 输出整个模型，items 为实例数
+// 查询类测试使用关闭延迟解析加载的模型。每项重复 -n 次，取耗时的中位数
+// 和最小值，吞吐量按中位数计算；lex、token_values、load 的字节数为模型
+// 文件大小，serialize 为输出大小，其余不计字节。allocs 和 alloc_bytes
+// 为最后一次重复中 operator new 的调用次数和申请的字节数。
+//
+// 用法：vulcan-parser-bench [-d 模型目录] [-n 重复次数] [-g 合成模型实例数]
+// 输出 csv：model,benchmark,iterations,median_ms,min_ms,mb_per_s,items,
+//           items_per_s,allocs,alloc_bytes
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "experiments/test_util.h"
+#include "ifcparse/IfcFile.h"
+#include "ifcparse/IfcGlobalId.h"
+#include "ifcparse/IfcParse.h"
+#include "ifcparse/IfcSpfStream.h"
+
+namespace {
+
+std::atomic<size_t> g_allocations(0);
+std::atomic<size_t> g_allocated_bytes(0);
+
+void *counted_alloc(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  return malloc(size == 0 ? 1 : size);
+}
+
+}  // namespace
+
+// 统计整个进程的 operator new 调用，对齐的版本很少使用，不做统计
+void *operator new(size_t size) {
+  void *p = counted_alloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](size_t size) {
+  void *p = counted_alloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return counted_alloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return counted_alloc(size);
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+void operator delete[](void *p, size_t) noexcept { operator delete[](p); }
+
+namespace {
+
+std::string g_data_dir = "resources/ifcModels";
+int g_iterations = 5;
+size_t g_synthetic_instances = 100000;
+
+// 执行 body 若干次并输出一行结果。body 返回处理的 items 数，reset 在每次
+// 重复前执行，不计入耗时和内存分配
+void measure(const std::string &model, const std::string &benchmark,
+             double bytes, const std::function<size_t()> &body,
+             const std::function<void()> &reset = nullptr) {
+  std::vector<double> seconds;
+  seconds.reserve(g_iterations);
+  size_t items = 0;
+  size_t allocations = 0;
+  size_t allocated_bytes = 0;
+  for (int i = 0; i < g_iterations; i++) {
+    if (reset) {
+      reset();
+    }
+    size_t allocations_before = g_allocations.load();
+    size_t bytes_before = g_allocated_bytes.load();
+    compbench::Timer timer;
+    items = body();
+    seconds.push_back(timer.elapsed());
+    allocations = g_allocations.load() - allocations_before;
+    allocated_bytes = g_allocated_bytes.load() - bytes_before;
+  }
+  if (reset) {
+    reset();
+  }
+
+  std::sort(seconds.begin(), seconds.end());
+  double median = seconds.size() % 2
+                      ? seconds[seconds.size() / 2]
+                      : (seconds[seconds.size() / 2 - 1] +
+                         seconds[seconds.size() / 2]) /
+                            2;
+  std::cout << model << "," << benchmark << "," << seconds.size() << ","
+            << median * 1000 << "," << seconds.front() * 1000 << ","
+            << bytes / median / (1 << 20) << "," << items << ","
+            << items / median << "," << allocations << "," << allocated_bytes
+            << std::endl;
+}
+
+std::unique_ptr<IfcParse::IfcFile> open_model(const std::string &path,
+                                              bool lazy) {
+  bool previous = IfcParse::IfcFile::lazy_load();
+  IfcParse::IfcFile::lazy_load(lazy);
+  std::unique_ptr<IfcParse::IfcFile> file(new IfcParse::IfcFile(path));
+  IfcParse::IfcFile::lazy_load(previous);
+  if (!file->good()) {
+    return nullptr;
+  }
+  return file;
+}
+
+void run_lexer(const std::string &model, const std::string &path,
+               double bytes) {
+  // 由 IfcFile 打开文件并初始化词法分析依赖的数值 locale，之后只借用
+  // 它的文件流
+  std::unique_ptr<IfcParse::IfcFile> file = open_model(path, true);
+  if (file == nullptr) {
+    return;
+  }
+  IfcParse::IfcSpfStream &stream = *file->stream;
+  IfcParse::IfcSpfLexer lexer(&stream, nullptr);
+
+  std::vector<IfcParse::Token> tokens;
+  measure(model, "lex", bytes, [&]() {
+    tokens.clear();
+    stream.Seek(0);
+    while (!stream.eof) {
+      tokens.push_back(lexer.Next());
+    }
+    return tokens.size();
+  });
+
+  size_t checksum = 0;
+  measure(model, "token_values", bytes, [&]() {
+    using IfcParse::TokenFunc;
+    for (const IfcParse::Token &token : tokens) {
+      switch (token.type) {
+        case IfcParse::Token_STRING:
+        case IfcParse::Token_ENUMERATION:
+        case IfcParse::Token_BINARY:
+          checksum += TokenFunc::asStringRef(token).size();
+          break;
+        case IfcParse::Token_KEYWORD:
+          checksum += TokenFunc::asKeywordView(token).size();
+          break;
+        case IfcParse::Token_INT:
+          checksum += TokenFunc::asInt(token);
+          break;
+        case IfcParse::Token_IDENTIFIER:
+          checksum += TokenFunc::asIdentifier(token);
+          break;
+        case IfcParse::Token_FLOAT:
+          checksum += TokenFunc::asFloat(token) != 0;
+          break;
+        default:
+          break;
+      }
+    }
+    return tokens.size();
+  });
+  if (checksum == 0 && !tokens.empty()) {
+    std::cerr << "Unexpected empty tokens in " << model << std::endl;
+  }
+}
+
+void run_queries(const std::string &model, IfcParse::IfcFile *file) {
+  size_t instances = std::distance(file->begin(), file->end());
+
+  std::vector<const IfcParse::declaration *> types(file->types_begin(),
+                                                   file->types_end());
+  auto by_type = [&]() {
+    size_t found = 0;
+    for (const IfcParse::declaration *type : types) {
+      found += file->instances_by_type(type)->size();
+    }
+    return found;
+  };
+  measure(model, "by_type_cold", 0, by_type,
+          [&]() { file->clear_type_cache(); });
+  measure(model, "by_type_warm", 0, by_type, [&]() { by_type(); });
+
+  size_t inverses = 0;
+  measure(model, "inverse", 0, [&]() {
+    for (const auto &pair : *file) {
+      inverses += file->getInverse(pair.first, nullptr, -1)->size();
+    }
+    return instances;
+  });
+  if (inverses == 0) {
+    std::cerr << "No inverse references in " << model << std::endl;
+  }
+
+  aggregate_of_instance::ptr products;
+  try {
+    products = file->instances_by_type("IfcProduct");
+  } catch (const IfcParse::IfcException &) {
+    products.reset(new aggregate_of_instance);
+  }
+  measure(model, "traverse", 0, [&]() {
+    size_t visited = 0;
+    for (IfcUtil::IfcBaseClass *product : *products) {
+      visited += file->traverse(product)->size();
+    }
+    return visited;
+  });
+
+  std::vector<std::string> guids;
+  aggregate_of_instance::ptr roots = file->instances_by_type("IfcRoot");
+  for (IfcUtil::IfcBaseClass *root : *roots) {
+    std::string guid = *root->data().getArgument(0);
+    guids.push_back(guid);
+  }
+  measure(model, "guid_lookup", 0, [&]() {
+    size_t found = 0;
+    for (const std::string &guid : guids) {
+      found += file->instance_by_guid(guid) != nullptr;
+    }
+    return found;
+  });
+
+  std::ostringstream output;
+  output << *file;
+  measure(model, "serialize", output.str().size(), [&]() {
+    std::ostringstream stream;
+    stream << *file;
+    return instances;
+  });
+}
+
+void run_model(const std::string &model, const std::string &path) {
+  // 先完整加载一次，schema 不支持或文件损坏的模型不参与测试
+  std::unique_ptr<IfcParse::IfcFile> file = open_model(path, false);
+  if (file == nullptr) {
+    std::cerr << "Failed to load " << path << std::endl;
+    return;
+  }
+  file.reset();
+
+  double bytes = std::filesystem::file_size(path);
+  run_lexer(model, path, bytes);
+  auto release = [&]() { file.reset(); };
+  for (bool lazy : {false, true}) {
+    measure(
+        model, lazy ? "load_lazy" : "load_eager", bytes,
+        [&]() {
+          file = open_model(path, lazy);
+          return file == nullptr ? 0
+                                 : std::distance(file->begin(), file->end());
+        },
+        release);
+  }
+
+  file = open_model(path, false);
+  run_queries(model, file.get());
+}
+
+std::string synthetic_guid(size_t n) {
+  IfcParse::IfcGuid guid = {};
+  for (int i = 0; i < 8; i++) {
+    guid.bytes[15 - i] = static_cast<unsigned char>(n >> (i * 8));
+  }
+  return IfcParse::IfcGlobalId::encode(guid);
+}
+
+// 生成约 instances 个实例的 IFC2X3 模型：每个构件由定位、四个点的折线、
+// 一个属性及其属性集和关联关系组成，共 13 个实例
+std::string write_synthetic_model(size_t instances) {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() /
+      ("vulcan-parser-bench-" + std::to_string(instances) + ".ifc");
+  std::ofstream out(path);
+  out << "ISO-10303-21;\nHEADER;\n"
+         "FILE_DESCRIPTION(('ViewDefinition [CoordinationView]'),'2;1');\n"
+         "FILE_NAME('synthetic.ifc','2023-01-01T00:00:00',(''),(''),'',"
+         "'vulcan-parser-bench','');\n"
+         "FILE_SCHEMA(('IFC2X3'));\nENDSEC;\nDATA;\n";
+  out << "#1=IFCDIRECTION((0.,0.,1.));\n";
+  size_t id = 2;
+  size_t guid = 1;
+  for (size_t element = 0; id + 13 <= instances + 2; element++) {
+    size_t base = id;
+    double x = static_cast<double>(element % 1000) * 1.5;
+    double y = static_cast<double>(element / 1000) * 2.25;
+    out << "#" << base << "=IFCCARTESIANPOINT((" << x << "," << y
+        << ",0.));\n";
+    out << "#" << base + 1 << "=IFCAXIS2PLACEMENT3D(#" << base << ",#1,$);\n";
+    out << "#" << base + 2 << "=IFCLOCALPLACEMENT($,#" << base + 1 << ");\n";
+    for (int corner = 0; corner < 4; corner++) {
+      out << "#" << base + 3 + corner << "=IFCCARTESIANPOINT(("
+          << (corner % 2) * 0.75 << "," << (corner / 2) * 0.5 << ",3.));\n";
+    }
+    out << "#" << base + 7 << "=IFCPOLYLINE((#" << base + 3 << ",#"
+        << base + 4 << ",#" << base + 6 << ",#" << base + 5 << ",#"
+        << base + 3 << "));\n";
+    out << "#" << base + 8 << "=IFCBUILDINGELEMENTPROXY('"
+        << synthetic_guid(guid++) << "',$,'Element " << element
+        << "','Synthetic element',$,#" << base + 2 << ",$,'E-" << element
+        << "',$);\n";
+    out << "#" << base + 9
+        << "=IFCPROPERTYSINGLEVALUE('Width',$,IFCLENGTHMEASURE("
+        << 0.5 + (element % 7) * 0.25 << "),$);\n";
+    out << "#" << base + 10 << "=IFCPROPERTYSINGLEVALUE('Label',$,IFCLABEL('"
+        << "Label \\X2\\00E9\\X0\\ " << element << "'),$);\n";
+    out << "#" << base + 11 << "=IFCPROPERTYSET('" << synthetic_guid(guid++)
+        << "',$,'Pset_Synthetic',$,(#" << base + 9 << ",#" << base + 10
+        << "));\n";
+    out << "#" << base + 12 << "=IFCRELDEFINESBYPROPERTIES('"
+        << synthetic_guid(guid++) << "',$,$,$,(#" << base + 8 << "),#"
+        << base + 11 << ");\n";
+    id += 13;
+  }
+  out << "ENDSEC;\nEND-ISO-10303-21;\n";
+  return path.string();
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int para;
+  while ((para = getopt(argc, argv, "d:n:g:")) != -1) {
+    switch (para) {
+      case 'd':
+        g_data_dir = optarg;
+        break;
+      case 'n':
+        g_iterations = std::max(1, atoi(optarg));
+        break;
+      case 'g':
+        g_synthetic_instances = strtoul(optarg, nullptr, 10);
+        break;
+    }
+  }
+
+  std::cout << "model,benchmark,iterations,median_ms,min_ms,mb_per_s,items,"
+               "items_per_s,allocs,alloc_bytes"
+            << std::endl;
+  if (std::filesystem::exists(g_data_dir)) {
+    for (const auto &entry :
+         std::filesystem::recursive_directory_iterator(g_data_dir)) {
+      if (entry.is_regular_file() && entry.path().extension() == ".ifc") {
+        run_model(entry.path().filename().string(), entry.path().string());
+      }
+    }
+  }
+  if (g_synthetic_instances > 0) {
+    std::string path = write_synthetic_model(g_synthetic_instances);
+    run_model("synthetic-" + std::to_string(g_synthetic_instances), path);
+    std::filesystem::remove(path);
+  }
+  return 0;
+}
@@ -0,0 +1,222 @@
+// Copyright 2023 VulcanDB
+//
+// 对比逐行执行与向量化执行列查询的耗时。逐行执行通过 Argument 的虚函数
+// 转换逐个实例地判断谓词和累加，是向量化引擎之前的执行方式。
+//
+// 用法：ifc-query-benchmark [-d 模型目录] [-n 重复次数] [-t 线程数]
+// 输出 csv：model,query,rows,row_ms,vector_ms,parallel_ms,result
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "backend/db.h"
+#include "backend/query/column_scan.h"
+#include "backend/query/predicate.h"
+#include "backend/query/query_parser.h"
+#include "backend/query/query_plan.h"
+#include "experiments/test_util.h"
+#include "ifcparse/IfcFile.h"
+
+namespace {
+
+// 仿照 TPC-H 的扫描、过滤、聚合和投影查询，模型中没有的类型会被跳过
+const char *g_queries[][2] = {
+    {"Q1", "SELECT COUNT(*), SUM(VolumeValue), AVG(VolumeValue), "
+           "MIN(VolumeValue), MAX(VolumeValue) FROM IfcQuantityVolume"},
+    {"Q2", "SELECT COUNT(*), SUM(AreaValue) FROM IfcQuantityArea "
+           "WHERE Name = 'NetSideArea'"},
+    {"Q3", "SELECT COUNT(*), AVG(LengthValue) FROM IfcQuantityLength "
+           "WHERE LengthValue >= 1000 AND LengthValue < 5000"},
+    {"Q4", "SELECT COUNT(*), COUNT(Description), COUNT(Unit) "
+           "FROM IfcPropertySingleValue"},
+    {"Q5", "SELECT COUNT(*), COUNT(Name) FROM IfcProduct WHERE Name != NULL"},
+    {"Q6", "SELECT Name, Tag FROM IfcWallStandardCase LIMIT 100"},
+};
+
+std::string g_data_dir = "resources/ifcModels";
+int g_iterations = 3;
+unsigned int g_threads = std::thread::hardware_concurrency();
+
+// 逐行执行，返回选中的行数
+int64_t run_row_at_a_time(const vulcan::QueryPlan &plan,
+                          IfcParse::IfcFile *file) {
+  aggregate_of_instance::ptr instances = file->instances_by_type(plan.type);
+  if (!instances) {
+    return 0;
+  }
+
+  int64_t selected = 0;
+  std::vector<double> sums(plan.columns.size(), 0);
+  std::vector<double> mins(plan.columns.size(),
+                           std::numeric_limits<double>::max());
+  std::vector<std::string> row;
+  for (IfcUtil::IfcBaseClass *instance : *instances) {
+    bool match = true;
+    for (const vulcan::ResolvedPredicate &predicate : plan.predicates) {
+      const Argument *arg =
+          instance->data().getArgument(predicate.attribute_index);
+      if (!vulcan::eval_predicate(arg, predicate.op, predicate.value)) {
+        match = false;
+        break;
+      }
+    }
+    if (!match) {
+      continue;
+    }
+    selected++;
+
+    row.clear();
+    for (size_t i = 0; i < plan.columns.size(); i++) {
+      const vulcan::PlanColumn &column = plan.columns[i];
+      if (column.attribute_index < 0) {
+        continue;
+      }
+      const Argument *arg =
+          instance->data().getArgument(column.attribute_index);
+      if (!plan.aggregate) {
+        row.push_back(arg->toString());
+      } else if (!arg->isNull() &&
+                 (arg->type() == IfcUtil::Argument_DOUBLE ||
+                  arg->type() == IfcUtil::Argument_INT)) {
+        double value = arg->type() == IfcUtil::Argument_DOUBLE
+                           ? static_cast<double>(*arg)
+                           : static_cast<int>(*arg);
+        sums[i] += value;
+        mins[i] = std::min(mins[i], value);
+      }
+    }
+    if (!plan.aggregate && plan.limit >= 0 && selected >= plan.limit) {
+      break;
+    }
+  }
+  return selected;
+}
+
+std::string run_vectorized(const vulcan::QueryPlan &plan, vulcan::Db *db,
+                           unsigned int threads) {
+  vulcan::ColumnScan scan(plan, db, std::numeric_limits<int64_t>::max());
+  if (scan.init() != 0) {
+    return scan.error();
+  }
+
+  // 与 ExecuteStage 一样，各线程领取 morsel 执行
+  std::atomic<size_t> next(0);
+  auto worker = [&scan, &next]() {
+    size_t morsel;
+    while ((morsel = next.fetch_add(1)) < scan.morsel_count()) {
+      scan.run_morsel(morsel);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (unsigned int i = 1; i < threads; i++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (std::thread &t : workers) {
+    t.join();
+  }
+
+  std::string result;
+  if (scan.finish(&result) != 0) {
+    return scan.error();
+  }
+  return result;
+}
+
+// 取聚合结果所在的第二行，投影查询取最后的行数统计
+std::string summary(const std::string &result) {
+  size_t begin = result.find('\n');
+  if (begin == std::string::npos) {
+    return result;
+  }
+  size_t end = result.find('\n', begin + 1);
+  std::string line = result.substr(begin + 1, end - begin - 1);
+  if (line.empty() || line[0] == '#') {
+    size_t last = result.rfind('(');
+    line = result.substr(last, result.size() - last - 1);
+  }
+  return line;
+}
+
+void run_model(const std::filesystem::path &path) {
+  vulcan::Db db;
+  try {
+    db.init(path.stem().c_str(), path.c_str());
+  } catch (const std::exception &e) {
+    std::cerr << "Failed to load " << path << ": " << e.what() << std::endl;
+    return;
+  }
+
+  for (const auto &query : g_queries) {
+    vulcan::Query parsed;
+    vulcan::QueryParser parser;
+    vulcan::QueryPlan plan;
+    vulcan::QueryResolver resolver;
+    if (parser.parse(query[1], &parsed) != 0 ||
+        resolver.resolve(parsed, db.model()->schema(), &plan) != 0) {
+      continue;
+    }
+
+    // 第一次执行会触发 IfcFile 的延迟解析，不计入结果
+    run_row_at_a_time(plan, db.model());
+    compbench::Timer timer;
+    int64_t rows = 0;
+    for (int i = 0; i < g_iterations; i++) {
+      rows = run_row_at_a_time(plan, db.model());
+    }
+    double row_ms = timer.elapsed() * 1000 / g_iterations;
+
+    std::string result;
+    timer.reset();
+    for (int i = 0; i < g_iterations; i++) {
+      result = run_vectorized(plan, &db, 1);
+    }
+    double vector_ms = timer.elapsed() * 1000 / g_iterations;
+
+    timer.reset();
+    for (int i = 0; i < g_iterations; i++) {
+      run_vectorized(plan, &db, g_threads);
+    }
+    double parallel_ms = timer.elapsed() * 1000 / g_iterations;
+
+    std::cout << path.filename().string() << "," << query[0] << "," << rows
+              << "," << row_ms << "," << vector_ms << "," << parallel_ms
+              << ",\"" << summary(result) << "\"" << std::endl;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int para;
+  while ((para = getopt(argc, argv, "d:n:t:")) != -1) {
+    switch (para) {
+      case 'd':
+        g_data_dir = optarg;
+        break;
+      case 'n':
+        g_iterations = std::max(1, atoi(optarg));
+        break;
+      case 't':
+        g_threads = std::max(1, atoi(optarg));
+        break;
+    }
+  }
+
+  std::cout << "model,query,rows,row_ms,vector_ms,parallel_ms,result"
+            << std::endl;
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator(g_data_dir)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".ifc") {
+      run_model(entry.path());
+    }
+  }
+  return 0;
+}
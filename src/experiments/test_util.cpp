@@ -1,14 +1,168 @@
 // Copyright 2023 VulcanDB
 #include "test_util.h"
 
+#include <stdio.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
 #include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <utility>
 
 namespace compbench {
 
+namespace {
+
+BenchmarkOptions g_options;
+
+double median(std::vector<double> samples) {
+  if (samples.empty()) {
+    return -1;
+  }
+  std::sort(samples.begin(), samples.end());
+  size_t mid = samples.size() / 2;
+  return samples.size() % 2 ? samples[mid]
+                            : (samples[mid - 1] + samples[mid]) / 2;
+}
+
+double stddev(const std::vector<double>& samples) {
+  if (samples.size() < 2) {
+    return samples.empty() ? -1 : 0;
+  }
+  double mean = 0;
+  for (double v : samples) {
+    mean += v;
+  }
+  mean /= samples.size();
+  double sum = 0;
+  for (double v : samples) {
+    sum += (v - mean) * (v - mean);
+  }
+  return std::sqrt(sum / (samples.size() - 1));
+}
+
+// 重置进程的峰值内存，内核不支持时峰值从进程启动开始计算
+void reset_peak_memory() {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+}
+
+// 进程的峰值内存(字节)，优先读取可以重置的 VmHWM
+double peak_memory() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return std::stod(line.substr(6)) * 1024;
+    }
+  }
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_maxrss) * 1024;
+}
+
+std::string json_string(const std::string& s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buffer[8];
+      snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+      out += buffer;
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+// 对一个文件执行预热和计时，结果写入test_watcher。多个文件并行时进程的峰值
+// 内存不属于任何一个文件，measure_memory为false，不记录内存
+void run_file(Converter& converter, const std::string& input_filename,
+              const std::string& output_filename, TestWatcher& test_watcher,
+              bool measure_memory) {
+  const BenchmarkOptions& options = g_options;
+  std::string reverted_filename = output_filename + ".reverted";
+  test_watcher.set_experiment_name(output_filename);
+  test_watcher.set_origin_size(std::filesystem::file_size(input_filename));
+
+  for (int i = 0; i < options.warmup; i++) {
+    converter.convert(input_filename, output_filename);
+    converter.revert(output_filename, reverted_filename);
+  }
+
+  if (measure_memory) {
+    reset_peak_memory();
+  }
+  bool revertible = true;
+  Timer timer;
+  for (int i = 0; i < std::max(options.repetitions, 1); i++) {
+    timer.reset();
+    converter.convert(input_filename, output_filename);
+    test_watcher.add_compress_sample(timer.elapsed());
+    if (revertible) {
+      timer.reset();
+      revertible = converter.revert(output_filename, reverted_filename);
+      if (revertible) {
+        test_watcher.add_decompress_sample(timer.elapsed());
+      }
+    }
+  }
+  if (measure_memory) {
+    test_watcher.set_memory_usage(peak_memory());
+  }
+  test_watcher.set_compress_size(std::filesystem::file_size(output_filename));
+
+  if (revertible) {
+    test_watcher.set_round_trip(converter.verify(
+        input_filename, output_filename, reverted_filename));
+    std::filesystem::remove(reverted_filename);
+  }
+}
+
+}  // namespace
+
+void set_benchmark_options(const BenchmarkOptions& options) {
+  g_options = options;
+}
+
+const BenchmarkOptions& benchmark_options() { return g_options; }
+
+bool Converter::verify(const std::string& origin_file,
+                       const std::string& /*converted_file*/,
+                       const std::string& reverted_file) {
+  std::ifstream origin(origin_file, std::ios::binary);
+  std::ifstream reverted(reverted_file, std::ios::binary);
+  std::istreambuf_iterator<char> end;
+  return origin && reverted &&
+         std::equal(std::istreambuf_iterator<char>(origin), end,
+                    std::istreambuf_iterator<char>(reverted), end);
+}
+
+void TestWatcher::add_compress_sample(double seconds) {
+  compress_samples_.push_back(seconds);
+  compress_time_ = median(compress_samples_);
+  compress_time_stddev_ = stddev(compress_samples_);
+}
+
+void TestWatcher::add_decompress_sample(double seconds) {
+  decompress_samples_.push_back(seconds);
+  decompress_time_ = median(decompress_samples_);
+  decompress_time_stddev_ = stddev(decompress_samples_);
+}
+
 std::string TestWatcher::get_header() const {
   std::string header =
       "experiment_name,origin_size,compress_size,compress_ratio,compress_"
-      "time,compress_speed,memory_usage";
+      "time,compress_speed,memory_usage,compress_time_stddev,decompress_"
+      "time,decompress_time_stddev,decompress_speed,round_trip,repetitions";
   return header;
 }
 
@@ -26,6 +180,13 @@ double TestWatcher::compress_speed() const {
   return origin_size_ / compress_time_;
 }
 
+double TestWatcher::decompress_speed() const {
+  if (decompress_time_ == INVALID_VALUE || origin_size_ == INVALID_VALUE) {
+    return INVALID_VALUE;
+  }
+  return origin_size_ / decompress_time_;
+}
+
 std::string TestWatcher::get_result() const {
   std::string result = experiment_name_ + ",";
   result += std::to_string(origin_size_) + " ,";
@@ -34,14 +195,47 @@ std::string TestWatcher::get_result() const {
   result += std::to_string(compress_time_) + " ,";
   result += std::to_string(compress_speed()) + " ,";
   result += std::to_string(memory_usage_) + " ,";
+  result += std::to_string(compress_time_stddev_) + " ,";
+  result += std::to_string(decompress_time_) + " ,";
+  result += std::to_string(decompress_time_stddev_) + " ,";
+  result += std::to_string(decompress_speed()) + " ,";
+  result += std::to_string(round_trip_) + " ,";
+  result += std::to_string(compress_samples_.size()) + " ,";
   return result;
 }
 
+std::string TestWatcher::get_json() const {
+  std::ostringstream json;
+  json.precision(9);
+  json << "{\"experiment_name\":" << json_string(experiment_name_)
+       << ",\"origin_size\":" << origin_size_
+       << ",\"compress_size\":" << compress_size_
+       << ",\"compress_ratio\":" << compress_ratio()
+       << ",\"compress_time\":" << compress_time_
+       << ",\"compress_time_stddev\":" << compress_time_stddev_
+       << ",\"compress_speed\":" << compress_speed()
+       << ",\"decompress_time\":" << decompress_time_
+       << ",\"decompress_time_stddev\":" << decompress_time_stddev_
+       << ",\"decompress_speed\":" << decompress_speed()
+       << ",\"round_trip\":" << round_trip_
+       << ",\"memory_usage\":" << memory_usage_ << ",\"compress_samples\":[";
+  for (size_t i = 0; i < compress_samples_.size(); i++) {
+    json << (i ? "," : "") << compress_samples_[i];
+  }
+  json << "],\"decompress_samples\":[";
+  for (size_t i = 0; i < decompress_samples_.size(); i++) {
+    json << (i ? "," : "") << decompress_samples_[i];
+  }
+  json << "]}";
+  return json.str();
+}
+
 // 遍历目录，对目录下的所有文件执行转换
-void traverseDir(const std::filesystem::path& root_dir,
-                 const std::filesystem::path& output_dir,
-                 std::string origin_postfix, std::string target_postfix,
-                 Converter& converter) {
+std::vector<TestWatcher> traverseDir(const std::filesystem::path& root_dir,
+                                     const std::filesystem::path& output_dir,
+                                     std::string origin_postfix,
+                                     std::string target_postfix,
+                                     Converter& converter) {
   if (!std::filesystem::exists(root_dir)) {
     std::cerr << "Root directory does not exist" << std::endl;
     exit(1);
@@ -49,11 +243,15 @@ void traverseDir(const std::filesystem::path& root_dir,
 
   // 初始化结果输出文件
   try {
+    std::filesystem::create_directories(output_dir);
     compbench::TestWatcher test_watcher;
     std::ofstream profile_file(output_dir.parent_path() / "profile.csv",
                                std::ios::app);
+    std::ofstream json_file(output_dir.parent_path() / "profile.jsonl",
+                            std::ios::app);
     profile_file << test_watcher.get_header() << std::endl;
 
+    std::vector<std::pair<std::string, std::string>> tasks;
     for (const auto& entry :
          std::filesystem::recursive_directory_iterator(root_dir)) {
       std::string relative_path =
@@ -81,17 +279,61 @@ void traverseDir(const std::filesystem::path& root_dir,
         output_filename.replace(replace_pos, origin_postfix.length(),
                                 target_postfix);
       }
+      std::filesystem::create_directories(
+          std::filesystem::path(output_filename).parent_path());
+      tasks.emplace_back(input_filename, output_filename);
+    }
 
-      // 执行测试
-      test_watcher.set_experiment_name(output_filename);
-      test_watcher.start();
-      converter.convert(input_filename, output_filename);
-      test_watcher.end();
-      test_watcher.set_origin_size(std::filesystem::file_size(input_filename));
-      test_watcher.set_compress_size(
-          std::filesystem::file_size(output_filename));
-      profile_file << test_watcher.get_result() << std::endl;
+    // 执行测试，并行时结果仍按遍历顺序输出
+    std::vector<TestWatcher> results(tasks.size());
+    std::atomic<size_t> next_task(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    unsigned jobs = converter.thread_safe() ? std::max(g_options.jobs, 1u) : 1;
+    jobs = std::max<size_t>(std::min<size_t>(jobs, tasks.size()), 1);
+    auto worker = [&]() {
+      for (size_t i = next_task++; i < tasks.size(); i = next_task++) {
+        try {
+          run_file(converter, tasks[i].first, tasks[i].second, results[i],
+                   jobs == 1);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          error = std::current_exception();
+          next_task = tasks.size();
+        }
+      }
+    };
+    if (jobs > 1) {
+      reset_peak_memory();
+    }
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < jobs; i++) {
+      workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : workers) {
+      t.join();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+
+    for (const TestWatcher& result : results) {
+      profile_file << result.get_result() << std::endl;
+      json_file << result.get_json() << std::endl;
+    }
+    if (jobs > 1) {
+      // 并行时只有整个进程的峰值，单独记录一行，不计入任何文件
+      double process_peak = peak_memory();
+      json_file << "{\"experiment_name\":" << json_string(output_dir.string())
+                << ",\"jobs\":" << jobs
+                << ",\"process_peak_memory\":" << process_peak << "}"
+                << std::endl;
+      std::cout << output_dir.string() << ": process peak memory "
+                << process_peak << " bytes with " << jobs << " jobs"
+                << std::endl;
     }
+    return results;
   } catch (const std::exception& e) {
     std::cerr << e.what() << std::endl;
     exit(1);
@@ -31,10 +31,10 @@ class Timer {
 
 // 测试结果的包装类
 class TestWatcher {
-  friend void traverseDir(const std::filesystem::path& root_dir,
-                          const std::filesystem::path& output_dir,
-                          std::string origin_postfix,
-                          std::string target_postfix, Converter& converter);
+  friend std::vector<TestWatcher> traverseDir(
+      const std::filesystem::path& root_dir,
+      const std::filesystem::path& output_dir, std::string origin_postfix,
+      std::string target_postfix, Converter& converter);
 
  public:
   const double INVALID_VALUE = -1;
@@ -44,12 +44,21 @@ class TestWatcher {
   ~TestWatcher() = default;
 
   void start() { timer_.reset(); }
-  void end() { compress_time_ = timer_.elapsed(); }
+  void end() { add_compress_sample(timer_.elapsed()); }
   // 获取当前任务的表头
   std::string get_header() const;
 
   // 获取上一个任务的结果，以","分割的csv格式返回
   std::string get_result() const;
+  // 获取上一个任务的结果，以单行json对象返回
+  std::string get_json() const;
+  // 记录一次计时的压缩或解压耗时(秒)，结果取所有样本的中位数
+  void add_compress_sample(double seconds);
+  void add_decompress_sample(double seconds);
+  // 记录往返校验的结果
+  void set_round_trip(bool ok) { round_trip_ = ok ? 1 : 0; }
+  // 记录运行期间的峰值内存(字节)，多个文件并行时不记录
+  void set_memory_usage(double bytes) { memory_usage_ = bytes; }
   // 获取实验名称
   void set_experiment_name(std::string name) { experiment_name_ = name; }
   // 记录原始文件大小
@@ -60,15 +69,22 @@ class TestWatcher {
   double compress_ratio() const;
   // 计算压缩速度
   double compress_speed() const;
-
-  // TODO(VulcanDB): 获取运行期间的平均内存占用
+  // 计算解压速度
+  double decompress_speed() const;
 
  public:
   std::string experiment_name_;
   double origin_size_ = INVALID_VALUE;
   double compress_size_ = INVALID_VALUE;
   double compress_time_ = INVALID_VALUE;
+  double compress_time_stddev_ = INVALID_VALUE;
+  double decompress_time_ = INVALID_VALUE;
+  double decompress_time_stddev_ = INVALID_VALUE;
+  // 1 还原结果正确，0 不正确，INVALID_VALUE 不支持还原
+  double round_trip_ = INVALID_VALUE;
   double memory_usage_ = INVALID_VALUE;
+  std::vector<double> compress_samples_;
+  std::vector<double> decompress_samples_;
 
  private:
   class Timer timer_;
@@ -77,14 +93,46 @@ class TestWatcher {
 class Converter {
  public:
   Converter() = default;
-  ~Converter() = default;
+  virtual ~Converter() = default;
 
   virtual void convert(const std::string& input_file,
                        const std::string& output_file) = 0;
   virtual std::string method_name() const = 0;
+
+  // 将convert的结果还原为原始格式，不支持还原时返回false
+  virtual bool revert(const std::string& /*converted_file*/,
+                      const std::string& /*output_file*/) {
+    return false;
+  }
+
+  // 检查还原的结果，默认与原始文件逐字节比较
+  virtual bool verify(const std::string& origin_file,
+                      const std::string& converted_file,
+                      const std::string& reverted_file);
+
+  // 能否在多个线程中同时转换不同的文件
+  virtual bool thread_safe() const { return false; }
 };
 
+// 基准测试的运行参数
+struct BenchmarkOptions {
+  // 每个文件的预热次数，不计入结果
+  int warmup = 0;
+  // 每个文件计时的次数
+  int repetitions = 1;
+  // 同时处理的文件数，只对thread_safe的转换器生效。并行时各文件不记录
+  // 峰值内存，整个进程的峰值单独写入profile.jsonl的一行
+  unsigned jobs = 1;
+};
+
+void set_benchmark_options(const BenchmarkOptions& options);
+const BenchmarkOptions& benchmark_options();
+
 /*接受一个转换函数作为参数，递归遍历目录的每个文件，对每个输入流执行该函数并转换为一个输出流
+ *
+ * 每个文件按benchmark_options()预热和重复执行，转换器支持还原时同时测量
+ * 解压耗时并校验还原结果。结果追加到output_dir上级目录的profile.csv和
+ * profile.jsonl中，并按遍历顺序返回。
  *
  * @param root_dir 遍历的根目录
  * @param output_dir 输出目录
@@ -94,9 +142,10 @@ class Converter {
  * @param convert_func
  * 对文件的处理函数，处理后的文件输出到output_dir，返回结果的iostream
  */
-void traverseDir(const std::filesystem::path& root_dir,
-                 const std::filesystem::path& output_dir,
-                 std::string origin_postfix, std::string target_postfix,
-                 Converter& converter);
+std::vector<TestWatcher> traverseDir(const std::filesystem::path& root_dir,
+                                     const std::filesystem::path& output_dir,
+                                     std::string origin_postfix,
+                                     std::string target_postfix,
+                                     Converter& converter);
 
 }  // namespace compbench
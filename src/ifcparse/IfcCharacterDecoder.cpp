@@ -29,6 +29,10 @@
 #include <iomanip>
 #include <codecvt>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "../ifcparse/IfcCharacterDecoder.h"
 #include "../ifcparse/IfcException.h"
 #include "../ifcparse/IfcSpfStream.h"
@@ -81,6 +85,54 @@ IfcCharacterDecoder::~IfcCharacterDecoder() {
 namespace {
 	static unsigned int reference_helper = 0;
 
+	// Whether a character inside a string needs the state machine: the
+	// apostrophe, the reverse solidus, or anything that is not printable
+	// ASCII (line breaks are dropped by the stream, bytes >= 0x80 depend
+	// on the conversion mode).
+	inline bool is_special(char c) {
+		const unsigned char u = static_cast<unsigned char>(c);
+		return c == '\'' || c == '\\' || u < 0x20 || u >= 0x7f;
+	}
+
+	// Returns the closing apostrophe of the string that starts at begin if
+	// the string is plain printable ASCII, i.e. it decodes to itself. Returns
+	// null when it contains escape sequences, quoted apostrophes or other
+	// characters that need the state machine, or is not terminated. An
+	// apostrophe followed by a line break is left to the state machine too:
+	// IfcSpfStream::Inc() skips line breaks, so it may still be the first
+	// half of a quoted apostrophe.
+	const char* find_plain_string_end(const char* begin, const char* end) {
+		const char* it = begin;
+#ifdef __SSE2__
+		const __m128i apostrophe = _mm_set1_epi8('\'');
+		const __m128i solidus = _mm_set1_epi8('\\');
+		const __m128i space = _mm_set1_epi8(0x20);
+		const __m128i del = _mm_set1_epi8(0x7f);
+		for (; end - it >= 16; it += 16) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+			// Signed comparison, bytes >= 0x80 are negative and also match
+			const __m128i special = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, apostrophe), _mm_cmpeq_epi8(v, solidus)),
+				_mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpeq_epi8(v, del)));
+			const int mask = _mm_movemask_epi8(special);
+			if (mask) {
+				it += __builtin_ctz(mask);
+				break;
+			}
+		}
+#endif
+		while (it != end && !is_special(*it)) {
+			++it;
+		}
+		if (it == end || *it != '\'') {
+			return 0;
+		}
+		if (it + 1 != end && (it[1] == '\'' || it[1] == '\r' || it[1] == '\n')) {
+			return 0;
+		}
+		return it;
+	}
+
 	class pure_impure_helper {
 	private:
 		bool pure_;
@@ -121,7 +173,36 @@ namespace {
 			: pure_(true), stream_(stream), pointer_(pointer)
 		{}
 
+		// Decodes a plain string without the state machine, see
+		// find_plain_string_end(). The result is the same in every mode.
+		bool get_plain(std::string& result) {
+			const unsigned int start = tell();
+			const char* begin = stream_->data_at(start);
+			const char* quote = find_plain_string_end(begin, begin + stream_->remaining_at(start));
+			if (quote == 0) {
+				return false;
+			}
+			result.reserve(quote - begin + 2);
+			result.push_back('\'');
+			result.append(begin, quote);
+			result.push_back('\'');
+			// Leave the pointer after the closing apostrophe, as the state
+			// machine does
+			if (pure_) {
+				pointer_ = start + (unsigned int)(quote - begin);
+			} else {
+				stream_->Seek(start + (unsigned int)(quote - begin));
+			}
+			increment();
+			return true;
+		}
+
 		std::string get(IfcParse::IfcCharacterDecoder::ConversionMode mode, char substitution_character) {
+			std::string plain;
+			if (get_plain(plain)) {
+				return plain;
+			}
+
 			unsigned int parse_state = 0;
 			builder_.clear();
 			builder_.push_back('\'');
@@ -245,6 +326,15 @@ std::string IfcCharacterDecoder::get(unsigned int& ptr) {
 }
 
 void IfcCharacterDecoder::skip() {
+	const unsigned int start = file->Tell();
+	const char* begin = file->data_at(start);
+	const char* quote = find_plain_string_end(begin, begin + file->remaining_at(start));
+	if (quote) {
+		file->Seek(start + (unsigned int)(quote - begin));
+		file->Inc();
+		return;
+	}
+
 	unsigned int parse_state = 0;
 	char current_char;
 	unsigned int hex_count = 0;
@@ -27,8 +27,12 @@
 #include <boost/unordered_map.hpp>
 #include <iterator>
 #include <map>
+#include <mutex>
 #include <set>
+#include <tuple>
 
+#include "../common/roaring_bitmap.h"
+#include "../ifcparse/IfcGlobalId.h"
 #include "../ifcparse/IfcParse.h"
 #include "../ifcparse/IfcSchema.h"
 #include "../ifcparse/IfcSpfHeader.h"
@@ -59,15 +63,50 @@ class IFC_PARSE_API IfcFile {
  public:
   typedef std::map<const IfcParse::declaration*, aggregate_of_instance::ptr>
       entities_by_type_t;
+  typedef std::map<const IfcParse::declaration*, vulcan::RoaringBitmap>
+      ids_by_type_t;
   typedef boost::unordered_map<unsigned int, IfcUtil::IfcBaseClass*>
       entity_by_id_t;
   typedef boost::unordered_map<uint32_t, IfcUtil::IfcBaseClass*>
       entity_by_iden_t;
-  typedef std::map<std::string, IfcUtil::IfcBaseClass*> entity_by_guid_t;
-  typedef std::tuple<int, int, int> inverse_attr_record;
-  enum INVERSE_ATTR { INSTANCE_ID, INSTANCE_TYPE, ATTRIBUTE_INDEX };
-  typedef std::map<inverse_attr_record, std::vector<int> > entities_by_ref_t;
-  typedef std::map<int, std::vector<int> > entities_by_ref_excl_t;
+  /// GlobalId -> instance. GlobalIds are keyed by their 16-byte binary
+  /// form; strings that are not valid GlobalIds, which some exporters
+  /// write, are kept by their text so that they can still be looked up.
+  class IFC_PARSE_API entity_by_guid_t {
+   public:
+    /// Returns null if no instance is registered under guid
+    IfcUtil::IfcBaseClass* find(const std::string& guid) const;
+    IfcUtil::IfcBaseClass* find(const IfcParse::IfcGuid& guid) const;
+    /// Registers instance under guid, returns the instance it replaces
+    IfcUtil::IfcBaseClass* assign(const std::string& guid,
+                                  IfcUtil::IfcBaseClass* instance);
+    /// Returns whether guid was registered
+    bool erase(const std::string& guid);
+    size_t size() const { return binary_.size() + text_.size(); }
+
+   private:
+    boost::unordered_map<IfcParse::IfcGuid, IfcUtil::IfcBaseClass*,
+                         IfcParse::IfcGuidHash>
+        binary_;
+    std::map<std::string, IfcUtil::IfcBaseClass*> text_;
+  };
+  /// A reference to an instance: the name of the referencing instance and
+  /// the index of the attribute that holds the reference.
+  struct inverse_ref {
+    int id;
+    int attribute_index;
+    bool operator==(const inverse_ref& other) const {
+      return id == other.id && attribute_index == other.attribute_index;
+    }
+    bool operator<(const inverse_ref& other) const {
+      return id < other.id ||
+             (id == other.id && attribute_index < other.attribute_index);
+    }
+  };
+  /// Referenced instance name -> references to it, in registration order.
+  /// The type of the referencing instance is looked up when filtering.
+  typedef boost::unordered_map<int, std::vector<inverse_ref> >
+      entities_by_ref_t;
   typedef std::map<unsigned int, aggregate_of_instance::ptr> ref_map_t;
   typedef entity_by_id_t::const_iterator const_iterator;
 
@@ -127,10 +166,17 @@ class IFC_PARSE_API IfcFile {
   entity_by_id_t byid;
   // this is for simple types
   entity_by_iden_t byidentity;
-  entities_by_type_t bytype;
+  // Instances of exactly one entity type, both as a list and as a bitmap of
+  // instance names. An instance is recorded only under its own type.
   entities_by_type_t bytype_excl;
+  ids_by_type_t bytype_ids;
+  // Subtype-inclusive results, computed on demand as the union over the
+  // subtype closure and dropped when an instance of a subtype is added or
+  // removed. The const type lookups fill them under type_cache_mutex_.
+  mutable entities_by_type_t bytype;
+  mutable ids_by_type_t bytype_ids_incl;
+  mutable std::mutex type_cache_mutex_;
   entities_by_ref_t byref;
-  entities_by_ref_excl_t byref_excl;
   entity_by_guid_t byguid;
   entity_entity_map_t entity_file_map;
 
@@ -144,6 +190,36 @@ class IFC_PARSE_API IfcFile {
 
   void build_inverses_(IfcUtil::IfcBaseClass*);
 
+  // In batch mode reference changes made by setArgument() and addEntity()
+  // are recorded here and applied in one pass, netting out references
+  // that are unregistered and registered again. Queries on the inverse
+  // index apply the pending changes first.
+  struct inverse_delta {
+    int referenced;
+    inverse_ref ref;
+    int count;
+  };
+  std::vector<inverse_delta> inverse_deltas_;
+  void apply_inverse_deltas_();
+
+  // (root identity, max_level, breadth first) -> closure
+  typedef std::tuple<uint32_t, int, bool> traversal_key_t;
+  std::map<traversal_key_t, aggregate_of_instance::ptr> traversals_;
+  bool traversal_cache_ = false;
+  aggregate_of_instance::ptr traverse_cached_(IfcUtil::IfcBaseClass* instance,
+                                              int max_level,
+                                              bool breadth_first,
+                                              unsigned threads);
+
+  void index_type_(IfcUtil::IfcBaseClass*);
+  void unindex_type_(IfcUtil::IfcBaseClass*);
+  void invalidate_type_cache_(const IfcParse::declaration*);
+  // The cached lookups, the caller holds type_cache_mutex_.
+  const vulcan::RoaringBitmap& ids_by_type_(
+      const IfcParse::declaration* t) const;
+  aggregate_of_instance::ptr instances_by_type_(
+      const IfcParse::declaration* t) const;
+
   typedef boost::multi_index_container<
       int,
       boost::multi_index::indexed_by<boost::multi_index::sequenced<>,
@@ -185,9 +261,19 @@ class IFC_PARSE_API IfcFile {
   type_iterator types_begin() const;
   type_iterator types_end() const;
 
+  /// Iterates over all types with instances, including supertypes. This
+  /// computes the subtype-inclusive list of every such type.
+  /// NOTE: The subtype-inclusive lookups fill a cache in the file under an
+  /// internal mutex. They may run concurrently with each other and with
+  /// other const access, but not with changes to the file.
   type_iterator types_incl_super_begin() const;
   type_iterator types_incl_super_end() const;
 
+  /// Drops the cached subtype-inclusive lookups, the next lookup of each
+  /// type computes its result again. Invalidates the references returned
+  /// by ids_by_type().
+  void clear_type_cache();
+
   /// Returns all entities in the file that match the template argument.
   /// NOTE: This also returns subtypes of the requested type, for example:
   /// IfcWall will also return IfcWallStandardCase entities
@@ -214,8 +300,13 @@ class IFC_PARSE_API IfcFile {
 
   /// Returns all entities in the file that match the positional argument.
   /// NOTE: This also returns subtypes of the requested type, for example:
-  /// IfcWall will also return IfcWallStandardCase entities
-  aggregate_of_instance::ptr instances_by_type(const IfcParse::declaration*);
+  /// IfcWall will also return IfcWallStandardCase entities. The list is
+  /// built from ids_by_type() on first use and is in ascending instance
+  /// name (#id) order, not in file order or the order in which instances
+  /// were added, so a type and its subtypes come out interleaved.
+  /// NOTE: The list is cached, see types_incl_super_begin().
+  aggregate_of_instance::ptr instances_by_type(
+      const IfcParse::declaration*) const;
 
   /// Returns all entities in the file that match the positional argument.
   aggregate_of_instance::ptr instances_by_type_excl_subtypes(
@@ -230,6 +321,18 @@ class IFC_PARSE_API IfcFile {
   aggregate_of_instance::ptr instances_by_type_excl_subtypes(
       const std::string& t);
 
+  /// Returns the instance names of all entities that match the positional
+  /// argument, including subtypes, in ascending order. Bitmaps of different
+  /// types (or of other indexes) can be intersected to combine conditions.
+  /// The reference is valid until an instance of the type is added or
+  /// removed. The union is cached on first use, see types_incl_super_begin().
+  const vulcan::RoaringBitmap& ids_by_type(
+      const IfcParse::declaration* t) const;
+
+  /// Returns the instance names of all entities of exactly this type.
+  const vulcan::RoaringBitmap& ids_by_type_excl_subtypes(
+      const IfcParse::declaration* t) const;
+
   /// Returns all entities in the file that reference the id
   aggregate_of_instance::ptr instances_by_reference(int id);
 
@@ -238,6 +341,7 @@ class IFC_PARSE_API IfcFile {
 
   /// Returns the entity with the specified GlobalId
   IfcUtil::IfcBaseClass* instance_by_guid(const std::string& guid);
+  IfcUtil::IfcBaseClass* instance_by_guid(const IfcParse::IfcGuid& guid);
 
   /// Performs a depth-first traversal, returning all entity instance
   /// attributes as a flat list. NB: includes the root instance specified
@@ -246,9 +350,17 @@ class IFC_PARSE_API IfcFile {
                                       int max_level = -1);
 
   /// Same as traverse() but maintains topological order by using a
-  /// breadth-first search
+  /// breadth-first search. Large frontiers are expanded by up to threads
+  /// threads, see IfcParse::traverse_levels().
   aggregate_of_instance::ptr traverse_breadth_first(
-      IfcUtil::IfcBaseClass* instance, int max_level = -1);
+      IfcUtil::IfcBaseClass* instance, int max_level = -1,
+      unsigned threads = 1);
+
+  /// Enables caching the results of traverse() and traverse_breadth_first()
+  /// per root instance. The cache is dropped whenever a reference between
+  /// instances is added or removed, or instances are deleted.
+  void traversal_cache(bool b);
+  bool traversal_cache() const { return traversal_cache_; }
 
   /// Get the attribute indices corresponding to the list of entity instances
   /// returned by getInverse().
@@ -279,6 +391,7 @@ class IFC_PARSE_API IfcFile {
 
   void batch() { batch_mode_ = true; }
   void unbatch() {
+    apply_inverse_deltas_();
     process_deletion_();
     batch_mode_ = false;
   }
@@ -17,8 +17,8 @@
  *                                                                              *
  ********************************************************************************/
 
-#include <vector>
 #include <algorithm>
+#include <cstring>
 
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
@@ -31,55 +31,88 @@
 #include "../ifcparse/IfcBaseClass.h"
 #include "../ifcparse/IfcLogger.h"
 
-static const char* chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_$";
+static constexpr char chars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_$";
 
-// Converts an unsigned integer into a base64 string of length l
-std::string base64(unsigned v, int l) {
-	std::string r;
-	r.reserve(l);
-	while ( v ) {
-		r.push_back(chars[v%64]);
-		v /= 64;
+namespace {
+
+	// Maps a character to its base64 value, 0xff for characters outside
+	// the alphabet. Built at compile time, so it is usable during static
+	// initialization of other translation units.
+	struct decode_table {
+		unsigned char values[256];
+
+		constexpr decode_table() : values() {
+			for (unsigned i = 0; i < 256; ++i) {
+				values[i] = 0xff;
+			}
+			for (unsigned i = 0; i < 64; ++i) {
+				values[(unsigned char)chars[i]] = (unsigned char)i;
+			}
+		}
+	};
+
+	constexpr decode_table table;
+
+	// Decodes four characters into 24 bits, sets bits above 0x3f in bad on
+	// invalid characters
+	inline uint32_t decode4(const unsigned char* s, unsigned& bad) {
+		const unsigned a = table.values[s[0]], b = table.values[s[1]];
+		const unsigned c = table.values[s[2]], d = table.values[s[3]];
+		bad |= a | b | c | d;
+		return (a << 18) | (b << 12) | (c << 6) | d;
 	}
-	while ( (int)r.size() != l ) r.push_back('0');
-	std::reverse(r.begin(),r.end());
-	return r;
+
+	inline void encode4(uint32_t v, char* out) {
+		out[0] = chars[(v >> 18) & 63];
+		out[1] = chars[(v >> 12) & 63];
+		out[2] = chars[(v >> 6) & 63];
+		out[3] = chars[v & 63];
+	}
+
 }
 
-// Converts a base64 string into an unsigned integer
-unsigned from_base64(const std::string& s) {
-	std::string::size_type zeros = s.find_first_not_of('0');
-	unsigned r = 0;
-	if ( zeros != std::string::npos )
-		for ( std::string::const_iterator i = s.begin()+zeros; i != s.end(); ++ i ) {
-			r *= 64;
-			const char* c = strchr(chars,*i);
-			if ( !c ) throw IfcParse::IfcException("Failed to decode GlobalId");
-			r += (unsigned)(c-chars);
-		}
-	return r;
+// The first two characters hold the first byte, each following group of
+// four characters holds three bytes
+bool IfcParse::IfcGlobalId::decode(const char* text, size_t size, IfcGuid& guid) {
+	if (size != length) {
+		return false;
+	}
+	const unsigned char* s = (const unsigned char*)text;
+	const unsigned hi = table.values[s[0]], lo = table.values[s[1]];
+	// The first character carries only two bits
+	unsigned bad = (hi > 3 ? 0xff : hi) | lo;
+	guid.bytes[0] = (unsigned char)((hi << 6) | lo);
+	for (unsigned i = 0; i < 5; ++i) {
+		const uint32_t v = decode4(s + 2 + 4 * i, bad);
+		guid.bytes[1 + 3 * i] = (unsigned char)(v >> 16);
+		guid.bytes[2 + 3 * i] = (unsigned char)(v >> 8);
+		guid.bytes[3 + 3 * i] = (unsigned char)v;
+	}
+	return bad < 64;
 }
 
-// Compresses the UUID byte array into a base64 representation
-std::string compress(unsigned char* v) {
-	std::string r;
-	r.reserve(22);
-	r += base64(v[0],2);
-	for ( unsigned i = 1; i < 16; i += 3 ) {
-		r += base64((v[i]<<16) + (v[i+1]<<8) + v[i+2],4);
+void IfcParse::IfcGlobalId::encode(const IfcGuid& guid, char* out) {
+	const unsigned char* v = guid.bytes;
+	out[0] = chars[v[0] >> 6];
+	out[1] = chars[v[0] & 63];
+	for (unsigned i = 0; i < 5; ++i) {
+		encode4(((uint32_t)v[1 + 3 * i] << 16) | ((uint32_t)v[2 + 3 * i] << 8) | v[3 + 3 * i], out + 2 + 4 * i);
 	}
+}
+
+std::string IfcParse::IfcGlobalId::encode(const IfcGuid& guid) {
+	std::string r(length, '0');
+	encode(guid, &r[0]);
 	return r;
 }
 
-// Expands the base64 representation into a UUID byte array
-void expand(const std::string& s, std::vector<unsigned char>& v) {
-	v.push_back((unsigned char)from_base64(s.substr(0,2)));
-	for( unsigned i = 0; i < 5; ++i ) {
-		unsigned d = from_base64(s.substr(2+4*i,4));
-		for ( unsigned j = 0; j < 3; ++ j ) {
-			v.push_back((d>>(8*(2-j))) % 256);
-		}
+size_t IfcParse::IfcGlobalId::decode_batch(const std::string* texts, size_t count, IfcGuid* guids, unsigned char* valid) {
+	size_t decoded = 0;
+	for (size_t i = 0; i < count; ++i) {
+		valid[i] = decode(texts[i], guids[i]) ? 1 : 0;
+		decoded += valid[i];
 	}
+	return decoded;
 }
 
 // A random number generator for the UUID
@@ -87,21 +120,13 @@ static boost::uuids::basic_random_generator<boost::mt19937> gen;
 
 IfcParse::IfcGlobalId::IfcGlobalId() {
 	uuid_data = gen();
-	std::vector<unsigned char> v(uuid_data.size());
-	std::copy(uuid_data.begin(), uuid_data.end(), v.begin());
-	string_data = compress(&v[0]);
-#if BOOST_VERSION < 104400
-	formatted_string = boost::lexical_cast<std::string>(uuid_data);
-#else
-	formatted_string = boost::uuids::to_string(uuid_data);
-#endif
+	IfcGuid guid;
+	std::copy(uuid_data.begin(), uuid_data.end(), guid.bytes);
+	string_data = encode(guid);
 
 #ifndef NDEBUG
-	std::vector<unsigned char> test_vector;
-	expand(string_data, test_vector);
-	boost::uuids::uuid test_uuid;
-	std::copy(test_vector.begin(), test_vector.end(), test_uuid.begin());
-	if (uuid_data != test_uuid) {
+	IfcGuid test_guid;
+	if (!decode(string_data, test_guid) || test_guid != guid) {
 		Logger::Message(Logger::LOG_ERROR, "Internal error generating GlobalId");
 	}
 #endif
@@ -110,21 +135,11 @@ IfcParse::IfcGlobalId::IfcGlobalId() {
 IfcParse::IfcGlobalId::IfcGlobalId(const std::string& s)
 	: string_data(s)
 {
-	std::vector<unsigned char> v;
-	expand(string_data, v);
-	std::copy(v.begin(), v.end(), uuid_data.begin());
-#if BOOST_VERSION < 104400
-	formatted_string = boost::lexical_cast<std::string>(uuid_data);
-#else
-	formatted_string = boost::uuids::to_string(uuid_data);
-#endif
-
-#ifndef NDEBUG
-	const std::string test_string = compress(&uuid_data.data[0]);
-	if (string_data != test_string) {
-		Logger::Message(Logger::LOG_ERROR, "Internal error generating GlobalId");
+	IfcGuid guid;
+	if (!decode(string_data, guid)) {
+		throw IfcParse::IfcException("Failed to decode GlobalId");
 	}
-#endif
+	std::copy(guid.bytes, guid.bytes + 16, uuid_data.begin());
 }
 
 IfcParse::IfcGlobalId::operator const std::string&() const {
@@ -136,5 +151,12 @@ IfcParse::IfcGlobalId::operator const boost::uuids::uuid&() const {
 }
 
 const std::string& IfcParse::IfcGlobalId::formatted() const {
+	if (formatted_string.empty()) {
+#if BOOST_VERSION < 104400
+		formatted_string = boost::lexical_cast<std::string>(uuid_data);
+#else
+		formatted_string = boost::uuids::to_string(uuid_data);
+#endif
+	}
 	return formatted_string;
 }
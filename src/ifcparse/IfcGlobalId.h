@@ -20,6 +20,9 @@
 #ifndef IFCGLOBALID_H
 #define IFCGLOBALID_H
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <boost/uuid/uuid.hpp>
 
@@ -27,10 +30,33 @@
 
 namespace IfcParse {
 
+	/// The 128-bit value of a GlobalId, in the byte order of its UUID.
+	/// Used instead of the 22-character text to index and compare GlobalIds.
+	struct IfcGuid {
+		unsigned char bytes[16];
+
+		bool operator==(const IfcGuid& other) const { return memcmp(bytes, other.bytes, 16) == 0; }
+		bool operator!=(const IfcGuid& other) const { return !(*this == other); }
+		bool operator<(const IfcGuid& other) const { return memcmp(bytes, other.bytes, 16) < 0; }
+	};
+
+	struct IfcGuidHash {
+		size_t operator()(const IfcGuid& guid) const {
+			uint64_t lo, hi;
+			memcpy(&lo, guid.bytes, 8);
+			memcpy(&hi, guid.bytes + 8, 8);
+			// Generated GUIDs are random, but some exporters derive them
+			// from counters, so both halves are mixed in
+			uint64_t h = (lo ^ (hi * 0x9e3779b97f4a7c15ULL)) * 0xff51afd7ed558ccdULL;
+			return static_cast<size_t>(h ^ (h >> 32));
+		}
+	};
+
 	/// A helper class for the creation of IFC GlobalIds.
 	class IFC_PARSE_API IfcGlobalId {
 	private:
-		std::string string_data, formatted_string;
+		std::string string_data;
+		mutable std::string formatted_string;
 		boost::uuids::uuid uuid_data;
 	public:
 		static const unsigned int length = 22;
@@ -38,9 +64,27 @@ namespace IfcParse {
 		IfcGlobalId(const std::string&);
 		operator const std::string&() const;
 		operator const boost::uuids::uuid&() const;
+		/// The UUID in its 8-4-4-4-12 hexadecimal form, formatted on first use
 		const std::string& formatted() const;
+
+		/// Decodes the 22-character base64 text of a GlobalId. Returns false
+		/// if the text has another length, contains characters outside the
+		/// GlobalId alphabet or encodes more than 128 bits. Does not allocate.
+		static bool decode(const char* text, size_t size, IfcGuid& guid);
+		static bool decode(const std::string& text, IfcGuid& guid) {
+			return decode(text.data(), text.size(), guid);
+		}
+
+		/// Writes the 22-character text of guid to out, without terminator.
+		static void encode(const IfcGuid& guid, char* out);
+		static std::string encode(const IfcGuid& guid);
+
+		/// Decodes a column of GlobalIds. valid[i] is set to 1 if texts[i]
+		/// was decoded into guids[i] and to 0 otherwise. Returns the number
+		/// of GlobalIds decoded.
+		static size_t decode_batch(const std::string* texts, size_t count, IfcGuid* guids, unsigned char* valid);
 	};
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -25,6 +25,7 @@
 #include "../ifcparse/IfcFile.h"
 #include "../ifcparse/IfcSIPrefix.h"
 #include "../ifcparse/IfcSchema.h"
+#include "../ifcparse/IfcTraversal.h"
 #include "../ifcparse/utils.h"
 
 #ifdef USE_MMAP
@@ -360,6 +361,14 @@ char IfcSpfStream::peek_at(unsigned int local_ptr) {
 	return buffer[local_ptr];
 }
 
+const char* IfcSpfStream::data_at(unsigned int local_ptr) {
+	return buffer + local_ptr;
+}
+
+unsigned int IfcSpfStream::remaining_at(unsigned int local_ptr) {
+	return local_ptr < len ? len - local_ptr : 0;
+}
+
 //
 // Reads a std::string from the file at specified offset
 // Omits whitespace and comments
@@ -586,6 +595,28 @@ const std::string &TokenFunc::asStringRef(const Token& t) {
 	return str;
 }
 
+std::string_view TokenFunc::asKeywordView(const Token& t) {
+	if (t.type == Token_NONE) {
+		return asStringRef(t);
+	}
+	IfcSpfStream* stream = t.lexer->stream;
+	unsigned int end = t.startPos;
+	while (!stream->is_eof_at(end)) {
+		char c = stream->peek_at(end);
+		if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_')) break;
+		++end;
+	}
+	// Whitespace, line breaks or comments inside or after the keyword are
+	// left to TokenString()
+	if (end > t.startPos && !stream->is_eof_at(end)) {
+		char c = stream->peek_at(end);
+		if (c == '(' || c == ')' || c == '=' || c == ',' || c == ';') {
+			return std::string_view(stream->data_at(t.startPos), end - t.startPos);
+		}
+	}
+	return asStringRef(t);
+}
+
 std::string TokenFunc::asString(const Token& t) {
 	if (isString(t) || isEnumeration(t) || isBinary(t)) {
 		return asStringRef(t);
@@ -998,7 +1029,7 @@ IfcEntityInstanceData* IfcParse::read(unsigned int i, IfcFile* f, boost::optiona
 	}
 	Token datatype = f->tokens->Next();
 	if (!TokenFunc::isKeyword(datatype)) throw IfcException("Unexpected token while parsing entity");
-	const IfcParse::declaration* ty = f->schema()->declaration_by_name(TokenFunc::asStringRef(datatype));
+	const IfcParse::declaration* ty = f->schema()->declaration_by_name(TokenFunc::asKeywordView(datatype));
 	IfcEntityInstanceData* e = new IfcEntityInstanceData(ty, f, i, offset.get_value_or(0));
 	return e;
 }
@@ -1020,49 +1051,100 @@ void IfcParse::IfcFile::try_read_semicolon() {
 	}
 }
 
-void IfcParse::IfcFile::register_inverse(unsigned id_from, const IfcParse::entity* from_entity, Token t, int attribute_index) {
+void IfcParse::IfcFile::register_inverse(unsigned id_from, const IfcParse::entity* /* from_entity */, Token t, int attribute_index) {
 	// Assume a check on token type has already been performed
-	auto e = from_entity;
-	byref_excl[t.value_int].push_back(id_from);
-	while (e) {
-		byref[{t.value_int, e->index_in_schema(), attribute_index}].push_back(id_from);
-		e = e->supertype();
-	}
+	byref[t.value_int].push_back({ (int) id_from, attribute_index });
 }
 
-void IfcParse::IfcFile::register_inverse(unsigned id_from, const IfcParse::entity* from_entity, IfcUtil::IfcBaseClass* inst, int attribute_index) {
-	auto e = from_entity;
-	byref_excl[inst->data().id()].push_back(id_from);
-	while (e) {
-		byref[{inst->data().id(), e->index_in_schema(), attribute_index}].push_back(id_from);
-		e = e->supertype();
+void IfcParse::IfcFile::register_inverse(unsigned id_from, const IfcParse::entity* /* from_entity */, IfcUtil::IfcBaseClass* inst, int attribute_index) {
+	// A reference is added, closures computed before may be incomplete
+	traversals_.clear();
+	if (batch_mode_) {
+		inverse_deltas_.push_back({ (int) inst->data().id(), { (int) id_from, attribute_index }, 1 });
+		return;
 	}
+	byref[inst->data().id()].push_back({ (int) id_from, attribute_index });
 }
 
-void IfcParse::IfcFile::unregister_inverse(unsigned id_from, const IfcParse::entity* from_entity, IfcUtil::IfcBaseClass* inst, int attribute_index) {
-	auto e = from_entity;
-	while (e) {
-		std::vector<int>& ids = byref[{inst->data().id(), e->index_in_schema(), attribute_index}];
-		std::vector<int>::iterator it = std::find(ids.begin(), ids.end(), id_from);
-		if (it == ids.end()) {
-			// @todo inverses also need to be populated when multiple instances are added to a new file.
-			// throw IfcParse::IfcException("Instance not found among inverses");
-		} else {
-			ids.erase(it);
-		}
-		e = e->supertype();
+void IfcParse::IfcFile::unregister_inverse(unsigned id_from, const IfcParse::entity* /* from_entity */, IfcUtil::IfcBaseClass* inst, int attribute_index) {
+	traversals_.clear();
+	if (batch_mode_) {
+		inverse_deltas_.push_back({ (int) inst->data().id(), { (int) id_from, attribute_index }, -1 });
+		return;
 	}
 
-	std::vector<int>& ids = byref_excl[inst->data().id()];
-	std::vector<int>::iterator it = std::find(ids.begin(), ids.end(), id_from);
-	if (it == ids.end()) {
+	auto refs = byref.find(inst->data().id());
+	if (refs == byref.end()) {
+		return;
+	}
+	const inverse_ref ref = { (int) id_from, attribute_index };
+	auto it = std::find(refs->second.begin(), refs->second.end(), ref);
+	if (it == refs->second.end()) {
 		// @todo inverses also need to be populated when multiple instances are added to a new file.
 		// throw IfcParse::IfcException("Instance not found among inverses");
 	} else {
-		ids.erase(it);
+		refs->second.erase(it);
+		if (refs->second.empty()) {
+			byref.erase(refs);
+		}
 	}
 }
 
+void IfcParse::IfcFile::apply_inverse_deltas_() {
+	if (inverse_deltas_.empty()) {
+		return;
+	}
+
+	// Group the changes by referenced instance and reference, so that the
+	// list of every referenced instance is visited once and a reference that
+	// was unregistered and registered again is left untouched.
+	std::stable_sort(inverse_deltas_.begin(), inverse_deltas_.end(), [](const inverse_delta& a, const inverse_delta& b) {
+		return a.referenced < b.referenced || (a.referenced == b.referenced && a.ref < b.ref);
+	});
+
+	std::vector<std::pair<inverse_ref, int> > removals;
+	size_t i = 0;
+	while (i < inverse_deltas_.size()) {
+		const int referenced = inverse_deltas_[i].referenced;
+		std::vector<inverse_ref>& refs = byref[referenced];
+		removals.clear();
+		while (i < inverse_deltas_.size() && inverse_deltas_[i].referenced == referenced) {
+			const inverse_ref ref = inverse_deltas_[i].ref;
+			int count = 0;
+			for (; i < inverse_deltas_.size() && inverse_deltas_[i].referenced == referenced && inverse_deltas_[i].ref == ref; ++i) {
+				count += inverse_deltas_[i].count;
+			}
+			if (count > 0) {
+				refs.insert(refs.end(), count, ref);
+			} else if (count < 0) {
+				removals.push_back({ ref, -count });
+			}
+		}
+
+		if (!removals.empty()) {
+			// Removes the first occurrences, like unregister_inverse() does.
+			// Removed references are never appended above, as their net count
+			// is negative.
+			refs.erase(std::remove_if(refs.begin(), refs.end(), [&removals](const inverse_ref& r) {
+				auto it = std::lower_bound(removals.begin(), removals.end(), r, [](const std::pair<inverse_ref, int>& a, const inverse_ref& b) {
+					return a.first < b;
+				});
+				if (it == removals.end() || !(it->first == r) || it->second == 0) {
+					return false;
+				}
+				--it->second;
+				return true;
+			}), refs.end());
+		}
+
+		if (refs.empty()) {
+			byref.erase(referenced);
+		}
+	}
+
+	inverse_deltas_.clear();
+}
+
 //
 // Returns a string representation of the entity
 // Note that this initializes the entity if it is not initialized
@@ -1463,9 +1545,9 @@ void IfcEntityInstanceData::setArgument(size_t i, Argument* a, IfcUtil::Argument
 			if (i == 0 && this->type() && this->file->ifcroot_type() && this->type()->is(*this->file->ifcroot_type())) {
 				try {
 					auto guid = (std::string) *current_attribute;
-					auto it = this->file->internal_guid_map().find(guid);
-					if (it != this->file->internal_guid_map().end() && &it->second->data() == this) {
-						this->file->internal_guid_map().erase(it);
+					IfcUtil::IfcBaseClass* registered = this->file->internal_guid_map().find(guid);
+					if (registered != 0 && &registered->data() == this) {
+						this->file->internal_guid_map().erase(guid);
 					}
 				} catch (IfcParse::IfcException& e) {
 					Logger::Error(e);
@@ -1492,11 +1574,9 @@ void IfcEntityInstanceData::setArgument(size_t i, Argument* a, IfcUtil::Argument
 		if (i == 0 && this->type() && this->file->ifcroot_type() && this->type()->is(*this->file->ifcroot_type())) {
 			try {
 				auto guid = (std::string) *new_attribute;
-				auto it = this->file->internal_guid_map().find(guid);
-				if (it != this->file->internal_guid_map().end()) {
+				if (this->file->internal_guid_map().assign(guid, this->file->instance_by_id(this->id())) != 0) {
 					Logger::Warning("Duplicate guid " + guid);
 				}
-				this->file->internal_guid_map()[guid] = this->file->instance_by_id(this->id());
 			} catch (IfcParse::IfcException& e) {
 				Logger::Error(e);
 			}
@@ -1619,7 +1699,7 @@ void IfcFile::initialize_(IfcParse::IfcSpfStream* s) {
 			current_id = (unsigned) TokenFunc::asIdentifier(token_stream[0]);
 			const IfcParse::declaration* entity_type;
 			try {
-				entity_type = schema_->declaration_by_name(TokenFunc::asStringRef(token_stream[2]));
+				entity_type = schema_->declaration_by_name(TokenFunc::asKeywordView(token_stream[2]));
 			} catch (const IfcException& ex) {
 				Logger::Message(Logger::LOG_ERROR, std::string(ex.what()) + " at offset " + std::to_string(token_stream[2].startPos));
 				goto advance;
@@ -1642,12 +1722,11 @@ void IfcFile::initialize_(IfcParse::IfcSpfStream* s) {
 			if (instance->declaration().is(*ifcroot_type_)) {
 				try {
 					const std::string guid = *instance->data().getArgument(0);
-					if ( byguid.find(guid) != byguid.end() ) {
+					if ( byguid.assign(guid, instance) != 0 ) {
 						std::stringstream ss;
 						ss << "Instance encountered with non-unique GlobalId " << guid;
 						Logger::Message(Logger::LOG_WARNING,ss.str());
 					}
-					byguid[guid] = instance;
 				} catch (const IfcException& ex) {
 					Logger::Message(Logger::LOG_ERROR,ex.what());
 				}
@@ -1656,31 +1735,7 @@ void IfcFile::initialize_(IfcParse::IfcSpfStream* s) {
 				attribute_index = -1;
 			}
 
-			const IfcParse::declaration* ty = &instance->declaration();
-
-			{
-				aggregate_of_instance::ptr insts = instances_by_type_excl_subtypes(ty);
-				if (!insts) {
-					insts = aggregate_of_instance::ptr(new aggregate_of_instance());
-					bytype_excl[ty] = insts;
-				}
-				insts->push(instance);
-			}
-
-			for (;;) {
-				aggregate_of_instance::ptr insts = instances_by_type(ty);
-				if (!insts) {
-					insts = aggregate_of_instance::ptr(new aggregate_of_instance());
-					bytype[ty] = insts;
-				}
-				insts->push(instance);
-				const IfcParse::declaration* pt = ty->as_entity()->supertype();
-				if (pt) {
-					ty = pt;
-				} else {
-					break;
-				}
-			}
+			index_type_(instance);
 
 			if (byid.find(current_id) != byid.end()) {
 				std::stringstream ss;
@@ -1735,102 +1790,54 @@ void IfcFile::recalculate_id_counter() {
 	MaxId = (unsigned int)k;
 }
 
-class traversal_recorder {
-	aggregate_of_instance::ptr list_;
-	std::map<int, aggregate_of_instance::ptr> instances_by_level_;
-	int mode_;
-
-public:
-	traversal_recorder(int mode) : mode_(mode) {
-		if (mode == 0) {
-			list_.reset(new aggregate_of_instance);
-		}
-	};
-
-	void push_back(int level, IfcUtil::IfcBaseClass* instance) {
-		if (mode_ == 0) {
-			list_->push(instance);
-		} else {
-			auto& l = instances_by_level_[level];
-			if (!l) {
-				l.reset(new aggregate_of_instance);
-			}
-			l->push(instance);
-		}
-	}
-
-	aggregate_of_instance::ptr get_list() const {
-		if (mode_ == 0) {
-			return list_;
-		} else {
-			aggregate_of_instance::ptr l(new aggregate_of_instance);
-			for (auto& p : instances_by_level_) {
-				l->push(p.second);
-			}
-			return l;
-		}
-	}
-};
-
-class traversal_visitor {
-private:
-	std::set<IfcUtil::IfcBaseClass*>& visited_;
-	traversal_recorder& list_;
-	int level_;
-	int max_level_;
-
-public:
-	traversal_visitor(std::set<IfcUtil::IfcBaseClass*>& visited, traversal_recorder& list, int level, int max_level)
-		: visited_(visited)
-		, list_(list)
-		, level_(level)
-		, max_level_(max_level)
-	{}
-
-	void operator()(IfcUtil::IfcBaseClass* inst, int index);
-};
-
-void traverse_(IfcUtil::IfcBaseClass* instance, std::set<IfcUtil::IfcBaseClass*>& visited, traversal_recorder& list, int level, int max_level) {
-	if (visited.find(instance) != visited.end()) {
-		return;
-	}
-	visited.insert(instance);
-	list.push_back(level, instance);
-
-	if (level >= max_level && max_level > 0) return;
-
-	traversal_visitor visit(visited, list, level + 1, max_level);
-	apply_individual_instance_visitor(&instance->data()).apply(visit);
-}
-
-void traversal_visitor::operator()(IfcUtil::IfcBaseClass* inst, int /* index */) {
-	traverse_(inst, visited_, list_, level_, max_level_);
-}
-
 aggregate_of_instance::ptr IfcParse::traverse(IfcUtil::IfcBaseClass* instance, int max_level) {
-	std::set<IfcUtil::IfcBaseClass*> visited;
-	traversal_recorder r(0);
-	traverse_(instance, visited, r, 0, max_level);
-	return r.get_list();
+	thread_visited_set visited;
+	return traverse_depth_first(instance, max_level, visited.get());
 }
 
-// I'm cheating this isn't breadth-first, but rather we record visited instances
-// keeping track of their rank and return a list ordered by rank. Is this equivalent?
-aggregate_of_instance::ptr IfcParse::traverse_breadth_first(IfcUtil::IfcBaseClass* instance, int max_level) {
-	std::set<IfcUtil::IfcBaseClass*> visited;
-	traversal_recorder r(1);
-	traverse_(instance, visited, r, 0, max_level);
-	return r.get_list();
+aggregate_of_instance::ptr IfcParse::traverse_breadth_first(IfcUtil::IfcBaseClass* instance, int max_level, unsigned threads) {
+	thread_visited_set visited;
+	return traverse_levels(instance, max_level, visited.get(), threads);
 }
 
 /// @note: for backwards compatibility
 aggregate_of_instance::ptr IfcFile::traverse(IfcUtil::IfcBaseClass* instance, int max_level) {
-	return IfcParse::traverse(instance, max_level);
+	return traverse_cached_(instance, max_level, false, 1);
 }
 
 /// @note: for backwards compatibility
-aggregate_of_instance::ptr IfcFile::traverse_breadth_first(IfcUtil::IfcBaseClass* instance, int max_level) {
-	return IfcParse::traverse_breadth_first(instance, max_level);
+aggregate_of_instance::ptr IfcFile::traverse_breadth_first(IfcUtil::IfcBaseClass* instance, int max_level, unsigned threads) {
+	return traverse_cached_(instance, max_level, true, threads);
+}
+
+aggregate_of_instance::ptr IfcFile::traverse_cached_(IfcUtil::IfcBaseClass* instance, int max_level, bool breadth_first, unsigned threads) {
+	if (!traversal_cache_) {
+		return breadth_first
+			? IfcParse::traverse_breadth_first(instance, max_level, threads)
+			: IfcParse::traverse(instance, max_level);
+	}
+
+	const traversal_key_t key(instance->identity(), max_level > 0 ? max_level : -1, breadth_first);
+	auto it = traversals_.find(key);
+	if (it == traversals_.end()) {
+		// Not emplaced before computing, the traversal may lazily load
+		// instances which can add instances to the file.
+		aggregate_of_instance::ptr closure = breadth_first
+			? IfcParse::traverse_breadth_first(instance, max_level, threads)
+			: IfcParse::traverse(instance, max_level);
+		it = traversals_.emplace(key, closure).first;
+	}
+
+	// Callers are free to modify the returned list
+	aggregate_of_instance::ptr copy(new aggregate_of_instance);
+	copy->reserve(it->second->size());
+	copy->push(it->second);
+	return copy;
+}
+
+void IfcFile::traversal_cache(bool b) {
+	traversal_cache_ = b;
+	traversals_.clear();
 }
 
 void IfcFile::addEntities(aggregate_of_instance::ptr es) {
@@ -1857,16 +1864,17 @@ IfcUtil::IfcBaseClass* IfcFile::addEntity(IfcUtil::IfcBaseClass* entity, int id)
 
 	IfcUtil::IfcBaseClass* new_entity = entity;
 
-	// Obtain all forward references by a depth-first 
-	// traversal and add them to the file.
+	// Obtain all forward references and add them to the file. Instances
+	// referenced more than once are found in entity_file_map the second time.
 	if (parsing_complete_) {
 		try {
-			aggregate_of_instance::ptr entity_attributes = traverse(entity, 1);
-			for (aggregate_of_instance::it it = entity_attributes->begin(); it != entity_attributes->end(); ++it) {
-				if (*it != entity) {
-					entity_entity_map_t::iterator mit2 = entity_file_map.find((*it)->identity());
+			std::vector<IfcUtil::IfcBaseClass*> entity_attributes;
+			forward_references(entity, entity_attributes);
+			for (IfcUtil::IfcBaseClass* entity_attribute : entity_attributes) {
+				if (entity_attribute != entity) {
+					entity_entity_map_t::iterator mit2 = entity_file_map.find(entity_attribute->identity());
 					if (mit2 == entity_file_map.end()) {
-						entity_file_map.insert(entity_entity_map_t::value_type((*it)->identity(), addEntity(*it)));
+						entity_file_map.insert(entity_entity_map_t::value_type(entity_attribute->identity(), addEntity(entity_attribute)));
 					}
 				}
 			}
@@ -2017,46 +2025,18 @@ IfcUtil::IfcBaseClass* IfcFile::addEntity(IfcUtil::IfcBaseClass* entity, int id)
 	if (new_entity->declaration().is(*ifcroot_type_)) {
 		try {
 			const std::string guid = *new_entity->data().getArgument(0);
-			if ( byguid.find(guid) != byguid.end() ) {
+			if ( byguid.assign(guid, new_entity) != 0 ) {
 				std::stringstream ss;
 				ss << "Overwriting entity with guid " << guid;
 				Logger::Message(Logger::LOG_WARNING,ss.str());
 			}
-			byguid[guid] = new_entity;
 		} catch (const IfcException& ex) {
 			Logger::Message(Logger::LOG_ERROR,ex.what());
 		}
 	}
 
-	// The mapping by entity type is updated.
 	const IfcParse::declaration* ty = &new_entity->declaration();
 
-	if (ty->as_entity()) {
-		aggregate_of_instance::ptr insts = instances_by_type_excl_subtypes(ty);
-		if (!insts) {
-			insts = aggregate_of_instance::ptr(new aggregate_of_instance());
-			bytype_excl[ty] = insts;
-		}
-		insts->push(new_entity);
-	}
-
-	for (; ty->as_entity();) {
-		aggregate_of_instance::ptr insts = instances_by_type(ty);
-		if (!insts) {
-			insts = aggregate_of_instance::ptr(new aggregate_of_instance());
-			bytype[ty] = insts;
-		}
-		insts->push(new_entity);
-
-		const IfcParse::declaration* pt = ty->as_entity()->supertype();
-		if (pt) {
-			ty = pt;
-		}
-		else {
-			break;
-		}
-	}
-
 	if (ty->as_entity()) {
 		int new_id = -1;
 		if (!new_entity->data().file) {
@@ -2083,6 +2063,9 @@ IfcUtil::IfcBaseClass* IfcFile::addEntity(IfcUtil::IfcBaseClass* entity, int id)
 
 		// The mapping by entity instance name is updated.
 		byid[new_id] = new_entity;
+
+		// The mapping by entity type is updated.
+		index_type_(new_entity);
 	} else if (!new_entity->data().file) {
 		// For non-entity instances, no mappings are updated, but the file
 		// pointer has to be set, so that actual copies are created in subsequent
@@ -2132,6 +2115,10 @@ void IfcFile::removeEntity(IfcUtil::IfcBaseClass* entity) {
 }
 
 void IfcFile::process_deletion_() {
+	if (!batch_deletion_ids_.empty()) {
+		// Closures may contain the deleted instances
+		traversals_.clear();
+	}
 
 	for (auto& id : batch_deletion_ids_.get<0>()) {
 		auto entity = instance_by_id(id);
@@ -2204,12 +2191,7 @@ void IfcFile::process_deletion_() {
 		}
 
 		if (!batch_mode_) {
-			byref.erase(
-				byref.lower_bound({ id,-1,-1 }), 
-				byref.upper_bound({ id, std::numeric_limits<int>::max(), std::numeric_limits<int>::max() })
-			);
-
-			byref_excl.erase(id);
+			byref.erase(id);
 
 			// This is based on traversal which needs instances to still be contained in the map.
 			// another option would be to keep byid intact for the remainder of this loop
@@ -2220,20 +2202,14 @@ void IfcFile::process_deletion_() {
 				const unsigned int name = entity_attribute->data().id();
 				// Do not update inverses for simple types (which have id()==0 in IfcOpenShell).
 				if (name != 0) {
-					{
-						auto lower = byref.lower_bound({ name,-1,-1 });
-						auto upper = byref.upper_bound({ name, std::numeric_limits<int>::max(), std::numeric_limits<int>::max() });
-
-						for (auto byref_it = lower; byref_it != upper; ++byref_it) {
-							auto& ids = byref_it->second;
-							ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
-						}
-					}
-					{
-						auto byref_it = byref_excl.find(name);
-						if (byref_it != byref_excl.end()) {
-							auto& ids = byref_it->second;
-							ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+					auto byref_it = byref.find(name);
+					if (byref_it != byref.end()) {
+						auto& refs = byref_it->second;
+						refs.erase(std::remove_if(refs.begin(), refs.end(), [id](const inverse_ref& r) {
+							return r.id == id;
+						}), refs.end());
+						if (refs.empty()) {
+							byref.erase(byref_it);
 						}
 					}
 				}
@@ -2242,44 +2218,14 @@ void IfcFile::process_deletion_() {
 
 		if (entity->declaration().is(*ifcroot_type_)) {
 			const std::string global_id = *entity->data().getArgument(0);
-			auto it = byguid.find(global_id);
-			if (it != byguid.end()) {
-				byguid.erase(it);
-			}
-			else {
+			if (!byguid.erase(global_id)) {
 				Logger::Warning("GlobalId on rooted instance not encountered in map");
 			}
 		}
 
 		byid.erase(byid.find(id));
 
-		const IfcParse::declaration* ty = &entity->declaration();
-
-		{
-			aggregate_of_instance::ptr instances_of_same_type = instances_by_type_excl_subtypes(ty);
-			instances_of_same_type->remove(entity);
-			if (instances_of_same_type->size() == 0) {
-				bytype_excl.erase(ty);
-			}
-		}
-
-		for (;;) {
-			aggregate_of_instance::ptr instances_of_same_type = instances_by_type(ty);
-			if (instances_of_same_type) {
-				instances_of_same_type->remove(entity);
-			}
-			if (instances_of_same_type->size() == 0) {
-				bytype.erase(ty);
-			}
-
-			const IfcParse::declaration* pt = ty->as_entity()->supertype();
-			if (pt) {
-				ty = pt;
-			}
-			else {
-				break;
-			}
-		}
+		unindex_type_(entity);
 
 		// entity_file_map is in place to prevent duplicate definitions with usage of add().
 		// Upon deletion the pairs need to be erased.
@@ -2295,33 +2241,21 @@ void IfcFile::process_deletion_() {
 
 	}
 	
-	if (batch_mode_) {
-		for (auto it = byref.begin(); it != byref.end();) {
-			bool do_delete = batch_deletion_ids_.get<1>().find(std::get<INSTANCE_ID>(it->first)) != batch_deletion_ids_.get<1>().end();
-			if (!do_delete) {
-				it->second.erase(std::remove_if(it->second.begin(), it->second.end(), [this](int x) {
-					return batch_deletion_ids_.get<1>().find(x) != batch_deletion_ids_.get<1>().end();
-				}), it->second.end());
-				do_delete = it->second.empty();
-			}
-			if (do_delete) {
-				it = byref.erase(it);
-			}
-			else {
-				++it;
-			}
-		}
+	if (batch_mode_ && !batch_deletion_ids_.empty()) {
+		// Includes the changes made above to instances that referenced the
+		// deleted ones.
+		apply_inverse_deltas_();
 
-		for (auto it = byref_excl.begin(); it != byref_excl.end();) {
+		for (auto it = byref.begin(); it != byref.end();) {
 			bool do_delete = batch_deletion_ids_.get<1>().find(it->first) != batch_deletion_ids_.get<1>().end();
 			if (!do_delete) {
-				it->second.erase(std::remove_if(it->second.begin(), it->second.end(), [this](int x) {
-					return batch_deletion_ids_.get<1>().find(x) != batch_deletion_ids_.get<1>().end();
+				it->second.erase(std::remove_if(it->second.begin(), it->second.end(), [this](const inverse_ref& r) {
+					return batch_deletion_ids_.get<1>().find(r.id) != batch_deletion_ids_.get<1>().end();
 				}), it->second.end());
 				do_delete = it->second.empty();
 			}
 			if (do_delete) {
-				it = byref_excl.erase(it);
+				it = byref.erase(it);
 			} else {
 				++it;
 			}
@@ -2331,9 +2265,96 @@ void IfcFile::process_deletion_() {
 	batch_deletion_ids_.clear();
 }
 
-aggregate_of_instance::ptr IfcFile::instances_by_type(const IfcParse::declaration* t) {
+void IfcFile::index_type_(IfcUtil::IfcBaseClass* instance) {
+	const IfcParse::declaration* ty = &instance->declaration();
+	aggregate_of_instance::ptr insts = instances_by_type_excl_subtypes(ty);
+	if (!insts) {
+		insts = aggregate_of_instance::ptr(new aggregate_of_instance());
+		bytype_excl[ty] = insts;
+	}
+	insts->push(instance);
+	bytype_ids[ty].add(instance->data().id());
+	invalidate_type_cache_(ty);
+}
+
+void IfcFile::unindex_type_(IfcUtil::IfcBaseClass* instance) {
+	const IfcParse::declaration* ty = &instance->declaration();
+	aggregate_of_instance::ptr insts = instances_by_type_excl_subtypes(ty);
+	if (insts) {
+		insts->remove(instance);
+		if (insts->size() == 0) {
+			bytype_excl.erase(ty);
+		}
+	}
+	auto it = bytype_ids.find(ty);
+	if (it != bytype_ids.end()) {
+		it->second.remove(instance->data().id());
+		if (it->second.empty()) {
+			bytype_ids.erase(it);
+		}
+	}
+	invalidate_type_cache_(ty);
+}
+
+void IfcFile::invalidate_type_cache_(const IfcParse::declaration* ty) {
+	std::lock_guard<std::mutex> lock(type_cache_mutex_);
+	// Subtype-inclusive results are cached on every supertype in the chain.
+	for (; ty && ty->as_entity(); ty = ty->as_entity()->supertype()) {
+		bytype.erase(ty);
+		bytype_ids_incl.erase(ty);
+	}
+}
+
+const vulcan::RoaringBitmap& IfcFile::ids_by_type(const IfcParse::declaration* t) const {
+	// Cached entries are only erased when the file changes, so the
+	// reference stays valid after the lock is released.
+	std::lock_guard<std::mutex> lock(type_cache_mutex_);
+	return ids_by_type_(t);
+}
+
+const vulcan::RoaringBitmap& IfcFile::ids_by_type_(const IfcParse::declaration* t) const {
+	if (t == nullptr || t->as_entity() == nullptr) {
+		return ids_by_type_excl_subtypes(t);
+	}
+	ids_by_type_t::const_iterator it = bytype_ids_incl.find(t);
+	if (it != bytype_ids_incl.end()) {
+		return it->second;
+	}
+	// The union is computed over the subtype closure, caching the
+	// intermediate results for the subtypes along the way.
+	vulcan::RoaringBitmap ids = ids_by_type_excl_subtypes(t);
+	for (const IfcParse::entity* subtype : t->as_entity()->subtypes()) {
+		ids |= ids_by_type_(subtype);
+	}
+	return bytype_ids_incl[t] = std::move(ids);
+}
+
+const vulcan::RoaringBitmap& IfcFile::ids_by_type_excl_subtypes(const IfcParse::declaration* t) const {
+	static const vulcan::RoaringBitmap empty;
+	ids_by_type_t::const_iterator it = bytype_ids.find(t);
+	return (it == bytype_ids.end()) ? empty : it->second;
+}
+
+aggregate_of_instance::ptr IfcFile::instances_by_type(const IfcParse::declaration* t) const {
+	std::lock_guard<std::mutex> lock(type_cache_mutex_);
+	return instances_by_type_(t);
+}
+
+aggregate_of_instance::ptr IfcFile::instances_by_type_(const IfcParse::declaration* t) const {
 	entities_by_type_t::const_iterator it = bytype.find(t);
-	return (it == bytype.end()) ? aggregate_of_instance::ptr() : it->second;
+	if (it != bytype.end()) {
+		return it->second;
+	}
+	const vulcan::RoaringBitmap& ids = ids_by_type_(t);
+	if (ids.empty()) {
+		return aggregate_of_instance::ptr();
+	}
+	aggregate_of_instance::ptr insts(new aggregate_of_instance());
+	ids.for_each([this, &insts](uint32_t id) {
+		insts->push(byid.find(id)->second);
+	});
+	bytype[t] = insts;
+	return insts;
 }
 
 aggregate_of_instance::ptr IfcFile::instances_by_type_excl_subtypes(const IfcParse::declaration* t) {
@@ -2350,9 +2371,13 @@ aggregate_of_instance::ptr IfcFile::instances_by_type_excl_subtypes(const std::s
 }
 
 aggregate_of_instance::ptr IfcFile::instances_by_reference(int t) {
+	apply_inverse_deltas_();
 	aggregate_of_instance::ptr ret(new aggregate_of_instance);
-	for (auto& i : byref_excl[t]) {
-		ret->push(instance_by_id(i));
+	auto it = byref.find(t);
+	if (it != byref.end()) {
+		for (auto& r : it->second) {
+			ret->push(instance_by_id(r.id));
+		}
 	}
 	return ret;
 }
@@ -2366,12 +2391,49 @@ IfcUtil::IfcBaseClass* IfcFile::instance_by_id(int id) {
 }
 
 IfcUtil::IfcBaseClass* IfcFile::instance_by_guid(const std::string& guid) {
-	entity_by_guid_t::const_iterator it = byguid.find(guid);
-	if ( it == byguid.end() ) {
+	IfcUtil::IfcBaseClass* instance = byguid.find(guid);
+	if ( instance == 0 ) {
 		throw IfcException("Instance with GlobalId '" + guid + "' not found");
-	} else {
-		return it->second;
 	}
+	return instance;
+}
+
+IfcUtil::IfcBaseClass* IfcFile::instance_by_guid(const IfcGuid& guid) {
+	IfcUtil::IfcBaseClass* instance = byguid.find(guid);
+	if ( instance == 0 ) {
+		throw IfcException("Instance with GlobalId '" + IfcGlobalId::encode(guid) + "' not found");
+	}
+	return instance;
+}
+
+IfcUtil::IfcBaseClass* IfcFile::entity_by_guid_t::find(const std::string& guid) const {
+	IfcGuid binary;
+	if (IfcGlobalId::decode(guid, binary)) {
+		return find(binary);
+	}
+	std::map<std::string, IfcUtil::IfcBaseClass*>::const_iterator it = text_.find(guid);
+	return it == text_.end() ? 0 : it->second;
+}
+
+IfcUtil::IfcBaseClass* IfcFile::entity_by_guid_t::find(const IfcGuid& guid) const {
+	auto it = binary_.find(guid);
+	return it == binary_.end() ? 0 : it->second;
+}
+
+IfcUtil::IfcBaseClass* IfcFile::entity_by_guid_t::assign(const std::string& guid, IfcUtil::IfcBaseClass* instance) {
+	IfcGuid binary;
+	IfcUtil::IfcBaseClass*& slot = IfcGlobalId::decode(guid, binary) ? binary_[binary] : text_[guid];
+	IfcUtil::IfcBaseClass* previous = slot;
+	slot = instance;
+	return previous;
+}
+
+bool IfcFile::entity_by_guid_t::erase(const std::string& guid) {
+	IfcGuid binary;
+	if (IfcGlobalId::decode(guid, binary)) {
+		return binary_.erase(binary) != 0;
+	}
+	return text_.erase(guid) != 0;
 }
 
 // FIXME: Test destructor to delete entity and arg allocations
@@ -2407,11 +2469,26 @@ IfcFile::type_iterator IfcFile::types_end() const {
 }
 
 IfcFile::type_iterator IfcFile::types_incl_super_begin() const {
-	return bytype.begin();
+	// The supertype lists are computed on demand, make sure every one of
+	// them is in the cache before iterating. Every type with instances is
+	// then cached, so concurrent lookups no longer insert into bytype.
+	std::lock_guard<std::mutex> lock(type_cache_mutex_);
+	for (const auto& pair : bytype_excl) {
+		for (const IfcParse::declaration* ty = pair.first; ty && ty->as_entity(); ty = ty->as_entity()->supertype()) {
+			instances_by_type_(ty);
+		}
+	}
+	return bytype.cbegin();
 }
 
 IfcFile::type_iterator IfcFile::types_incl_super_end() const {
-	return bytype.end();
+	return bytype.cend();
+}
+
+void IfcFile::clear_type_cache() {
+	std::lock_guard<std::mutex> lock(type_cache_mutex_);
+	bytype.clear();
+	bytype_ids_incl.clear();
 }
 
 namespace {
@@ -2459,43 +2536,15 @@ std::string IfcFile::createTimestamp() const {
 }
 
 std::vector<int> IfcFile::get_inverse_indices(int instance_id) {
+	apply_inverse_deltas_();
 	std::vector<int> return_value;
-	
-	auto lower = byref.lower_bound({ instance_id, -1, -1 });
-	auto upper = byref.upper_bound({ instance_id, std::numeric_limits<int>::max(), std::numeric_limits<int>::max() });
-
-	// Mapping of instance id to attribute offset.
-	std::map<int, std::vector<int>> mapping;
-	
-	for (auto it = lower; it != upper; ++it) {
-		for (auto& i : it->second) {
-			// We only take the tuple for the type that id=i actually is, in order not
-			// to count double. Because byref contains mappings for every supertype of id=i.
-			if (instance_by_id(i)->declaration().index_in_schema() == std::get<1>(it->first)) {
-				mapping[i].push_back(std::get<2>(it->first));
-			}
-		}
-	}
-
-	auto refs = instances_by_reference(instance_id);
-
-	for (auto& r : *refs) {
-		auto it = mapping.find(r->data().id());
-		if (it == mapping.end() || it->second.empty()) {
-			throw IfcException("Internal error");
+	// Same order as instances_by_reference()
+	auto it = byref.find(instance_id);
+	if (it != byref.end()) {
+		for (auto& r : it->second) {
+			return_value.push_back(r.attribute_index);
 		}
-		return_value.push_back(it->second.front());
-		it->second.erase(it->second.begin());
-		if (it->second.empty()) {
-			mapping.erase(it);
-		}
-	}
-
-	// Test whether all mappings where indeed used.
-	if (!mapping.empty()) {
-		throw IfcException("Internal error");
 	}
-
 	return return_value;
 }
 
@@ -2503,34 +2552,31 @@ aggregate_of_instance::ptr IfcFile::getInverse(int instance_id, const IfcParse::
 	if (type == nullptr && attribute_index == -1) {
 		return instances_by_reference(instance_id);
 	}
-	
+
+	apply_inverse_deltas_();
 	aggregate_of_instance::ptr return_value(new aggregate_of_instance);
-	
-	if (attribute_index == -1) {
-		auto lower = byref.lower_bound({ instance_id, type->index_in_schema(), -1 });
-		auto upper = byref.upper_bound({ instance_id, type->index_in_schema(), std::numeric_limits<int>::max() });
 
-		for (auto it = lower; it != upper; ++it) {
-			for (auto& i : it->second) {
-				return_value->push(instance_by_id(i));
+	auto it = byref.find(instance_id);
+	if (it != byref.end()) {
+		for (auto& r : it->second) {
+			if (attribute_index != -1 && r.attribute_index != attribute_index) {
+				continue;
 			}
-		}
-	} else {
-		auto it = byref.find({ instance_id, type->index_in_schema(), attribute_index });
-		if (it != byref.end()) {
-			for (auto& i : it->second) {
-				return_value->push(instance_by_id(i));
+			IfcUtil::IfcBaseClass* inst = instance_by_id(r.id);
+			if (type == nullptr || inst->declaration().is(*type)) {
+				return_value->push(inst);
 			}
 		}
 	}
 
-
 	return return_value;
 }
 
 
 int IfcFile::getTotalInverses(int instance_id) {
-	return byref_excl[instance_id].size();
+	apply_inverse_deltas_();
+	auto it = byref.find(instance_id);
+	return it == byref.end() ? 0 : (int) it->second.size();
 }
 
 
@@ -2633,13 +2679,7 @@ std::pair<IfcUtil::IfcBaseClass*, double> IfcFile::getUnit(const std::string& un
 void IfcParse::IfcFile::build_inverses_(IfcUtil::IfcBaseClass* inst) {
 	std::function<void(IfcUtil::IfcBaseClass*,int)> fn = [this, inst](IfcUtil::IfcBaseClass* attr, int idx) {
 		if (attr->declaration().as_entity()) {
-			unsigned entity_attribute_id = attr->data().id();
-			auto decl = inst->declaration().as_entity();
-			byref_excl[entity_attribute_id].push_back(inst->data().id());
-			while (decl) {
-				byref[{entity_attribute_id, decl->index_in_schema(), idx}].push_back(inst->data().id());
-				decl = decl->supertype();
-			}
+			register_inverse(inst->data().id(), inst->declaration().as_entity(), attr, idx);
 		}
 	};
 	
@@ -36,6 +36,7 @@
 #endif
 
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <iostream>
 #include <vector>
@@ -132,6 +133,9 @@ namespace IfcParse {
 		static std::string asString(const Token& t);
 		/// Returns the token as a string in internal buffer (for optimization purposes)
 		static const std::string &asStringRef(const Token& t);
+		/// Returns a keyword token as a view into the file buffer when it is
+		/// stored contiguously, otherwise into the internal buffer
+		static std::string_view asKeywordView(const Token& t);
 		/// Returns the token as a string (without the dot or apostrophe)
 		static boost::dynamic_bitset<> asBinary(const Token& t);
 		/// Returns a string representation of the token (including the dot or apostrophe)
@@ -268,7 +272,7 @@ namespace IfcParse {
 
 	IFC_PARSE_API aggregate_of_instance::ptr traverse(IfcUtil::IfcBaseClass* instance, int max_level = -1);
 
-	IFC_PARSE_API aggregate_of_instance::ptr traverse_breadth_first(IfcUtil::IfcBaseClass* instance, int max_level = -1);
+	IFC_PARSE_API aggregate_of_instance::ptr traverse_breadth_first(IfcUtil::IfcBaseClass* instance, int max_level = -1, unsigned threads = 1);
 }
 
 IFC_PARSE_API std::ostream& operator<< (std::ostream& os, const IfcParse::IfcFile& f);
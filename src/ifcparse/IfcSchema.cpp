@@ -1,7 +1,16 @@
 #include "IfcSchema.h"
 #include "../ifcparse/IfcBaseClass.h"
+#include "../ifcparse/IfcLogger.h"
 
 #include <map>
+#include <mutex>
+#include <set>
+#include <cstring>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
 
 bool IfcParse::declaration::is(const std::string& name) const {
 	const std::string* name_ptr = &name;
@@ -68,9 +77,62 @@ IfcParse::schema_definition::schema_definition(const std::string& name, const st
 		if ((**it).as_enumeration_type()) enumeration_types_.push_back((**it).as_enumeration_type());
 		if ((**it).as_entity()) entities_.push_back((**it).as_entity());
 	}
+	build_keyword_table_();
 	schemas[name_] = this;
 }
 
+void IfcParse::schema_definition::build_keyword_table_() {
+	const size_t n = declarations_.size();
+	size_t num_slots = 1, num_buckets = 1;
+	while (num_slots < n + n / 2) num_slots <<= 1;
+	while (num_buckets < n / 4) num_buckets <<= 1;
+	keyword_seeds_.assign(num_buckets, 0);
+	keyword_slots_.assign(num_slots, -1);
+
+	std::vector<uint64_t> hashes(n);
+	std::vector<std::vector<int> > buckets(num_buckets);
+	for (size_t i = 0; i < n; ++i) {
+		hashes[i] = keyword_hash_(declarations_[i]->name_uc());
+		buckets[keyword_bucket_(hashes[i])].push_back(static_cast<int>(i));
+	}
+
+	// Place the largest buckets first, while most slots are still free
+	std::vector<size_t> order(num_buckets);
+	for (size_t b = 0; b < num_buckets; ++b) order[b] = b;
+	std::stable_sort(order.begin(), order.end(), [&buckets](size_t a, size_t b) {
+		return buckets[a].size() > buckets[b].size();
+	});
+
+	const uint32_t max_seed = 1 << 20;
+	std::vector<size_t> slots;
+	for (size_t b : order) {
+		const std::vector<int>& keys = buckets[b];
+		if (keys.empty()) break;
+		uint32_t seed = 0;
+		for (; seed < max_seed; ++seed) {
+			slots.clear();
+			for (int key : keys) {
+				size_t slot = keyword_slot_(hashes[key], seed);
+				if (keyword_slots_[slot] != -1 || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+					break;
+				}
+				slots.push_back(slot);
+			}
+			if (slots.size() == keys.size()) break;
+		}
+		if (seed == max_seed) {
+			// Only happens for names with equal 64-bit hashes
+			keyword_seeds_.clear();
+			keyword_slots_.clear();
+			return;
+		}
+		keyword_seeds_[b] = seed;
+		for (size_t i = 0; i < keys.size(); ++i) {
+			keyword_slots_[slots[i]] = keys[i];
+		}
+	}
+}
+
 IfcParse::schema_definition::~schema_definition() {
 	for (std::vector<const declaration*>::const_iterator it = declarations_.begin(); it != declarations_.end(); ++it) {
 		delete *it;
@@ -128,6 +190,80 @@ void IfcParse::register_schema(schema_definition* s) {
 #include "../ifcparse/Ifc4x3_add2.h"
 #endif
 
+namespace {
+	// Schemas that are not compiled in (HAS_SCHEMA_*) are built as separate
+	// shared libraries, libvulcan_schema_<name>.so, exporting the entry points
+	// in IfcSchemaPlugin.cpp. They are opened on first use and never closed,
+	// since instances keep pointers into their declarations and vtables.
+	typedef const IfcParse::schema_definition* (*load_schema_fn)();
+	typedef void (*clear_schema_fn)();
+
+	std::recursive_mutex plugin_mutex;
+	std::map<std::string, clear_schema_fn> loaded_plugins;
+
+	const char* const plugin_prefix = "libvulcan_schema_";
+#ifdef _WIN32
+	const char* const plugin_suffix = ".dll";
+#elif defined(__APPLE__)
+	const char* const plugin_suffix = ".dylib";
+#else
+	const char* const plugin_suffix = ".so";
+#endif
+
+	// VULCAN_SCHEMA_PATH overrides the directory configured at build time; an
+	// empty result leaves the search to the dynamic loader (rpath etc.)
+	std::string plugin_directory() {
+		const char* env = getenv("VULCAN_SCHEMA_PATH");
+		if (env && *env) {
+			return env;
+		}
+#ifdef VULCAN_SCHEMA_DIR
+		return VULCAN_SCHEMA_DIR;
+#else
+		return std::string();
+#endif
+	}
+
+	bool load_schema_plugin(const std::string& name_uc) {
+#ifdef _WIN32
+		return false;
+#else
+		if (loaded_plugins.find(name_uc) != loaded_plugins.end()) {
+			return true;
+		}
+		if (name_uc.empty() || name_uc.find_first_of("/\\.") != std::string::npos) {
+			return false;
+		}
+		const std::string file_name = plugin_prefix + boost::to_lower_copy(name_uc) + plugin_suffix;
+		const std::string dir = plugin_directory();
+		void* handle = nullptr;
+		if (!dir.empty()) {
+			handle = dlopen((std::filesystem::path(dir) / file_name).c_str(), RTLD_NOW | RTLD_LOCAL);
+		}
+		if (!handle) {
+			handle = dlopen(file_name.c_str(), RTLD_NOW | RTLD_LOCAL);
+		}
+		if (!handle) {
+			Logger::Message(Logger::LOG_DEBUG, std::string("Unable to load schema plugin: ") + dlerror());
+			return false;
+		}
+		load_schema_fn load = (load_schema_fn) dlsym(handle, "vulcan_load_schema");
+		clear_schema_fn clear = (clear_schema_fn) dlsym(handle, "vulcan_clear_schema");
+		if (!load || !clear) {
+			Logger::Message(Logger::LOG_ERROR, file_name + " is not a schema plugin");
+			dlclose(handle);
+			return false;
+		}
+		const IfcParse::schema_definition* schema = load();
+		if (boost::to_upper_copy(schema->name()) != name_uc) {
+			Logger::Message(Logger::LOG_ERROR, file_name + " provides schema " + schema->name());
+		}
+		loaded_plugins[name_uc] = clear;
+		return true;
+#endif
+	}
+}
+
 const IfcParse::schema_definition* IfcParse::schema_by_name(const std::string& name) {
 	// TODO: initialize automatically somehow
 #ifdef HAS_SCHEMA_2x3
@@ -167,7 +303,12 @@ const IfcParse::schema_definition* IfcParse::schema_by_name(const std::string& n
    Ifc4x3_add2::get_schema();
 #endif
 
-	std::map<std::string, const IfcParse::schema_definition*>::const_iterator it = schemas.find(boost::to_upper_copy(name));
+	const std::string name_uc = boost::to_upper_copy(name);
+	std::lock_guard<std::recursive_mutex> lock(plugin_mutex);
+	std::map<std::string, const IfcParse::schema_definition*>::const_iterator it = schemas.find(name_uc);
+	if (it == schemas.end() && load_schema_plugin(name_uc)) {
+		it = schemas.find(name_uc);
+	}
 	if (it == schemas.end()) {
 		throw IfcParse::IfcException("No schema named " + name);
 	}
@@ -181,10 +322,25 @@ std::vector<std::string> IfcParse::schema_names() {
 	} catch (IfcParse::IfcException&) {}
 
 	// Populate vector with map keys
-	std::vector<std::string> return_value;
+	std::lock_guard<std::recursive_mutex> lock(plugin_mutex);
+	std::set<std::string> names;
 	for (auto& pair : schemas) {
-		return_value.push_back(pair.first);
+		names.insert(pair.first);
+	}
+
+	// Plugins that are available but not loaded yet are listed by file name
+	const std::string dir = plugin_directory();
+	std::error_code ec;
+	if (!dir.empty() && std::filesystem::is_directory(dir, ec)) {
+		for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+			const std::string file_name = entry.path().filename().string();
+			if (boost::starts_with(file_name, plugin_prefix) && boost::ends_with(file_name, plugin_suffix)) {
+				const size_t length = file_name.size() - strlen(plugin_prefix) - strlen(plugin_suffix);
+				names.insert(boost::to_upper_copy(file_name.substr(strlen(plugin_prefix), length)));
+			}
+		}
 	}
+	std::vector<std::string> return_value(names.begin(), names.end());
 
 	return return_value;
 }
@@ -227,6 +383,13 @@ void IfcParse::clear_schemas() {
 	Ifc4x3_add2::clear_schema();
 #endif
 
+	std::lock_guard<std::recursive_mutex> lock(plugin_mutex);
+	for (auto& pair : loaded_plugins) {
+		pair.second();
+		schemas.erase(pair.first);
+	}
+	loaded_plugins.clear();
+
 	// clear any remaining registered schemas
 	// we pop schemas until map is empty, because map iteration is invalidated after each erasure
 	while (!schemas.empty()) {
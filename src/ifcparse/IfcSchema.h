@@ -20,7 +20,9 @@
 #ifndef IFCSCHEMA_H
 #define IFCSCHEMA_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 #include <iterator>
@@ -423,6 +425,45 @@ namespace IfcParse {
 
 		instance_factory* factory_;
 
+		// Perfect hash from upper case name to index in declarations_,
+		// built once per schema. A key selects a bucket from the high
+		// bits of its hash; the bucket's seed, mixed with the hash, gives
+		// a slot that no other name maps to. Empty when construction
+		// failed, in which case the binary search is used.
+		std::vector<uint32_t> keyword_seeds_;
+		std::vector<int> keyword_slots_;
+
+		static char keyword_upper_(char c) {
+			return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+		}
+
+		// FNV-1a over the upper cased name, so lookups need no copy
+		static uint64_t keyword_hash_(std::string_view name) {
+			uint64_t h = 14695981039346656037ULL;
+			for (char c : name) {
+				h ^= static_cast<unsigned char>(keyword_upper_(c));
+				h *= 1099511628211ULL;
+			}
+			return h;
+		}
+
+		static uint64_t keyword_mix_(uint64_t h) {
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdULL;
+			h ^= h >> 33;
+			return h;
+		}
+
+		size_t keyword_bucket_(uint64_t h) const {
+			return (h >> 32) & (keyword_seeds_.size() - 1);
+		}
+
+		size_t keyword_slot_(uint64_t h, uint32_t seed) const {
+			return keyword_mix_(h ^ seed) & (keyword_slots_.size() - 1);
+		}
+
+		void build_keyword_table_();
+
 		std::string& temp_string_() const {
 			static my_thread_local std::string s;
 			return s;
@@ -434,19 +475,37 @@ namespace IfcParse {
 
 		~schema_definition();
 
-		const declaration* declaration_by_name(const std::string& name) const {
-			const std::string* name_ptr = &name;
-			if (std::any_of(name.begin(), name.end(), [](char c) { return std::islower(c); })) {
-				temp_string_() = name;
+		/// Case insensitive lookup, returns null if the name is not declared
+		const declaration* find_declaration(std::string_view name) const {
+			if (keyword_slots_.empty()) {
+				temp_string_().assign(name.data(), name.size());
 				boost::to_upper(temp_string_());
-				name_ptr = &temp_string_();
+				std::vector<const declaration*>::const_iterator it = std::lower_bound(declarations_.begin(), declarations_.end(), temp_string_(), declaration_by_name_cmp());
+				return it == declarations_.end() || (**it).name_uc() != temp_string_() ? 0 : *it;
+			}
+			uint64_t h = keyword_hash_(name);
+			int index = keyword_slots_[keyword_slot_(h, keyword_seeds_[keyword_bucket_(h)])];
+			if (index < 0) {
+				return 0;
+			}
+			const std::string& uc = declarations_[index]->name_uc();
+			if (uc.size() != name.size()) {
+				return 0;
 			}
-			std::vector<const declaration*>::const_iterator it = std::lower_bound(declarations_.begin(), declarations_.end(), *name_ptr, declaration_by_name_cmp());
-			if (it == declarations_.end() || (**it).name_uc() != *name_ptr) {
-				throw IfcParse::IfcException("Entity with name '" + name + "' not found in schema '" + name_ + "'");
-			} else {
-				return *it;
+			for (size_t i = 0; i < name.size(); ++i) {
+				if (keyword_upper_(name[i]) != uc[i]) {
+					return 0;
+				}
+			}
+			return declarations_[index];
+		}
+
+		const declaration* declaration_by_name(std::string_view name) const {
+			const declaration* decl = find_declaration(name);
+			if (decl == 0) {
+				throw IfcParse::IfcException("Entity with name '" + std::string(name) + "' not found in schema '" + name_ + "'");
 			}
+			return decl;
 		}
 
 		const declaration* declaration_by_name(int name) const {
@@ -464,6 +523,7 @@ namespace IfcParse {
 		IfcUtil::IfcBaseClass* instantiate(IfcEntityInstanceData* data) const;
 	};
 
+	// Schemas not compiled in are loaded from their plugin library on first use
 	IFC_PARSE_API const schema_definition* schema_by_name(const std::string&);
 
 	IFC_PARSE_API std::vector<std::string> schema_names();
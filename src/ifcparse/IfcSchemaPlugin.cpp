@@ -0,0 +1,23 @@
+// Entry points of a schema plugin library, libvulcan_schema_<name>.so. The
+// file is compiled once per schema, together with IfcX.cpp and
+// IfcX-schema.cpp, with IFC_SCHEMA_HEADER and IFC_SCHEMA_NAMESPACE naming the
+// generated schema. IfcParse::schema_by_name() opens the library on first use
+// and resolves these symbols, see IfcSchema.cpp.
+
+#ifndef IFC_SCHEMA_HEADER
+#error IFC_SCHEMA_HEADER must name the generated schema header
+#endif
+
+#include "../ifcparse/IfcSchema.h"
+#include IFC_SCHEMA_HEADER
+
+// Populates the schema, which registers itself in the schema map of the core
+extern "C" __attribute__((visibility("default")))
+const IfcParse::schema_definition* vulcan_load_schema() {
+	return &IFC_SCHEMA_NAMESPACE::get_schema();
+}
+
+extern "C" __attribute__((visibility("default")))
+void vulcan_clear_schema() {
+	IFC_SCHEMA_NAMESPACE::clear_schema();
+}
@@ -76,6 +76,10 @@ namespace IfcParse {
 		bool is_eof_at(unsigned int);
 		void increment_at(unsigned int&);
 		char peek_at(unsigned int);
+		/// Pointer into the in-memory file at the specified offset
+		const char* data_at(unsigned int);
+		/// Number of bytes in the file from the specified offset onwards
+		unsigned int remaining_at(unsigned int);
 	};
 }
 
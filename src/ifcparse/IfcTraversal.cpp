@@ -0,0 +1,195 @@
+// Copyright 2023 VulcanDB
+
+#include "../ifcparse/IfcTraversal.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "../ifcparse/IfcBaseClass.h"
+#include "../ifcparse/IfcParse.h"
+
+using namespace IfcParse;
+
+bool visited_set::insert(IfcUtil::IfcBaseClass* instance) {
+	const unsigned id = instance->data().id();
+	if (id == 0) {
+		return unnamed_.insert(instance).second;
+	}
+	const size_t word = id >> 6;
+	if (word >= words_.size()) {
+		words_.resize((std::max)(word + 1, words_.size() * 2), 0);
+	}
+	const uint64_t bit = uint64_t(1) << (id & 63);
+	if (words_[word] & bit) {
+		return false;
+	}
+	if (words_[word] == 0) {
+		touched_.push_back((uint32_t) word);
+	}
+	words_[word] |= bit;
+	return true;
+}
+
+bool visited_set::contains(IfcUtil::IfcBaseClass* instance) const {
+	const unsigned id = instance->data().id();
+	if (id == 0) {
+		return unnamed_.find(instance) != unnamed_.end();
+	}
+	const size_t word = id >> 6;
+	return word < words_.size() && (words_[word] & (uint64_t(1) << (id & 63))) != 0;
+}
+
+void visited_set::clear() {
+	for (uint32_t word : touched_) {
+		words_[word] = 0;
+	}
+	touched_.clear();
+	unnamed_.clear();
+}
+
+namespace {
+	thread_local std::vector<std::unique_ptr<visited_set> > thread_visited_sets;
+	thread_local size_t thread_visited_depth = 0;
+}
+
+thread_visited_set::thread_visited_set() {
+	if (thread_visited_sets.size() <= thread_visited_depth) {
+		thread_visited_sets.emplace_back(new visited_set);
+	}
+	set_ = thread_visited_sets[thread_visited_depth++].get();
+	set_->clear();
+}
+
+thread_visited_set::~thread_visited_set() {
+	--thread_visited_depth;
+}
+
+void IfcParse::forward_references(IfcUtil::IfcBaseClass* instance, std::vector<IfcUtil::IfcBaseClass*>& children) {
+	IfcEntityInstanceData& data = instance->data();
+	for (size_t i = 0; i < data.getArgumentCount(); ++i) {
+		Argument* attr = data.getArgument(i);
+		if (!attr) {
+			continue;
+		}
+		switch (attr->type()) {
+		case IfcUtil::Argument_ENTITY_INSTANCE: {
+			IfcUtil::IfcBaseClass* inst = *attr;
+			if (inst) {
+				children.push_back(inst);
+			}
+			break; }
+		case IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE: {
+			aggregate_of_instance::ptr list = *attr;
+			children.insert(children.end(), list->begin(), list->end());
+			break; }
+		case IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_ENTITY_INSTANCE: {
+			aggregate_of_aggregate_of_instance::ptr list = *attr;
+			for (aggregate_of_aggregate_of_instance::outer_it it = list->begin(); it != list->end(); ++it) {
+				children.insert(children.end(), it->begin(), it->end());
+			}
+			break; }
+		default:
+			break;
+		}
+	}
+}
+
+aggregate_of_instance::ptr IfcParse::traverse_depth_first(IfcUtil::IfcBaseClass* instance, int max_level, visited_set& visited) {
+	aggregate_of_instance::ptr result(new aggregate_of_instance);
+	std::vector<std::pair<IfcUtil::IfcBaseClass*, int> > stack;
+	std::vector<IfcUtil::IfcBaseClass*> children;
+
+	stack.push_back({ instance, 0 });
+	while (!stack.empty()) {
+		const std::pair<IfcUtil::IfcBaseClass*, int> top = stack.back();
+		stack.pop_back();
+		if (!visited.insert(top.first)) {
+			continue;
+		}
+		result->push(top.first);
+
+		if (top.second >= max_level && max_level > 0) {
+			continue;
+		}
+
+		// Pushed in reverse, so that the first child is expanded first and its
+		// descendants are visited before the second child, as in a recursive
+		// traversal.
+		children.clear();
+		forward_references(top.first, children);
+		for (auto it = children.rbegin(); it != children.rend(); ++it) {
+			if (!visited.contains(*it)) {
+				stack.push_back({ *it, top.second + 1 });
+			}
+		}
+	}
+
+	return result;
+}
+
+aggregate_of_instance::ptr IfcParse::traverse_levels(IfcUtil::IfcBaseClass* instance, int max_level, visited_set& visited, unsigned threads) {
+	aggregate_of_instance::ptr result(new aggregate_of_instance);
+	std::vector<IfcUtil::IfcBaseClass*> frontier, next;
+	std::vector<std::vector<IfcUtil::IfcBaseClass*> > children(1);
+
+	visited.insert(instance);
+	result->push(instance);
+	frontier.push_back(instance);
+
+	for (int level = 0; !frontier.empty() && (max_level <= 0 || level < max_level); ++level) {
+		size_t workers = 1;
+		if (threads > 1 && frontier.size() >= parallel_frontier) {
+			workers = (std::min)((size_t) threads, frontier.size() / (parallel_frontier / 4));
+		}
+		if (children.size() < workers) {
+			children.resize(workers);
+		}
+
+		if (workers == 1) {
+			children[0].clear();
+			for (IfcUtil::IfcBaseClass* inst : frontier) {
+				forward_references(inst, children[0]);
+			}
+		} else {
+			for (IfcUtil::IfcBaseClass* inst : frontier) {
+				if (inst->data().attributes() == 0) {
+					inst->data().load();
+				}
+			}
+
+			// Every worker collects the references of a contiguous part of the
+			// frontier, merged below in frontier order.
+			const size_t chunk = (frontier.size() + workers - 1) / workers;
+			auto expand = [&frontier, &children, chunk](size_t w) {
+				children[w].clear();
+				const size_t end = (std::min)(frontier.size(), (w + 1) * chunk);
+				for (size_t i = w * chunk; i < end; ++i) {
+					forward_references(frontier[i], children[w]);
+				}
+			};
+			std::vector<std::thread> pool;
+			for (size_t w = 1; w < workers; ++w) {
+				pool.emplace_back(expand, w);
+			}
+			expand(0);
+			for (std::thread& t : pool) {
+				t.join();
+			}
+		}
+
+		next.clear();
+		for (size_t w = 0; w < workers; ++w) {
+			for (IfcUtil::IfcBaseClass* inst : children[w]) {
+				if (visited.insert(inst)) {
+					next.push_back(inst);
+					result->push(inst);
+				}
+			}
+		}
+		frontier.swap(next);
+	}
+
+	return result;
+}
@@ -0,0 +1,78 @@
+// Copyright 2023 VulcanDB
+
+#ifndef IFCTRAVERSAL_H
+#define IFCTRAVERSAL_H
+
+#include <stdint.h>
+
+#include <unordered_set>
+#include <vector>
+
+#include "ifc_parse_api.h"
+#include "../ifcparse/aggregate_of_instance.h"
+
+namespace IfcUtil {
+	class IfcBaseClass;
+}
+
+namespace IfcParse {
+
+	/// Set of instances visited by a traversal. Entity instances are tracked
+	/// in a dense bitset indexed by instance name. clear() only resets the
+	/// words that were set, so one set can be reused across traversals at a
+	/// cost proportional to the size of the previous result. Instances
+	/// without a name (simple types and instances that are not part of a
+	/// file) are tracked by address.
+	class IFC_PARSE_API visited_set {
+	public:
+		/// Marks the instance as visited, returns false if it already was.
+		bool insert(IfcUtil::IfcBaseClass* instance);
+		bool contains(IfcUtil::IfcBaseClass* instance) const;
+		void clear();
+
+	private:
+		std::vector<uint64_t> words_;
+		std::vector<uint32_t> touched_;
+		std::unordered_set<const IfcUtil::IfcBaseClass*> unnamed_;
+	};
+
+	/// A visited_set of the calling thread, cleared and reused by the next
+	/// traversal on that thread. A traversal may lazily load instances,
+	/// which may add instances to the file and traverse them, so nested
+	/// traversals get a set of their own.
+	class IFC_PARSE_API thread_visited_set {
+	public:
+		thread_visited_set();
+		~thread_visited_set();
+		thread_visited_set(const thread_visited_set&) = delete;
+		thread_visited_set& operator=(const thread_visited_set&) = delete;
+
+		visited_set& get() { return *set_; }
+
+	private:
+		visited_set* set_;
+	};
+
+	/// Appends the instances directly referenced by the attributes of
+	/// instance to children, in attribute order.
+	IFC_PARSE_API void forward_references(IfcUtil::IfcBaseClass* instance, std::vector<IfcUtil::IfcBaseClass*>& children);
+
+	/// Depth-first pre-order traversal with an explicit stack. Visits the same
+	/// instances in the same order as the recursive traversal it replaces.
+	/// Instances at max_level are returned but not expanded, max_level <= 0
+	/// means unbounded. The root is the first element of the result.
+	IFC_PARSE_API aggregate_of_instance::ptr traverse_depth_first(IfcUtil::IfcBaseClass* instance, int max_level, visited_set& visited);
+
+	/// Level-synchronous breadth-first traversal. Every instance is returned
+	/// once, at its shortest distance from the root, ordered by level and by
+	/// discovery within a level. The order does not depend on threads.
+	///
+	/// Frontiers of at least parallel_frontier instances are expanded by up
+	/// to threads worker threads. Lazy loading is not thread safe, so the
+	/// frontier is loaded first by the calling thread.
+	IFC_PARSE_API aggregate_of_instance::ptr traverse_levels(IfcUtil::IfcBaseClass* instance, int max_level, visited_set& visited, unsigned threads = 1);
+
+	const size_t parallel_frontier = 4096;
+}
+
+#endif
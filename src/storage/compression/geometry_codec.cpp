@@ -0,0 +1,688 @@
+// Copyright 2023 VulcanDB
+
+#include "storage/compression/geometry_codec.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "common/vulcan_logger.h"
+
+namespace vulcan {
+
+namespace {
+
+const char MAGIC[] = "VGC1";
+const size_t MAGIC_SIZE = 4;
+// 每块的值个数，块内共用一个位宽
+const size_t BLOCK_SIZE = 128;
+// Morton 码每个轴的位数
+const int MORTON_BITS = 21;
+// 量化后的坐标需能被 double 精确表示
+const double MAX_QUANTIZED = 9007199254740992.0;
+
+// 只有一个引用列表属性的拓扑实体
+const char *const LIST_KINDS[] = {"IFCPOLYLOOP",    "IFCPOLYLINE",
+                                  "IFCFACE",        "IFCCLOSEDSHELL",
+                                  "IFCOPENSHELL",   "IFCCONNECTEDFACESET"};
+const uint64_t LIST_KIND_COUNT = sizeof(LIST_KINDS) / sizeof(LIST_KINDS[0]);
+// 属性为 (引用, 方向) 的拓扑实体，编号接在 LIST_KINDS 之后
+const char *const BOUND_KINDS[] = {"IFCFACEOUTERBOUND", "IFCFACEBOUND"};
+const uint64_t KIND_COUNT =
+    LIST_KIND_COUNT + sizeof(BOUND_KINDS) / sizeof(BOUND_KINDS[0]);
+
+const char *kind_name(uint64_t kind) {
+  return kind < LIST_KIND_COUNT ? LIST_KINDS[kind]
+                                : BOUND_KINDS[kind - LIST_KIND_COUNT];
+}
+
+uint64_t zigzag(uint64_t delta) {
+  int64_t v = static_cast<int64_t>(delta);
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+uint64_t unzigzag(uint64_t v) { return (v >> 1) ^ (~(v & 1) + 1); }
+
+// 在低 MORTON_BITS 位的每一位之间插入两个 0
+uint64_t spread_bits(uint64_t v) {
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffffULL;
+  v = (v | v << 16) & 0x1f0000ff0000ffULL;
+  v = (v | v << 8) & 0x100f00f00f00f00fULL;
+  v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+  v = (v | v << 2) & 0x1249249249249249ULL;
+  return v;
+}
+
+void put_varint(std::string &out, uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back(static_cast<char>(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back(static_cast<char>(v));
+}
+
+// 按块打包一列值：先写值的个数，每块写位宽和按低位优先排列的位
+void put_column(std::string &out, const std::vector<uint64_t> &values) {
+  put_varint(out, values.size());
+  for (size_t begin = 0; begin < values.size(); begin += BLOCK_SIZE) {
+    size_t end = std::min(values.size(), begin + BLOCK_SIZE);
+    uint64_t all = 0;
+    for (size_t i = begin; i < end; i++) all |= values[i];
+    int width = 0;
+    while (width < 64 && (all >> width) != 0) width++;
+    out.push_back(static_cast<char>(width));
+
+    uint64_t acc = 0;
+    int bits = 0;
+    for (size_t i = begin; i < end && width > 0; i++) {
+      uint64_t v = values[i];
+      int left = width;
+      while (left > 0) {
+        int take = std::min(left, 64 - bits);
+        uint64_t part = take == 64 ? v : v & ((1ULL << take) - 1);
+        acc |= part << bits;
+        bits += take;
+        left -= take;
+        v = take == 64 ? 0 : v >> take;
+        if (bits == 64) {
+          out.append(reinterpret_cast<const char *>(&acc), 8);
+          acc = 0;
+          bits = 0;
+        }
+      }
+    }
+    for (; bits > 0; bits -= 8) {
+      out.push_back(static_cast<char>(acc));
+      acc >>= 8;
+    }
+  }
+}
+
+class Reader {
+ public:
+  explicit Reader(const std::string &data) : data_(data) {}
+
+  bool varint(uint64_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (pos_ >= data_.size()) return false;
+      uint8_t byte = static_cast<uint8_t>(data_[pos_++]);
+      v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+  }
+
+  bool bytes(size_t size, const char *&p) {
+    if (data_.size() - pos_ < size) return false;
+    p = data_.data() + pos_;
+    pos_ += size;
+    return true;
+  }
+
+  bool column(std::vector<uint64_t> &values) {
+    uint64_t count;
+    // 每块至少占一个字节，据此拒绝损坏的计数
+    if (!varint(count) || count / BLOCK_SIZE > data_.size() - pos_) {
+      return false;
+    }
+    values.resize(count);
+    for (size_t begin = 0; begin < count; begin += BLOCK_SIZE) {
+      size_t end = std::min<size_t>(count, begin + BLOCK_SIZE);
+      const char *p;
+      if (!bytes(1, p)) return false;
+      int width = static_cast<uint8_t>(*p);
+      if (width > 64) return false;
+      size_t size = ((end - begin) * width + 7) / 8;
+      if (!bytes(size, p)) return false;
+      size_t bit = 0;
+      for (size_t i = begin; i < end; i++) {
+        uint64_t v = 0;
+        for (int got = 0; got < width;) {
+          size_t byte = bit / 8;
+          int offset = bit % 8;
+          int take = std::min(8 - offset, width - got);
+          uint64_t part = (static_cast<uint8_t>(p[byte]) >> offset) &
+                          ((1u << take) - 1);
+          v |= part << got;
+          got += take;
+          bit += take;
+        }
+        values[i] = v;
+      }
+    }
+    return true;
+  }
+
+  bool done() const { return pos_ == data_.size(); }
+
+ private:
+  const std::string &data_;
+  size_t pos_ = 0;
+};
+
+// 从 pos 开始切出一条语句，stmt_end 为分号之后的位置，返回值为语句所在行
+// 的行尾之后的位置。字符串和注释中的分号不结束语句。
+size_t next_statement(const std::string &s, size_t pos, size_t &stmt_end) {
+  size_t n = s.size();
+  size_t i = pos;
+  while (i < n) {
+    char c = s[i];
+    if (c == '\'') {
+      for (i++; i < n; i++) {
+        if (s[i] != '\'') continue;
+        if (i + 1 < n && s[i + 1] == '\'') {
+          i++;
+        } else {
+          break;
+        }
+      }
+      i++;
+    } else if (c == '/' && i + 1 < n && s[i + 1] == '*') {
+      size_t close = s.find("*/", i + 2);
+      i = close == std::string::npos ? n : close + 2;
+    } else if (c == ';') {
+      stmt_end = ++i;
+      while (i < n && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r')) i++;
+      if (i < n && s[i] == '\n') i++;
+      return i;
+    } else {
+      i++;
+    }
+  }
+  stmt_end = n;
+  return n;
+}
+
+// 语句的简单词法分析，失败时语句按文本保存
+class StatementParser {
+ public:
+  StatementParser(const std::string &s, size_t pos, size_t end)
+      : p_(s.c_str() + pos), end_(s.c_str() + end) {}
+
+  void skip_space() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r' ||
+                         *p_ == '\n')) {
+      p_++;
+    }
+  }
+
+  bool expect(char c) {
+    skip_space();
+    if (p_ >= end_ || *p_ != c) return false;
+    p_++;
+    return true;
+  }
+
+  bool keyword(const char *word) {
+    skip_space();
+    size_t size = strlen(word);
+    if (static_cast<size_t>(end_ - p_) < size || memcmp(p_, word, size) != 0) {
+      return false;
+    }
+    const char *after = p_ + size;
+    if (after < end_ && (isalnum(static_cast<unsigned char>(*after)) ||
+                         *after == '_')) {
+      return false;
+    }
+    p_ = after;
+    return true;
+  }
+
+  // 实体名，例如 #12
+  bool name(uint64_t &id) {
+    if (!expect('#')) return false;
+    if (p_ >= end_ || !isdigit(static_cast<unsigned char>(*p_))) return false;
+    id = 0;
+    for (; p_ < end_ && isdigit(static_cast<unsigned char>(*p_)); p_++) {
+      if (id > (UINT64_MAX >> 1) / 10) return false;
+      id = id * 10 + (*p_ - '0');
+    }
+    return true;
+  }
+
+  bool real(double &v) {
+    skip_space();
+    if (p_ >= end_ || !(isdigit(static_cast<unsigned char>(*p_)) ||
+                        *p_ == '-' || *p_ == '+' || *p_ == '.')) {
+      return false;
+    }
+    char *after;
+    v = strtod(p_, &after);
+    if (after == p_ || after > end_ || !std::isfinite(v)) return false;
+    p_ = after;
+    return true;
+  }
+
+  bool at_end() {
+    skip_space();
+    return p_ == end_;
+  }
+
+ private:
+  const char *p_;
+  const char *end_;
+};
+
+struct Point {
+  uint64_t id;
+  int dims;
+  int64_t q[3];
+  uint64_t key;
+};
+
+struct Topology {
+  uint64_t id;
+  uint64_t kind;
+  // 引用在 refs 中的起止位置
+  size_t begin;
+  size_t end;
+  bool orientation = false;
+};
+
+// 坐标平移到非负后取高位计算 Morton 码，按码排序使空间上相邻的点排在一起
+void sort_by_morton(std::vector<Point> &points) {
+  if (points.empty()) return;
+  int64_t low[3], high[3];
+  for (int axis = 0; axis < 3; axis++) {
+    low[axis] = high[axis] = axis < points[0].dims ? points[0].q[axis] : 0;
+  }
+  for (const Point &point : points) {
+    for (int axis = 0; axis < point.dims; axis++) {
+      low[axis] = std::min(low[axis], point.q[axis]);
+      high[axis] = std::max(high[axis], point.q[axis]);
+    }
+  }
+  int shift = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    uint64_t range =
+        static_cast<uint64_t>(high[axis]) - static_cast<uint64_t>(low[axis]);
+    while (shift < 64 && (range >> shift) >> MORTON_BITS != 0) shift++;
+  }
+  for (Point &point : points) {
+    point.key = 0;
+    for (int axis = 0; axis < point.dims; axis++) {
+      uint64_t offset = static_cast<uint64_t>(point.q[axis]) -
+                        static_cast<uint64_t>(low[axis]);
+      point.key |= spread_bits(offset >> shift) << axis;
+    }
+  }
+  std::sort(points.begin(), points.end(), [](const Point &a, const Point &b) {
+    return a.key != b.key ? a.key < b.key : a.id < b.id;
+  });
+}
+
+// 实体名和各坐标轴分列，按点的顺序差分后打包
+std::string pack_points(const std::vector<Point> &points) {
+  std::vector<uint64_t> ids, dims, coords[3];
+  uint64_t prev_id = 0;
+  uint64_t prev[3] = {0, 0, 0};
+  for (const Point &point : points) {
+    ids.push_back(zigzag(point.id - prev_id));
+    prev_id = point.id;
+    dims.push_back(point.dims - 2);
+    for (int axis = 0; axis < point.dims; axis++) {
+      uint64_t v = static_cast<uint64_t>(point.q[axis]);
+      coords[axis].push_back(zigzag(v - prev[axis]));
+      prev[axis] = v;
+    }
+  }
+  std::string out;
+  put_column(out, ids);
+  put_column(out, dims);
+  for (int axis = 0; axis < 3; axis++) put_column(out, coords[axis]);
+  return out;
+}
+
+bool parse_point(const std::string &s, size_t pos, size_t end, double tol,
+                 Point &point) {
+  StatementParser parser(s, pos, end);
+  if (!parser.name(point.id) || !parser.expect('=') ||
+      !parser.keyword("IFCCARTESIANPOINT") || !parser.expect('(') ||
+      !parser.expect('(')) {
+    return false;
+  }
+  point.dims = 0;
+  do {
+    double v;
+    if (point.dims == 3 || !parser.real(v)) return false;
+    double q = std::round(v / tol);
+    if (!(std::fabs(q) < MAX_QUANTIZED)) return false;
+    point.q[point.dims++] = static_cast<int64_t>(q);
+  } while (parser.expect(','));
+  return point.dims >= 2 && parser.expect(')') && parser.expect(')') &&
+         parser.expect(';') && parser.at_end();
+}
+
+bool parse_topology(const std::string &s, size_t pos, size_t end,
+                    Topology &topology, std::vector<uint64_t> &refs) {
+  StatementParser parser(s, pos, end);
+  if (!parser.name(topology.id) || !parser.expect('=')) return false;
+  for (topology.kind = 0; topology.kind < KIND_COUNT; topology.kind++) {
+    if (parser.keyword(kind_name(topology.kind))) break;
+  }
+  if (topology.kind == KIND_COUNT || !parser.expect('(')) return false;
+
+  topology.begin = refs.size();
+  uint64_t ref;
+  bool ok;
+  if (topology.kind < LIST_KIND_COUNT) {
+    ok = parser.expect('(');
+    do {
+      ok = ok && parser.name(ref);
+      if (ok) refs.push_back(ref);
+    } while (ok && parser.expect(','));
+    ok = ok && parser.expect(')');
+  } else {
+    ok = parser.name(ref) && parser.expect(',') && parser.expect('.');
+    if (ok) refs.push_back(ref);
+    if (ok && parser.keyword("T")) {
+      topology.orientation = true;
+    } else if (ok && parser.keyword("F")) {
+      topology.orientation = false;
+    } else {
+      ok = false;
+    }
+    ok = ok && parser.expect('.');
+  }
+  ok = ok && parser.expect(')') && parser.expect(';') && parser.at_end();
+  if (!ok) refs.resize(topology.begin);
+  topology.end = refs.size();
+  return ok;
+}
+
+// 语句开头的实体名，不是实体实例时返回 false
+bool leading_name(const std::string &s, size_t pos, size_t end, uint64_t &id) {
+  StatementParser parser(s, pos, end);
+  return parser.name(id);
+}
+
+bool is_data_keyword(const std::string &s, size_t pos, size_t end) {
+  StatementParser parser(s, pos, end);
+  return parser.keyword("DATA") && parser.expect(';');
+}
+
+// 使 tolerance 的整数倍都能精确书写的小数位数
+int decimal_places(double tol) {
+  int places = 0;
+  double scaled = tol;
+  while (places < 15 &&
+         std::fabs(scaled - std::round(scaled)) > 1e-9 * scaled) {
+    scaled *= 10;
+    places++;
+  }
+  return places;
+}
+
+void append_real(std::string &out, int64_t q, double tol, int places) {
+  if (q == 0) {
+    out += "0.";
+    return;
+  }
+  char buffer[64];
+  int size = snprintf(buffer, sizeof(buffer), "%.*f", places,
+                      static_cast<double>(q) * tol);
+  std::string text(buffer, size);
+  if (text.find('.') == std::string::npos) {
+    text += '.';
+  } else {
+    while (text.back() == '0') text.pop_back();
+  }
+  out += text;
+}
+
+}  // namespace
+
+int GeometryCodec::encode(const std::string &spf, double tolerance,
+                          std::string &encoded) {
+  if (!(tolerance > 0) || !std::isfinite(tolerance)) {
+    LOG(error, "GeometryCodec: invalid tolerance {}", tolerance);
+    return -1;
+  }
+
+  std::vector<Point> points;
+  std::vector<Topology> topologies;
+  std::vector<uint64_t> refs;
+  std::string text;
+  for (size_t pos = 0; pos < spf.size();) {
+    size_t stmt_end;
+    size_t next = next_statement(spf, pos, stmt_end);
+    Point point;
+    Topology topology;
+    if (parse_point(spf, pos, stmt_end, tolerance, point)) {
+      points.push_back(point);
+    } else if (parse_topology(spf, pos, stmt_end, topology, refs)) {
+      topologies.push_back(topology);
+    } else {
+      text.append(spf, pos, next - pos);
+    }
+    pos = next;
+  }
+
+  // 解码与点的顺序无关，取两种顺序中编码较短的一种
+  std::string point_columns = pack_points(points);
+  sort_by_morton(points);
+  std::string morton_columns = pack_points(points);
+  if (morton_columns.size() < point_columns.size()) {
+    point_columns.swap(morton_columns);
+  }
+
+  std::vector<uint64_t> kinds, topology_ids, counts, first_refs, ref_deltas;
+  std::vector<uint64_t> orientations;
+  uint64_t prev_id = 0;
+  for (const Topology &topology : topologies) {
+    kinds.push_back(topology.kind);
+    topology_ids.push_back(zigzag(topology.id - prev_id));
+    prev_id = topology.id;
+    if (topology.kind < LIST_KIND_COUNT) {
+      counts.push_back(topology.end - topology.begin - 1);
+    } else {
+      orientations.push_back(topology.orientation);
+    }
+    // 第一个引用的差分值通常远大于其余引用，单独成列
+    first_refs.push_back(zigzag(refs[topology.begin] - topology.id));
+    for (size_t i = topology.begin + 1; i < topology.end; i++) {
+      ref_deltas.push_back(zigzag(refs[i] - refs[i - 1]));
+    }
+  }
+
+  uLongf bound = compressBound(text.size());
+  std::string deflated(bound, '\0');
+  if (compress2(reinterpret_cast<Bytef *>(&deflated[0]), &bound,
+                reinterpret_cast<const Bytef *>(text.data()), text.size(),
+                Z_BEST_COMPRESSION) != Z_OK) {
+    LOG(error, "GeometryCodec: failed to deflate {} bytes", text.size());
+    return -1;
+  }
+  deflated.resize(bound);
+
+  encoded.assign(MAGIC, MAGIC_SIZE);
+  encoded.append(reinterpret_cast<const char *>(&tolerance), sizeof(double));
+  encoded += point_columns;
+  put_column(encoded, kinds);
+  put_column(encoded, topology_ids);
+  put_column(encoded, counts);
+  put_column(encoded, first_refs);
+  put_column(encoded, ref_deltas);
+  put_column(encoded, orientations);
+  put_varint(encoded, text.size());
+  put_varint(encoded, deflated.size());
+  encoded += deflated;
+  return 0;
+}
+
+int GeometryCodec::decode(const std::string &encoded, std::string &spf) {
+  Reader reader(encoded);
+  const char *p;
+  double tol;
+  if (!reader.bytes(MAGIC_SIZE, p) || memcmp(p, MAGIC, MAGIC_SIZE) != 0 ||
+      !reader.bytes(sizeof(double), p)) {
+    LOG(error, "GeometryCodec: not an encoded model");
+    return -1;
+  }
+  memcpy(&tol, p, sizeof(double));
+
+  // 读到的计数和其它列不一致时说明数据损坏
+  std::vector<uint64_t> ids, dims, coords[3];
+  std::vector<uint64_t> kinds, topology_ids, counts, first_refs, ref_deltas;
+  std::vector<uint64_t> orientations;
+  bool ok = reader.column(ids) && reader.column(dims) &&
+            dims.size() == ids.size();
+  size_t third = 0;
+  for (size_t i = 0; ok && i < dims.size(); i++) {
+    ok = dims[i] <= 1;
+    third += dims[i];
+  }
+  ok = ok && reader.column(coords[0]) && reader.column(coords[1]) &&
+       reader.column(coords[2]) && coords[0].size() == ids.size() &&
+       coords[1].size() == ids.size() && coords[2].size() == third;
+  ok = ok && reader.column(kinds) && reader.column(topology_ids) &&
+       topology_ids.size() == kinds.size();
+  size_t lists = 0;
+  for (size_t i = 0; ok && i < kinds.size(); i++) {
+    ok = kinds[i] < KIND_COUNT;
+    lists += kinds[i] < LIST_KIND_COUNT;
+  }
+  ok = ok && reader.column(counts) && counts.size() == lists;
+  size_t ref_count = 0;
+  for (size_t i = 0; ok && i < counts.size(); i++) {
+    ok = counts[i] < encoded.size() * BLOCK_SIZE;
+    ref_count += counts[i];
+  }
+  ok = ok && reader.column(first_refs) && first_refs.size() == kinds.size() &&
+       reader.column(ref_deltas) && ref_deltas.size() == ref_count &&
+       reader.column(orientations) &&
+       orientations.size() == kinds.size() - lists;
+  uint64_t text_size, deflated_size;
+  ok = ok && reader.varint(text_size) && reader.varint(deflated_size) &&
+       reader.bytes(deflated_size, p) && reader.done();
+  if (!ok) {
+    LOG(error, "GeometryCodec: corrupted columns");
+    return -1;
+  }
+
+  std::string text(text_size, '\0');
+  uLongf inflated = text_size;
+  if (uncompress(reinterpret_cast<Bytef *>(&text[0]), &inflated,
+                 reinterpret_cast<const Bytef *>(p), deflated_size) != Z_OK ||
+      inflated != text_size) {
+    LOG(error, "GeometryCodec: corrupted text stream");
+    return -1;
+  }
+
+  // 先把列式编码的语句生成出来，再按实体名插回文本语句之间
+  std::vector<std::pair<uint64_t, std::string>> statements;
+  statements.reserve(ids.size() + kinds.size());
+  int places = decimal_places(tol);
+  uint64_t id = 0;
+  uint64_t prev[3] = {0, 0, 0};
+  size_t z = 0;
+  for (size_t i = 0; i < ids.size(); i++) {
+    id += unzigzag(ids[i]);
+    std::string statement =
+        "#" + std::to_string(id) + "=IFCCARTESIANPOINT((";
+    for (int axis = 0; axis < 2 + static_cast<int>(dims[i]); axis++) {
+      prev[axis] += unzigzag(coords[axis][axis == 2 ? z++ : i]);
+      if (axis > 0) statement += ',';
+      append_real(statement, static_cast<int64_t>(prev[axis]), tol, places);
+    }
+    statement += "));\n";
+    statements.emplace_back(id, std::move(statement));
+  }
+
+  id = 0;
+  size_t ref = 0, list = 0, bound = 0;
+  for (size_t i = 0; i < kinds.size(); i++) {
+    id += unzigzag(topology_ids[i]);
+    std::string statement =
+        "#" + std::to_string(id) + "=" + kind_name(kinds[i]) + "(";
+    uint64_t prev_ref = id + unzigzag(first_refs[i]);
+    if (kinds[i] < LIST_KIND_COUNT) {
+      statement += "(#" + std::to_string(prev_ref);
+      for (uint64_t j = 0; j < counts[list]; j++) {
+        prev_ref += unzigzag(ref_deltas[ref++]);
+        statement += ",#" + std::to_string(prev_ref);
+      }
+      statement += ')';
+      list++;
+    } else {
+      statement += "#" + std::to_string(prev_ref) +
+                   (orientations[bound++] ? ",.T." : ",.F.");
+    }
+    statement += ");\n";
+    statements.emplace_back(id, std::move(statement));
+  }
+  std::stable_sort(statements.begin(), statements.end(),
+                   [](const std::pair<uint64_t, std::string> &a,
+                      const std::pair<uint64_t, std::string> &b) {
+                     return a.first < b.first;
+                   });
+
+  spf.clear();
+  spf.reserve(text.size() + statements.size() * 48);
+  size_t next_statement_index = 0;
+  bool in_data = false;
+  for (size_t pos = 0; pos < text.size();) {
+    size_t stmt_end;
+    size_t next = next_statement(text, pos, stmt_end);
+    uint64_t name;
+    bool instance = leading_name(text, pos, stmt_end, name);
+    if (in_data) {
+      while (next_statement_index < statements.size() &&
+             (!instance || statements[next_statement_index].first < name)) {
+        spf += statements[next_statement_index++].second;
+      }
+    }
+    in_data = in_data || is_data_keyword(text, pos, stmt_end);
+    spf.append(text, pos, next - pos);
+    pos = next;
+  }
+  for (; next_statement_index < statements.size(); next_statement_index++) {
+    spf += statements[next_statement_index].second;
+  }
+  return 0;
+}
+
+void GeometryCodec::compress(const std::string &input_filename,
+                             const std::string &output_filename,
+                             const void *comp_arg) {
+  GeometryCodecArg default_arg;
+  const GeometryCodecArg *arg =
+      comp_arg ? static_cast<const GeometryCodecArg *>(comp_arg)
+               : &default_arg;
+  std::ifstream input(input_filename, std::ios::binary);
+  if (!input) {
+    LOG(error, "GeometryCodec: cannot open {}", input_filename);
+    return;
+  }
+  std::stringstream buffer;
+  buffer << input.rdbuf();
+  std::string encoded;
+  if (encode(buffer.str(), arg->tolerance, encoded) != 0) return;
+  std::ofstream(output_filename, std::ios::binary) << encoded;
+}
+
+void GeometryCodec::decompress(const std::string &input_filename,
+                               const std::string &output_filename) {
+  std::ifstream input(input_filename, std::ios::binary);
+  if (!input) {
+    LOG(error, "GeometryCodec: cannot open {}", input_filename);
+    return;
+  }
+  std::stringstream buffer;
+  buffer << input.rdbuf();
+  std::string spf;
+  if (decode(buffer.str(), spf) != 0) return;
+  std::ofstream(output_filename, std::ios::binary) << spf;
+}
+
+}  // namespace vulcan
@@ -0,0 +1,60 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "storage/compression/compressor_interface.h"
+
+namespace vulcan {
+
+struct GeometryCodecArg {
+  // 坐标量化的步长，使用模型的长度单位，解码误差不超过步长的一半
+  double tolerance = 1e-4;
+};
+
+/**
+ * @brief IFC 几何数据的列式编码。
+ *
+ * SPF 文本被切分为语句，三类语句按列编码，其余语句原样拼接后用 deflate
+ * 压缩：
+ *  - IFCCARTESIANPOINT：坐标按 tolerance 量化为整数，按 Morton 序排列后
+ *    逐列做差分，实例名也按同样的顺序差分。Morton 序会打乱实例名，
+ *    文件顺序编码更短时保留文件顺序；
+ *  - 只有一个引用列表属性的拓扑语句(IFCPOLYLOOP、IFCFACE、IFCCLOSEDSHELL
+ *    等)：引用相对前一个引用差分，第一个引用相对实例名差分；
+ *  - IFCFACEBOUND/IFCFACEOUTERBOUND：引用和方向各占一列。
+ * 差分值经 zigzag 变换后每 128 个一块按块内最大位宽打包。
+ *
+ * 解码得到语义相同的 SPF：其它语句保持原文和顺序，列式编码的语句按实例
+ * 名插回，坐标为量化后的值。
+ */
+class GeometryCodec : public CompressorInterface {
+ public:
+  GeometryCodec() = default;
+  ~GeometryCodec() = default;
+
+  // comp_arg 为 GeometryCodecArg，为空时使用默认参数
+  void compress(const std::string &input_filename,
+                const std::string &output_filename,
+                const void *comp_arg) override;
+  void decompress(const std::string &input_filename,
+                  const std::string &output_filename) override;
+
+  /**
+   * @brief 编码 SPF 文本。
+   * @return 0 成功，-1 参数错误或压缩失败
+   */
+  static int encode(const std::string &spf, double tolerance,
+                    std::string &encoded);
+
+  /**
+   * @brief 解码 encode() 的结果。
+   * @return 0 成功，-1 数据损坏
+   */
+  static int decode(const std::string &encoded, std::string &spf);
+};
+
+}  // namespace vulcan
@@ -0,0 +1,337 @@
+// Copyright 2023 VulcanDB
+
+#include "storage/compression/ifc_diff.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "common/vulcan_logger.h"
+#include "ifcparse/IfcFile.h"
+#include "ifcparse/IfcTraversal.h"
+
+namespace vulcan {
+
+namespace {
+
+// 同一层的实例数达到该值时才并行计算
+const size_t PARALLEL_LEVEL = 4096;
+
+// 区分空值、聚合边界和环上引用的标记
+const uint64_t NULL_TAG = 0x6e756c6c;
+const uint64_t AGGREGATE_BEGIN_TAG = 0x28;
+const uint64_t AGGREGATE_END_TAG = 0x29;
+const uint64_t CYCLE_TAG = 0x6379636c65;
+
+uint64_t hash_bytes(const std::string &bytes) {
+  uint64_t h = 14695981039346656037ULL;
+  for (unsigned char c : bytes) {
+    h = (h ^ c) * 1099511628211ULL;
+  }
+  return h;
+}
+
+// splitmix64 的终结函数，结果与组合顺序相关
+uint64_t combine(uint64_t h, uint64_t v) {
+  uint64_t x = (h ^ v) + 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+class MerkleHasher {
+ public:
+  explicit MerkleHasher(const std::vector<int32_t> &slot, size_t size)
+      : slot_(slot), hash_(size, 0), done_(size, 0) {}
+
+  uint64_t hash(size_t i) const { return hash_[i]; }
+  bool done(size_t i) const { return done_[i] != 0; }
+  void set_done(size_t i) { done_[i] = 1; }
+
+  // 计算实例的哈希，被引用的实例中尚未计算的视为环上的引用
+  void compute(size_t i, IfcUtil::IfcBaseClass *instance) {
+    IfcEntityInstanceData &data = instance->data();
+    uint64_t h = hash_bytes(instance->declaration().name_uc());
+    for (size_t j = 0; j < data.getArgumentCount(); j++) {
+      h = combine(h, hash_argument(data.getArgument(j)));
+    }
+    hash_[i] = h == 0 ? 1 : h;
+  }
+
+ private:
+  uint64_t hash_reference(IfcUtil::IfcBaseClass *instance) const {
+    const unsigned id = instance->data().id();
+    if (id == 0) {
+      // 选择类型中的简单类型值不是独立的实例，按文本参与哈希
+      return hash_bytes(instance->data().toString());
+    }
+    const int32_t i = id < slot_.size() ? slot_[id] : -1;
+    if (i < 0 || !done_[i]) {
+      return combine(CYCLE_TAG, hash_bytes(instance->declaration().name_uc()));
+    }
+    return hash_[i];
+  }
+
+  uint64_t hash_argument(Argument *argument) const {
+    if (argument == nullptr) {
+      return NULL_TAG;
+    }
+    switch (argument->type()) {
+      case IfcUtil::Argument_ENTITY_INSTANCE: {
+        IfcUtil::IfcBaseClass *instance = *argument;
+        return instance ? hash_reference(instance) : NULL_TAG;
+      }
+      case IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE: {
+        aggregate_of_instance::ptr list = *argument;
+        uint64_t h = AGGREGATE_BEGIN_TAG;
+        for (IfcUtil::IfcBaseClass *instance : *list) {
+          h = combine(h, hash_reference(instance));
+        }
+        return combine(h, AGGREGATE_END_TAG);
+      }
+      case IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_ENTITY_INSTANCE: {
+        aggregate_of_aggregate_of_instance::ptr list = *argument;
+        uint64_t h = AGGREGATE_BEGIN_TAG;
+        for (auto it = list->begin(); it != list->end(); ++it) {
+          h = combine(h, AGGREGATE_BEGIN_TAG);
+          for (IfcUtil::IfcBaseClass *instance : *it) {
+            h = combine(h, hash_reference(instance));
+          }
+          h = combine(h, AGGREGATE_END_TAG);
+        }
+        return combine(h, AGGREGATE_END_TAG);
+      }
+      default:
+        return hash_bytes(argument->toString());
+    }
+  }
+
+  const std::vector<int32_t> &slot_;
+  std::vector<uint64_t> hash_;
+  std::vector<char> done_;
+};
+
+// 返回带 GlobalId 的 IfcRoot 实例的 GlobalId，其它实例返回空串
+std::string global_id(IfcParse::IfcFile *file,
+                      IfcUtil::IfcBaseClass *instance) {
+  const IfcParse::declaration *root = file->ifcroot_type();
+  if (root == nullptr || !instance->declaration().is(*root)) {
+    return std::string();
+  }
+  Argument *argument = instance->data().getArgument(0);
+  if (argument == nullptr || argument->isNull()) {
+    return std::string();
+  }
+  return *argument;
+}
+
+}  // namespace
+
+int IfcDiff::hash_instances(IfcParse::IfcFile *file,
+                            std::vector<uint64_t> &hashes) const {
+  std::vector<IfcUtil::IfcBaseClass *> instances;
+  unsigned max_id = 0;
+  for (auto it = file->begin(); it != file->end(); ++it) {
+    instances.push_back(it->second);
+    max_id = std::max(max_id, it->first);
+  }
+  if (instances.empty()) {
+    LOG(warn, "IfcDiff::hash_instances: no instance in the model");
+    return -1;
+  }
+  std::sort(instances.begin(), instances.end(),
+            [](IfcUtil::IfcBaseClass *a, IfcUtil::IfcBaseClass *b) {
+              return a->data().id() < b->data().id();
+            });
+
+  const size_t n = instances.size();
+  std::vector<int32_t> slot(max_id + 1, -1);
+  for (size_t i = 0; i < n; i++) {
+    slot[instances[i]->data().id()] = static_cast<int32_t>(i);
+  }
+
+  // 正向引用的邻接表，同时加载全部实例，之后的并行计算只读模型。
+  // pending 为尚未计算的被引用实例数，parents 为反向的邻接表。
+  std::vector<uint32_t> child_begin(n + 1, 0);
+  std::vector<uint32_t> children;
+  std::vector<IfcUtil::IfcBaseClass *> references;
+  for (size_t i = 0; i < n; i++) {
+    references.clear();
+    IfcParse::forward_references(instances[i], references);
+    for (IfcUtil::IfcBaseClass *reference : references) {
+      const unsigned id = reference->data().id();
+      if (id != 0 && id <= max_id && slot[id] >= 0) {
+        children.push_back(static_cast<uint32_t>(slot[id]));
+      }
+    }
+    child_begin[i + 1] = static_cast<uint32_t>(children.size());
+  }
+  std::vector<uint32_t> pending(n);
+  std::vector<uint32_t> parent_begin(n + 1, 0);
+  for (size_t i = 0; i < n; i++) {
+    pending[i] = child_begin[i + 1] - child_begin[i];
+  }
+  for (uint32_t child : children) {
+    parent_begin[child + 1]++;
+  }
+  for (size_t i = 0; i < n; i++) {
+    parent_begin[i + 1] += parent_begin[i];
+  }
+  std::vector<uint32_t> parents(children.size());
+  std::vector<uint32_t> fill(parent_begin.begin(), parent_begin.end() - 1);
+  for (size_t i = 0; i < n; i++) {
+    for (uint32_t k = child_begin[i]; k < child_begin[i + 1]; k++) {
+      parents[fill[children[k]]++] = static_cast<uint32_t>(i);
+    }
+  }
+
+  MerkleHasher hasher(slot, n);
+  std::vector<uint32_t> frontier, next;
+  // 按层计算 frontier 中的实例，再把被引用实例都已计算的实例加入下一层
+  auto drain = [&]() {
+    while (!frontier.empty()) {
+      size_t workers = 1;
+      if (threads_ > 1 && frontier.size() >= PARALLEL_LEVEL) {
+        workers = std::min(static_cast<size_t>(threads_),
+                           frontier.size() / (PARALLEL_LEVEL / 4));
+      }
+      const size_t chunk = (frontier.size() + workers - 1) / workers;
+      auto compute = [&](size_t w) {
+        const size_t end = std::min(frontier.size(), (w + 1) * chunk);
+        for (size_t k = w * chunk; k < end; k++) {
+          hasher.compute(frontier[k], instances[frontier[k]]);
+        }
+      };
+      std::vector<std::thread> pool;
+      for (size_t w = 1; w < workers; w++) {
+        pool.emplace_back(compute, w);
+      }
+      compute(0);
+      for (std::thread &t : pool) {
+        t.join();
+      }
+
+      next.clear();
+      for (uint32_t i : frontier) {
+        hasher.set_done(i);
+      }
+      for (uint32_t i : frontier) {
+        for (uint32_t k = parent_begin[i]; k < parent_begin[i + 1]; k++) {
+          const uint32_t parent = parents[k];
+          if (pending[parent] > 0 && --pending[parent] == 0 &&
+              !hasher.done(parent)) {
+            next.push_back(parent);
+          }
+        }
+      }
+      frontier.swap(next);
+    }
+  };
+
+  for (size_t i = 0; i < n; i++) {
+    if (pending[i] == 0) {
+      frontier.push_back(static_cast<uint32_t>(i));
+    }
+  }
+  drain();
+  // 剩下的实例在环上或依赖环上的实例，按实例名顺序逐个断开
+  for (size_t i = 0; i < n; i++) {
+    if (!hasher.done(i)) {
+      pending[i] = 0;
+      frontier.push_back(static_cast<uint32_t>(i));
+      drain();
+    }
+  }
+
+  hashes.assign(max_id + 1, 0);
+  for (size_t i = 0; i < n; i++) {
+    hashes[instances[i]->data().id()] = hasher.hash(i);
+  }
+  return 0;
+}
+
+int IfcDiff::diff(IfcParse::IfcFile *a, IfcParse::IfcFile *b,
+                  IfcDiffResult &result) const {
+  std::vector<uint64_t> hashes_a, hashes_b;
+  if (hash_instances(a, hashes_a) != 0 || hash_instances(b, hashes_b) != 0) {
+    return -1;
+  }
+  result = IfcDiffResult();
+
+  // IfcRoot 实例按 GlobalId 配对
+  std::unordered_map<std::string, unsigned> guids_b;
+  for (unsigned id = 0; id < hashes_b.size(); id++) {
+    if (hashes_b[id] == 0) {
+      continue;
+    }
+    result.instances_b++;
+    std::string guid = global_id(b, b->instance_by_id(id));
+    if (!guid.empty()) {
+      result.rooted_b++;
+      guids_b.emplace(std::move(guid), id);
+    }
+  }
+  std::vector<char> paired_a(hashes_a.size(), 0);
+  std::vector<char> paired_b(hashes_b.size(), 0);
+  for (unsigned id = 0; id < hashes_a.size(); id++) {
+    if (hashes_a[id] == 0) {
+      continue;
+    }
+    result.instances_a++;
+    const std::string guid = global_id(a, a->instance_by_id(id));
+    if (guid.empty()) {
+      continue;
+    }
+    result.rooted_a++;
+    auto it = guids_b.find(guid);
+    if (it == guids_b.end() || paired_b[it->second]) {
+      continue;
+    }
+    paired_a[id] = paired_b[it->second] = 1;
+    result.guid_pairs++;
+    if (hashes_a[id] == hashes_b[it->second]) {
+      result.guid_unchanged++;
+      result.unchanged.emplace_back(id, it->second);
+    } else {
+      result.modified.emplace_back(id, it->second);
+    }
+  }
+
+  // 其余实例按哈希配对，相同哈希的实例按实例名顺序一一对应
+  std::vector<std::pair<uint64_t, unsigned>> rest_a, rest_b;
+  for (unsigned id = 0; id < hashes_a.size(); id++) {
+    if (hashes_a[id] != 0 && !paired_a[id]) {
+      rest_a.emplace_back(hashes_a[id], id);
+    }
+  }
+  for (unsigned id = 0; id < hashes_b.size(); id++) {
+    if (hashes_b[id] != 0 && !paired_b[id]) {
+      rest_b.emplace_back(hashes_b[id], id);
+    }
+  }
+  std::sort(rest_a.begin(), rest_a.end());
+  std::sort(rest_b.begin(), rest_b.end());
+  size_t i = 0, j = 0;
+  while (i < rest_a.size() || j < rest_b.size()) {
+    if (j == rest_b.size() ||
+        (i < rest_a.size() && rest_a[i].first < rest_b[j].first)) {
+      result.removed.push_back(rest_a[i++].second);
+    } else if (i == rest_a.size() || rest_b[j].first < rest_a[i].first) {
+      result.added.push_back(rest_b[j++].second);
+    } else {
+      result.unchanged.emplace_back(rest_a[i++].second, rest_b[j++].second);
+    }
+  }
+  std::sort(result.unchanged.begin(), result.unchanged.end());
+  std::sort(result.removed.begin(), result.removed.end());
+  std::sort(result.added.begin(), result.added.end());
+
+  LOG(info,
+      "IfcDiff: {} unchanged, {} modified, {} removed, {} added instances",
+      result.unchanged.size(), result.modified.size(), result.removed.size(),
+      result.added.size());
+  return 0;
+}
+
+}  // namespace vulcan
@@ -0,0 +1,75 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+namespace IfcParse {
+class IfcFile;
+}  // namespace IfcParse
+
+namespace vulcan {
+
+/**
+ * @brief 两个模型版本的差异，实例用实例名(#id)表示。
+ */
+struct IfcDiffResult {
+  // 内容相同的实例对 (A 中的名字, B 中的名字)
+  std::vector<std::pair<unsigned, unsigned>> unchanged;
+  // GlobalId 相同但内容不同的 IfcRoot 实例对
+  std::vector<std::pair<unsigned, unsigned>> modified;
+  // 只在 A 中的实例
+  std::vector<unsigned> removed;
+  // 只在 B 中的实例
+  std::vector<unsigned> added;
+
+  size_t instances_a = 0;
+  size_t instances_b = 0;
+  // 带 GlobalId 的 IfcRoot 实例数
+  size_t rooted_a = 0;
+  size_t rooted_b = 0;
+  // GlobalId 在两个版本中都出现的实例对，以及其中内容相同的对数
+  size_t guid_pairs = 0;
+  size_t guid_unchanged = 0;
+};
+
+/**
+ * @brief 基于 Merkle 哈希的模型差异计算。
+ *
+ * 实例的结构哈希由类型名和各属性值计算，属性中引用的实例用其哈希代替，
+ * 因此哈希与实例名无关，被引用实例的变化会传递到引用它的实例。哈希沿
+ * 正向引用自底向上计算：同一层的实例只依赖更低层，按层并行。正向引用
+ * 成环时，环上尚未计算的实例只按类型名参与哈希。
+ *
+ * 匹配分两步：IfcRoot 实例按 GlobalId 配对，哈希相同为 unchanged，
+ * 否则为 modified；其余实例没有稳定的标识，按哈希的多重集合配对，
+ * 多出的部分为 removed/added。两步都只用哈希表，耗时与实例数近似线性。
+ */
+class IfcDiff {
+ public:
+  explicit IfcDiff(unsigned threads = 1) : threads_(threads) {}
+
+  /**
+   * @brief 计算 file 中每个实例的结构哈希。
+   * 会加载全部实例的属性，调用者需持有模型的锁。
+   * @param hashes 按实例名索引，大小为 getMaxId()+1，未使用的名字为 0
+   * @return 0 成功，-1 模型中没有实例
+   */
+  int hash_instances(IfcParse::IfcFile *file,
+                     std::vector<uint64_t> &hashes) const;
+
+  /**
+   * @brief 计算从 a 到 b 的差异，result 中原有的内容被替换。
+   * @return 0 成功，-1 任一模型为空
+   */
+  int diff(IfcParse::IfcFile *a, IfcParse::IfcFile *b,
+           IfcDiffResult &result) const;
+
+ private:
+  unsigned threads_;
+};
+
+}  // namespace vulcan
@@ -2,6 +2,13 @@
 
 #include "ifccompressor_impl.h"
 
+#include <algorithm>
+#include <thread>
+
+#include "common/vulcan_logger.h"
+#include "ifcparse/IfcFile.h"
+#include "storage/compression/ifc_diff.h"
+
 namespace vulcan {
 
 void IfcCompressorImpl::IfcCompressor(string fileName, string fileName4Write,
@@ -982,7 +989,29 @@ void IfcCompressorImpl::IfcCompressorAna(stringstream &ifile,
 
 void IfcCompressorImpl::IfcCompare(string fileA, string fileB, float &sA2B,
                                    float &sB2A, float &machR, float &missR,
-                                   float &guidPR, float &AR) {}
+                                   float &guidPR, float &AR) {
+  sA2B = sB2A = machR = missR = guidPR = AR = 0;
+  IfcParse::IfcFile a(fileA), b(fileB);
+  if (!a.good() || !b.good()) {
+    LOG(error, "IfcCompare: failed to open {} or {}", fileA, fileB);
+    return;
+  }
+
+  IfcDiffResult diff;
+  IfcDiff engine(std::max(1u, std::thread::hardware_concurrency()));
+  if (engine.diff(&a, &b, diff) != 0) {
+    return;
+  }
+  auto ratio = [](size_t part, size_t total) {
+    return total == 0 ? 0.0f : static_cast<float>(part) / total;
+  };
+  sA2B = ratio(diff.unchanged.size(), diff.instances_a);
+  sB2A = ratio(diff.unchanged.size(), diff.instances_b);
+  machR = ratio(diff.guid_unchanged, diff.guid_pairs);
+  missR = ratio(diff.rooted_a - diff.guid_pairs, diff.rooted_a);
+  guidPR = ratio(diff.guid_pairs, diff.rooted_a);
+  AR = ratio(diff.added.size(), diff.instances_b);
+}
 
 void IfcCompressorImpl::IfcInstanceAna(string instance, int &id, string &type,
                                        string &content, vector<int> &cite) {
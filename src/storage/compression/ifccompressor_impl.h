@@ -45,6 +45,14 @@ class IfcCompressorImpl : public CompressorInterface {
     return;
   }
 
+  // Compares two versions of a model, see IfcDiff. The ratios are the shares
+  // of unchanged instances of A (sA2B) and of B (sB2A), of GlobalId pairs
+  // whose content is unchanged (machR), of rooted instances of A whose
+  // GlobalId is missing in (missR) or found in (guidPR) B, and of instances
+  // of B that were added (AR). All are 0 if a model cannot be opened.
+  void IfcCompare(string fileA, string fileB, float &sA2B, float &sB2A,
+                  float &machR, float &missR, float &guidPR, float &AR);
+
  private:
   // Initial Implement of IfcCompressor, don't want to refactor the code since
   // it can work
@@ -80,8 +88,6 @@ class IfcCompressorImpl : public CompressorInterface {
                      int flag = 0);
   void IfcCompressorAna(stringstream &ifile, stringstream &result,
                         int &totalCount, int &compCount);
-  void IfcCompare(string fileA, string fileB, float &sA2B, float &sB2A,
-                  float &machR, float &missR, float &guidPR, float &AR);
 
   void IfcInstanceAna(
       string instance, int &id, string &type, string &content,
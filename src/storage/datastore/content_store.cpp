@@ -0,0 +1,529 @@
+// Copyright 2023 VulcanDB
+
+#include "storage/datastore/content_store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "common/vulcan_logger.h"
+#include "ifcparse/IfcFile.h"
+#include "storage/compression/ifc_diff.h"
+#include "storage/datastore/datastore_interface.h"
+
+namespace vulcan {
+
+namespace {
+
+const char *OBJECT_PREFIX = "cas:o:";
+const char *CHUNK_PREFIX = "cas:c:";
+const char *MODEL_PREFIX = "cas:m:";
+
+// 平均每块 64 个对象，最多 1024 个
+const uint64_t CHUNK_MASK = 63;
+const size_t MAX_CHUNK_SIZE = 1024;
+
+const size_t HASH_DIGITS = 16;
+
+void append_hash(uint64_t hash, std::string &out) {
+  char buf[HASH_DIGITS + 1];
+  snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash));
+  out.append(buf, HASH_DIGITS);
+}
+
+std::string hash_key(const char *prefix, uint64_t hash) {
+  std::string key = prefix;
+  append_hash(hash, key);
+  return key;
+}
+
+bool parse_hash(const char *text, uint64_t &hash) {
+  char *end = nullptr;
+  hash = strtoull(text, &end, 16);
+  return end == text + HASH_DIGITS;
+}
+
+std::string join_hashes(const std::vector<uint64_t> &hashes, size_t begin,
+                        size_t end) {
+  std::string out;
+  out.reserve((end - begin) * (HASH_DIGITS + 1));
+  for (size_t i = begin; i < end; i++) {
+    if (i != begin) {
+      out += ',';
+    }
+    append_hash(hashes[i], out);
+  }
+  return out;
+}
+
+int split_hashes(const std::string &text, std::vector<uint64_t> &hashes) {
+  for (size_t pos = 0; pos < text.size(); pos += HASH_DIGITS + 1) {
+    uint64_t hash;
+    if (text.size() - pos < HASH_DIGITS || !parse_hash(&text[pos], hash)) {
+      return -1;
+    }
+    hashes.push_back(hash);
+  }
+  return 0;
+}
+
+// 实例名序列写作区间列表，如 1-500,502-502
+std::string join_ids(const std::vector<unsigned> &ids) {
+  std::string out;
+  for (size_t i = 0; i < ids.size();) {
+    size_t last = i;
+    while (last + 1 < ids.size() && ids[last + 1] == ids[last] + 1) {
+      last++;
+    }
+    if (i != 0) {
+      out += ',';
+    }
+    out += std::to_string(ids[i]);
+    out += '-';
+    out += std::to_string(ids[last]);
+    i = last + 1;
+  }
+  return out;
+}
+
+int split_ids(const std::string &text, std::vector<unsigned> &ids) {
+  const char *p = text.c_str();
+  while (*p != '\0') {
+    char *end = nullptr;
+    unsigned long first = strtoul(p, &end, 10);
+    if (end == p || *end != '-') {
+      return -1;
+    }
+    p = end + 1;
+    unsigned long last = strtoul(p, &end, 10);
+    if (end == p || last < first || (*end != ',' && *end != '\0')) {
+      return -1;
+    }
+    for (unsigned long id = first; id <= last; id++) {
+      ids.push_back(static_cast<unsigned>(id));
+    }
+    p = *end == ',' ? end + 1 : end;
+  }
+  return 0;
+}
+
+// FNV-1a，块的内容是对象哈希的列表，不需要更强的混合
+uint64_t hash_text(const std::string &text) {
+  uint64_t h = 14695981039346656037ULL;
+  for (unsigned char c : text) {
+    h = (h ^ c) * 1099511628211ULL;
+  }
+  return h;
+}
+
+void append_reference(IfcUtil::IfcBaseClass *instance,
+                      const std::vector<uint64_t> &hashes, std::string &out) {
+  const unsigned id = instance->data().id();
+  if (id == 0) {
+    // 选择类型中的简单类型值不是独立的实例，内联书写
+    out += instance->data().toString(true);
+    return;
+  }
+  out += '@';
+  append_hash(id < hashes.size() ? hashes[id] : 0, out);
+}
+
+void append_argument(Argument *argument, const std::vector<uint64_t> &hashes,
+                     std::string &out) {
+  if (argument == nullptr) {
+    out += '$';
+    return;
+  }
+  switch (argument->type()) {
+    case IfcUtil::Argument_ENTITY_INSTANCE: {
+      IfcUtil::IfcBaseClass *instance = *argument;
+      if (instance == nullptr) {
+        out += '$';
+      } else {
+        append_reference(instance, hashes, out);
+      }
+      break;
+    }
+    case IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE: {
+      aggregate_of_instance::ptr list = *argument;
+      out += '(';
+      for (auto it = list->begin(); it != list->end(); ++it) {
+        if (it != list->begin()) {
+          out += ',';
+        }
+        append_reference(*it, hashes, out);
+      }
+      out += ')';
+      break;
+    }
+    case IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_ENTITY_INSTANCE: {
+      aggregate_of_aggregate_of_instance::ptr list = *argument;
+      out += '(';
+      for (auto it = list->begin(); it != list->end(); ++it) {
+        if (it != list->begin()) {
+          out += ',';
+        }
+        out += '(';
+        for (auto inner = it->begin(); inner != it->end(); ++inner) {
+          if (inner != it->begin()) {
+            out += ',';
+          }
+          append_reference(*inner, hashes, out);
+        }
+        out += ')';
+      }
+      out += ')';
+      break;
+    }
+    default:
+      out += argument->toString(true);
+      break;
+  }
+}
+
+std::string canonical_text(IfcUtil::IfcBaseClass *instance,
+                           const std::vector<uint64_t> &hashes) {
+  IfcEntityInstanceData &data = instance->data();
+  std::string out = instance->declaration().name_uc();
+  out += '(';
+  for (size_t i = 0; i < data.getArgumentCount(); i++) {
+    if (i != 0) {
+      out += ',';
+    }
+    append_argument(data.getArgument(i), hashes, out);
+  }
+  out += ')';
+  return out;
+}
+
+}  // namespace
+
+int ContentStore::read_entry(const std::string &key, uint64_t &count,
+                             std::string &payload) {
+  const char *value = session_->get(key.c_str());
+  if (value == nullptr) {
+    return -1;
+  }
+  char *end = nullptr;
+  count = strtoull(value, &end, 10);
+  if (end == value || *end != ':') {
+    LOG(error, "ContentStore: malformed entry {}", key);
+    return -1;
+  }
+  payload.assign(end + 1);
+  return 0;
+}
+
+void ContentStore::write_entry(const std::string &key, uint64_t count,
+                               const std::string &payload,
+                               ContentStoreStats *stats) {
+  std::string value = std::to_string(count);
+  value += ':';
+  value += payload;
+  session_->upsert_kv(key.c_str(), value.c_str());
+  if (stats != nullptr) {
+    stats->bytes_written += key.size() + value.size();
+  }
+}
+
+int ContentStore::read_model(const std::string &name,
+                             std::vector<unsigned> &ids,
+                             std::vector<uint64_t> &chunks) {
+  const char *value = session_->get((MODEL_PREFIX + name).c_str());
+  if (value == nullptr) {
+    return -1;
+  }
+  ids.clear();
+  chunks.clear();
+  const char *separator = strchr(value, ';');
+  if (separator == nullptr ||
+      split_ids(std::string(value, separator), ids) != 0 ||
+      split_hashes(separator + 1, chunks) != 0) {
+    LOG(error, "ContentStore: malformed model {}", name);
+    return -1;
+  }
+  return 0;
+}
+
+int ContentStore::put_model(const std::string &name, IfcParse::IfcFile *file,
+                            ContentStoreStats *stats) {
+  std::vector<uint64_t> hashes;
+  if (IfcDiff().hash_instances(file, hashes) != 0) {
+    return -1;
+  }
+
+  // 按实例名排列的哈希序列，内容相同的实例共享一个对象
+  std::vector<unsigned> ids;
+  std::vector<uint64_t> sequence;
+  std::unordered_map<uint64_t, IfcUtil::IfcBaseClass *> instances;
+  for (unsigned id = 0; id < hashes.size(); id++) {
+    if (hashes[id] != 0) {
+      ids.push_back(id);
+      sequence.push_back(hashes[id]);
+      instances.emplace(hashes[id], file->instance_by_id(id));
+    }
+  }
+
+  // 先切块、检查哈希冲突并汇总每个块和对象增加的引用数，再在一个事务中
+  // 写入，失败时存储保持不变
+  struct Update {
+    uint64_t count = 0;  // 已有的引用数，0 表示新写入
+    uint64_t added = 0;  // 本次增加的引用数
+    std::string payload;
+  };
+  std::vector<uint64_t> chunks;
+  std::unordered_map<uint64_t, Update> chunk_updates;
+  std::unordered_map<uint64_t, Update> object_updates;
+  std::string payload;
+  size_t begin = 0;
+  for (size_t i = 0; i < sequence.size(); i++) {
+    if ((sequence[i] & CHUNK_MASK) != 0 && i + 1 < sequence.size() &&
+        i + 1 - begin < MAX_CHUNK_SIZE) {
+      continue;
+    }
+    std::string members = join_hashes(sequence, begin, i + 1);
+    const uint64_t chunk_hash = hash_text(members);
+    const std::string key = hash_key(CHUNK_PREFIX, chunk_hash);
+    chunks.push_back(chunk_hash);
+    auto chunk = chunk_updates.emplace(chunk_hash, Update());
+    Update &chunk_update = chunk.first->second;
+    chunk_update.added++;
+    if (!chunk.second) {
+      // 同一个块在模型中重复出现
+      if (chunk_update.payload != members) {
+        LOG(error, "ContentStore: hash collision on chunk {}", key);
+        return -1;
+      }
+      begin = i + 1;
+      continue;
+    }
+    if (read_entry(key, chunk_update.count, payload) == 0) {
+      if (payload != members) {
+        LOG(error, "ContentStore: hash collision on chunk {}", key);
+        return -1;
+      }
+    } else {
+      // 新块的成员每出现一次增加一个引用
+      chunk_update.count = 0;
+      for (size_t k = begin; k <= i; k++) {
+        auto object = object_updates.emplace(sequence[k], Update());
+        Update &object_update = object.first->second;
+        object_update.added++;
+        if (!object.second) {
+          continue;
+        }
+        const std::string object_key = hash_key(OBJECT_PREFIX, sequence[k]);
+        object_update.payload =
+            canonical_text(instances[sequence[k]], hashes);
+        if (read_entry(object_key, object_update.count, payload) != 0) {
+          object_update.count = 0;
+        } else if (payload != object_update.payload) {
+          LOG(error, "ContentStore: hash collision on object {}", object_key);
+          return -1;
+        }
+      }
+    }
+    chunk_update.payload = std::move(members);
+    begin = i + 1;
+  }
+
+  std::vector<unsigned> old_ids;
+  std::vector<uint64_t> old_chunks;
+  const bool replace = read_model(name, old_ids, old_chunks) == 0;
+
+  if (session_->begin_transaction() != 0) {
+    return -1;
+  }
+  for (const auto &entry : object_updates) {
+    const Update &update = entry.second;
+    const bool shared = update.count > 0;
+    write_entry(hash_key(OBJECT_PREFIX, entry.first),
+                update.count + update.added, update.payload,
+                shared ? nullptr : stats);
+    if (stats != nullptr) {
+      (shared ? stats->objects_shared : stats->objects_written)++;
+    }
+  }
+  for (const auto &entry : chunk_updates) {
+    const Update &update = entry.second;
+    const bool shared = update.count > 0;
+    write_entry(hash_key(CHUNK_PREFIX, entry.first),
+                update.count + update.added, update.payload,
+                shared ? nullptr : stats);
+    if (stats != nullptr) {
+      (shared ? stats->chunks_shared : stats->chunks_written)++;
+    }
+  }
+
+  // 新版本的引用先于旧版本的释放写入，共享的块和对象不会被中途删除
+  const std::string model_key = MODEL_PREFIX + name;
+  const std::string manifest =
+      join_ids(ids) + ';' + join_hashes(chunks, 0, chunks.size());
+  session_->upsert_kv(model_key.c_str(), manifest.c_str());
+  if (stats != nullptr) {
+    stats->bytes_written += model_key.size() + manifest.size();
+  }
+
+  int rc = 0;
+  if (replace) {
+    for (uint64_t chunk : old_chunks) {
+      rc |= release_chunk(chunk);
+    }
+  }
+  if (rc != 0) {
+    session_->rollback_transaction();
+    return -1;
+  }
+  return session_->commit_transaction() == 0 ? 0 : -1;
+}
+
+int ContentStore::remove_model(const std::string &name) {
+  std::vector<unsigned> ids;
+  std::vector<uint64_t> chunks;
+  if (read_model(name, ids, chunks) != 0) {
+    return -1;
+  }
+  if (session_->begin_transaction() != 0) {
+    return -1;
+  }
+  session_->delete_kv((MODEL_PREFIX + name).c_str());
+  int rc = 0;
+  for (uint64_t chunk : chunks) {
+    rc |= release_chunk(chunk);
+  }
+  if (rc != 0) {
+    session_->rollback_transaction();
+    return -1;
+  }
+  return session_->commit_transaction() == 0 ? 0 : -1;
+}
+
+int ContentStore::release_chunk(uint64_t hash) {
+  const std::string key = hash_key(CHUNK_PREFIX, hash);
+  uint64_t count;
+  std::string payload;
+  if (read_entry(key, count, payload) != 0) {
+    LOG(error, "ContentStore: missing chunk {}", key);
+    return -1;
+  }
+  if (count > 1) {
+    write_entry(key, count - 1, payload, nullptr);
+    return 0;
+  }
+  session_->delete_kv(key.c_str());
+  std::vector<uint64_t> members;
+  if (split_hashes(payload, members) != 0) {
+    LOG(error, "ContentStore: malformed chunk {}", key);
+    return -1;
+  }
+  int rc = 0;
+  for (uint64_t member : members) {
+    rc |= release_object(member);
+  }
+  return rc;
+}
+
+int ContentStore::release_object(uint64_t hash) {
+  const std::string key = hash_key(OBJECT_PREFIX, hash);
+  uint64_t count;
+  std::string payload;
+  if (read_entry(key, count, payload) != 0) {
+    LOG(error, "ContentStore: missing object {}", key);
+    return -1;
+  }
+  if (count > 1) {
+    write_entry(key, count - 1, payload, nullptr);
+  } else {
+    session_->delete_kv(key.c_str());
+  }
+  return 0;
+}
+
+int ContentStore::model_objects(
+    const std::string &name,
+    std::vector<std::pair<unsigned, uint64_t>> &objects) {
+  std::vector<unsigned> ids;
+  std::vector<uint64_t> chunks;
+  if (read_model(name, ids, chunks) != 0) {
+    return -1;
+  }
+  std::vector<uint64_t> hashes;
+  for (uint64_t chunk : chunks) {
+    uint64_t count;
+    std::string payload;
+    if (read_entry(hash_key(CHUNK_PREFIX, chunk), count, payload) != 0 ||
+        split_hashes(payload, hashes) != 0) {
+      LOG(error, "ContentStore: model {} has a bad chunk", name);
+      return -1;
+    }
+  }
+  if (hashes.size() != ids.size()) {
+    LOG(error, "ContentStore: model {} has {} names for {} objects", name,
+        ids.size(), hashes.size());
+    return -1;
+  }
+  objects.clear();
+  objects.reserve(ids.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    objects.emplace_back(ids[i], hashes[i]);
+  }
+  return 0;
+}
+
+int ContentStore::get_object(uint64_t hash, std::string &text) {
+  uint64_t count;
+  return read_entry(hash_key(OBJECT_PREFIX, hash), count, text);
+}
+
+int ContentStore::export_model(const std::string &name, std::string &data) {
+  std::vector<std::pair<unsigned, uint64_t>> objects;
+  if (model_objects(name, objects) != 0) {
+    return -1;
+  }
+  // 内容相同的实例中实例名最小的一个是引用的目标
+  std::unordered_map<uint64_t, unsigned> ids;
+  for (const auto &object : objects) {
+    ids.emplace(object.second, object.first);
+  }
+
+  data.clear();
+  std::string text;
+  for (const auto &object : objects) {
+    if (get_object(object.second, text) != 0) {
+      LOG(error, "ContentStore: model {} misses an object", name);
+      return -1;
+    }
+    data += '#';
+    data += std::to_string(object.first);
+    data += '=';
+    // 字符串中的 @ 原样保留，SPF 的字符串内引号写作 ''，按引号切换即可
+    bool in_string = false;
+    for (size_t k = 0; k < text.size(); k++) {
+      const char c = text[k];
+      uint64_t child;
+      if (c == '\'') {
+        in_string = !in_string;
+      } else if (c == '@' && !in_string && k + HASH_DIGITS < text.size() &&
+                 parse_hash(&text[k + 1], child)) {
+        auto it = ids.find(child);
+        if (it == ids.end()) {
+          LOG(error, "ContentStore: dangling reference in model {}", name);
+          return -1;
+        }
+        data += '#';
+        data += std::to_string(it->second);
+        k += HASH_DIGITS;
+        continue;
+      }
+      data += c;
+    }
+    data += ";\n";
+  }
+  return 0;
+}
+
+}  // namespace vulcan
@@ -0,0 +1,110 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace IfcParse {
+class IfcFile;
+}  // namespace IfcParse
+
+namespace vulcan {
+
+class DataStoreSession;
+
+struct ContentStoreStats {
+  // 新写入的对象数和已存在而共享的对象数
+  size_t objects_written = 0;
+  size_t objects_shared = 0;
+  size_t chunks_written = 0;
+  size_t chunks_shared = 0;
+  // 新写入的值的字节数
+  size_t bytes_written = 0;
+};
+
+/**
+ * @brief 跨模型、跨版本共享实例的内容寻址存储。
+ *
+ * 实例按 IfcDiff 的结构哈希寻址，保存为规范化文本：类型名和属性值按
+ * SPF 格式书写，引用写作 @ 加被引用实例的哈希。引用的子图相同时哈希
+ * 相同，因此相同的实例和子图在所有模型和版本中只保存一次。内容完全
+ * 相同的实例合并为一个对象。
+ *
+ * 模型版本是按实例名排列的 (实例名, 哈希) 列表，内容相同的实例各占
+ * 一项。哈希序列按内容切分为块，块也按哈希寻址；实例名序列通常是连续的，
+ * 按区间记录。块的边界由哈希值决定，增删实例只影响所在的块，实例名的
+ * 重新编号也不影响块，所以新版本的存储量与变化量成正比，而不是与模型
+ * 大小成正比。
+ *
+ * 块被模型引用计数，对象被块引用计数，每出现一次计一次，计数为 0 时
+ * 删除。键的格式为：
+ *   cas:o:<哈希>  对象，值为 "<计数>:<规范化文本>"
+ *   cas:c:<哈希>  块，值为 "<计数>:<对象哈希列表>"
+ *   cas:m:<模型名> 模型，值为 "<实例名区间列表>;<块哈希列表>"
+ * 哈希为 16 位十六进制数，实例名区间写作 <起>-<止>，列表以逗号分隔。
+ * 实例名与各块的对象按顺序一一对应。一个版本的全部修改在同一个事务中
+ * 写入。
+ *
+ * 不是线程安全的，调用者需串行访问同一个存储。
+ */
+class ContentStore {
+ public:
+  explicit ContentStore(std::shared_ptr<DataStoreSession> session)
+      : session_(std::move(session)) {}
+
+  /**
+   * @brief 保存模型的一个版本，同名的版本被替换。
+   * 会加载全部实例，调用者需持有模型的锁。
+   * @return 0 成功，-1 模型为空、存储中的数据损坏、哈希冲突或事务失败，
+   * 失败时存储不变
+   */
+  int put_model(const std::string &name, IfcParse::IfcFile *file,
+                ContentStoreStats *stats = nullptr);
+
+  /**
+   * @brief 删除模型版本，不再被引用的块和对象随之删除。
+   * @return 0 成功，-1 模型不存在、存储中的数据损坏或事务失败，失败时
+   * 存储不变
+   */
+  int remove_model(const std::string &name);
+
+  /**
+   * @brief 读取模型版本的 (实例名, 哈希) 列表，按实例名升序排列。
+   * @return 0 成功，-1 模型不存在或存储中的数据损坏
+   */
+  int model_objects(const std::string &name,
+                    std::vector<std::pair<unsigned, uint64_t>> &objects);
+
+  /**
+   * @brief 读取对象的规范化文本。
+   * @return 0 成功，-1 对象不存在
+   */
+  int get_object(uint64_t hash, std::string &text);
+
+  /**
+   * @brief 以 SPF DATA 段的格式导出模型版本，保留保存时的实例名。引用按
+   * 内容解析，指向内容相同的实例中实例名最小的一个。
+   * @return 0 成功，-1 模型不存在或存储中的数据损坏
+   */
+  int export_model(const std::string &name, std::string &data);
+
+ private:
+  int read_model(const std::string &name, std::vector<unsigned> &ids,
+                 std::vector<uint64_t> &chunks);
+  int read_entry(const std::string &key, uint64_t &count,
+                 std::string &payload);
+  void write_entry(const std::string &key, uint64_t count,
+                   const std::string &payload, ContentStoreStats *stats);
+  // 引用计数减一，为 0 时删除，块的对象随之释放
+  int release_chunk(uint64_t hash);
+  int release_object(uint64_t hash);
+
+  std::shared_ptr<DataStoreSession> session_;
+};
+
+}  // namespace vulcan
@@ -50,6 +50,11 @@ class DataStoreSession {
   virtual void upsert_kv(const char* key, const char* value) = 0;
   virtual bool insert_kv(const char* key, const char* value) = 0;
   virtual void delete_kv(const char* key) = 0;
+  // 事务：begin 之后的修改在 commit 时一起生效，rollback 时全部撤销，
+  // 返回 0 表示成功
+  virtual int begin_transaction() = 0;
+  virtual int commit_transaction() = 0;
+  virtual int rollback_transaction() = 0;
   // TODO: Scan接口
 };
 
@@ -147,4 +147,31 @@ void WiredTigerSession::delete_kv(const char* key) {
   CheckOp(cursor_->remove(cursor_), "cursor_->remove");
 }
 
+int WiredTigerSession::begin_transaction() {
+  int ret = session_->begin_transaction(session_, nullptr);
+  if (ret != 0) {
+    LOG(error, "WiredTigerSession: begin_transaction failed. {}",
+        wiredtiger_strerror(ret));
+  }
+  return ret;
+}
+
+int WiredTigerSession::commit_transaction() {
+  int ret = session_->commit_transaction(session_, nullptr);
+  if (ret != 0) {
+    LOG(error, "WiredTigerSession: commit_transaction failed. {}",
+        wiredtiger_strerror(ret));
+  }
+  return ret;
+}
+
+int WiredTigerSession::rollback_transaction() {
+  int ret = session_->rollback_transaction(session_, nullptr);
+  if (ret != 0) {
+    LOG(error, "WiredTigerSession: rollback_transaction failed. {}",
+        wiredtiger_strerror(ret));
+  }
+  return ret;
+}
+
 }  // namespace vulcan
@@ -38,6 +38,9 @@ class WiredTigerSession : public DataStoreSession {
   void upsert_kv(const char* key, const char* value) override;
   bool insert_kv(const char* key, const char* value) override;
   void delete_kv(const char* key) override;
+  int begin_transaction() override;
+  int commit_transaction() override;
+  int rollback_transaction() override;
 
  private:
   WT_CONNECTION* const conn_;
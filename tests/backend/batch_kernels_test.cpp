@@ -0,0 +1,114 @@
+// Copyright 2023 VulcanDB
+#include "backend/query/batch_kernels.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace vulcan {
+
+class BatchKernelsTest : public ::testing::Test {
+ protected:
+  static Column int_column(const std::vector<int64_t> &values,
+                           const std::vector<uint8_t> &valid) {
+    Column column;
+    column.type = ColumnType::INT;
+    column.ints = values;
+    column.valid = valid;
+    return column;
+  }
+
+  static QueryLiteral int_literal(int64_t value) {
+    QueryLiteral literal;
+    literal.kind = QueryLiteral::INT;
+    literal.int_value = value;
+    return literal;
+  }
+};
+
+TEST_F(BatchKernelsTest, FilterMatchesRowSemantics) {
+  // Arrange
+  Column ints = int_column({1, 5, 9, 0, 7}, {1, 1, 1, 0, 1});
+  Column names;
+  names.type = ColumnType::STRING;
+  names.enumeration = true;
+  names.strings = {"SOLID", "standard", "", "SOLID", "MOVABLE"};
+  names.valid = {1, 1, 0, 1, 1};
+  QueryLiteral real;
+  real.kind = QueryLiteral::REAL;
+  real.real_value = 4.5;
+  QueryLiteral null_literal;
+  QueryLiteral standard;
+  standard.kind = QueryLiteral::ENUM;
+  standard.str_value = "Standard";
+  std::vector<uint8_t> gt(5, 1), is_null(5, 1), not_enum(5, 1), mismatch(5, 1);
+
+  // Act
+  filter_column(ints, CompOp::GT, real, gt.data());
+  filter_column(ints, CompOp::EQ, null_literal, is_null.data());
+  filter_column(names, CompOp::NE, standard, not_enum.data());
+  filter_column(names, CompOp::EQ, int_literal(1), mismatch.data());
+
+  // Assert
+  EXPECT_EQ(std::vector<uint8_t>({0, 1, 1, 0, 1}), gt);
+  EXPECT_EQ(std::vector<uint8_t>({0, 0, 0, 1, 0}), is_null);
+  EXPECT_EQ(std::vector<uint8_t>({1, 0, 0, 1, 1}), not_enum);
+  EXPECT_EQ(0u, count_selected(mismatch.data(), mismatch.size()));
+}
+
+TEST_F(BatchKernelsTest, AggregatesMergeAcrossBatches) {
+  // Arrange
+  Column ints = int_column({4, -2, 100, 3}, {1, 1, 0, 1});
+  Column doubles;
+  doubles.type = ColumnType::DOUBLE;
+  doubles.doubles = {0.5, 10.25};
+  doubles.valid = {1, 1};
+  std::vector<uint8_t> int_mask = {1, 1, 1, 0};
+  std::vector<uint8_t> double_mask = {1, 1};
+  AggregateState count_star(AggFunc::COUNT), count(AggFunc::COUNT),
+      sum(AggFunc::SUM), avg(AggFunc::AVG), min(AggFunc::MIN),
+      max(AggFunc::MAX), int_sum(AggFunc::SUM), empty(AggFunc::SUM);
+
+  // Act
+  count_star.update(nullptr, int_mask.data(), 4);
+  count.update(&ints, int_mask.data(), 4);
+  int_sum.update(&ints, int_mask.data(), 4);
+  for (AggregateState *state : {&sum, &avg, &min, &max}) {
+    AggregateState first(*state), second(*state);
+    first.update(&ints, int_mask.data(), 4);
+    second.update(&doubles, double_mask.data(), 2);
+    state->merge(first);
+    state->merge(second);
+  }
+
+  // Assert
+  EXPECT_EQ("3", count_star.result());
+  EXPECT_EQ("2", count.result());
+  EXPECT_EQ("2", int_sum.result());
+  EXPECT_EQ("12.75", sum.result());
+  EXPECT_EQ("3.1875", avg.result());
+  EXPECT_EQ("-2", min.result());
+  EXPECT_EQ("10.25", max.result());
+  EXPECT_EQ("$", empty.result());
+}
+
+TEST_F(BatchKernelsTest, NonNumericAggregateFails) {
+  // Arrange
+  Column names;
+  names.type = ColumnType::STRING;
+  names.strings = {"a"};
+  names.valid = {1};
+  std::vector<uint8_t> mask = {1};
+  AggregateState sum(AggFunc::SUM), count(AggFunc::COUNT);
+
+  // Act
+  int sum_ret = sum.update(&names, mask.data(), 1);
+  int count_ret = count.update(&names, mask.data(), 1);
+
+  // Assert
+  EXPECT_EQ(-1, sum_ret);
+  EXPECT_EQ(0, count_ret);
+  EXPECT_EQ("1", count.result());
+}
+
+}  // namespace vulcan
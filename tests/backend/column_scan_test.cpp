@@ -0,0 +1,103 @@
+// Copyright 2023 VulcanDB
+#include "backend/query/column_scan.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "backend/db.h"
+#include "backend/query/query_parser.h"
+#include "backend/query/query_plan.h"
+#include "ifc_test_util.h"
+#include "ifcparse/IfcFile.h"
+
+namespace vulcan {
+
+namespace {
+
+// 超过两个 morsel 的长度量，LengthValue 依次为 1..n
+std::string length_model(size_t count) {
+  std::string data;
+  for (size_t i = 1; i <= count; i++) {
+    data += "#" + std::to_string(i) + "=IFCQUANTITYLENGTH('Length',$,$," +
+            std::to_string(i) + ".);\n";
+  }
+  return test::ifc_model(data);
+}
+
+}  // namespace
+
+class ColumnScanTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = std::filesystem::temp_directory_path() / "vulcan-column-scan.ifc";
+    std::ofstream(path_) << length_model(2 * ColumnScan::MORSEL_SIZE + 100);
+    db_.init("column_scan", path_.c_str());
+
+    Query query;
+    QueryParser parser;
+    QueryResolver resolver;
+    ASSERT_EQ(parser.parse("SELECT COUNT(*), SUM(LengthValue), "
+                           "MAX(LengthValue) FROM IfcQuantityLength",
+                           &query),
+              0);
+    ASSERT_EQ(resolver.resolve(query, db_.model()->schema(), &plan_), 0);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(path_);
+    std::filesystem::remove(path_.string() + ".rtree");
+  }
+
+  std::filesystem::path path_;
+  Db db_;
+  QueryPlan plan_;
+};
+
+TEST_F(ColumnScanTest, MorselsLoadConcurrentlyWithoutDbLock) {
+  // Arrange
+  ColumnScan serial(plan_, &db_, 100);
+  ASSERT_EQ(serial.init(), 0);
+  for (size_t i = 0; i < serial.morsel_count(); i++) {
+    serial.run_morsel(i);
+  }
+  std::string expected;
+  ASSERT_EQ(serial.finish(&expected), 0);
+  ColumnScan scan(plan_, &db_, 100);
+  ASSERT_EQ(scan.init(), 0);
+  ASSERT_EQ(scan.morsel_count(), 3u);
+
+  // Act
+  // 测试线程持有 Db 的锁，每个 morsel 在各自的线程上物化
+  db_.lock();
+  std::vector<std::future<void>> morsels;
+  for (size_t i = 0; i < scan.morsel_count(); i++) {
+    morsels.push_back(
+        std::async(std::launch::async, [&scan, i]() { scan.run_morsel(i); }));
+  }
+  std::vector<std::future_status> status;
+  for (std::future<void> &morsel : morsels) {
+    status.push_back(morsel.wait_for(std::chrono::seconds(10)));
+  }
+  db_.unlock();
+  for (std::future<void> &morsel : morsels) {
+    morsel.get();
+  }
+  std::string result;
+  ASSERT_EQ(scan.finish(&result), 0);
+
+  // Assert
+  for (std::future_status morsel_status : status) {
+    EXPECT_EQ(morsel_status, std::future_status::ready);
+  }
+  EXPECT_EQ(result, expected);
+  EXPECT_NE(result.find("16484, 135869370, 16484"), std::string::npos)
+      << result;
+}
+
+}  // namespace vulcan
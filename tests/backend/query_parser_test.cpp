@@ -0,0 +1,224 @@
+// Copyright 2023 VulcanDB
+#include "backend/query/query_parser.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+
+#include "backend/query/query_plan.h"
+
+namespace vulcan {
+
+class QueryParserTest : public ::testing::Test {
+ protected:
+  QueryParser parser_;
+  Query query_;
+};
+
+TEST_F(QueryParserTest, ParsesSelectWithPredicatesPathAndLimit) {
+  // Arrange
+  const char *text =
+      "select only IfcWall where Name = 'A''1' and PredefinedType != .SOLID."
+      " and Tag >= 1.5e2 -> IsDefinedBy -> RelatingPropertyDefinition "
+      "limit 10;";
+
+  // Act
+  int ret = parser_.parse(text, &query_);
+
+  // Assert
+  ASSERT_EQ(0, ret) << parser_.error();
+  ASSERT_EQ(Query::SELECT, query_.kind);
+  const SelectQuery &select = query_.select;
+  EXPECT_TRUE(select.only);
+  EXPECT_EQ("IfcWall", select.type_name);
+  ASSERT_EQ(3u, select.predicates.size());
+  EXPECT_EQ("Name", select.predicates[0].attribute);
+  EXPECT_EQ(CompOp::EQ, select.predicates[0].op);
+  EXPECT_EQ(QueryLiteral::STRING, select.predicates[0].value.kind);
+  EXPECT_EQ("A'1", select.predicates[0].value.str_value);
+  EXPECT_EQ(CompOp::NE, select.predicates[1].op);
+  EXPECT_EQ(QueryLiteral::ENUM, select.predicates[1].value.kind);
+  EXPECT_EQ("SOLID", select.predicates[1].value.str_value);
+  EXPECT_EQ(CompOp::GE, select.predicates[2].op);
+  EXPECT_EQ(QueryLiteral::REAL, select.predicates[2].value.kind);
+  EXPECT_DOUBLE_EQ(150.0, select.predicates[2].value.real_value);
+  ASSERT_EQ(2u, select.path.size());
+  EXPECT_EQ("IsDefinedBy", select.path[0]);
+  EXPECT_EQ("RelatingPropertyDefinition", select.path[1]);
+  EXPECT_EQ(10, select.limit);
+}
+
+TEST_F(QueryParserTest, ParsesInstanceReferenceAndLiterals) {
+  // Arrange
+  QueryParser null_parser;
+  Query null_query;
+
+  // Act
+  int ref_ret = parser_.parse("SELECT #42 -> Representation", &query_);
+  int null_ret = null_parser.parse(
+      "SELECT IfcDoor WHERE OverallHeight = NULL AND IsExternal = TRUE "
+      "AND OwnerHistory <> #7",
+      &null_query);
+
+  // Assert
+  ASSERT_EQ(0, ref_ret) << parser_.error();
+  EXPECT_TRUE(query_.select.type_name.empty());
+  EXPECT_EQ(42, query_.select.instance_id);
+  EXPECT_EQ(-1, query_.select.limit);
+  ASSERT_EQ(0, null_ret) << null_parser.error();
+  const auto &predicates = null_query.select.predicates;
+  ASSERT_EQ(3u, predicates.size());
+  EXPECT_EQ(QueryLiteral::NUL, predicates[0].value.kind);
+  EXPECT_EQ(QueryLiteral::BOOL, predicates[1].value.kind);
+  EXPECT_TRUE(predicates[1].value.bool_value);
+  EXPECT_EQ(QueryLiteral::REF, predicates[2].value.kind);
+  EXPECT_EQ(7, predicates[2].value.int_value);
+}
+
+TEST_F(QueryParserTest, ParsesOpenAndUse) {
+  // Arrange
+  Query use_query;
+
+  // Act
+  int open_ret = parser_.parse("OPEN '/data/house.ifc' AS house", &query_);
+  int use_ret = parser_.parse("use house;", &use_query);
+
+  // Assert
+  ASSERT_EQ(0, open_ret) << parser_.error();
+  EXPECT_EQ(Query::OPEN, query_.kind);
+  EXPECT_EQ("/data/house.ifc", query_.path);
+  EXPECT_EQ("house", query_.name);
+  ASSERT_EQ(0, use_ret) << parser_.error();
+  EXPECT_EQ(Query::USE, use_query.kind);
+  EXPECT_EQ("house", use_query.name);
+}
+
+TEST_F(QueryParserTest, ParsesColumnQuery) {
+  // Arrange
+  Query projection;
+
+  // Act
+  int agg_ret = parser_.parse(
+      "SELECT COUNT(*), sum(VolumeValue) FROM ONLY IfcQuantityVolume "
+      "WHERE Name = 'NetVolume'",
+      &query_);
+  int proj_ret =
+      parser_.parse("SELECT Name, Tag FROM IfcWall LIMIT 5", &projection);
+
+  // Assert
+  ASSERT_EQ(0, agg_ret) << parser_.error();
+  const SelectQuery &select = query_.select;
+  ASSERT_EQ(2u, select.items.size());
+  EXPECT_EQ(AggFunc::COUNT, select.items[0].func);
+  EXPECT_TRUE(select.items[0].attribute.empty());
+  EXPECT_EQ(AggFunc::SUM, select.items[1].func);
+  EXPECT_EQ("VolumeValue", select.items[1].attribute);
+  EXPECT_TRUE(select.only);
+  EXPECT_EQ("IfcQuantityVolume", select.type_name);
+  ASSERT_EQ(1u, select.predicates.size());
+  ASSERT_EQ(0, proj_ret) << parser_.error();
+  ASSERT_EQ(2u, projection.select.items.size());
+  EXPECT_EQ(AggFunc::NONE, projection.select.items[1].func);
+  EXPECT_EQ("Tag", projection.select.items[1].attribute);
+  EXPECT_EQ(5, projection.select.limit);
+}
+
+TEST_F(QueryParserTest, RejectsMalformedQueries) {
+  // Arrange
+  const char *queries[] = {
+      "",
+      "DELETE IfcWall",
+      "SELECT",
+      "SELECT IfcWall WHERE Name 'x'",
+      "SELECT IfcWall WHERE Name = 'unterminated",
+      "SELECT IfcWall ->",
+      "SELECT IfcWall LIMIT -1",
+      "SELECT IfcWall extra",
+      "OPEN house.ifc",
+      "SELECT # 1",
+      "SELECT Name FROM",
+      "SELECT SUM(*) FROM IfcWall",
+      "SELECT MEDIAN(Tag) FROM IfcWall",
+      "SELECT Name, FROM IfcWall",
+      "SELECT Name FROM IfcWall -> Tag",
+  };
+
+  for (const char *text : queries) {
+    // Act
+    Query query;
+    int ret = parser_.parse(text, &query);
+
+    // Assert
+    EXPECT_EQ(-1, ret) << text;
+    EXPECT_FALSE(parser_.error().empty()) << text;
+  }
+}
+
+TEST_F(QueryParserTest, ParsesWithinBox) {
+  // Arrange
+  QueryParser column_parser;
+  Query column_query;
+
+  // Act
+  int ret = parser_.parse(
+      "SELECT IfcWall WHERE Name = 'W' WITHIN (0, -1.5, 0, 10, 2, 3.) "
+      "-> ContainedInStructure",
+      &query_);
+  int column_ret = column_parser.parse(
+      "SELECT COUNT(*) FROM IfcWall WITHIN (0, 0, 0, 1, 1, 1)", &column_query);
+
+  // Assert
+  ASSERT_EQ(0, ret) << parser_.error();
+  const SelectQuery &select = query_.select;
+  EXPECT_TRUE(select.within);
+  const double expected[6] = {0, -1.5, 0, 10, 2, 3};
+  for (int i = 0; i < 6; i++) {
+    EXPECT_DOUBLE_EQ(expected[i], select.within_box[i]) << i;
+  }
+  EXPECT_EQ(1u, select.predicates.size());
+  EXPECT_EQ(1u, select.path.size());
+  EXPECT_EQ(-1, column_ret);
+  EXPECT_EQ(-1, parser_.parse("SELECT IfcWall WITHIN (0, 0, 0)", &query_));
+}
+
+TEST(QueryResolverTest, OpenIsConfinedToDataDir) {
+  // Arrange
+  std::filesystem::path root =
+      std::filesystem::temp_directory_path() / "vulcan-resolver-test";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root / "models");
+  std::filesystem::create_directory_symlink("/etc", root / "escape");
+  QueryResolver resolver;
+  resolver.set_data_dir(root.string() + "/");
+  auto open = [&resolver](const std::string &path, QueryPlan *plan) {
+    Query query;
+    query.kind = Query::OPEN;
+    query.path = path;
+    return resolver.resolve(query, nullptr, plan);
+  };
+
+  // Act
+  QueryPlan relative, absolute, rejected;
+  int relative_ret = open("models/house.ifc", &relative);
+  int absolute_ret = open((root / "house.ifc").string(), &absolute);
+
+  // Assert
+  ASSERT_EQ(0, relative_ret) << resolver.error();
+  EXPECT_EQ((root / "models/house.ifc").string(), relative.path_name);
+  ASSERT_EQ(0, absolute_ret) << resolver.error();
+  EXPECT_EQ((root / "house.ifc").string(), absolute.path_name);
+  for (const char *path : {"../house.ifc", "models/../../house.ifc",
+                           "/etc/passwd", "escape/passwd", "."}) {
+    EXPECT_EQ(-1, open(path, &rejected)) << path;
+    EXPECT_FALSE(resolver.error().empty()) << path;
+  }
+  QueryResolver unconfigured;
+  Query query;
+  query.kind = Query::OPEN;
+  query.path = "house.ifc";
+  EXPECT_EQ(-1, unconfigured.resolve(query, nullptr, &rejected));
+  std::filesystem::remove_all(root);
+}
+
+}  // namespace vulcan
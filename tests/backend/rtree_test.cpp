@@ -0,0 +1,111 @@
+// Copyright 2023 VulcanDB
+#include "backend/index/rtree.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace vulcan {
+
+class RTreeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::uniform_real_distribution<double> position(0, 1000);
+    std::uniform_real_distribution<double> size(0.1, 20);
+    for (uint32_t i = 0; i < 5000; i++) {
+      double x = position(rng_), y = position(rng_), z = position(rng_) / 10;
+      entries_.push_back(
+          {BoundingBox(x, y, z, x + size(rng_), y + size(rng_), z + size(rng_)),
+           i});
+    }
+    tree_.build(entries_);
+  }
+
+  BoundingBox random_box(double extent) {
+    std::uniform_real_distribution<double> position(0, 1000);
+    double x = position(rng_), y = position(rng_), z = position(rng_) / 10;
+    return BoundingBox(x, y, z, x + extent, y + extent, z + extent);
+  }
+
+  std::vector<uint32_t> brute_force(const BoundingBox &box) const {
+    std::vector<uint32_t> ids;
+    for (const RTree::Entry &entry : entries_) {
+      if (entry.box.intersects(box)) {
+        ids.push_back(entry.id);
+      }
+    }
+    return ids;
+  }
+
+  std::mt19937 rng_{7};
+  std::vector<RTree::Entry> entries_;
+  RTree tree_;
+};
+
+TEST_F(RTreeTest, BoxSearchMatchesBruteForce) {
+  for (int i = 0; i < 100; i++) {
+    // Arrange
+    BoundingBox box = random_box(i % 2 == 0 ? 5 : 80);
+    std::vector<uint32_t> expected = brute_force(box);
+
+    // Act
+    std::vector<uint32_t> ids;
+    tree_.search(box, &ids);
+
+    // Assert
+    std::sort(ids.begin(), ids.end());
+    EXPECT_EQ(ids, expected);
+  }
+  EXPECT_EQ(tree_.size(), entries_.size());
+  EXPECT_EQ(tree_.height(), 4);
+}
+
+TEST_F(RTreeTest, NearestIsOrderedByDistance) {
+  // Arrange
+  double point[3] = {500, 500, 50};
+  std::vector<double> distances;
+  for (const RTree::Entry &entry : entries_) {
+    distances.push_back(entry.box.distance2(point));
+  }
+  std::sort(distances.begin(), distances.end());
+
+  // Act
+  std::vector<std::pair<double, uint32_t>> result;
+  tree_.nearest(point, 10, &result);
+
+  // Assert
+  ASSERT_EQ(result.size(), 10u);
+  for (size_t i = 0; i < result.size(); i++) {
+    EXPECT_DOUBLE_EQ(result[i].first * result[i].first, distances[i]);
+  }
+}
+
+TEST_F(RTreeTest, SerializeRoundTrip) {
+  // Arrange
+  std::string data = tree_.serialize();
+  BoundingBox box = random_box(100);
+  std::vector<uint32_t> expected;
+  tree_.search(box, &expected);
+
+  // Act
+  RTree loaded;
+  int ret = loaded.deserialize(data);
+  std::vector<uint32_t> ids;
+  loaded.search(box, &ids);
+
+  // Assert
+  EXPECT_EQ(ret, 0);
+  EXPECT_EQ(ids, expected);
+  EXPECT_EQ(loaded.height(), tree_.height());
+
+  // 截断或篡改的数据被拒绝
+  EXPECT_EQ(loaded.deserialize(data.substr(0, data.size() - 1)), -1);
+  EXPECT_TRUE(loaded.empty());
+  std::string corrupted = data;
+  corrupted[corrupted.size() - 12] = 0x7f;  // 根节点的 first
+  EXPECT_EQ(loaded.deserialize(corrupted), -1);
+}
+
+}  // namespace vulcan
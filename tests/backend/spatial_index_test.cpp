@@ -0,0 +1,161 @@
+// Copyright 2023 VulcanDB
+#include "backend/index/spatial_index.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "backend/db.h"
+#include "backend/query/query_executor.h"
+#include "backend/session.h"
+#include "ifc_test_util.h"
+#include "ifcparse/IfcFile.h"
+
+namespace vulcan {
+
+namespace {
+
+/**
+ * 一面墙：4x2 的矩形剖面拉伸 3，放置在 (10, 0, 0)；
+ * 一根柱：同一剖面的映射，放大 2 倍后平移到 (0, 20, 0)。
+ */
+const char *TEST_DATA =
+    "#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+    "#2=IFCDIRECTION((0.,0.,1.));\n"
+    "#3=IFCDIRECTION((1.,0.,0.));\n"
+    "#4=IFCAXIS2PLACEMENT3D(#1,#2,#3);\n"
+    "#5=IFCLOCALPLACEMENT($,#4);\n"
+    "#6=IFCCARTESIANPOINT((10.,0.,0.));\n"
+    "#7=IFCAXIS2PLACEMENT3D(#6,$,$);\n"
+    "#8=IFCLOCALPLACEMENT(#5,#7);\n"
+    "#9=IFCCARTESIANPOINT((0.,0.));\n"
+    "#10=IFCAXIS2PLACEMENT2D(#9,$);\n"
+    "#11=IFCRECTANGLEPROFILEDEF(.AREA.,$,#10,4.,2.);\n"
+    "#12=IFCEXTRUDEDAREASOLID(#11,#4,#2,3.);\n"
+    "#13=IFCGEOMETRICREPRESENTATIONCONTEXT($,'Model',3,1.E-05,#4,$);\n"
+    "#14=IFCSHAPEREPRESENTATION(#13,'Body','SweptSolid',(#12));\n"
+    "#15=IFCPRODUCTDEFINITIONSHAPE($,$,(#14));\n"
+    "#16=IFCWALL('2O2Fr$t4X7Zf8NOew3FLOH',$,'Wall',$,$,#8,#15,$);\n"
+    "#17=IFCREPRESENTATIONMAP(#4,#14);\n"
+    "#18=IFCCARTESIANPOINT((0.,20.,0.));\n"
+    "#19=IFCCARTESIANTRANSFORMATIONOPERATOR3D($,$,#18,2.,$);\n"
+    "#20=IFCMAPPEDITEM(#17,#19);\n"
+    "#21=IFCSHAPEREPRESENTATION(#13,'Body','MappedRepresentation',(#20));\n"
+    "#22=IFCPRODUCTDEFINITIONSHAPE($,$,(#21));\n"
+    "#23=IFCCOLUMN('1kTvXnbbzCWw8lcMd1dR4o',$,'Column',$,$,#5,#22,$);\n"
+    "#24=IFCBUILDINGSTOREY('0wTdTKcJT5Ax6N3e0Fl$0t',$,'Storey',$,$,#5,$,$,"
+    ".ELEMENT.,0.);\n";
+
+}  // namespace
+
+class SpatialIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    model_ = test::open_ifc(TEST_DATA);
+    ASSERT_TRUE(model_->good());
+  }
+
+  std::unique_ptr<IfcParse::IfcFile> model_;
+  SpatialIndex index_;
+};
+
+TEST_F(SpatialIndexTest, BoxesFollowPlacementAndMapping) {
+  // Act
+  size_t count = index_.build(model_.get());
+
+  // Assert
+  // 楼层没有几何表示，不在索引中
+  EXPECT_EQ(count, 2u);
+  BoundingBox bounds = index_.tree().bounds();
+  EXPECT_DOUBLE_EQ(bounds.min[0], -4);
+  EXPECT_DOUBLE_EQ(bounds.min[1], -1);
+  EXPECT_DOUBLE_EQ(bounds.min[2], 0);
+  EXPECT_DOUBLE_EQ(bounds.max[0], 12);
+  EXPECT_DOUBLE_EQ(bounds.max[1], 22);
+  EXPECT_DOUBLE_EQ(bounds.max[2], 6);
+
+  double wall_point[3] = {11.5, 0.5, 2.5};
+  EXPECT_EQ(index_.search(wall_point), std::vector<uint32_t>{16});
+  double column_point[3] = {-3.5, 21.5, 5.5};
+  EXPECT_EQ(index_.search(column_point), std::vector<uint32_t>{23});
+  double empty_point[3] = {5, 10, 1};
+  EXPECT_TRUE(index_.search(empty_point).empty());
+}
+
+TEST_F(SpatialIndexTest, NearestReturnsClosestProduct) {
+  // Arrange
+  index_.build(model_.get());
+  double point[3] = {13, 0, 1};
+
+  // Act
+  std::vector<std::pair<double, uint32_t>> result = index_.nearest(point, 2);
+
+  // Assert
+  ASSERT_EQ(result.size(), 2u);
+  EXPECT_EQ(result[0].second, 16u);
+  EXPECT_DOUBLE_EQ(result[0].first, 1);
+  EXPECT_EQ(result[1].second, 23u);
+}
+
+TEST_F(SpatialIndexTest, FileRoundTripKeepsEntries) {
+  // Arrange
+  index_.build(model_.get());
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "vulcan-spatial-index.rtree";
+  SpatialIndex loaded;
+
+  // Act
+  int saved = index_.save(path.string());
+  int ret = loaded.load(path.string());
+
+  // Assert
+  ASSERT_EQ(saved, 0);
+  ASSERT_EQ(ret, 0);
+  EXPECT_EQ(loaded.size(), index_.size());
+  double wall_point[3] = {11.5, 0.5, 2.5};
+  EXPECT_EQ(loaded.search(wall_point), std::vector<uint32_t>{16});
+  EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+  std::filesystem::remove(path);
+  EXPECT_EQ(loaded.load(path.string()), -1);
+}
+
+TEST(SpatialQueryTest, WithinFiltersProductsByBoundingBox) {
+  // Arrange
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "vulcan-spatial-query.ifc";
+  std::ofstream(path) << test::ifc_model(TEST_DATA);
+  DbManager::get_instance()->open("spatial_query", path.string());
+  Session session;
+  ASSERT_TRUE(session.set_current_db("spatial_query"));
+  QueryParser parser;
+  Query query;
+  ASSERT_EQ(parser.parse("SELECT IfcProduct WITHIN (13, 1, 4, 9, -1, 0)",
+                         &query), 0) << parser.error();
+  QueryResolver resolver;
+  QueryPlan plan;
+  ASSERT_EQ(resolver.resolve(query,
+                             session.get_current_db()->model()->schema(),
+                             &plan), 0) << resolver.error();
+
+  // Act
+  QueryExecutor executor;
+  std::string result;
+  int ret = executor.execute(plan, &session, &result);
+
+  // Assert
+  ASSERT_EQ(ret, 0) << executor.error();
+  EXPECT_NE(result.find("#16=IfcWall"), std::string::npos) << result;
+  EXPECT_EQ(result.find("#23=IfcColumn"), std::string::npos) << result;
+  EXPECT_NE(result.find("(1 rows)"), std::string::npos) << result;
+  // 第一次空间查询建立的索引写在模型旁，下次打开时直接加载
+  std::string index_path = path.string() + ".rtree";
+  EXPECT_TRUE(std::filesystem::exists(index_path));
+  std::filesystem::remove(index_path);
+  std::filesystem::remove(path);
+}
+
+}  // namespace vulcan
@@ -0,0 +1,170 @@
+// Copyright 2023 VulcanDB
+#include "backend/seda/timer_wheel.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "backend/seda/callback.h"
+#include "backend/seda/stage.h"
+#include "backend/seda/stage_event.h"
+#include "common/vulcan_utility.h"
+
+namespace vulcan {
+
+// 不启动定时器线程，通过 advance 手动推进时间轮
+class TimerWheelTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    wheel_.reset(new TimerWheel());
+    // 第一个定时器会把时间轮对齐到当前时间
+    base_ms_ = monotonic_ms() + 1000;
+  }
+
+  TimerWheel::TimerId schedule_at(uint64_t deadline_ms) {
+    return wheel_->schedule(
+        deadline_ms, [this, deadline_ms]() { fired_.push_back(deadline_ms); });
+  }
+
+  std::unique_ptr<TimerWheel> wheel_;
+  uint64_t base_ms_;
+  std::vector<uint64_t> fired_;
+};
+
+TEST_F(TimerWheelTest, FiresInDeadlineOrderAcrossLevels) {
+  // Arrange
+  std::vector<uint64_t> deadlines = {base_ms_ + 70000, base_ms_ + 3,
+                                     base_ms_ + 300, base_ms_ + 255,
+                                     base_ms_ + 65536};
+  for (uint64_t deadline : deadlines) {
+    schedule_at(deadline);
+  }
+
+  // Act
+  size_t fired_early = wheel_->advance(base_ms_ + 2);
+  size_t fired_all = wheel_->advance(base_ms_ + 70000);
+
+  // Assert
+  EXPECT_EQ(fired_early, 0u);
+  EXPECT_EQ(fired_all, deadlines.size());
+  std::vector<uint64_t> expected = {base_ms_ + 3, base_ms_ + 255,
+                                    base_ms_ + 300, base_ms_ + 65536,
+                                    base_ms_ + 70000};
+  EXPECT_EQ(fired_, expected);
+  EXPECT_EQ(wheel_->size(), 0u);
+}
+
+TEST_F(TimerWheelTest, CancelledTimerDoesNotFire) {
+  // Arrange
+  TimerWheel::TimerId keep = schedule_at(base_ms_ + 10);
+  TimerWheel::TimerId drop = schedule_at(base_ms_ + 10);
+
+  // Act
+  bool cancelled = wheel_->cancel(drop);
+  wheel_->advance(base_ms_ + 10);
+
+  // Assert
+  EXPECT_TRUE(cancelled);
+  EXPECT_EQ(fired_.size(), 1u);
+  EXPECT_FALSE(wheel_->cancel(keep));
+  EXPECT_FALSE(wheel_->cancel(drop));
+}
+
+TEST_F(TimerWheelTest, ExpiredDeadlineFiresOnNextAdvance) {
+  // Arrange
+  schedule_at(base_ms_ + 5);
+  wheel_->advance(base_ms_ + 5);
+  schedule_at(base_ms_ - 100);
+
+  // Act
+  size_t fired = wheel_->advance(base_ms_ + 6);
+
+  // Assert
+  EXPECT_EQ(fired, 1u);
+  EXPECT_EQ(fired_.size(), 2u);
+}
+
+TEST_F(TimerWheelTest, TimerIdIsVisibleToExpiry) {
+  // Arrange
+  TimerWheel::TimerId id = TimerWheel::INVALID_TIMER;
+  TimerWheel::TimerId seen = TimerWheel::INVALID_TIMER;
+  TimerWheel::TimerId returned =
+      wheel_->schedule(base_ms_ + 1, [&]() { seen = id; }, &id);
+
+  // Act
+  wheel_->advance(base_ms_ + 1);
+
+  // Assert
+  EXPECT_NE(returned, TimerWheel::INVALID_TIMER);
+  EXPECT_EQ(id, returned);
+  EXPECT_EQ(seen, returned);
+}
+
+TEST(TimerWheelThreadTest, EarlierTimerWakesSleepingThread) {
+  // Arrange
+  TimerWheel wheel;
+  ASSERT_EQ(wheel.start(), 0);
+  // 定时器线程睡眠到一分钟后的槽
+  wheel.schedule(monotonic_ms() + 60000, []() {});
+  std::promise<uint64_t> fired;
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // Act
+  uint64_t deadline_ms = monotonic_ms() + 20;
+  wheel.schedule(deadline_ms, [&]() { fired.set_value(monotonic_ms()); });
+  std::future<uint64_t> result = fired.get_future();
+
+  // Assert
+  ASSERT_EQ(result.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+  uint64_t fired_ms = result.get();
+  EXPECT_GE(fired_ms, deadline_ms);
+  EXPECT_LT(fired_ms, deadline_ms + 1000);
+  EXPECT_EQ(wheel.size(), 1u);
+  wheel.stop();
+}
+
+// 未连接线程池的 stage，事件一直留在队列中
+class IdleStage : public Stage {
+ public:
+  IdleStage() : Stage("IdleStage") {}
+
+  void handle_event(StageEvent *) override { handled_++; }
+  void callback_event(StageEvent *event, CallbackContext *) override {
+    delete event;
+  }
+  void timeout_event(StageEvent *event, CallbackContext *) override {
+    timed_out_++;
+    delete event;
+  }
+
+  int handled_ = 0;
+  int timed_out_ = 0;
+};
+
+TEST(TimeoutInfoTest, ExpiryTimesOutQueuedEvent) {
+  // Arrange
+  IdleStage stage;
+  StageEvent *event = new StageEvent();
+  event->push_callback(new CompletionCallback(&stage));
+  uint64_t deadline_ms = monotonic_ms() + 5;
+  event->set_deadline(deadline_ms);
+  ASSERT_TRUE(stage.add_event(event));
+
+  // Act
+  TimerWheel::get_instance()->advance(deadline_ms - 1);
+  int64_t qlen_before = stage.qlen();
+  TimerWheel::get_instance()->advance(deadline_ms);
+
+  // Assert
+  EXPECT_EQ(qlen_before, 1);
+  EXPECT_EQ(stage.timed_out_, 1);
+  EXPECT_EQ(stage.handled_, 0);
+  EXPECT_EQ(stage.qlen(), 0);
+}
+
+}  // namespace vulcan
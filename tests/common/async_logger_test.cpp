@@ -0,0 +1,145 @@
+// Copyright 2023 VulcanDB
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/log_ring_buffer.h"
+#include "common/vulcan_logger.h"
+
+namespace vulcan {
+
+// Test case for slot reuse and ordering in the ring buffer
+TEST(LogRingBufferTest, ClaimPublishAndPopInOrder) {
+  // Arrange
+  LogRingBuffer queue(3);
+  ASSERT_EQ(queue.capacity(), 4u);
+
+  // Act
+  std::vector<LogRecord *> claimed;
+  for (int i = 0; i < 4; i++) {
+    LogRecord *record = queue.try_claim();
+    ASSERT_NE(record, nullptr);
+    record->thread_id = i;
+    claimed.push_back(record);
+  }
+  LogRecord *overflow = queue.try_claim();
+  // 先发布后占用的槽位，队首未发布时消费者看不到后面的记录
+  queue.publish(claimed[1]);
+  LogRecord *blocked = queue.front();
+  queue.publish(claimed[0]);
+
+  // Assert
+  EXPECT_EQ(overflow, nullptr);
+  EXPECT_EQ(blocked, nullptr);
+  LogRecord *first = queue.front();
+  ASSERT_EQ(first, claimed[0]);
+  queue.pop(first);
+  EXPECT_NE(queue.try_claim(), nullptr);
+  ASSERT_EQ(queue.front(), claimed[1]);
+  EXPECT_EQ(queue.consumed(), 1u);
+  EXPECT_EQ(queue.enqueued(), 5u);
+}
+
+// Test case for concurrent producers: every record arrives exactly once
+TEST(LogRingBufferTest, ConcurrentProducersDeliverEveryRecord) {
+  // Arrange
+  const int producers = 4;
+  const int per_producer = 20000;
+  LogRingBuffer queue(64);
+  std::vector<std::thread> threads;
+
+  // Act
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&queue, p] {
+      for (int i = 0; i < per_producer; i++) {
+        LogRecord *record;
+        while ((record = queue.try_claim()) == nullptr) {
+          std::this_thread::yield();
+        }
+        record->thread_id = p * per_producer + i;
+        queue.publish(record);
+      }
+    });
+  }
+  std::set<size_t> seen;
+  std::vector<size_t> last(producers, 0);
+  bool ordered = true;
+  while (seen.size() < static_cast<size_t>(producers * per_producer)) {
+    LogRecord *record = queue.front();
+    if (record == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    size_t value = record->thread_id;
+    size_t p = value / per_producer;
+    ordered = ordered && last[p] <= value;
+    last[p] = value;
+    seen.insert(value);
+    queue.pop(record);
+  }
+  for (std::thread &t : threads) {
+    t.join();
+  }
+
+  // Assert
+  EXPECT_EQ(seen.size(), static_cast<size_t>(producers * per_producer));
+  EXPECT_TRUE(ordered);
+  EXPECT_EQ(queue.front(), nullptr);
+}
+
+// Test case for the asynchronous logger writing to the file sink
+TEST(AsyncLoggerTest, FlushWritesEveryMessage) {
+  // Arrange
+  std::filesystem::path dir = std::filesystem::temp_directory_path() /
+                              ("vulcan_async_log_" + std::to_string(getpid()));
+  VulcanLogger *logger = VulcanLogger::get_instance();
+  logger->init(dir, "async", TRACE, PANIC);
+  ASSERT_EQ(logger->enable_async(16, LogOverflowPolicy::BLOCK), 0);
+  ASSERT_EQ(logger->enable_async(16, LogOverflowPolicy::BLOCK), -1);
+  const int threads = 4;
+  const int per_thread = 500;
+
+  // Act
+  std::vector<std::thread> writers;
+  for (int t = 0; t < threads; t++) {
+    writers.emplace_back([t] {
+      for (int i = 0; i < per_thread; i++) {
+        // 整数参数延迟格式化，字符串参数在调用线程格式化
+        LOG(info, "deferred {} {} {:.1f}", t, i, 0.5);
+        LOG(warn, "eager {}", std::string("thread-") + std::to_string(t));
+      }
+    });
+  }
+  for (std::thread &w : writers) {
+    w.join();
+  }
+  logger->flush();
+  logger->disable_async();
+
+  // Assert
+  std::ifstream log_file(dir / "async.log");
+  std::string line;
+  int deferred = 0;
+  int eager = 0;
+  bool last_seen = false;
+  while (std::getline(log_file, line)) {
+    deferred += line.find("[info]") != std::string::npos &&
+                line.find("deferred ") != std::string::npos;
+    eager += line.find("[warning] [") != std::string::npos &&
+             line.find("eager thread-") != std::string::npos;
+    last_seen = last_seen || line.find("deferred 3 499 0.5") != line.npos;
+  }
+  EXPECT_EQ(deferred, threads * per_thread);
+  EXPECT_EQ(eager, threads * per_thread);
+  EXPECT_TRUE(last_seen);
+  EXPECT_EQ(logger->dropped(), 0u);
+  std::filesystem::remove_all(dir);
+}
+
+}  // namespace vulcan
@@ -0,0 +1,75 @@
+// Copyright 2023 VulcanDB
+#include "common/latency_histogram.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace vulcan {
+
+class LatencyHistogramTest : public ::testing::Test {
+ protected:
+  void SetUp() override { histogram_.reset(new LatencyHistogram()); }
+
+  std::unique_ptr<LatencyHistogram> histogram_;
+};
+
+TEST_F(LatencyHistogramTest, BucketBoundsCoverValue) {
+  // Arrange
+  std::vector<uint64_t> values = {0, 1, 31, 32, 33, 1000, 123456789};
+
+  for (uint64_t value : values) {
+    // Act
+    int index = LatencyHistogram::bucket_index(value);
+
+    // Assert
+    EXPECT_LE(LatencyHistogram::bucket_lower_bound(index), value);
+    EXPECT_GT(LatencyHistogram::bucket_lower_bound(index + 1), value);
+  }
+}
+
+TEST_F(LatencyHistogramTest, PercentileWithinRelativeError) {
+  // Arrange
+  for (uint64_t i = 1; i <= 10000; i++) {
+    histogram_->record(i);
+  }
+
+  // Act
+  LatencyHistogram::Snapshot snap = histogram_->snapshot();
+
+  // Assert
+  EXPECT_EQ(snap.total, 10000u);
+  EXPECT_EQ(snap.max, 10000u);
+  EXPECT_EQ(snap.mean(), 5000u);
+  EXPECT_NEAR(snap.percentile(0.5), 5000, 5000 / 16);
+  EXPECT_NEAR(snap.percentile(0.99), 9900, 9900 / 16);
+}
+
+TEST_F(LatencyHistogramTest, ConcurrentRecordsAreMerged) {
+  // Arrange
+  const int threads = 4;
+  const int per_thread = 10000;
+
+  // Act
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([this, t]() {
+      for (int i = 0; i < per_thread; i++) {
+        histogram_->record(t + 1);
+      }
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+
+  // Assert
+  LatencyHistogram::Snapshot snap = histogram_->snapshot();
+  EXPECT_EQ(snap.total, static_cast<uint64_t>(threads * per_thread));
+  EXPECT_EQ(snap.max, static_cast<uint64_t>(threads));
+  EXPECT_EQ(snap.counts[1], static_cast<uint64_t>(per_thread));
+}
+
+}  // namespace vulcan
@@ -0,0 +1,133 @@
+// Copyright 2023 VulcanDB
+#include "common/lock_profiler.h"
+
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/mutex.h"
+
+namespace vulcan {
+
+class LockProfilerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    LockProfiler::set_sample_period(1);
+    LockProfiler::reset();
+  }
+
+  void TearDown() override {
+    LockProfiler::set_sample_period(LockProfiler::DEFAULT_SAMPLE_PERIOD);
+  }
+
+  static LockSite::Counters counters_of(int line) {
+    for (LockSite *site = LockSite::head(); site != nullptr;
+         site = site->next()) {
+      if (site->line() == line &&
+          strstr(site->file(), "lock_profiler_test.cpp") != nullptr) {
+        return site->collect();
+      }
+    }
+    return LockSite::Counters();
+  }
+
+  pthread_mutex_t mutex_ = PTHREAD_MUTEX_INITIALIZER;
+};
+
+// Test case for uncontended acquisitions: counted, never timed
+TEST_F(LockProfilerTest, UncontendedLockIsCountedOnly) {
+  // Arrange
+  int line = 0;
+
+  // Act
+  for (int i = 0; i < 100; i++) {
+    line = __LINE__ + 1;
+    MUTEX_LOCK(&mutex_);
+    MUTEX_UNLOCK(&mutex_);
+  }
+
+  // Assert
+  LockSite::Counters counters = counters_of(line);
+  EXPECT_EQ(counters.acquisitions, 100u);
+  EXPECT_EQ(counters.contended, 0u);
+  EXPECT_EQ(counters.estimated_wait_ns(), 0u);
+}
+
+// Test case for a held lock: the waiter is reported at its call site
+TEST_F(LockProfilerTest, ContendedWaitIsReportedBySite) {
+  // Arrange
+  MUTEX_LOCK(&mutex_);
+  int line = __LINE__ + 4;
+
+  // Act
+  std::thread waiter([this] {
+    MUTEX_LOCK(&mutex_);
+    MUTEX_UNLOCK(&mutex_);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  MUTEX_UNLOCK(&mutex_);
+  waiter.join();
+
+  // Assert
+  LockSite::Counters counters = counters_of(line);
+  EXPECT_EQ(counters.acquisitions, 1u);
+  EXPECT_EQ(counters.contended, 1u);
+  EXPECT_GE(counters.max_wait_ns, 10u * 1000 * 1000);
+  std::string report = LockProfiler::report(1);
+  EXPECT_NE(report.find("lock_profiler_test.cpp:" + std::to_string(line) +
+                        ": acquisitions=1 contended=1"),
+            std::string::npos)
+      << report;
+}
+
+// Test case for sampling: counts stay exact, wait time is extrapolated
+TEST_F(LockProfilerTest, SampledWaitIsExtrapolated) {
+  // Arrange
+  LockProfiler::set_sample_period(8);
+  const int threads = 4;
+  const int per_thread = 2000;
+  int line = __LINE__ + 7;
+
+  // Act
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([this] {
+      for (int i = 0; i < per_thread; i++) {
+        MUTEX_LOCK(&mutex_);
+        std::this_thread::yield();
+        MUTEX_UNLOCK(&mutex_);
+      }
+    });
+  }
+  for (std::thread &w : workers) {
+    w.join();
+  }
+
+  // Assert
+  LockSite::Counters counters = counters_of(line);
+  EXPECT_EQ(counters.acquisitions, static_cast<uint64_t>(threads * per_thread));
+  ASSERT_GT(counters.contended, 0u);
+  EXPECT_LT(counters.sampled_contended, counters.contended);
+  EXPECT_GE(counters.estimated_wait_ns(), counters.wait_ns);
+}
+
+// Test case for a disabled profiler: plain pthread_mutex_lock
+TEST_F(LockProfilerTest, DisabledProfilerRecordsNothing) {
+  // Arrange
+  LockProfiler::set_sample_period(0);
+  int line = __LINE__ + 3;
+
+  // Act
+  MUTEX_LOCK(&mutex_);
+  MUTEX_UNLOCK(&mutex_);
+
+  // Assert
+  EXPECT_EQ(counters_of(line).acquisitions, 0u);
+}
+
+}  // namespace vulcan
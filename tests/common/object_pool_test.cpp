@@ -0,0 +1,128 @@
+// Copyright 2023 VulcanDB
+#include "common/object_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <list>
+#include <thread>
+#include <vector>
+
+namespace vulcan {
+
+namespace {
+
+class SmallObject : public PooledObject {
+ public:
+  virtual ~SmallObject() = default;
+  char payload[40];
+};
+
+class LargeObject : public SmallObject {
+ public:
+  char more[200];
+};
+
+}  // namespace
+
+#ifndef __SANITIZE_ADDRESS__
+
+// Test case for reuse: a freed block is handed out again on the same thread
+TEST(ObjectPoolTest, FreedBlockIsReused) {
+  // Arrange
+  SmallObject *first = new SmallObject();
+  delete first;
+  uint64_t heap_blocks = ObjectPool::heap_blocks();
+
+  // Act
+  SmallObject *second = new SmallObject();
+
+  // Assert
+  EXPECT_EQ(second, first);
+  EXPECT_EQ(ObjectPool::heap_blocks(), heap_blocks);
+  delete second;
+}
+
+// Test case for deletion through a base pointer: the derived size is used
+TEST(ObjectPoolTest, DerivedObjectReturnsToItsSizeClass) {
+  // Arrange
+  SmallObject *large = new LargeObject();
+  delete large;
+  uint64_t heap_blocks = ObjectPool::heap_blocks();
+
+  // Act
+  LargeObject *again = new LargeObject();
+  SmallObject *small = new SmallObject();
+
+  // Assert
+  EXPECT_EQ(static_cast<SmallObject *>(again), large);
+  EXPECT_NE(small, large);
+  EXPECT_LE(ObjectPool::heap_blocks(), heap_blocks + 1);
+  delete again;
+  delete small;
+}
+
+// Test case for producer/consumer threads: blocks flow back via the depot
+TEST(ObjectPoolTest, CrossThreadFreesAreRecycled) {
+  // Arrange
+  const int rounds = 20;
+  const int per_round = 1000;
+  auto exchange = [&] {
+    std::vector<SmallObject *> objects;
+    for (int i = 0; i < per_round; i++) {
+      objects.push_back(new SmallObject());
+    }
+    std::thread consumer([&objects] {
+      for (SmallObject *object : objects) {
+        delete object;
+      }
+    });
+    consumer.join();
+  };
+  exchange();
+  uint64_t heap_blocks = ObjectPool::heap_blocks();
+
+  // Act
+  for (int round = 1; round < rounds; round++) {
+    exchange();
+  }
+
+  // Assert
+  EXPECT_EQ(ObjectPool::heap_blocks(), heap_blocks);
+}
+
+// Test case for the STL allocator: list nodes come from the pool
+TEST(ObjectPoolTest, PoolAllocatorServesListNodes) {
+  // Arrange
+  std::list<int, PoolAllocator<int>> warm(100, 0);
+  warm.clear();
+  uint64_t heap_blocks = ObjectPool::heap_blocks();
+
+  // Act
+  std::list<int, PoolAllocator<int>> values;
+  for (int i = 0; i < 100; i++) {
+    values.push_back(i);
+  }
+
+  // Assert
+  EXPECT_EQ(values.size(), 100u);
+  EXPECT_EQ(values.back(), 99);
+  EXPECT_EQ(ObjectPool::heap_blocks(), heap_blocks);
+}
+
+#endif  // __SANITIZE_ADDRESS__
+
+// Test case for requests over MAX_SIZE: served by the global operator new
+TEST(ObjectPoolTest, OversizedRequestBypassesPool) {
+  // Arrange
+  uint64_t heap_blocks = ObjectPool::heap_blocks();
+
+  // Act
+  void *ptr = ObjectPool::allocate(ObjectPool::MAX_SIZE + 1);
+
+  // Assert
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(ObjectPool::heap_blocks(), heap_blocks);
+  ObjectPool::deallocate(ptr, ObjectPool::MAX_SIZE + 1);
+}
+
+}  // namespace vulcan
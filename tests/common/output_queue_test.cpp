@@ -0,0 +1,166 @@
+// Copyright 2023 VulcanDB
+#include "common/io/output_queue.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace vulcan {
+
+class OutputQueueTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds_), 0);
+    fcntl(fds_[0], F_SETFL, fcntl(fds_[0], F_GETFL) | O_NONBLOCK);
+  }
+
+  void TearDown() override {
+    ::close(fds_[0]);
+    ::close(fds_[1]);
+  }
+
+  std::string read_all(size_t len) {
+    std::string result(len, '\0');
+    size_t got = 0;
+    while (got < len) {
+      ssize_t ret = ::read(fds_[1], &result[got], len - got);
+      if (ret <= 0) break;
+      got += ret;
+    }
+    result.resize(got);
+    return result;
+  }
+
+  int fds_[2];
+};
+
+// Test case for gathering several fragments into one flush
+TEST_F(OutputQueueTest, FlushFragmentsInOrder) {
+  // Arrange
+  static const char terminator = '\0';
+  OutputQueue queue;
+  queue.append(std::string("Hello, "));
+  queue.append(std::string("world!"));
+  queue.append_ref(&terminator, 1);
+  ASSERT_EQ(queue.pending_bytes(), 14u);
+
+  // Act
+  OutputQueue::FlushStatus status = queue.flush(fds_[0]);
+
+  // Assert
+  ASSERT_EQ(status, OutputQueue::FLUSH_DONE);
+  ASSERT_TRUE(queue.empty());
+  ASSERT_EQ(read_all(14), std::string("Hello, world!\0", 14));
+}
+
+// Test case for a full socket buffer: flush must not block
+TEST_F(OutputQueueTest, FlushPendingWhenSocketFull) {
+  // Arrange
+  OutputQueue queue;
+  const size_t len = 8 * 1024 * 1024;
+  queue.append(std::string(len, 'x'));
+
+  // Act
+  OutputQueue::FlushStatus status = queue.flush(fds_[0]);
+
+  // Assert
+  ASSERT_EQ(status, OutputQueue::FLUSH_PENDING);
+  ASSERT_GT(queue.pending_bytes(), 0u);
+  ASSERT_LT(queue.pending_bytes(), len);
+}
+
+// Test case for file-backed fragments sent with sendfile
+TEST_F(OutputQueueTest, FlushFileFragment) {
+  // Arrange
+  FILE *tmp = tmpfile();
+  ASSERT_NE(tmp, nullptr);
+  const std::string content = "ISO-10303-21;";
+  ASSERT_EQ(::write(fileno(tmp), content.data(), content.size()),
+            static_cast<ssize_t>(content.size()));
+  OutputQueue queue;
+  queue.append(std::string("<"));
+  queue.append_file(dup(fileno(tmp)), 4, content.size() - 4);
+  queue.append(std::string(">"));
+  fclose(tmp);
+
+  // Act
+  OutputQueue::FlushStatus status = queue.flush(fds_[0]);
+
+  // Assert
+  ASSERT_EQ(status, OutputQueue::FLUSH_DONE);
+  ASSERT_EQ(read_all(content.size() - 2), "<10303-21;>");
+}
+
+// Test case for a closed peer: flush reports EPIPE instead of raising SIGPIPE
+TEST_F(OutputQueueTest, FlushErrorWhenPeerClosed) {
+  // Arrange
+  OutputQueue queue;
+  queue.append(std::string("lost"));
+  ::close(fds_[1]);
+  fds_[1] = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  // Act
+  OutputQueue::FlushStatus status = queue.flush(fds_[0]);
+
+  // Assert
+  ASSERT_EQ(status, OutputQueue::FLUSH_ERROR);
+  ASSERT_EQ(errno, EPIPE);
+}
+
+// Test case for zerocopy completions: reaping the error queue releases every
+// send submitted with MSG_ZEROCOPY
+TEST(OutputQueueZeroCopyTest, ReapCompletions) {
+  // Arrange
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addrlen = sizeof(addr);
+  ASSERT_EQ(bind(listener, (struct sockaddr *)&addr, sizeof(addr)), 0);
+  ASSERT_EQ(listen(listener, 1), 0);
+  ASSERT_EQ(getsockname(listener, (struct sockaddr *)&addr, &addrlen), 0);
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(client, (struct sockaddr *)&addr, sizeof(addr)), 0);
+  int server = ::accept(listener, nullptr, nullptr);
+  ASSERT_GE(server, 0);
+  fcntl(server, F_SETFL, fcntl(server, F_GETFL) | O_NONBLOCK);
+
+  OutputQueue queue;
+  if (queue.enable_zerocopy(server) < 0) {
+    ::close(server);
+    ::close(client);
+    ::close(listener);
+    GTEST_SKIP() << "SO_ZEROCOPY is not supported";
+  }
+  const size_t len = OutputQueue::ZEROCOPY_THRESHOLD * 2;
+  queue.append(std::string(len, 'z'));
+
+  // Act
+  ASSERT_EQ(queue.flush(server), OutputQueue::FLUSH_DONE);
+  std::string received(len, '\0');
+  size_t got = 0;
+  while (got < len) {
+    ssize_t ret = ::read(client, &received[got], len - got);
+    ASSERT_GT(ret, 0);
+    got += ret;
+  }
+  for (int i = 0; i < 1000 && queue.zerocopy_pending(); i++) {
+    queue.reap_zerocopy(server);
+    usleep(1000);
+  }
+
+  // Assert
+  EXPECT_FALSE(queue.zerocopy_pending());
+  EXPECT_EQ(received, std::string(len, 'z'));
+  ::close(server);
+  ::close(client);
+  ::close(listener);
+}
+
+}  // namespace vulcan
@@ -0,0 +1,111 @@
+// Copyright 2023 VulcanDB
+#include "common/roaring_bitmap.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace vulcan {
+
+class RoaringBitmapTest : public ::testing::Test {
+ protected:
+  // 生成跨越多个容器的随机值，同时填充 bitmap 和作为参照的 set
+  void fill(size_t count, uint32_t range, RoaringBitmap *bitmap,
+            std::set<uint32_t> *reference) {
+    std::uniform_int_distribution<uint32_t> dist(0, range);
+    for (size_t i = 0; i < count; i++) {
+      uint32_t value = dist(rng_);
+      bitmap->add(value);
+      reference->insert(value);
+    }
+  }
+
+  static std::vector<uint32_t> values(const std::set<uint32_t> &set) {
+    return std::vector<uint32_t>(set.begin(), set.end());
+  }
+
+  std::mt19937 rng_{42};
+};
+
+TEST_F(RoaringBitmapTest, AddRemoveAcrossRepresentations) {
+  // Arrange
+  RoaringBitmap bitmap;
+  std::set<uint32_t> reference;
+
+  // Act
+  // 一个容器超过 ARRAY_MAX 个元素后转为位图表示
+  for (uint32_t i = 0; i < 10000; i += 2) {
+    bitmap.add(i);
+    reference.insert(i);
+  }
+  bitmap.add(0);
+  bitmap.add(1u << 20);
+  reference.insert(1u << 20);
+
+  // Assert
+  EXPECT_EQ(bitmap.cardinality(), reference.size());
+  EXPECT_EQ(bitmap.to_vector(), values(reference));
+  EXPECT_TRUE(bitmap.contains(9998));
+  EXPECT_FALSE(bitmap.contains(9999));
+
+  // Act
+  // 删除到 ARRAY_MAX 以下后转回数组，删空的容器被移除
+  for (uint32_t i = 0; i < 6000; i += 2) {
+    EXPECT_TRUE(bitmap.remove(i));
+    reference.erase(i);
+  }
+  EXPECT_FALSE(bitmap.remove(1));
+  EXPECT_TRUE(bitmap.remove(1u << 20));
+  reference.erase(1u << 20);
+
+  // Assert
+  EXPECT_EQ(bitmap.cardinality(), reference.size());
+  EXPECT_EQ(bitmap.to_vector(), values(reference));
+}
+
+TEST_F(RoaringBitmapTest, SetOperationsMatchReference) {
+  // Arrange
+  RoaringBitmap sparse, dense;
+  std::set<uint32_t> sparse_ref, dense_ref;
+  fill(3000, 1u << 20, &sparse, &sparse_ref);
+  fill(200000, 1u << 18, &dense, &dense_ref);
+  std::vector<uint32_t> expected_and, expected_or;
+  std::set_intersection(sparse_ref.begin(), sparse_ref.end(),
+                        dense_ref.begin(), dense_ref.end(),
+                        std::back_inserter(expected_and));
+  std::set_union(sparse_ref.begin(), sparse_ref.end(), dense_ref.begin(),
+                 dense_ref.end(), std::back_inserter(expected_or));
+
+  // Act
+  RoaringBitmap intersection = sparse & dense;
+  RoaringBitmap unioned = sparse | dense;
+  RoaringBitmap dense_and_dense = dense & dense;
+
+  // Assert
+  EXPECT_EQ(intersection.to_vector(), expected_and);
+  EXPECT_EQ(unioned.to_vector(), expected_or);
+  EXPECT_EQ(unioned.cardinality(), expected_or.size());
+  EXPECT_EQ(dense_and_dense, dense);
+  EXPECT_NE(unioned, dense);
+}
+
+TEST_F(RoaringBitmapTest, EqualityIgnoresConstructionOrder) {
+  // Arrange
+  RoaringBitmap forward, backward;
+
+  // Act
+  for (uint32_t i = 0; i < 5000; i++) {
+    forward.add(i * 3);
+    backward.add((4999 - i) * 3);
+  }
+
+  // Assert
+  EXPECT_EQ(forward, backward);
+  EXPECT_LT(forward.memory_bytes(), 5000 * sizeof(void *));
+}
+
+}  // namespace vulcan
@@ -0,0 +1,93 @@
+// Copyright 2023 VulcanDB
+#include "experiments/compression_benchmark/deflate_test_runner.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace compbench {
+
+namespace {
+
+// 一行中有多条语句，字符串中含有分号和实例名
+const char *TEST_DATA =
+    "ISO-10303-21;\n"
+    "DATA;\n"
+    "#1=IFCCARTESIANPOINT((0.,0.,0.));#2=IFCDIRECTION((0.,0.,1.)); "
+    "#3=IFCLABEL('a;#9=b''c;');\n"
+    "#4=IFCDIRECTION((1.,0.,0.));\n"
+    "ENDSEC;\n"
+    "END-ISO-10303-21;\n";
+
+std::string read_file(const std::filesystem::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  return buffer.str();
+}
+
+}  // namespace
+
+class BlockDeflateTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = std::filesystem::temp_directory_path() / "vulcan-block-deflate";
+    std::filesystem::create_directories(dir_);
+    input_ = dir_ / "model.ifc";
+    std::ofstream(input_, std::ios::binary) << TEST_DATA;
+    compressed_ = dir_ / "model.vbd";
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  std::filesystem::path dir_;
+  std::filesystem::path input_;
+  std::filesystem::path compressed_;
+};
+
+TEST_F(BlockDeflateTest, ReadsStatementsSharingALine) {
+  // Arrange
+  // 块很小，每条语句单独成块，块边界落在行中间
+  BlockDeflate::compress(input_.string(), compressed_.string(),
+                         Z_DEFAULT_COMPRESSION, 8, 2);
+
+  // Act
+  std::string second;
+  int ret2 = BlockDeflate::read_instances(compressed_.string(), 2, 2, second);
+  std::string third;
+  int ret3 = BlockDeflate::read_instances(compressed_.string(), 3, 3, third);
+  std::string missing;
+  int ret9 = BlockDeflate::read_instances(compressed_.string(), 9, 9, missing);
+  std::string all;
+  int ret_all = BlockDeflate::read_instances(compressed_.string(), 1, 4, all);
+
+  // Assert
+  ASSERT_EQ(ret2, 0);
+  EXPECT_EQ(second, "#2=IFCDIRECTION((0.,0.,1.)); ");
+  ASSERT_EQ(ret3, 0);
+  EXPECT_EQ(third, "#3=IFCLABEL('a;#9=b''c;');\n");
+  ASSERT_EQ(ret9, 0);
+  EXPECT_TRUE(missing.empty());
+  ASSERT_EQ(ret_all, 0);
+  EXPECT_EQ(all,
+            "#1=IFCCARTESIANPOINT((0.,0.,0.));#2=IFCDIRECTION((0.,0.,1.)); "
+            "#3=IFCLABEL('a;#9=b''c;');\n#4=IFCDIRECTION((1.,0.,0.));\n");
+}
+
+TEST_F(BlockDeflateTest, DecompressRestoresInput) {
+  // Arrange
+  BlockDeflate::compress(input_.string(), compressed_.string(),
+                         Z_DEFAULT_COMPRESSION, 8, 2);
+  std::filesystem::path output = dir_ / "model.out";
+
+  // Act
+  BlockDeflate::decompress(compressed_.string(), output.string());
+
+  // Assert
+  EXPECT_EQ(read_file(output), TEST_DATA);
+}
+
+}  // namespace compbench
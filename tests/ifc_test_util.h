@@ -0,0 +1,46 @@
+// Copyright 2023 VulcanDB
+#pragma once
+
+#include <string.h>
+
+#include <memory>
+#include <string>
+
+#include "ifcparse/IfcFile.h"
+
+namespace vulcan {
+namespace test {
+
+// 由 DATA 段的实例语句组成的 IFC2X3 模型文本
+inline std::string ifc_model(const std::string &data,
+                             const std::string &file_name = "t.ifc") {
+  return "ISO-10303-21;\n"
+         "HEADER;\n"
+         "FILE_DESCRIPTION((''),'2;1');\n"
+         "FILE_NAME('" +
+         file_name +
+         "','2023-01-01T00:00:00',(''),(''),'','','');\n"
+         "FILE_SCHEMA(('IFC2X3'));\n"
+         "ENDSEC;\n"
+         "DATA;\n" +
+         data +
+         "ENDSEC;\n"
+         "END-ISO-10303-21;\n";
+}
+
+// 从内存中的模型文本打开 IfcFile，IfcFile 接管缓冲区并用 delete[] 释放
+inline std::unique_ptr<IfcParse::IfcFile> open_ifc_text(
+    const std::string &text) {
+  char *buffer = new char[text.size()];
+  memcpy(buffer, text.data(), text.size());
+  return std::unique_ptr<IfcParse::IfcFile>(
+      new IfcParse::IfcFile(buffer, static_cast<int>(text.size())));
+}
+
+// 打开由 DATA 段实例语句组成的模型
+inline std::unique_ptr<IfcParse::IfcFile> open_ifc(const std::string &data) {
+  return open_ifc_text(ifc_model(data));
+}
+
+}  // namespace test
+}  // namespace vulcan
@@ -0,0 +1,110 @@
+// Copyright 2023 VulcanDB
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ifcparse/IfcCharacterDecoder.h"
+#include "ifcparse/IfcParse.h"
+#include "ifcparse/IfcSpfStream.h"
+
+namespace {
+
+// IfcSpfStream 接管缓冲区并用 delete[] 释放
+std::unique_ptr<IfcParse::IfcSpfStream> make_stream(const std::string &text) {
+  char *data = new char[text.size()];
+  memcpy(data, text.data(), text.size());
+  return std::unique_ptr<IfcParse::IfcSpfStream>(
+      new IfcParse::IfcSpfStream(data, static_cast<int>(text.size())));
+}
+
+// 解码从开头引号之后开始的字符串，返回结果和结束位置
+std::pair<std::string, unsigned int> decode(const std::string &text) {
+  std::unique_ptr<IfcParse::IfcSpfStream> stream = make_stream(text);
+  IfcParse::IfcCharacterDecoder decoder(stream.get());
+  unsigned int ptr = 1;
+  std::string value = decoder.get(ptr);
+  return {value, ptr};
+}
+
+}  // namespace
+
+// Test case for plain strings: returned as a slice, pointer after the quote
+TEST(CharacterDecoderTest, PlainStringIsCopied) {
+  // Arrange
+  std::string longer = "'2O2Fr$t4X7Zf8NOew3FLOH and more than sixteen bytes',";
+
+  // Act
+  auto shorter = decode("'abc',");
+  auto value = decode(longer);
+  auto empty = decode("'',");
+
+  // Assert
+  EXPECT_EQ(shorter.first, "'abc'");
+  EXPECT_EQ(shorter.second, 5u);
+  EXPECT_EQ(value.first, longer.substr(0, longer.size() - 1));
+  EXPECT_EQ(value.second, longer.size() - 1);
+  EXPECT_EQ(empty.first, "''");
+  EXPECT_EQ(empty.second, 2u);
+}
+
+// Test case for strings that still need the state machine
+TEST(CharacterDecoderTest, EscapedStringIsDecoded) {
+  // Arrange & Act
+  auto quoted = decode("'it''s',");
+  auto extended = decode("'caf\\X2\\00E9\\X0\\ au lait with padding',");
+  auto wrapped = decode("'line\r\nbreak',");
+
+  // Assert
+  EXPECT_EQ(quoted.first, "'it's'");
+  EXPECT_EQ(quoted.second, 7u);
+  EXPECT_EQ(extended.first, "'caf\xc3\xa9 au lait with padding'");
+  EXPECT_EQ(wrapped.first, "'linebreak'");
+}
+
+// Test case for a quoted apostrophe split by a line break
+TEST(CharacterDecoderTest, ApostropheBeforeLineBreakIsNotTheEnd) {
+  // Arrange
+  std::string crlf = "'it'\r\n's',";
+  std::string lf = "'sixteen bytes of it'\n's',";
+
+  // Act
+  auto crlf_value = decode(crlf);
+  auto lf_value = decode(lf);
+  auto closed = decode("'abc'\n,");
+
+  // Assert
+  EXPECT_EQ(crlf_value.first, "'it's'");
+  EXPECT_EQ(crlf_value.second, crlf.size() - 1);
+  EXPECT_EQ(lf_value.first, "'sixteen bytes of it's'");
+  EXPECT_EQ(lf_value.second, lf.size() - 1);
+  EXPECT_EQ(closed.first, "'abc'");
+}
+
+// Test case for skip(): the lexer resumes at the next token either way
+TEST(CharacterDecoderTest, LexerSkipsPlainAndEscapedStrings) {
+  // Arrange
+  std::string text = "'abc','it''s','\\X2\\00E9\\X0\\','x\\\\y';";
+  std::unique_ptr<IfcParse::IfcSpfStream> stream = make_stream(text);
+  IfcParse::IfcSpfLexer lexer(stream.get(), nullptr);
+
+  // Act
+  std::vector<IfcParse::Token> tokens;
+  while (!stream->eof) {
+    tokens.push_back(lexer.Next());
+  }
+
+  // Assert
+  std::vector<unsigned int> expected = {0, 5, 6, 13, 14, 28, 29, 35};
+  ASSERT_EQ(tokens.size(), expected.size());
+  for (size_t i = 0; i < tokens.size(); i++) {
+    EXPECT_EQ(tokens[i].startPos, expected[i]) << i;
+    EXPECT_EQ(tokens[i].type, i % 2 == 0 ? IfcParse::Token_STRING
+                                         : IfcParse::Token_OPERATOR)
+        << i;
+  }
+  EXPECT_EQ(IfcParse::TokenFunc::asString(tokens[2]), "it's");
+  EXPECT_EQ(IfcParse::TokenFunc::asString(tokens[6]), "x\\y");
+}
@@ -0,0 +1,104 @@
+// Copyright 2023 VulcanDB
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ifcparse/IfcFile.h"
+#include "ifcparse/IfcGlobalId.h"
+
+namespace {
+
+const char *TEST_MODEL =
+    "ISO-10303-21;\n"
+    "HEADER;\n"
+    "FILE_DESCRIPTION((''),'2;1');\n"
+    "FILE_NAME('t.ifc','2023-01-01T00:00:00',(''),(''),'','','');\n"
+    "FILE_SCHEMA(('IFC2X3'));\n"
+    "ENDSEC;\n"
+    "DATA;\n"
+    "#1=IFCBUILDINGELEMENTPROXY('2O2Fr$t4X7Zf8NOew3FLOH',$,$,$,$,$,$,$,$);\n"
+    "#2=IFCBUILDINGELEMENTPROXY('not-a-guid',$,$,$,$,$,$,$,$);\n"
+    "ENDSEC;\n"
+    "END-ISO-10303-21;\n";
+
+}  // namespace
+
+// Test case for the codec: known GlobalId/UUID pairs round trip
+TEST(GlobalIdTest, DecodeAndEncodeRoundTrip) {
+  // Arrange
+  const std::vector<std::pair<std::string, std::string>> cases = {
+      {"2O2Fr$t4X7Zf8NOew3FLOH", "9808fd7f-dc48-478e-9217-628e833d5611"},
+      {"0000000000000000000000", "00000000-0000-0000-0000-000000000000"},
+      {"1hqIFTRjfV6AWq_bMtnZwI", "6bd123dd-6eda-5f18-a834-fa55b7c63e92"},
+  };
+
+  for (const auto &c : cases) {
+    // Act
+    IfcParse::IfcGuid guid;
+    bool decoded = IfcParse::IfcGlobalId::decode(c.first, guid);
+
+    // Assert
+    ASSERT_TRUE(decoded) << c.first;
+    EXPECT_EQ(IfcParse::IfcGlobalId::encode(guid), c.first);
+    EXPECT_EQ(IfcParse::IfcGlobalId(c.first).formatted(), c.second);
+  }
+}
+
+// Test case for invalid text: wrong length, alphabet or more than 128 bits
+TEST(GlobalIdTest, InvalidTextIsRejected) {
+  // Arrange
+  IfcParse::IfcGuid guid;
+
+  // Act & Assert
+  EXPECT_FALSE(IfcParse::IfcGlobalId::decode("2O2Fr$t4X7Zf8NOew3FLO", guid));
+  EXPECT_FALSE(IfcParse::IfcGlobalId::decode("2O2Fr$t4X7Zf8NOew3FLOHH", guid));
+  EXPECT_FALSE(IfcParse::IfcGlobalId::decode("2O2Fr-t4X7Zf8NOew3FLOH", guid));
+  EXPECT_FALSE(IfcParse::IfcGlobalId::decode("4O2Fr$t4X7Zf8NOew3FLOH", guid));
+  EXPECT_THROW(IfcParse::IfcGlobalId("not-a-guid"), IfcParse::IfcException);
+}
+
+// Test case for the batch API: invalid entries are flagged, not fatal
+TEST(GlobalIdTest, BatchDecodeFlagsInvalidEntries) {
+  // Arrange
+  std::vector<std::string> texts = {"2O2Fr$t4X7Zf8NOew3FLOH", "", "x",
+                                    "1hqIFTRjfV6AWq_bMtnZwI"};
+  std::vector<IfcParse::IfcGuid> guids(texts.size());
+  std::vector<unsigned char> valid(texts.size());
+
+  // Act
+  size_t decoded = IfcParse::IfcGlobalId::decode_batch(
+      texts.data(), texts.size(), guids.data(), valid.data());
+
+  // Assert
+  EXPECT_EQ(decoded, 2u);
+  EXPECT_EQ(valid, (std::vector<unsigned char>{1, 0, 0, 1}));
+  EXPECT_EQ(IfcParse::IfcGlobalId::encode(guids[3]), texts[3]);
+}
+
+// Test case for the file index: binary and text keys both resolve
+TEST(GlobalIdTest, FileIndexesGlobalIds) {
+  // Arrange
+  int len = static_cast<int>(strlen(TEST_MODEL));
+  char *data = new char[len];
+  memcpy(data, TEST_MODEL, len);
+  std::unique_ptr<IfcParse::IfcFile> file(new IfcParse::IfcFile(data, len));
+  IfcParse::IfcGuid guid;
+  ASSERT_TRUE(IfcParse::IfcGlobalId::decode("2O2Fr$t4X7Zf8NOew3FLOH", guid));
+
+  // Act
+  IfcUtil::IfcBaseClass *by_text = file->instance_by_guid(
+      std::string("2O2Fr$t4X7Zf8NOew3FLOH"));
+  IfcUtil::IfcBaseClass *by_binary = file->instance_by_guid(guid);
+  IfcUtil::IfcBaseClass *invalid = file->instance_by_guid("not-a-guid");
+
+  // Assert
+  EXPECT_EQ(by_text, file->instance_by_id(1));
+  EXPECT_EQ(by_binary, file->instance_by_id(1));
+  EXPECT_EQ(invalid, file->instance_by_id(2));
+  EXPECT_EQ(file->internal_guid_map().size(), 2u);
+  EXPECT_THROW(file->instance_by_guid("1hqIFTRjfV6AWq_bMtnZwI"),
+               IfcParse::IfcException);
+}
@@ -0,0 +1,135 @@
+// Copyright 2023 VulcanDB
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "ifc_test_util.h"
+#include "ifcparse/IfcFile.h"
+#include "ifcparse/IfcWrite.h"
+
+namespace {
+
+const char *TEST_DATA =
+    "#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+    "#2=IFCCARTESIANPOINT((1.,0.,0.));\n"
+    "#3=IFCCARTESIANPOINT((1.,1.,0.));\n"
+    "#4=IFCPOLYLINE((#1,#2));\n"
+    "#5=IFCPOLYLINE((#1,#1,#3));\n"
+    "#6=IFCDIRECTION((0.,0.,1.));\n"
+    "#7=IFCAXIS2PLACEMENT3D(#1,#6,$);\n";
+
+const int MAX_ID = 7;
+
+// (引用者, 属性下标)，排序后用于比较
+typedef std::vector<std::pair<int, int>> RefList;
+
+}  // namespace
+
+class InverseIndexTest : public ::testing::Test {
+ protected:
+  static std::unique_ptr<IfcParse::IfcFile> open_model() {
+    return vulcan::test::open_ifc(TEST_DATA);
+  }
+
+  static RefList refs(IfcParse::IfcFile *file, int id) {
+    aggregate_of_instance::ptr instances = file->instances_by_reference(id);
+    std::vector<int> indices = file->get_inverse_indices(id);
+    EXPECT_EQ(static_cast<size_t>(instances->size()), indices.size());
+    EXPECT_EQ(file->getTotalInverses(id), static_cast<int>(indices.size()));
+    RefList result;
+    for (size_t i = 0; i < indices.size(); i++) {
+      result.emplace_back((*(instances->begin() + i))->data().id(),
+                          indices[i]);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  static void set_points(IfcParse::IfcFile *file, int id,
+                         const std::vector<int> &points) {
+    aggregate_of_instance::ptr list(new aggregate_of_instance);
+    for (int point : points) {
+      list->push(file->instance_by_id(point));
+    }
+    IfcWrite::IfcWriteArgument *arg = new IfcWrite::IfcWriteArgument();
+    arg->set(list);
+    file->instance_by_id(id)->data().setArgument(0, arg);
+  }
+
+  static void set_location(IfcParse::IfcFile *file, int id, int point) {
+    IfcWrite::IfcWriteArgument *arg = new IfcWrite::IfcWriteArgument();
+    arg->set(static_cast<IfcUtil::IfcBaseInterface *>(
+        file->instance_by_id(point)));
+    file->instance_by_id(id)->data().setArgument(0, arg);
+  }
+
+  static void edit(IfcParse::IfcFile *file) {
+    set_points(file, 4, {1, 2, 3});
+    set_points(file, 5, {3});
+    set_location(file, 7, 2);
+    set_points(file, 4, {2, 3});
+  }
+};
+
+TEST_F(InverseIndexTest, ParsedReferencesHaveAttributeIndices) {
+  // Arrange
+  std::unique_ptr<IfcParse::IfcFile> file = open_model();
+
+  // Act
+  RefList point_refs = refs(file.get(), 1);
+  aggregate_of_instance::ptr polylines = file->getInverse(
+      1, file->schema()->declaration_by_name("IfcPolyline"), 0);
+  aggregate_of_instance::ptr placements = file->getInverse(
+      1, file->schema()->declaration_by_name("IfcPlacement"), -1);
+
+  // Assert
+  EXPECT_EQ(point_refs, (RefList{{4, 0}, {5, 0}, {5, 0}, {7, 0}}));
+  EXPECT_EQ(polylines->size(), 3u);
+  ASSERT_EQ(placements->size(), 1u);
+  EXPECT_EQ((*placements->begin())->data().id(), 7u);
+}
+
+TEST_F(InverseIndexTest, BatchedEditsMatchDirectEdits) {
+  // Arrange
+  std::unique_ptr<IfcParse::IfcFile> direct = open_model();
+  std::unique_ptr<IfcParse::IfcFile> batched = open_model();
+
+  // Act
+  edit(direct.get());
+  batched->batch();
+  edit(batched.get());
+  // 批处理期间的查询能看到尚未合并的修改
+  RefList during_batch = refs(batched.get(), 3);
+  batched->unbatch();
+
+  // Assert
+  EXPECT_EQ(during_batch, refs(direct.get(), 3));
+  for (int id = 1; id <= MAX_ID; id++) {
+    EXPECT_EQ(refs(batched.get(), id), refs(direct.get(), id)) << "#" << id;
+  }
+  EXPECT_EQ(refs(batched.get(), 1), (RefList{}));
+  EXPECT_EQ(refs(batched.get(), 2), (RefList{{4, 0}, {7, 0}}));
+  EXPECT_EQ(refs(batched.get(), 3), (RefList{{4, 0}, {5, 0}}));
+}
+
+TEST_F(InverseIndexTest, BatchedDeletionDropsReferences) {
+  // Arrange
+  std::unique_ptr<IfcParse::IfcFile> file = open_model();
+
+  // Act
+  file->batch();
+  set_points(file.get(), 4, {1, 3});
+  file->removeEntity(file->instance_by_id(5));
+  file->removeEntity(file->instance_by_id(6));
+  file->unbatch();
+
+  // Assert
+  EXPECT_EQ(refs(file.get(), 1), (RefList{{4, 0}, {7, 0}}));
+  EXPECT_EQ(refs(file.get(), 2), (RefList{}));
+  EXPECT_EQ(refs(file.get(), 3), (RefList{{4, 0}}));
+  EXPECT_EQ(refs(file.get(), 6), (RefList{}));
+  EXPECT_TRUE(file->instance_by_id(7)->data().getArgument(1)->isNull());
+}
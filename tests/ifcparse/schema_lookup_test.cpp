@@ -0,0 +1,95 @@
+// Copyright 2023 VulcanDB
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ifcparse/Ifc2x3.h"
+#include "ifcparse/IfcFile.h"
+
+namespace {
+
+// 关键字后跟空白、换行以及小写关键字，覆盖 asKeywordView 的回退路径
+const char *TEST_MODEL =
+    "ISO-10303-21;\n"
+    "HEADER;\n"
+    "FILE_DESCRIPTION((''),'2;1');\n"
+    "FILE_NAME('t.ifc','2023-01-01T00:00:00',(''),(''),'','','');\n"
+    "FILE_SCHEMA(('IFC2X3'));\n"
+    "ENDSEC;\n"
+    "DATA;\n"
+    "#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+    "#2=IFCCARTESIANPOINT ((1.,0.,0.));\n"
+    "#3=IfcDirection((0.,0.,1.));\n"
+    "#4=IFCCARTESIAN\nPOINT((1.,1.,0.));\n"
+    "ENDSEC;\n"
+    "END-ISO-10303-21;\n";
+
+}  // namespace
+
+// Test case for the perfect hash: every declaration maps back to itself
+TEST(SchemaLookupTest, EveryDeclarationIsFound) {
+  // Arrange
+  const IfcParse::schema_definition &schema = Ifc2x3::get_schema();
+
+  // Act & Assert
+  for (const IfcParse::declaration *decl : schema.declarations()) {
+    EXPECT_EQ(schema.declaration_by_name(decl->name_uc()), decl);
+    EXPECT_EQ(schema.declaration_by_name(decl->name()), decl);
+  }
+}
+
+// Test case for misses: unknown names, prefixes and extensions
+TEST(SchemaLookupTest, UnknownNameIsRejected) {
+  // Arrange
+  const IfcParse::schema_definition &schema = Ifc2x3::get_schema();
+
+  // Act & Assert
+  EXPECT_EQ(schema.find_declaration("IFCNOTATYPE"), nullptr);
+  EXPECT_EQ(schema.find_declaration("IFCWAL"), nullptr);
+  EXPECT_EQ(schema.find_declaration("IFCWALLX"), nullptr);
+  EXPECT_EQ(schema.find_declaration(""), nullptr);
+  EXPECT_NE(schema.find_declaration("ifcwall"), nullptr);
+  EXPECT_THROW(schema.declaration_by_name("IfcNotAType"),
+               IfcParse::IfcException);
+}
+
+// Test case for the lexer: keywords are resolved in and out of the buffer
+TEST(SchemaLookupTest, ParsedKeywordsResolveToDeclarations) {
+  // Arrange
+  int len = static_cast<int>(strlen(TEST_MODEL));
+  char *data = new char[len];
+  memcpy(data, TEST_MODEL, len);
+
+  // Act
+  std::unique_ptr<IfcParse::IfcFile> file(new IfcParse::IfcFile(data, len));
+
+  // Assert
+  ASSERT_TRUE(file->good());
+  const IfcParse::schema_definition *schema = file->schema();
+  for (int id = 1; id <= 4; id++) {
+    const IfcParse::declaration &decl = file->instance_by_id(id)->declaration();
+    EXPECT_EQ(&decl, schema->declaration_by_name(id == 3 ? "IfcDirection"
+                                                         : "IfcCartesianPoint"))
+        << "#" << id;
+  }
+}
+
+// Test case for schema plugins: a schema is loaded by name on first use
+TEST(SchemaLookupTest, SchemaIsLoadedByName) {
+  // Arrange & Act
+  const IfcParse::schema_definition *schema = IfcParse::schema_by_name("ifc4");
+  std::vector<std::string> names = IfcParse::schema_names();
+
+  // Assert
+  ASSERT_NE(schema, nullptr);
+  EXPECT_EQ(schema->name(), "IFC4");
+  EXPECT_EQ(IfcParse::schema_by_name("IFC4"), schema);
+  EXPECT_NE(std::find(names.begin(), names.end(), "IFC4"), names.end());
+  EXPECT_NE(std::find(names.begin(), names.end(), "IFC2X3"), names.end());
+  EXPECT_THROW(IfcParse::schema_by_name("IFC9"), IfcParse::IfcException);
+  EXPECT_THROW(IfcParse::schema_by_name("../IFC4"), IfcParse::IfcException);
+}
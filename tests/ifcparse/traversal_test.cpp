@@ -0,0 +1,172 @@
+// Copyright 2023 VulcanDB
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ifc_test_util.h"
+#include "ifcparse/IfcFile.h"
+#include "ifcparse/IfcTraversal.h"
+#include "ifcparse/IfcWrite.h"
+
+namespace {
+
+const int POINT_COUNT = 10000;
+
+/**
+ * #1..#N 为点，#N+1 为引用全部点的折线，其后是共享同一原点的放置，
+ * 使一些实例可以经由不同深度的路径到达。
+ */
+std::string model_data() {
+  std::string model;
+  std::string points;
+  for (int i = 1; i <= POINT_COUNT; i++) {
+    model += "#" + std::to_string(i) + "=IFCCARTESIANPOINT((" +
+             std::to_string(i) + ".,0.,0.));\n";
+    points += (i > 1 ? ",#" : "#") + std::to_string(i);
+  }
+  const std::string n1 = std::to_string(POINT_COUNT + 1);
+  const std::string n2 = std::to_string(POINT_COUNT + 2);
+  const std::string n3 = std::to_string(POINT_COUNT + 3);
+  const std::string n4 = std::to_string(POINT_COUNT + 4);
+  const std::string n5 = std::to_string(POINT_COUNT + 5);
+  const std::string n6 = std::to_string(POINT_COUNT + 6);
+  model += "#" + n1 + "=IFCPOLYLINE((" + points + "));\n";
+  model += "#" + n2 + "=IFCDIRECTION((0.,0.,1.));\n";
+  model += "#" + n3 + "=IFCAXIS2PLACEMENT3D(#1,#" + n2 + ",$);\n";
+  model += "#" + n4 + "=IFCLOCALPLACEMENT($,#" + n3 + ");\n";
+  model += "#" + n5 + "=IFCAXIS2PLACEMENT3D(#2,$,$);\n";
+  model += "#" + n6 + "=IFCLOCALPLACEMENT(#" + n4 + ",#" + n5 + ");\n";
+  return model;
+}
+
+// 替换前的递归深度优先遍历，作为对照
+void recursive_traverse(IfcUtil::IfcBaseClass *instance, int level,
+                        int max_level, std::set<IfcUtil::IfcBaseClass *> *seen,
+                        std::vector<IfcUtil::IfcBaseClass *> *out) {
+  if (!seen->insert(instance).second) {
+    return;
+  }
+  out->push_back(instance);
+  if (level >= max_level && max_level > 0) {
+    return;
+  }
+  std::vector<IfcUtil::IfcBaseClass *> children;
+  IfcParse::forward_references(instance, children);
+  for (IfcUtil::IfcBaseClass *child : children) {
+    recursive_traverse(child, level + 1, max_level, seen, out);
+  }
+}
+
+std::vector<IfcUtil::IfcBaseClass *> to_vector(
+    const aggregate_of_instance::ptr &list) {
+  return std::vector<IfcUtil::IfcBaseClass *>(list->begin(), list->end());
+}
+
+}  // namespace
+
+class TraversalTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    file_ = vulcan::test::open_ifc(model_data());
+    ASSERT_TRUE(file_->good());
+  }
+
+  IfcUtil::IfcBaseClass *instance(int offset) {
+    return file_->instance_by_id(POINT_COUNT + offset);
+  }
+
+  std::unique_ptr<IfcParse::IfcFile> file_;
+};
+
+TEST_F(TraversalTest, DepthFirstMatchesRecursiveTraversal) {
+  for (int max_level : {-1, 1, 2}) {
+    for (int offset = 1; offset <= 6; offset++) {
+      // Arrange
+      std::set<IfcUtil::IfcBaseClass *> seen;
+      std::vector<IfcUtil::IfcBaseClass *> expected;
+      recursive_traverse(instance(offset), 0, max_level, &seen, &expected);
+
+      // Act
+      aggregate_of_instance::ptr result =
+          file_->traverse(instance(offset), max_level);
+
+      // Assert
+      EXPECT_EQ(to_vector(result), expected)
+          << "root #" << POINT_COUNT + offset << " max_level " << max_level;
+    }
+  }
+}
+
+TEST_F(TraversalTest, BreadthFirstReturnsShortestLevels) {
+  // Act
+  aggregate_of_instance::ptr result =
+      file_->traverse_breadth_first(instance(6));
+  aggregate_of_instance::ptr bounded =
+      file_->traverse_breadth_first(instance(6), 2);
+
+  // Assert
+  // #N+6 -> #N+4, #N+5 -> #N+3, #2 -> #1, #N+2
+  std::vector<int> ids;
+  for (IfcUtil::IfcBaseClass *inst : *result) {
+    ids.push_back(inst->data().id());
+  }
+  const int n = POINT_COUNT;
+  EXPECT_EQ(ids, (std::vector<int>{n + 6, n + 4, n + 5, n + 3, 2, 1, n + 2}));
+  EXPECT_EQ(bounded->size(), 5u);
+}
+
+TEST_F(TraversalTest, ParallelFrontierKeepsOrder) {
+  // Arrange
+  ASSERT_GE(POINT_COUNT, static_cast<int>(IfcParse::parallel_frontier));
+  aggregate_of_instance::ptr serial =
+      file_->traverse_breadth_first(instance(1), -1, 1);
+
+  // Act
+  aggregate_of_instance::ptr parallel =
+      file_->traverse_breadth_first(instance(1), -1, 4);
+
+  // Assert
+  EXPECT_EQ(parallel->size(), static_cast<unsigned>(POINT_COUNT + 1));
+  EXPECT_EQ(to_vector(parallel), to_vector(serial));
+}
+
+TEST_F(TraversalTest, CachedClosureIsDroppedOnEdit) {
+  // Arrange
+  file_->traversal_cache(true);
+  IfcUtil::IfcBaseClass *placement = instance(5);
+  EXPECT_EQ(file_->traverse(placement)->size(), 2u);
+
+  // Act
+  aggregate_of_instance::ptr cached = file_->traverse(placement);
+  cached->push(instance(2));
+  IfcWrite::IfcWriteArgument *axis = new IfcWrite::IfcWriteArgument();
+  axis->set(static_cast<IfcUtil::IfcBaseInterface *>(instance(2)));
+  placement->data().setArgument(1, axis);
+  aggregate_of_instance::ptr edited = file_->traverse(placement);
+
+  // Assert
+  // 返回的是副本，调用者的修改不影响缓存
+  EXPECT_EQ(cached->size(), 3u);
+  EXPECT_EQ(edited->size(), 3u);
+  EXPECT_TRUE(edited->contains(instance(2)));
+}
+
+TEST(VisitedSetTest, ClearResetsTouchedWords) {
+  // Arrange
+  std::unique_ptr<IfcParse::IfcFile> file =
+      vulcan::test::open_ifc(model_data());
+  IfcParse::visited_set visited;
+
+  // Act
+  EXPECT_TRUE(visited.insert(file->instance_by_id(9000)));
+  EXPECT_FALSE(visited.insert(file->instance_by_id(9000)));
+  visited.clear();
+
+  // Assert
+  EXPECT_FALSE(visited.contains(file->instance_by_id(9000)));
+  EXPECT_TRUE(visited.insert(file->instance_by_id(9000)));
+  EXPECT_FALSE(visited.contains(file->instance_by_id(9001)));
+}
@@ -0,0 +1,104 @@
+// Copyright 2023 VulcanDB
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ifc_test_util.h"
+#include "ifcparse/IfcFile.h"
+
+namespace {
+
+// 文件顺序与实例名顺序不同，点和方向同属 IfcGeometricRepresentationItem
+const char *TEST_DATA =
+    "#9=IFCCARTESIANPOINT((0.,0.,0.));\n"
+    "#2=IFCDIRECTION((0.,0.,1.));\n"
+    "#5=IFCCARTESIANPOINT((1.,0.,0.));\n"
+    "#7=IFCAXIS2PLACEMENT3D(#9,#2,$);\n";
+
+std::vector<int> ids(const aggregate_of_instance::ptr &list) {
+  std::vector<int> result;
+  if (list) {
+    for (IfcUtil::IfcBaseClass *instance : *list) {
+      result.push_back(instance->data().id());
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(TypeIndexTest, SubtypeInclusiveListIsInInstanceNameOrder) {
+  // Arrange
+  std::unique_ptr<IfcParse::IfcFile> file = vulcan::test::open_ifc(TEST_DATA);
+
+  // Act
+  std::vector<int> points = ids(file->instances_by_type("IfcCartesianPoint"));
+  std::vector<int> items =
+      ids(file->instances_by_type("IfcGeometricRepresentationItem"));
+  std::vector<int> exact =
+      ids(file->instances_by_type_excl_subtypes("IfcCartesianPoint"));
+
+  // Assert
+  EXPECT_EQ(points, (std::vector<int>{5, 9}));
+  EXPECT_EQ(items, (std::vector<int>{2, 5, 7, 9}));
+  // 精确类型的列表保持加入的顺序
+  EXPECT_EQ(exact, (std::vector<int>{9, 5}));
+}
+
+TEST(TypeIndexTest, RemovalDropsCachedSupertypeLists) {
+  // Arrange
+  std::unique_ptr<IfcParse::IfcFile> file = vulcan::test::open_ifc(TEST_DATA);
+  ids(file->instances_by_type("IfcGeometricRepresentationItem"));
+
+  // Act
+  file->removeEntity(file->instance_by_id(5));
+
+  // Assert
+  EXPECT_EQ(ids(file->instances_by_type("IfcGeometricRepresentationItem")),
+            (std::vector<int>{2, 7, 9}));
+  EXPECT_EQ(ids(file->instances_by_type("IfcPoint")), (std::vector<int>{9}));
+}
+
+TEST(TypeIndexTest, ConcurrentConstLookupsAgree) {
+  // Arrange
+  std::unique_ptr<IfcParse::IfcFile> file = vulcan::test::open_ifc(TEST_DATA);
+  const IfcParse::IfcFile &model = *file;
+  const std::vector<std::string> types = {
+      "IfcRepresentationItem", "IfcGeometricRepresentationItem", "IfcPoint",
+      "IfcCartesianPoint", "IfcPlacement"};
+  const std::vector<size_t> expected = {4, 4, 2, 2, 1};
+
+  // Act
+  std::vector<std::vector<size_t>> found(4,
+                                         std::vector<size_t>(types.size()));
+  std::vector<std::thread> readers;
+  for (size_t t = 0; t < found.size(); t++) {
+    readers.emplace_back([&, t]() {
+      for (size_t i = 0; i < types.size(); i++) {
+        // 每个线程从不同的类型开始，使缓存的填充互相交错
+        size_t k = (i + t) % types.size();
+        const IfcParse::declaration *type =
+            model.schema()->declaration_by_name(types[k]);
+        found[t][k] = model.instances_by_type(type)->size();
+      }
+    });
+  }
+  for (std::thread &reader : readers) {
+    reader.join();
+  }
+  size_t incl_super = 0;
+  for (auto it = model.types_incl_super_begin();
+       it != model.types_incl_super_end(); ++it) {
+    incl_super++;
+  }
+
+  // Assert
+  for (const std::vector<size_t> &sizes : found) {
+    EXPECT_EQ(sizes, expected);
+  }
+  // 点、方向、放置及其各级超类型
+  EXPECT_EQ(incl_super, 7u);
+}
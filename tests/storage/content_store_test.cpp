@@ -0,0 +1,257 @@
+// Copyright 2023 VulcanDB
+#include "storage/datastore/content_store.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ifc_test_util.h"
+#include "ifcparse/IfcFile.h"
+#include "storage/compression/ifc_diff.h"
+#include "storage/datastore/datastore_interface.h"
+
+namespace vulcan {
+
+namespace {
+
+// 内存中的键值存储，代替 WiredTiger，事务开始时保存快照用于回滚
+class MemorySession : public DataStoreSession {
+ public:
+  const char *get(const char *key) override {
+    auto it = kv.find(key);
+    return it == kv.end() ? nullptr : it->second.c_str();
+  }
+  void upsert_kv(const char *key, const char *value) override {
+    kv[key] = value;
+  }
+  bool insert_kv(const char *key, const char *value) override {
+    return kv.emplace(key, value).second;
+  }
+  void delete_kv(const char *key) override { kv.erase(key); }
+  int begin_transaction() override {
+    snapshot = kv;
+    return 0;
+  }
+  int commit_transaction() override {
+    snapshot.clear();
+    return 0;
+  }
+  int rollback_transaction() override {
+    kv.swap(snapshot);
+    snapshot.clear();
+    return 0;
+  }
+
+  std::map<std::string, std::string> kv;
+  std::map<std::string, std::string> snapshot;
+};
+
+std::string hex(uint64_t hash) {
+  char buf[17];
+  snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash));
+  return buf;
+}
+
+// 一条由 points 个点组成的折线，name 为构件名
+std::string polyline_model(int points, const std::string &name) {
+  std::string data;
+  for (int i = 1; i <= points; i++) {
+    data += "#" + std::to_string(i) + "=IFCCARTESIANPOINT((" +
+            std::to_string(i) + ".,0.,0.));\n";
+  }
+  data += "#" + std::to_string(points + 1) + "=IFCPOLYLINE((";
+  for (int i = 1; i <= points; i++) {
+    data += (i == 1 ? "#" : ",#") + std::to_string(i);
+  }
+  data += "));\n#" + std::to_string(points + 2) +
+          "=IFCBUILDINGELEMENTPROXY('2O2Fr$t4X7Zf8NOew3FLOH',$,'" + name +
+          "',$,$,$,$,$,$);\n";
+  return data;
+}
+
+}  // namespace
+
+// Test case for export: the stored model parses back to the same content
+TEST(ContentStoreTest, ExportedModelMatchesOriginal) {
+  // Arrange
+  auto session = std::make_shared<MemorySession>();
+  ContentStore store(session);
+  std::unique_ptr<IfcParse::IfcFile> original = test::open_ifc(
+      "#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+      "#2=IFCDIRECTION((0.,0.,1.));\n"
+      "#3=IFCAXIS2PLACEMENT3D(#1,#2,$);\n"
+      "#4=IFCLOCALPLACEMENT($,#3);\n"
+      "#5=IFCBUILDINGELEMENTPROXY('2O2Fr$t4X7Zf8NOew3FLOH',$,'it''s a@b',"
+      "$,$,#4,$,$,$);\n"
+      "#6=IFCPROPERTYSINGLEVALUE('w',$,IFCLENGTHMEASURE(2.5),$);\n");
+
+  // Act
+  ASSERT_EQ(store.put_model("p@1", original.get()), 0);
+  std::string data;
+  ASSERT_EQ(store.export_model("p@1", data), 0);
+  std::unique_ptr<IfcParse::IfcFile> exported = test::open_ifc(data);
+  IfcDiffResult diff;
+  ASSERT_EQ(IfcDiff().diff(original.get(), exported.get(), diff), 0);
+
+  // Assert
+  EXPECT_EQ(diff.unchanged.size(), 6u);
+  EXPECT_TRUE(diff.modified.empty());
+  EXPECT_TRUE(diff.removed.empty());
+  EXPECT_TRUE(diff.added.empty());
+}
+
+// Test case for revisions: a small change stores a small amount of data
+TEST(ContentStoreTest, RevisionsShareUnchangedContent) {
+  // Arrange
+  auto session = std::make_shared<MemorySession>();
+  ContentStore store(session);
+  std::unique_ptr<IfcParse::IfcFile> v1 =
+      test::open_ifc(polyline_model(2000, "v1"));
+  std::unique_ptr<IfcParse::IfcFile> v2 =
+      test::open_ifc(polyline_model(2000, "v2"));
+  ContentStoreStats first, second;
+
+  // Act
+  ASSERT_EQ(store.put_model("p@1", v1.get(), &first), 0);
+  ASSERT_EQ(store.put_model("p@2", v2.get(), &second), 0);
+
+  // Assert
+  EXPECT_EQ(first.objects_written, 2002u);
+  EXPECT_EQ(second.objects_written, 1u);
+  EXPECT_GT(second.chunks_shared, 0u);
+  EXPECT_LT(second.bytes_written * 20, first.bytes_written);
+  std::vector<std::pair<unsigned, uint64_t>> objects;
+  ASSERT_EQ(store.model_objects("p@2", objects), 0);
+  ASSERT_EQ(objects.size(), 2002u);
+  EXPECT_EQ(objects.front().first, 1u);
+  EXPECT_EQ(objects.back().first, 2002u);
+  EXPECT_TRUE(std::is_sorted(objects.begin(), objects.end()));
+  EXPECT_EQ(session->kv["cas:m:p@2"].compare(0, 7, "1-2002;"), 0);
+}
+
+// Test case for the model record: names and duplicate instances are kept
+TEST(ContentStoreTest, ModelKeepsInstanceNamesAndDuplicates) {
+  // Arrange
+  auto session = std::make_shared<MemorySession>();
+  ContentStore store(session);
+  std::unique_ptr<IfcParse::IfcFile> file = test::open_ifc(
+      "#3=IFCCARTESIANPOINT((1.,2.,3.));\n"
+      "#7=IFCCARTESIANPOINT((1.,2.,3.));\n"
+      "#8=IFCPOLYLINE((#3,#7));\n");
+
+  // Act
+  ASSERT_EQ(store.put_model("p@1", file.get()), 0);
+  std::vector<std::pair<unsigned, uint64_t>> objects;
+  ASSERT_EQ(store.model_objects("p@1", objects), 0);
+  std::string data;
+  ASSERT_EQ(store.export_model("p@1", data), 0);
+
+  // Assert
+  ASSERT_EQ(objects.size(), 3u);
+  EXPECT_EQ(objects[0].first, 3u);
+  EXPECT_EQ(objects[1].first, 7u);
+  EXPECT_EQ(objects[2].first, 8u);
+  EXPECT_EQ(objects[0].second, objects[1].second);
+  // 两个点共享一个对象，被块引用两次
+  EXPECT_EQ(session->kv["cas:o:" + hex(objects[0].second)].compare(0, 2, "2:"),
+            0);
+  EXPECT_EQ(data,
+            "#3=IFCCARTESIANPOINT((1.,2.,3.));\n"
+            "#7=IFCCARTESIANPOINT((1.,2.,3.));\n"
+            "#8=IFCPOLYLINE((#3,#3));\n");
+  ASSERT_EQ(store.remove_model("p@1"), 0);
+  EXPECT_TRUE(session->kv.empty());
+}
+
+// Test case for transactions: a replace that fails midway is rolled back
+TEST(ContentStoreTest, FailedReplaceRollsBack) {
+  // Arrange
+  auto session = std::make_shared<MemorySession>();
+  ContentStore store(session);
+  std::unique_ptr<IfcParse::IfcFile> v1 =
+      test::open_ifc(polyline_model(500, "a"));
+  std::unique_ptr<IfcParse::IfcFile> v2 =
+      test::open_ifc(polyline_model(500, "b"));
+  ASSERT_EQ(store.put_model("p@1", v1.get()), 0);
+  // 旧版本的最后一个块丢失，替换时释放它失败
+  const std::string manifest = session->kv["cas:m:p@1"];
+  session->kv.erase("cas:c:" + manifest.substr(manifest.size() - 16));
+  const std::map<std::string, std::string> before = session->kv;
+
+  // Act
+  int replace_ret = store.put_model("p@1", v2.get());
+  int remove_ret = store.remove_model("p@1");
+
+  // Assert
+  EXPECT_EQ(replace_ret, -1);
+  EXPECT_EQ(remove_ret, -1);
+  EXPECT_EQ(session->kv, before);
+}
+
+// Test case for reference counting: content lives as long as a model uses it
+TEST(ContentStoreTest, RemovedModelsReleaseContent) {
+  // Arrange
+  auto session = std::make_shared<MemorySession>();
+  ContentStore store(session);
+  std::unique_ptr<IfcParse::IfcFile> v1 =
+      test::open_ifc(polyline_model(500, "a"));
+  std::unique_ptr<IfcParse::IfcFile> v2 =
+      test::open_ifc(polyline_model(500, "b"));
+  ASSERT_EQ(store.put_model("p@1", v1.get()), 0);
+  const size_t entries = session->kv.size();
+
+  // Act & Assert
+  ASSERT_EQ(store.put_model("p@1", v1.get()), 0);
+  EXPECT_EQ(session->kv.size(), entries);
+
+  ASSERT_EQ(store.put_model("p@2", v2.get()), 0);
+  ASSERT_EQ(store.remove_model("p@1"), 0);
+  std::string data;
+  EXPECT_EQ(store.export_model("p@1", data), -1);
+  ASSERT_EQ(store.export_model("p@2", data), 0);
+  EXPECT_NE(data.find("'b'"), std::string::npos);
+
+  ASSERT_EQ(store.remove_model("p@2"), 0);
+  EXPECT_TRUE(session->kv.empty());
+  EXPECT_EQ(store.remove_model("p@2"), -1);
+}
+
+// Test case for hash collisions: a rejected model leaves the store unchanged
+TEST(ContentStoreTest, CollisionLeavesStoreUnchanged) {
+  // Arrange
+  auto session = std::make_shared<MemorySession>();
+  ContentStore store(session);
+  std::unique_ptr<IfcParse::IfcFile> v1 =
+      test::open_ifc(polyline_model(500, "a"));
+  std::unique_ptr<IfcParse::IfcFile> v2 =
+      test::open_ifc(polyline_model(500, "b"));
+  ASSERT_EQ(store.put_model("p@1", v1.get()), 0);
+  // 伪造冲突：清单中最后一个块的成员和全部对象的内容与新版本不一致
+  const std::string manifest = session->kv["cas:m:p@1"];
+  std::string &last_chunk =
+      session->kv["cas:c:" + manifest.substr(manifest.size() - 16)];
+  last_chunk.back() = last_chunk.back() == '0' ? '1' : '0';
+  for (auto &entry : session->kv) {
+    if (entry.first.compare(0, 6, "cas:o:") == 0) {
+      entry.second += ' ';
+    }
+  }
+  const std::map<std::string, std::string> before = session->kv;
+
+  // Act
+  int same_ret = store.put_model("p@2", v1.get());
+  int changed_ret = store.put_model("p@3", v2.get());
+
+  // Assert
+  EXPECT_EQ(same_ret, -1);
+  EXPECT_EQ(changed_ret, -1);
+  EXPECT_EQ(session->kv, before);
+}
+
+}  // namespace vulcan
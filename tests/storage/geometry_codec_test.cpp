@@ -0,0 +1,140 @@
+// Copyright 2023 VulcanDB
+#include "storage/compression/geometry_codec.h"
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include "ifc_test_util.h"
+#include "ifcparse/IfcFile.h"
+
+namespace vulcan {
+
+namespace {
+
+// 四个面组成的网格，点的坐标带有超出精度的尾数
+std::string mesh_model() {
+  std::string data;
+  int id = 1;
+  for (int i = 0; i < 9; i++) {
+    data += "#" + std::to_string(id++) + "=IFCCARTESIANPOINT((" +
+            std::to_string(i % 3 * 1.25 - 0.000012) + "," +
+            std::to_string(i / 3 * -2.5 + 0.000049) + ",3.141592));\n";
+  }
+  data += "#10=IFCCARTESIANPOINT((0.5,-7.));\n";
+  std::string faces;
+  for (int i = 0; i < 4; i++) {
+    int corner = i / 2 * 3 + i % 2 + 1;
+    int loop = 11 + i * 3;
+    data += "#" + std::to_string(loop) + "=IFCPOLYLOOP((#" +
+            std::to_string(corner) + ",#" + std::to_string(corner + 1) +
+            ",#" + std::to_string(corner + 4) + ",#" +
+            std::to_string(corner + 3) + "));\n";
+    data += "#" + std::to_string(loop + 1) + "=IFCFACEOUTERBOUND(#" +
+            std::to_string(loop) + (i == 3 ? ",.F.);\n" : ",.T.);\n");
+    data += "#" + std::to_string(loop + 2) + "=IFCFACE((#" +
+            std::to_string(loop + 1) + "));\n";
+    faces += (i == 0 ? "#" : ",#") + std::to_string(loop + 2);
+  }
+  data += "#23=IFCCLOSEDSHELL((" + faces + "));\n";
+  data += "#24=IFCPOLYLINE((#10,#1));\n";
+  data += "#25=IFCPROPERTYSINGLEVALUE('a;b','it''s',IFCLABEL('x'),$);\n";
+  return data;
+}
+
+}  // namespace
+
+// Test case for the round trip: coordinates stay within half a step and
+// every other attribute is preserved
+TEST(GeometryCodecTest, RoundTripKeepsModelWithinTolerance) {
+  // Arrange
+  const double tolerance = 1e-4;
+  std::string original = test::ifc_model(mesh_model(), "t;1.ifc");
+
+  // Act
+  std::string encoded, decoded;
+  ASSERT_EQ(GeometryCodec::encode(original, tolerance, encoded), 0);
+  ASSERT_EQ(GeometryCodec::decode(encoded, decoded), 0);
+
+  // Assert
+  std::unique_ptr<IfcParse::IfcFile> a = test::open_ifc_text(original);
+  std::unique_ptr<IfcParse::IfcFile> b = test::open_ifc_text(decoded);
+  ASSERT_TRUE(a->good());
+  ASSERT_TRUE(b->good());
+  for (unsigned id = 1; id <= 25; id++) {
+    IfcUtil::IfcBaseClass *x = a->instance_by_id(id);
+    IfcUtil::IfcBaseClass *y = b->instance_by_id(id);
+    ASSERT_EQ(x->declaration().name(), y->declaration().name()) << id;
+    if (id > 10) {
+      EXPECT_EQ(x->data().toString(), y->data().toString()) << id;
+      continue;
+    }
+    std::vector<double> p = *x->data().getArgument(0);
+    std::vector<double> q = *y->data().getArgument(0);
+    ASSERT_EQ(p.size(), q.size()) << id;
+    for (size_t i = 0; i < p.size(); i++) {
+      EXPECT_LE(std::fabs(p[i] - q[i]), tolerance / 2 + 1e-12) << id;
+    }
+  }
+  EXPECT_NE(decoded.find("FILE_NAME('t;1.ifc'"), std::string::npos);
+  EXPECT_NE(decoded.find("#25=IFCPROPERTYSINGLEVALUE('a;b','it''s',"),
+            std::string::npos);
+}
+
+// Test case for geometry: the columns are smaller than deflated text and
+// decoding is stable
+TEST(GeometryCodecTest, GeometryIsSmallerThanDeflate) {
+  // Arrange
+  std::string data;
+  for (int i = 1; i <= 3000; i++) {
+    data += "#" + std::to_string(i) + "=IFCCARTESIANPOINT((" +
+            std::to_string(i * 0.1) + "," + std::to_string(i % 17 * 0.3) +
+            ",0.));\n";
+  }
+  for (int i = 1; i < 3000; i++) {
+    data += "#" + std::to_string(3000 + i) + "=IFCPOLYLINE((#" +
+            std::to_string(i) + ",#" + std::to_string(i + 1) + "));\n";
+  }
+  std::string original = test::ifc_model(data, "t;1.ifc");
+
+  uLongf deflated = compressBound(original.size());
+  std::string buffer(deflated, '\0');
+  ASSERT_EQ(compress2(reinterpret_cast<Bytef *>(&buffer[0]), &deflated,
+                      reinterpret_cast<const Bytef *>(original.data()),
+                      original.size(), Z_BEST_COMPRESSION),
+            Z_OK);
+
+  // Act
+  std::string encoded, decoded, reencoded;
+  ASSERT_EQ(GeometryCodec::encode(original, 1e-3, encoded), 0);
+  ASSERT_EQ(GeometryCodec::decode(encoded, decoded), 0);
+  ASSERT_EQ(GeometryCodec::encode(decoded, 1e-3, reencoded), 0);
+
+  // Assert
+  EXPECT_LT(encoded.size() * 2, deflated);
+  EXPECT_EQ(reencoded, encoded);
+  EXPECT_NE(decoded.find("#3000=IFCCARTESIANPOINT((300.,2.4,0.));"),
+            std::string::npos);
+}
+
+// Test case for malformed input: bad arguments and damaged data are rejected
+TEST(GeometryCodecTest, RejectsInvalidInput) {
+  // Arrange
+  std::string original = test::ifc_model(mesh_model(), "t;1.ifc");
+  std::string encoded, decoded;
+  ASSERT_EQ(GeometryCodec::encode(original, 1e-4, encoded), 0);
+
+  // Act & Assert
+  EXPECT_EQ(GeometryCodec::encode(original, 0, encoded), -1);
+  EXPECT_EQ(GeometryCodec::decode(original, decoded), -1);
+  EXPECT_EQ(GeometryCodec::decode(encoded.substr(0, encoded.size() - 1),
+                                  decoded),
+            -1);
+  encoded[encoded.size() - 3] ^= 0x5a;
+  EXPECT_EQ(GeometryCodec::decode(encoded, decoded), -1);
+}
+
+}  // namespace vulcan
@@ -0,0 +1,174 @@
+// Copyright 2023 VulcanDB
+#include "storage/compression/ifc_diff.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ifc_test_util.h"
+#include "ifcparse/IfcFile.h"
+#include "storage/compression/ifccompressor_impl.h"
+
+namespace vulcan {
+
+namespace {
+
+const char *VERSION_A =
+    "#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+    "#2=IFCDIRECTION((0.,0.,1.));\n"
+    "#3=IFCAXIS2PLACEMENT3D(#1,#2,$);\n"
+    "#4=IFCLOCALPLACEMENT($,#3);\n"
+    "#5=IFCBUILDINGELEMENTPROXY('2O2Fr$t4X7Zf8NOew3FLOH',$,'a',$,$,#4,$,$,$);\n"
+    "#6=IFCBUILDINGELEMENTPROXY('1hqIFTRjfV6AWq_bMtnZwI',$,'b',$,$,#4,$,$,$);\n"
+    "#7=IFCBUILDINGELEMENTPROXY('0000000000000000000001',$,'c',$,$,$,$,$,$);\n";
+
+}  // namespace
+
+// Test case for renumbering: structurally equal instances get equal hashes
+TEST(IfcDiffTest, RenumberedModelIsUnchanged) {
+  // Arrange
+  std::unique_ptr<IfcParse::IfcFile> a = test::open_ifc(VERSION_A);
+  std::unique_ptr<IfcParse::IfcFile> b = test::open_ifc(
+      "#12=IFCLOCALPLACEMENT($,#13);\n"
+      "#13=IFCAXIS2PLACEMENT3D(#15,#14,$);\n"
+      "#14=IFCDIRECTION((0.,0.,1.));\n"
+      "#15=IFCCARTESIANPOINT((0.,0.,0.));\n"
+      "#16=IFCBUILDINGELEMENTPROXY('0000000000000000000001',$,'c',$,$,$,$,$,"
+      "$);\n"
+      "#17=IFCBUILDINGELEMENTPROXY('1hqIFTRjfV6AWq_bMtnZwI',$,'b',$,$,#12,$,$,"
+      "$);\n"
+      "#18=IFCBUILDINGELEMENTPROXY('2O2Fr$t4X7Zf8NOew3FLOH',$,'a',$,$,#12,$,$,"
+      "$);\n");
+  IfcDiff engine;
+  IfcDiffResult result;
+
+  // Act
+  int rc = engine.diff(a.get(), b.get(), result);
+
+  // Assert
+  ASSERT_EQ(rc, 0);
+  std::vector<std::pair<unsigned, unsigned>> expected = {
+      {1, 15}, {2, 14}, {3, 13}, {4, 12}, {5, 18}, {6, 17}, {7, 16}};
+  EXPECT_EQ(result.unchanged, expected);
+  EXPECT_TRUE(result.modified.empty());
+  EXPECT_TRUE(result.removed.empty());
+  EXPECT_TRUE(result.added.empty());
+  EXPECT_EQ(result.rooted_a, 3u);
+  EXPECT_EQ(result.guid_pairs, 3u);
+  EXPECT_EQ(result.guid_unchanged, 3u);
+}
+
+// Test case for a change below a rooted instance: the owner is modified
+TEST(IfcDiffTest, ChangePropagatesToReferencingInstances) {
+  // Arrange
+  std::unique_ptr<IfcParse::IfcFile> a = test::open_ifc(VERSION_A);
+  std::unique_ptr<IfcParse::IfcFile> b = test::open_ifc(
+      "#1=IFCCARTESIANPOINT((1.,0.,0.));\n"
+      "#2=IFCDIRECTION((0.,0.,1.));\n"
+      "#3=IFCAXIS2PLACEMENT3D(#1,#2,$);\n"
+      "#4=IFCLOCALPLACEMENT($,#3);\n"
+      "#5=IFCBUILDINGELEMENTPROXY('2O2Fr$t4X7Zf8NOew3FLOH',$,'a',$,$,#4,$,$,"
+      "$);\n"
+      "#6=IFCBUILDINGELEMENTPROXY('1hqIFTRjfV6AWq_bMtnZwI',$,'b2',$,$,$,$,$,"
+      "$);\n"
+      "#8=IFCBUILDINGELEMENTPROXY('0000000000000000000002',$,'d',$,$,$,$,$,"
+      "$);\n");
+  IfcDiff engine;
+  IfcDiffResult result;
+
+  // Act
+  int rc = engine.diff(a.get(), b.get(), result);
+
+  // Assert
+  ASSERT_EQ(rc, 0);
+  EXPECT_EQ(result.unchanged,
+            (std::vector<std::pair<unsigned, unsigned>>{{2, 2}}));
+  EXPECT_EQ(result.modified,
+            (std::vector<std::pair<unsigned, unsigned>>{{5, 5}, {6, 6}}));
+  EXPECT_EQ(result.removed, (std::vector<unsigned>{1, 3, 4, 7}));
+  EXPECT_EQ(result.added, (std::vector<unsigned>{1, 3, 4, 8}));
+  EXPECT_EQ(result.guid_pairs, 2u);
+  EXPECT_EQ(result.guid_unchanged, 0u);
+}
+
+// Test case for reference cycles: every instance still gets a hash
+TEST(IfcDiffTest, CyclicReferencesAreHashed) {
+  // Arrange
+  const char *data =
+      "#1=IFCCOMPOSITECURVE((#2),.F.);\n"
+      "#2=IFCCOMPOSITECURVESEGMENT(.CONTINUOUS.,.T.,#1);\n"
+      "#3=IFCCARTESIANPOINT((0.,0.,0.));\n";
+  std::unique_ptr<IfcParse::IfcFile> a = test::open_ifc(data);
+  std::unique_ptr<IfcParse::IfcFile> b = test::open_ifc(data);
+  IfcDiff engine;
+  std::vector<uint64_t> hashes_a, hashes_b;
+
+  // Act
+  ASSERT_EQ(engine.hash_instances(a.get(), hashes_a), 0);
+  ASSERT_EQ(engine.hash_instances(b.get(), hashes_b), 0);
+
+  // Assert
+  ASSERT_EQ(hashes_a.size(), 4u);
+  EXPECT_EQ(hashes_a[0], 0u);
+  EXPECT_NE(hashes_a[1], 0u);
+  EXPECT_NE(hashes_a[2], 0u);
+  EXPECT_NE(hashes_a[1], hashes_a[2]);
+  EXPECT_EQ(hashes_a, hashes_b);
+}
+
+// Test case for parallel levels: hashes do not depend on the thread count
+TEST(IfcDiffTest, ParallelHashesMatchSerial) {
+  // Arrange
+  std::string data;
+  const int points = 10000;
+  for (int i = 1; i <= points; i++) {
+    data += "#" + std::to_string(i) + "=IFCCARTESIANPOINT((" +
+            std::to_string(i % 100) + ".,0.,0.));\n";
+  }
+  for (int i = 1; i < points; i++) {
+    data += "#" + std::to_string(points + i) + "=IFCPOLYLINE((#" +
+            std::to_string(i) + ",#" + std::to_string(i + 1) + "));\n";
+  }
+  std::unique_ptr<IfcParse::IfcFile> file = test::open_ifc(data);
+  std::vector<uint64_t> serial, parallel;
+
+  // Act
+  ASSERT_EQ(IfcDiff(1).hash_instances(file.get(), serial), 0);
+  ASSERT_EQ(IfcDiff(4).hash_instances(file.get(), parallel), 0);
+
+  // Assert
+  EXPECT_EQ(serial, parallel);
+  EXPECT_EQ(serial[1], serial[101]);
+  EXPECT_NE(serial[1], serial[2]);
+}
+
+// Test case for IfcCompare: the ratios are derived from the diff
+TEST(IfcDiffTest, CompareReportsRatios) {
+  // Arrange
+  std::string path_a = testing::TempDir() + "ifc_diff_a.ifc";
+  std::string path_b = testing::TempDir() + "ifc_diff_b.ifc";
+  std::ofstream(path_a) << test::ifc_model(VERSION_A);
+  std::ofstream(path_b) << test::ifc_model(
+      std::string(VERSION_A) +
+      "#8=IFCBUILDINGELEMENTPROXY('0000000000000000000002',$,'d',$,$,$,$,$,"
+      "$);\n");
+  IfcCompressorImpl compressor;
+  float sA2B, sB2A, machR, missR, guidPR, AR;
+
+  // Act
+  compressor.IfcCompare(path_a, path_b, sA2B, sB2A, machR, missR, guidPR, AR);
+
+  // Assert
+  EXPECT_FLOAT_EQ(sA2B, 1.0f);
+  EXPECT_FLOAT_EQ(sB2A, 7.0f / 8);
+  EXPECT_FLOAT_EQ(machR, 1.0f);
+  EXPECT_FLOAT_EQ(missR, 0.0f);
+  EXPECT_FLOAT_EQ(guidPR, 1.0f);
+  EXPECT_FLOAT_EQ(AR, 1.0f / 8);
+}
+
+}  // namespace vulcan